@@ -45,6 +45,8 @@ extern "C" {
 #include "sbdi_block.h"
 #include "sbdi_hdr.h"
 #include "sbdi_crypto_type.h"
+#include "sbdi_wp.h"
+#include "sbdi_commit.h"
 
 #include <sys/types.h>
 #include <stdint.h>
@@ -93,9 +95,14 @@ struct secure_block_device_interface {
   void *mt;
   sbdi_hdr_v1_t *hdr;
   sbdi_bc_t *cache;
-  sbdi_bl_data_t write_store_dat[2];
+  sbdi_wp_t *wp;
+  sbdi_cm_t *cm;
+  sbdi_bl_data_t write_store_dat[2] SBDI_BL_ALIGNED;
   sbdi_block_t write_store[2];
+  sbdi_bl_data_t batch_store_dat[SBDI_BL_BATCH_SIZE] SBDI_BL_ALIGNED;
   size_t offset;
+  siv_ctx mctx; //!< the expanded master key, kept until the device is closed
+  sbdi_sym_mst_key_t mkey; //!< the master key mctx has been expanded from
 };
 
 sbdi_t *sbdi_create(sbdi_pio_t *pioypto);
@@ -114,11 +121,15 @@ sbdi_error_t sbdi_read(ssize_t *rd, sbdi_t *sbdi, void *buf, size_t nbyte);
 sbdi_error_t sbdi_write(ssize_t *wr, sbdi_t *sbdi, const void *buf,
     size_t nbyte);
 
+sbdi_error_t sbdi_punch_hole(sbdi_t *sbdi, off_t offset, size_t len);
+sbdi_error_t sbdi_ftruncate(sbdi_t *sbdi, off_t length);
+
 sbdi_error_t sbdi_lseek(off_t *new_off, sbdi_t *sbdi, off_t offset,
     sbdi_whence_t whence);
 
 sbdi_error_t sbdi_fsync(sbdi_t *sbdi, sbdi_sym_mst_key_t mkey);
 sbdi_error_t sbdi_sync(sbdi_t *sbdi, sbdi_sym_mst_key_t mkey, mt_hash_t root);
+sbdi_error_t sbdi_get_sync_stats(sbdi_t *sbdi, sbdi_cm_stats_t *stats);
 
 #endif /* SECURE_BLOCK_DEVICE_INTERFACE_H_ */
 
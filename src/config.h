@@ -42,11 +42,26 @@
 #define SBDI_CRYPTO_TYPE_SIV    1u //!< Cryptographic abstraction layer that uses SIV and CMAC for its cryptographic operations
 #define SBDI_CRYPTO_TYPE_OCB    2u //!< Cryptographic abstraction layer that uses OCB and CMAC for its cryptographic operations
 #define SBDI_CRYPTO_TYPE_HMAC   3u //!< Cryptographic abstraction layer that uses CBC and HMAC for its cryptographic operations
+#define SBDI_CRYPTO_TYPE_GCM    4u //!< Cryptographic abstraction layer that uses GCM and CMAC for its cryptographic operations
+#define SBDI_CRYPTO_TYPE_GCM_SIV 5u //!< Cryptographic abstraction layer that uses AES-GCM-SIV and CMAC for its cryptographic operations
+#define SBDI_CRYPTO_TYPE_CHACHA 6u //!< Cryptographic abstraction layer that uses ChaCha20-Poly1305 and CMAC for its cryptographic operations
+#define SBDI_CRYPTO_TYPE_AEGIS 7u //!< Cryptographic abstraction layer that uses AEGIS-128L and CMAC for its cryptographic operations
+#define SBDI_CRYPTO_TYPE_GMAC 8u //!< Cryptographic abstraction layer that uses GMAC and CMAC for its cryptographic operations and leaves data blocks unencrypted
 /* Enable runtime cryptographic abstraction layer selection */
 #undef SBDI_CRYPTO_TYPE
 // #define SBDI_CRYPTO_TYPE        SBDI_CRYPTO_TYPE_OCB /*!< Specify which kind of cryptography to use as default */
 
 #define SBDI_CACHE_MAX_SIZE     16u
+#define SBDI_HDR_CTR_RESERVE    1024u //!< The number of block counter values a header write reserves in advance, so that the header only needs rewriting once they are used up
+#define SBDI_BL_ALIGN           4096u //!< The alignment in bytes of the block buffers, so that direct I/O back ends can transfer aligned runs of blocks without a bounce buffer
+#define SBDI_BL_BATCH_SIZE      8u //!< The maximum number of independent blocks the block layer hands to the cryptographic abstraction layer at once
+#define SBDI_WORKER_THREADS     3u //!< The number of worker threads that encrypt independent blocks in parallel with the calling thread (0 disables threading)
 #define SBDI_CACHE_PROFILE
+#define SBDI_JNL_CHECKPOINT_SIZE (4u * 1024u * 1024u) //!< The number of durable log bytes after which the write-ahead log checkpoints committed blocks in the background
+#define SBDI_LSB_SEGMENT_SIZE   (1024u * 1024u) //!< The maximum size of a segment of the log-structured back end
+#define SBDI_MMAP_CHUNK_SIZE    (64u * 1024u * 1024u) //!< The granularity in bytes by which the mmap back end grows its mapping
+#define SBDI_MMAP_READAHEAD     (512u * 1024u) //!< The number of bytes the mmap back end asks the kernel to prefetch ahead of sequential reads
+#define SBDI_SEG_GROUPS         31u //!< The number of management groups per file of the segment file back end (31 groups of 2 KiB blocks make segments of just under 4 MiB)
+#define SBDI_SEG_OPEN_FILES     16u //!< The number of segment files the segment file back end keeps open
 
 #endif /* CONFIG_H_ */
@@ -0,0 +1,321 @@
+/* Copyright (c) IAIK, Graz University of Technology, 2015.
+ * All rights reserved.
+ * Contact: http://opensource.iaik.tugraz.at
+ * 
+ * This file is part of the Secure Block Device Library.
+ * 
+ * Commercial License Usage
+ * Licensees holding valid commercial licenses may use this file in
+ * accordance with the commercial license agreement provided with the
+ * Software or, alternatively, in accordance with the terms contained in
+ * a written agreement between you and SIC. For further information
+ * contact us at http://opensource.iaik.tugraz.at.
+ * 
+ * Alternatively, this file may be used under the terms of the GNU General
+ * Public License as published by the Free Software Foundation version 2.
+ * 
+ * The Secure Block Device Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with the Secure Block Device Library. If not, see <http://www.gnu.org/licenses/>.
+ */
+///
+/// \file
+/// \brief Implements the AEGIS-128L authenticated encryption scheme.
+///
+/// The implementation follows the AEGIS-128L specification of the CFRG
+/// AEGIS draft with a 128 bit tag. Both code paths process the message in
+/// 32 byte blocks and zero pad the final partial block.
+///
+#include "aegis128l.h"
+#include "aes_ni.h"
+#include "rijndael-alg-fst.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#if AES_NI_SUPPORTED
+# include <immintrin.h>
+#endif
+
+#define AEGIS128L_BLK  16
+#define AEGIS128L_RATE 32
+
+static const unsigned char aegis128l_c0[AEGIS128L_BLK] = { 0x00, 0x01, 0x01,
+    0x02, 0x03, 0x05, 0x08, 0x0d, 0x15, 0x22, 0x37, 0x59, 0x90, 0xe9, 0x79,
+    0x62 };
+static const unsigned char aegis128l_c1[AEGIS128L_BLK] = { 0xdb, 0x3d, 0x18,
+    0x55, 0x6d, 0xc2, 0x2f, 0xf1, 0x20, 0x11, 0x31, 0x42, 0x73, 0xb5, 0x28,
+    0xdd };
+
+/*!
+ * \brief Builds the final block, which holds the bit lengths of the
+ * additional data and the message in little endian byte order
+ */
+static void aegis128l_len_block(unsigned char b[AEGIS128L_BLK],
+    const int ad_len, const int len)
+{
+  const uint64_t a = (uint64_t) ad_len * 8, m = (uint64_t) len * 8;
+  for (int i = 0; i < 8; ++i) {
+    b[i] = (unsigned char) (a >> (8 * i));
+    b[8 + i] = (unsigned char) (m >> (8 * i));
+  }
+}
+
+typedef unsigned char aegis128l_blk_t[AEGIS128L_BLK];
+
+static inline void aegis128l_xor(unsigned char *r, const unsigned char *a,
+    const unsigned char *b)
+{
+  for (int i = 0; i < AEGIS128L_BLK; ++i) {
+    r[i] = a[i] ^ b[i];
+  }
+}
+
+/*!
+ * \brief Absorbs the two message blocks m0 and m1 into the state
+ */
+static void aegis128l_update(aegis128l_blk_t S[8], const unsigned char *m0,
+    const unsigned char *m1)
+{
+  aegis128l_blk_t t, s7;
+  memcpy(s7, S[7], AEGIS128L_BLK);
+  // Going from the last to the first state block keeps S[i - 1] unmodified
+  // until it has been used
+  for (int i = 7; i > 0; --i) {
+    if (i == 4) {
+      aegis128l_xor(t, S[4], m1);
+      rijndaelEncryptRound(S[3], t, S[4]);
+    } else {
+      rijndaelEncryptRound(S[i - 1], S[i], S[i]);
+    }
+  }
+  aegis128l_xor(t, S[0], m0);
+  rijndaelEncryptRound(s7, t, S[0]);
+}
+
+/*!
+ * \brief Computes the key stream block z0 || z1 of the current state
+ */
+static void aegis128l_keystream(aegis128l_blk_t S[8],
+    unsigned char z[AEGIS128L_RATE])
+{
+  for (int i = 0; i < AEGIS128L_BLK; ++i) {
+    z[i] = S[6][i] ^ S[1][i] ^ (S[2][i] & S[3][i]);
+    z[AEGIS128L_BLK + i] = S[2][i] ^ S[5][i] ^ (S[6][i] & S[7][i]);
+  }
+}
+
+/*!
+ * \brief Encrypts or decrypts a message and computes its tag with the
+ * portable code
+ */
+static void aegis128l_crypt(const aegis128l_ctx *ctx,
+    const unsigned char *nonce, const unsigned char *ad, const int ad_len,
+    const unsigned char *in, unsigned char *out, const int len,
+    const int encrypt, unsigned char *tag)
+{
+  aegis128l_blk_t S[8];
+  unsigned char z[AEGIS128L_RATE], b[AEGIS128L_RATE];
+  aegis128l_xor(S[0], ctx->key, nonce);
+  memcpy(S[1], aegis128l_c1, AEGIS128L_BLK);
+  memcpy(S[2], aegis128l_c0, AEGIS128L_BLK);
+  memcpy(S[3], aegis128l_c1, AEGIS128L_BLK);
+  memcpy(S[4], S[0], AEGIS128L_BLK);
+  aegis128l_xor(S[5], ctx->key, aegis128l_c0);
+  aegis128l_xor(S[6], ctx->key, aegis128l_c1);
+  memcpy(S[7], S[5], AEGIS128L_BLK);
+  for (int i = 0; i < 10; ++i) {
+    aegis128l_update(S, nonce, ctx->key);
+  }
+  for (int i = 0; i < ad_len; i += AEGIS128L_RATE) {
+    const int n = (ad_len - i < AEGIS128L_RATE) ? ad_len - i : AEGIS128L_RATE;
+    memset(b, 0, AEGIS128L_RATE);
+    memcpy(b, ad + i, n);
+    aegis128l_update(S, b, b + AEGIS128L_BLK);
+  }
+  for (int i = 0; i < len; i += AEGIS128L_RATE) {
+    const int n = (len - i < AEGIS128L_RATE) ? len - i : AEGIS128L_RATE;
+    aegis128l_keystream(S, z);
+    memset(b, 0, AEGIS128L_RATE);
+    memcpy(b, in + i, n);
+    for (int j = 0; j < n; ++j) {
+      out[i + j] = b[j] ^ z[j];
+    }
+    // The state absorbs the zero padded plaintext
+    if (!encrypt) {
+      memcpy(b, out + i, n);
+    }
+    aegis128l_update(S, b, b + AEGIS128L_BLK);
+  }
+  aegis128l_len_block(b, ad_len, len);
+  aegis128l_xor(b, b, S[2]);
+  for (int i = 0; i < 7; ++i) {
+    aegis128l_update(S, b, b);
+  }
+  memcpy(tag, S[0], AEGIS128L_BLK);
+  for (int i = 1; i < 7; ++i) {
+    aegis128l_xor(tag, tag, S[i]);
+  }
+  memset(S, 0, sizeof(S));
+  memset(z, 0, sizeof(z));
+  memset(b, 0, sizeof(b));
+}
+
+#if AES_NI_SUPPORTED
+#define AEGIS128L_NI_UPDATE(S, m0, m1) do {                 \
+    const __m128i s7 = S[7];                                \
+    S[7] = _mm_aesenc_si128(S[6], S[7]);                    \
+    S[6] = _mm_aesenc_si128(S[5], S[6]);                    \
+    S[5] = _mm_aesenc_si128(S[4], S[5]);                    \
+    S[4] = _mm_aesenc_si128(S[3], _mm_xor_si128(S[4], m1)); \
+    S[3] = _mm_aesenc_si128(S[2], S[3]);                    \
+    S[2] = _mm_aesenc_si128(S[1], S[2]);                    \
+    S[1] = _mm_aesenc_si128(S[0], S[1]);                    \
+    S[0] = _mm_aesenc_si128(s7, _mm_xor_si128(S[0], m0));   \
+  } while (0)
+
+#define AEGIS128L_NI_Z0(S) _mm_xor_si128(_mm_xor_si128(S[6], S[1]), \
+    _mm_and_si128(S[2], S[3]))
+#define AEGIS128L_NI_Z1(S) _mm_xor_si128(_mm_xor_si128(S[2], S[5]), \
+    _mm_and_si128(S[6], S[7]))
+
+/*!
+ * \brief Encrypts or decrypts a message and computes its tag with AES-NI
+ */
+__attribute__((target("aes,sse2")))
+static void aegis128l_crypt_ni(const aegis128l_ctx *ctx,
+    const unsigned char *nonce, const unsigned char *ad, const int ad_len,
+    const unsigned char *in, unsigned char *out, const int len,
+    const int encrypt, unsigned char *tag)
+{
+  const __m128i k = _mm_loadu_si128((const __m128i *) ctx->key);
+  const __m128i n = _mm_loadu_si128((const __m128i *) nonce);
+  const __m128i c0 = _mm_loadu_si128((const __m128i *) aegis128l_c0);
+  const __m128i c1 = _mm_loadu_si128((const __m128i *) aegis128l_c1);
+  __m128i S[8], m0, m1;
+  unsigned char b[AEGIS128L_RATE];
+  int i;
+  S[0] = _mm_xor_si128(k, n);
+  S[1] = c1;
+  S[2] = c0;
+  S[3] = c1;
+  S[4] = S[0];
+  S[5] = _mm_xor_si128(k, c0);
+  S[6] = _mm_xor_si128(k, c1);
+  S[7] = S[5];
+  for (i = 0; i < 10; ++i) {
+    AEGIS128L_NI_UPDATE(S, n, k);
+  }
+  for (i = 0; i + AEGIS128L_RATE <= ad_len; i += AEGIS128L_RATE) {
+    m0 = _mm_loadu_si128((const __m128i *) (ad + i));
+    m1 = _mm_loadu_si128((const __m128i *) (ad + i + AEGIS128L_BLK));
+    AEGIS128L_NI_UPDATE(S, m0, m1);
+  }
+  if (i < ad_len) {
+    memset(b, 0, AEGIS128L_RATE);
+    memcpy(b, ad + i, ad_len - i);
+    m0 = _mm_loadu_si128((const __m128i *) b);
+    m1 = _mm_loadu_si128((const __m128i *) (b + AEGIS128L_BLK));
+    AEGIS128L_NI_UPDATE(S, m0, m1);
+  }
+  for (i = 0; i + AEGIS128L_RATE <= len; i += AEGIS128L_RATE) {
+    const __m128i z0 = AEGIS128L_NI_Z0(S);
+    const __m128i z1 = AEGIS128L_NI_Z1(S);
+    m0 = _mm_loadu_si128((const __m128i *) (in + i));
+    m1 = _mm_loadu_si128((const __m128i *) (in + i + AEGIS128L_BLK));
+    const __m128i o0 = _mm_xor_si128(m0, z0);
+    const __m128i o1 = _mm_xor_si128(m1, z1);
+    _mm_storeu_si128((__m128i *) (out + i), o0);
+    _mm_storeu_si128((__m128i *) (out + i + AEGIS128L_BLK), o1);
+    if (encrypt) {
+      AEGIS128L_NI_UPDATE(S, m0, m1);
+    } else {
+      AEGIS128L_NI_UPDATE(S, o0, o1);
+    }
+  }
+  if (i < len) {
+    const int r = len - i;
+    memset(b, 0, AEGIS128L_RATE);
+    memcpy(b, in + i, r);
+    m0 = _mm_xor_si128(_mm_loadu_si128((const __m128i *) b), AEGIS128L_NI_Z0(S));
+    m1 = _mm_xor_si128(_mm_loadu_si128((const __m128i *) (b + AEGIS128L_BLK)),
+        AEGIS128L_NI_Z1(S));
+    _mm_storeu_si128((__m128i *) b, m0);
+    _mm_storeu_si128((__m128i *) (b + AEGIS128L_BLK), m1);
+    memcpy(out + i, b, r);
+    // The state absorbs the zero padded plaintext
+    memset(b, 0, AEGIS128L_RATE);
+    memcpy(b, encrypt ? in + i : out + i, r);
+    m0 = _mm_loadu_si128((const __m128i *) b);
+    m1 = _mm_loadu_si128((const __m128i *) (b + AEGIS128L_BLK));
+    AEGIS128L_NI_UPDATE(S, m0, m1);
+  }
+  aegis128l_len_block(b, ad_len, len);
+  m0 = _mm_xor_si128(_mm_loadu_si128((const __m128i *) b), S[2]);
+  for (i = 0; i < 7; ++i) {
+    AEGIS128L_NI_UPDATE(S, m0, m0);
+  }
+  m0 = _mm_xor_si128(_mm_xor_si128(S[0], S[1]), _mm_xor_si128(S[2], S[3]));
+  m0 = _mm_xor_si128(m0, _mm_xor_si128(_mm_xor_si128(S[4], S[5]), S[6]));
+  _mm_storeu_si128((__m128i *) tag, m0);
+  memset(b, 0, sizeof(b));
+}
+#endif
+
+//----------------------------------------------------------------------
+int aegis128l_init(aegis128l_ctx *ctx, const unsigned char *key)
+{
+  if (!ctx || !key) {
+    return -1;
+  }
+  memcpy(ctx->key, key, AEGIS128L_KEY_SIZE);
+  ctx->use_ni = aes_ni_is_available();
+  return 0;
+}
+
+//----------------------------------------------------------------------
+void aegis128l_clear(aegis128l_ctx *ctx)
+{
+  memset(ctx, 0, sizeof(aegis128l_ctx));
+}
+
+//----------------------------------------------------------------------
+void aegis128l_encrypt(const aegis128l_ctx *ctx, const unsigned char *nonce,
+    const unsigned char *ad, const int ad_len, const unsigned char *p,
+    unsigned char *c, const int len, unsigned char *tag)
+{
+#if AES_NI_SUPPORTED
+  if (ctx->use_ni) {
+    aegis128l_crypt_ni(ctx, nonce, ad, ad_len, p, c, len, 1, tag);
+    return;
+  }
+#endif
+  aegis128l_crypt(ctx, nonce, ad, ad_len, p, c, len, 1, tag);
+}
+
+//----------------------------------------------------------------------
+int aegis128l_decrypt(const aegis128l_ctx *ctx, const unsigned char *nonce,
+    const unsigned char *ad, const int ad_len, const unsigned char *c,
+    unsigned char *p, const int len, const unsigned char *tag)
+{
+  unsigned char t[AEGIS128L_TAG_SIZE];
+#if AES_NI_SUPPORTED
+  if (ctx->use_ni) {
+    aegis128l_crypt_ni(ctx, nonce, ad, ad_len, c, p, len, 0, t);
+  } else
+#endif
+  aegis128l_crypt(ctx, nonce, ad, ad_len, c, p, len, 0, t);
+  unsigned char d = 0;
+  for (int i = 0; i < AEGIS128L_TAG_SIZE; ++i) {
+    d |= t[i] ^ tag[i];
+  }
+  if (d) {
+    memset(p, 0, len);
+    return -1;
+  }
+  return 1;
+}
@@ -0,0 +1,114 @@
+/* Copyright (c) IAIK, Graz University of Technology, 2015.
+ * All rights reserved.
+ * Contact: http://opensource.iaik.tugraz.at
+ * 
+ * This file is part of the Secure Block Device Library.
+ * 
+ * Commercial License Usage
+ * Licensees holding valid commercial licenses may use this file in
+ * accordance with the commercial license agreement provided with the
+ * Software or, alternatively, in accordance with the terms contained in
+ * a written agreement between you and SIC. For further information
+ * contact us at http://opensource.iaik.tugraz.at.
+ * 
+ * Alternatively, this file may be used under the terms of the GNU General
+ * Public License as published by the Free Software Foundation version 2.
+ * 
+ * The Secure Block Device Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with the Secure Block Device Library. If not, see <http://www.gnu.org/licenses/>.
+ */
+///
+/// \file
+/// \brief Specifies an AEGIS-128L authenticated encryption implementation.
+///
+/// AEGIS-128L keeps a state of eight AES blocks and updates it with one AES
+/// round per state block for every 32 bytes of input. The eight rounds of
+/// an update are independent, so AES-NI can pipeline them and AEGIS-128L
+/// runs considerably faster than AES based block cipher modes. CPUs without
+/// AES-NI use the round function of the reference AES implementation. The
+/// context is never modified after aegis128l_init.
+///
+/// AEGIS-128L must never be used twice with the same key and nonce.
+///
+#ifndef AEGIS128L_H_
+#define AEGIS128L_H_
+
+#define AEGIS128L_KEY_SIZE   16 //!< The size in bytes of the AEGIS-128L key
+#define AEGIS128L_NONCE_SIZE 16 //!< The size in bytes of the AEGIS-128L nonce
+#define AEGIS128L_TAG_SIZE   16 //!< The size in bytes of the AEGIS-128L tag
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*!
+ * \brief the AEGIS-128L context
+ */
+typedef struct aegis128l_ctx {
+  unsigned char key[AEGIS128L_KEY_SIZE]; //!< the AEGIS-128L key
+  int use_ni; //!< non-zero if the AES-NI kernels are used
+} aegis128l_ctx;
+
+/*!
+ * \brief Initializes an AEGIS-128L context with the given key
+ *
+ * @param ctx[out] the context to initialize
+ * @param key[in] the AEGIS128L_KEY_SIZE byte key
+ * @return 0 if the initialization was successful; -1 otherwise
+ */
+int aegis128l_init(aegis128l_ctx *ctx, const unsigned char *key);
+
+/*!
+ * \brief Overwrites all key material of the given AEGIS-128L context
+ *
+ * @param ctx[inout] the context to clear
+ */
+void aegis128l_clear(aegis128l_ctx *ctx);
+
+/*!
+ * \brief Encrypts and authenticates a message
+ *
+ * @param ctx[in] the AEGIS-128L context
+ * @param nonce[in] the AEGIS128L_NONCE_SIZE byte nonce
+ * @param ad[in] the additional authenticated data (can be NULL if ad_len is
+ * 0)
+ * @param ad_len[in] the length of the additional authenticated data
+ * @param p[in] the plaintext
+ * @param c[out] the ciphertext (may be equal to p)
+ * @param len[in] the length of the plaintext
+ * @param tag[out] the AEGIS128L_TAG_SIZE byte authentication tag
+ */
+void aegis128l_encrypt(const aegis128l_ctx *ctx, const unsigned char *nonce,
+    const unsigned char *ad, const int ad_len, const unsigned char *p,
+    unsigned char *c, const int len, unsigned char *tag);
+
+/*!
+ * \brief Decrypts and verifies a message
+ *
+ * If the tag does not match, the plaintext buffer is cleared.
+ *
+ * @param ctx[in] the AEGIS-128L context
+ * @param nonce[in] the AEGIS128L_NONCE_SIZE byte nonce
+ * @param ad[in] the additional authenticated data (can be NULL if ad_len is
+ * 0)
+ * @param ad_len[in] the length of the additional authenticated data
+ * @param c[in] the ciphertext
+ * @param p[out] the plaintext (may be equal to c)
+ * @param len[in] the length of the ciphertext
+ * @param tag[in] the AEGIS128L_TAG_SIZE byte authentication tag
+ * @return 1 if the tag is valid; -1 otherwise
+ */
+int aegis128l_decrypt(const aegis128l_ctx *ctx, const unsigned char *nonce,
+    const unsigned char *ad, const int ad_len, const unsigned char *c,
+    unsigned char *p, const int len, const unsigned char *tag);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AEGIS128L_H_ */
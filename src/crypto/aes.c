@@ -33,15 +33,28 @@
 
 #include "rijndael-alg-fst.h"
 #include "aes.h"
+#include "aes_ni.h"
+#include "aes_ct.h"
 
 #include <string.h>
 
+#if AES_NI_SUPPORTED && (AES_NI_CBC_LANES != AES_MB_LANES)
+# error "the multi-buffer CBC kernel must process AES_MB_LANES lanes"
+#endif
+
 int
 AES_set_encrypt_key(const unsigned char *userkey, const int bits, AES_KEY *key)
 {
     key->rounds = rijndaelKeySetupEnc(key->key, userkey, bits);
     if (key->rounds == 0)
 	return -1;
+    /*
+     * Without AES-NI the single block and bulk fallbacks use the constant
+     * time bitsliced implementation instead of the T-tables.
+     */
+    key->use_ct = !aes_ni_is_available();
+    if (key->use_ct)
+	aes_ct_keysched(key->ct_key, key->key, key->rounds);
     return 0;
 }
 
@@ -49,6 +62,7 @@ int
 AES_set_decrypt_key(const unsigned char *userkey, const int bits, AES_KEY *key)
 {
     key->rounds = rijndaelKeySetupDec(key->key, userkey, bits);
+    key->use_ct = 0;
     if (key->rounds == 0)
 	return -1;
     return 0;
@@ -57,7 +71,29 @@ AES_set_decrypt_key(const unsigned char *userkey, const int bits, AES_KEY *key)
 void
 AES_encrypt(const unsigned char *in, unsigned char *out, const AES_KEY *key)
 {
-    rijndaelEncrypt(key->key, key->rounds, in, out);
+    if (key->use_ct)
+	aes_ct_encrypt_blks(key->ct_key, key->rounds, in, out, 1);
+    else
+	rijndaelEncrypt(key->key, key->rounds, in, out);
+}
+
+/*
+ * Encrypts nblk independent blocks (ECB), which lets the bitsliced
+ * implementation process them in batches of AES_CT_BATCH blocks.
+ */
+void
+AES_encrypt_blks(const unsigned char *in, unsigned char *out,
+		 const unsigned nblk, const AES_KEY *key)
+{
+    unsigned i;
+
+    if (key->use_ct) {
+	aes_ct_encrypt_blks(key->ct_key, key->rounds, in, out, nblk);
+	return;
+    }
+    for (i = 0; i < nblk; i++)
+	rijndaelEncrypt(key->key, key->rounds, in + i * AES_BLOCK_SIZE,
+			out + i * AES_BLOCK_SIZE);
 }
 
 void
@@ -93,6 +129,15 @@ AES_cbc_encrypt(const unsigned char *in, unsigned char *out,
 	    memcpy(iv, out, AES_BLOCK_SIZE);
 	}
     } else {
+#if AES_NI_SUPPORTED
+	/* the block decryptions are independent and run interleaved */
+	if (aes_ni_is_available() && size >= AES_BLOCK_SIZE) {
+	    aes_ni_cbc_decrypt(key, in, out, size / AES_BLOCK_SIZE, iv);
+	    in += size - size % AES_BLOCK_SIZE;
+	    out += size - size % AES_BLOCK_SIZE;
+	    size %= AES_BLOCK_SIZE;
+	}
+#endif
 	while (size >= AES_BLOCK_SIZE) {
 	    memcpy(tmp, in, AES_BLOCK_SIZE);
 	    AES_decrypt(tmp, out, key);
@@ -113,6 +158,70 @@ AES_cbc_encrypt(const unsigned char *in, unsigned char *out,
     }
 }
 
+/*
+ * Multi-buffer CBC encryption: runs "lanes" independent CBC chains over
+ * nblk whole blocks each. out (or single entries of it) may be NULL to
+ * compute a CBC-MAC only; the final chaining values are left in iv.
+ */
+void
+AES_cbc_encrypt_mb(const unsigned char *const *in, unsigned char *const *out,
+		   const unsigned long nblk, const AES_KEY *key,
+		   unsigned char (*iv)[AES_BLOCK_SIZE], const int lanes)
+{
+    unsigned char tmp[AES_BLOCK_SIZE];
+    unsigned long j;
+    int g, l, i, n;
+
+    for (g = 0; g < lanes; g += AES_MB_LANES) {
+	n = (lanes - g < AES_MB_LANES) ? lanes - g : AES_MB_LANES;
+#if AES_NI_SUPPORTED
+	if (aes_ni_is_available()) {
+	    const unsigned char *lin[AES_MB_LANES];
+	    unsigned char *lout[AES_MB_LANES];
+	    unsigned char liv[AES_MB_LANES][AES_BLOCK_SIZE];
+
+	    /* unused lanes shadow lane 0 but never store anything */
+	    for (l = 0; l < AES_MB_LANES; l++) {
+		lin[l] = in[g + (l < n ? l : 0)];
+		lout[l] = (l < n && out) ? out[g + l] : NULL;
+		memcpy(liv[l], iv[g + (l < n ? l : 0)], AES_BLOCK_SIZE);
+	    }
+	    aes_ni_cbc_encrypt_x8(key, lin, lout, nblk, liv);
+	    for (l = 0; l < n; l++)
+		memcpy(iv[g + l], liv[l], AES_BLOCK_SIZE);
+	    continue;
+	}
+#endif
+	if (key->use_ct) {
+	    unsigned char blks[AES_MB_LANES][AES_BLOCK_SIZE];
+
+	    /* the lanes are independent, so each step is one batch */
+	    for (j = 0; j < nblk; j++) {
+		for (l = 0; l < n; l++)
+		    for (i = 0; i < AES_BLOCK_SIZE; i++)
+			blks[l][i] = in[g + l][j * AES_BLOCK_SIZE + i] ^ iv[g + l][i];
+		aes_ct_encrypt_blks(key->ct_key, key->rounds, blks[0], blks[0], n);
+		for (l = 0; l < n; l++) {
+		    memcpy(iv[g + l], blks[l], AES_BLOCK_SIZE);
+		    if (out && out[g + l])
+			memcpy(out[g + l] + j * AES_BLOCK_SIZE, blks[l],
+			       AES_BLOCK_SIZE);
+		}
+	    }
+	    continue;
+	}
+	for (j = 0; j < nblk; j++) {
+	    for (l = g; l < g + n; l++) {
+		for (i = 0; i < AES_BLOCK_SIZE; i++)
+		    tmp[i] = in[l][j * AES_BLOCK_SIZE + i] ^ iv[l][i];
+		AES_encrypt(tmp, iv[l], key);
+		if (out && out[l])
+		    memcpy(out[l] + j * AES_BLOCK_SIZE, iv[l], AES_BLOCK_SIZE);
+	    }
+	}
+    }
+}
+
 void aes_cfb8_encrypt(const uint8_t *in, uint8_t *out,
 		      size_t length, const AES_KEY *key,
 		      uint8_t *iv, int forward)
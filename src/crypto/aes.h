@@ -40,12 +40,17 @@
 #define AES_BLOCK_SIZE 16
 #define AES_MAXNR 14
 
+#define AES_MB_LANES 8
+
 #define AES_ENCRYPT 1
 #define AES_DECRYPT 0
 
 typedef struct aes_key {
     uint32_t key[(AES_MAXNR+1)*4];
     int rounds;
+    /* bitsliced round keys, only valid if use_ct is set (see aes_ct.h) */
+    uint64_t ct_key[(AES_MAXNR+1)*8];
+    int use_ct;
 } AES_KEY;
 
 #ifdef __cplusplus
@@ -56,12 +61,18 @@ int AES_set_encrypt_key(const unsigned char *, const int, AES_KEY *);
 int AES_set_decrypt_key(const unsigned char *, const int, AES_KEY *);
 
 void AES_encrypt(const unsigned char *, unsigned char *, const AES_KEY *);
+void AES_encrypt_blks(const unsigned char *, unsigned char *,
+		      const unsigned, const AES_KEY *);
 void AES_decrypt(const unsigned char *, unsigned char *, const AES_KEY *);
 
 void AES_cbc_encrypt(const unsigned char *, unsigned char *,
 		     const unsigned long, const AES_KEY *,
 		     unsigned char *, int);
 
+void AES_cbc_encrypt_mb(const unsigned char *const *, unsigned char *const *,
+			const unsigned long, const AES_KEY *,
+			unsigned char (*)[AES_BLOCK_SIZE], const int);
+
 void aes_cfb8_encrypt(const uint8_t *in, uint8_t *out,
 		      size_t length, const AES_KEY *key,
 		      uint8_t *iv, int forward);
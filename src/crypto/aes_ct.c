@@ -0,0 +1,450 @@
+/* Copyright (c) IAIK, Graz University of Technology, 2015.
+ * All rights reserved.
+ * Contact: http://opensource.iaik.tugraz.at
+ * 
+ * This file is part of the Secure Block Device Library.
+ * 
+ * Commercial License Usage
+ * Licensees holding valid commercial licenses may use this file in
+ * accordance with the commercial license agreement provided with the
+ * Software or, alternatively, in accordance with the terms contained in
+ * a written agreement between you and SIC. For further information
+ * contact us at http://opensource.iaik.tugraz.at.
+ * 
+ * Alternatively, this file may be used under the terms of the GNU General
+ * Public License as published by the Free Software Foundation version 2.
+ * 
+ * The Secure Block Device Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with the Secure Block Device Library. If not, see <http://www.gnu.org/licenses/>.
+ */
+///
+/// \file
+/// \brief Implements a bitsliced, constant time AES encryption.
+///
+/// A group of four blocks is held in eight 64 bit words q[0..7], where q[b]
+/// contains bit b of all 64 state bytes. The state byte in row r and column
+/// c of block k is stored at bit 16 * r + 4 * c + k, so every row occupies a
+/// 16 bit lane. ShiftRows then rotates the lanes, and MixColumns combines
+/// each lane with the lanes rotated by one, two and three rows.
+///
+#include "aes_ct.h"
+
+#include <string.h>
+
+#define AES_CT_BLK 16u //!< The size in bytes of an AES block
+#define AES_CT_GRP  4u //!< The number of blocks of a bitsliced group
+
+//----------------------------------------------------------------------
+static inline uint64_t aes_ct_rotr(const uint64_t x, const int n)
+{
+  return (x >> n) | (x << (64 - n));
+}
+
+//----------------------------------------------------------------------
+static inline uint32_t aes_ct_load_le32(const unsigned char *p)
+{
+  return (uint32_t) p[0] | (uint32_t) p[1] << 8 | (uint32_t) p[2] << 16
+      | (uint32_t) p[3] << 24;
+}
+
+//----------------------------------------------------------------------
+static inline void aes_ct_store_le32(unsigned char *p, const uint32_t v)
+{
+  p[0] = (unsigned char) v;
+  p[1] = (unsigned char) (v >> 8);
+  p[2] = (unsigned char) (v >> 16);
+  p[3] = (unsigned char) (v >> 24);
+}
+
+/*!
+ * \brief Spreads the four columns of a block over two words, so that row r
+ * of columns 0 and 2 (q0) or 1 and 3 (q1) occupies bytes 2r and 2r + 1
+ */
+static inline void aes_ct_interleave_in(uint64_t *q0, uint64_t *q1,
+    const unsigned char *in)
+{
+  uint64_t x[4];
+  for (int c = 0; c < 4; ++c) {
+    x[c] = aes_ct_load_le32(in + 4 * c);
+    x[c] = (x[c] | (x[c] << 16)) & 0x0000FFFF0000FFFFull;
+    x[c] = (x[c] | (x[c] << 8)) & 0x00FF00FF00FF00FFull;
+  }
+  *q0 = x[0] | (x[2] << 8);
+  *q1 = x[1] | (x[3] << 8);
+}
+
+/*!
+ * \brief Reverses aes_ct_interleave_in
+ */
+static inline void aes_ct_interleave_out(unsigned char *out,
+    const uint64_t q0, const uint64_t q1)
+{
+  uint64_t x[4];
+  x[0] = q0 & 0x00FF00FF00FF00FFull;
+  x[1] = q1 & 0x00FF00FF00FF00FFull;
+  x[2] = (q0 >> 8) & 0x00FF00FF00FF00FFull;
+  x[3] = (q1 >> 8) & 0x00FF00FF00FF00FFull;
+  for (int c = 0; c < 4; ++c) {
+    x[c] = (x[c] | (x[c] >> 8)) & 0x0000FFFF0000FFFFull;
+    aes_ct_store_le32(out + 4 * c, (uint32_t) x[c] | (uint32_t) (x[c] >> 16));
+  }
+}
+
+/*!
+ * \brief Transposes the 8x8 bit matrices formed by byte j of the eight
+ * words, i.e. bit b of byte j of q[k] becomes bit k of byte j of q[b]
+ */
+static void aes_ct_ortho(uint64_t q[8])
+{
+  static const uint64_t m[3] = { 0x5555555555555555ull, 0x3333333333333333ull,
+      0x0F0F0F0F0F0F0F0Full };
+  for (int l = 0; l < 3; ++l) {
+    const int s = 1 << l;
+    for (int i = 0; i < 8; ++i) {
+      if (i & s) {
+        continue;
+      }
+      const uint64_t a = q[i], b = q[i + s];
+      q[i] = (a & m[l]) | ((b & m[l]) << s);
+      q[i + s] = ((a >> s) & m[l]) | (b & ~m[l]);
+    }
+  }
+}
+
+/*!
+ * \brief Converts up to four blocks into the bitsliced representation;
+ * missing blocks are treated as zero blocks
+ */
+static void aes_ct_load(uint64_t q[8], const unsigned char *in,
+    const unsigned nblk)
+{
+  for (unsigned i = 0; i < AES_CT_GRP; ++i) {
+    if (i < nblk) {
+      aes_ct_interleave_in(&q[i], &q[i + 4], in + i * AES_CT_BLK);
+    } else {
+      q[i] = q[i + 4] = 0;
+    }
+  }
+  aes_ct_ortho(q);
+}
+
+/*!
+ * \brief Converts a bitsliced group back into nblk (at most four) blocks
+ */
+static void aes_ct_store(uint64_t q[8], unsigned char *out,
+    const unsigned nblk)
+{
+  aes_ct_ortho(q);
+  for (unsigned i = 0; i < nblk; ++i) {
+    aes_ct_interleave_out(out + i * AES_CT_BLK, q[i], q[i + 4]);
+  }
+}
+
+/*!
+ * \brief Applies the AES S-box to all bytes of a bitsliced group
+ *
+ * This is the circuit of Boyar and Peralta ("A depth-16 circuit for the AES
+ * S-box"), where x0 is the most significant bit of the input byte.
+ */
+static void aes_ct_sbox(uint64_t q[8])
+{
+  uint64_t x0, x1, x2, x3, x4, x5, x6, x7;
+  uint64_t y1, y2, y3, y4, y5, y6, y7, y8, y9;
+  uint64_t y10, y11, y12, y13, y14, y15, y16, y17, y18, y19;
+  uint64_t y20, y21;
+  uint64_t z0, z1, z2, z3, z4, z5, z6, z7, z8, z9;
+  uint64_t z10, z11, z12, z13, z14, z15, z16, z17;
+  uint64_t t0, t1, t2, t3, t4, t5, t6, t7, t8, t9;
+  uint64_t t10, t11, t12, t13, t14, t15, t16, t17, t18, t19;
+  uint64_t t20, t21, t22, t23, t24, t25, t26, t27, t28, t29;
+  uint64_t t30, t31, t32, t33, t34, t35, t36, t37, t38, t39;
+  uint64_t t40, t41, t42, t43, t44, t45, t46, t47, t48, t49;
+  uint64_t t50, t51, t52, t53, t54, t55, t56, t57, t58, t59;
+  uint64_t t60, t61, t62, t63, t64, t65, t66, t67;
+  uint64_t s0, s1, s2, s3, s4, s5, s6, s7;
+
+  x0 = q[7];
+  x1 = q[6];
+  x2 = q[5];
+  x3 = q[4];
+  x4 = q[3];
+  x5 = q[2];
+  x6 = q[1];
+  x7 = q[0];
+
+  // Top linear transformation
+  y14 = x3 ^ x5;
+  y13 = x0 ^ x6;
+  y9 = x0 ^ x3;
+  y8 = x0 ^ x5;
+  t0 = x1 ^ x2;
+  y1 = t0 ^ x7;
+  y4 = y1 ^ x3;
+  y12 = y13 ^ y14;
+  y2 = y1 ^ x0;
+  y5 = y1 ^ x6;
+  y3 = y5 ^ y8;
+  t1 = x4 ^ y12;
+  y15 = t1 ^ x5;
+  y20 = t1 ^ x1;
+  y6 = y15 ^ x7;
+  y10 = y15 ^ t0;
+  y11 = y20 ^ y9;
+  y7 = x7 ^ y11;
+  y17 = y10 ^ y11;
+  y19 = y10 ^ y8;
+  y16 = t0 ^ y11;
+  y21 = y13 ^ y16;
+  y18 = x0 ^ y16;
+
+  // Non-linear section
+  t2 = y12 & y15;
+  t3 = y3 & y6;
+  t4 = t3 ^ t2;
+  t5 = y4 & x7;
+  t6 = t5 ^ t2;
+  t7 = y13 & y16;
+  t8 = y5 & y1;
+  t9 = t8 ^ t7;
+  t10 = y2 & y7;
+  t11 = t10 ^ t7;
+  t12 = y9 & y11;
+  t13 = y14 & y17;
+  t14 = t13 ^ t12;
+  t15 = y8 & y10;
+  t16 = t15 ^ t12;
+  t17 = t4 ^ t14;
+  t18 = t6 ^ t16;
+  t19 = t9 ^ t14;
+  t20 = t11 ^ t16;
+  t21 = t17 ^ y20;
+  t22 = t18 ^ y19;
+  t23 = t19 ^ y21;
+  t24 = t20 ^ y18;
+
+  t25 = t21 ^ t22;
+  t26 = t21 & t23;
+  t27 = t24 ^ t26;
+  t28 = t25 & t27;
+  t29 = t28 ^ t22;
+  t30 = t23 ^ t24;
+  t31 = t22 ^ t26;
+  t32 = t31 & t30;
+  t33 = t32 ^ t24;
+  t34 = t23 ^ t33;
+  t35 = t27 ^ t33;
+  t36 = t24 & t35;
+  t37 = t36 ^ t34;
+  t38 = t27 ^ t36;
+  t39 = t29 & t38;
+  t40 = t25 ^ t39;
+
+  t41 = t40 ^ t37;
+  t42 = t29 ^ t33;
+  t43 = t29 ^ t40;
+  t44 = t33 ^ t37;
+  t45 = t42 ^ t41;
+  z0 = t44 & y15;
+  z1 = t37 & y6;
+  z2 = t33 & x7;
+  z3 = t43 & y16;
+  z4 = t40 & y1;
+  z5 = t29 & y7;
+  z6 = t42 & y11;
+  z7 = t45 & y17;
+  z8 = t41 & y10;
+  z9 = t44 & y12;
+  z10 = t37 & y3;
+  z11 = t33 & y4;
+  z12 = t43 & y13;
+  z13 = t40 & y5;
+  z14 = t29 & y2;
+  z15 = t42 & y9;
+  z16 = t45 & y14;
+  z17 = t41 & y8;
+
+  // Bottom linear transformation
+  t46 = z15 ^ z16;
+  t47 = z10 ^ z11;
+  t48 = z5 ^ z13;
+  t49 = z9 ^ z10;
+  t50 = z2 ^ z12;
+  t51 = z2 ^ z5;
+  t52 = z7 ^ z8;
+  t53 = z0 ^ z3;
+  t54 = z6 ^ z7;
+  t55 = z16 ^ z17;
+  t56 = z12 ^ t48;
+  t57 = t50 ^ t53;
+  t58 = z4 ^ t46;
+  t59 = z3 ^ t54;
+  t60 = t46 ^ t57;
+  t61 = z14 ^ t57;
+  t62 = t52 ^ t58;
+  t63 = t49 ^ t58;
+  t64 = z4 ^ t59;
+  t65 = t61 ^ t62;
+  t66 = z1 ^ t63;
+  s0 = t59 ^ t63;
+  s6 = t56 ^ ~t62;
+  s7 = t48 ^ ~t60;
+  t67 = t64 ^ t65;
+  s3 = t53 ^ t66;
+  s4 = t51 ^ t66;
+  s5 = t47 ^ t65;
+  s1 = t64 ^ ~s3;
+  s2 = t55 ^ ~t67;
+
+  q[7] = s0;
+  q[6] = s1;
+  q[5] = s2;
+  q[4] = s3;
+  q[3] = s4;
+  q[2] = s5;
+  q[1] = s6;
+  q[0] = s7;
+}
+
+/*!
+ * \brief Rotates row r of every block left by r columns
+ */
+static inline void aes_ct_shift_rows(uint64_t q[8])
+{
+  for (int b = 0; b < 8; ++b) {
+    const uint64_t x = q[b];
+    q[b] = (x & 0x000000000000FFFFull)
+        | ((x & 0x00000000FFF00000ull) >> 4)
+        | ((x & 0x00000000000F0000ull) << 12)
+        | ((x & 0x0000FF0000000000ull) >> 8)
+        | ((x & 0x000000FF00000000ull) << 8)
+        | ((x & 0xF000000000000000ull) >> 12)
+        | ((x & 0x0FFF000000000000ull) << 4);
+  }
+}
+
+/*!
+ * \brief Computes 2 * a_r ^ 3 * a_r+1 ^ a_r+2 ^ a_r+3 for every row r,
+ * which equals 2 * t ^ a_r+1 ^ rot2(t) for t = a_r ^ a_r+1
+ */
+static inline void aes_ct_mix_columns(uint64_t q[8])
+{
+  uint64_t r1[8], t[8];
+  for (int b = 0; b < 8; ++b) {
+    r1[b] = aes_ct_rotr(q[b], 16);
+    t[b] = q[b] ^ r1[b];
+  }
+  q[0] = t[7] ^ r1[0] ^ aes_ct_rotr(t[0], 32);
+  q[1] = t[0] ^ t[7] ^ r1[1] ^ aes_ct_rotr(t[1], 32);
+  q[2] = t[1] ^ r1[2] ^ aes_ct_rotr(t[2], 32);
+  q[3] = t[2] ^ t[7] ^ r1[3] ^ aes_ct_rotr(t[3], 32);
+  q[4] = t[3] ^ t[7] ^ r1[4] ^ aes_ct_rotr(t[4], 32);
+  q[5] = t[4] ^ r1[5] ^ aes_ct_rotr(t[5], 32);
+  q[6] = t[5] ^ r1[6] ^ aes_ct_rotr(t[6], 32);
+  q[7] = t[6] ^ r1[7] ^ aes_ct_rotr(t[7], 32);
+}
+
+//----------------------------------------------------------------------
+static inline void aes_ct_add_round_key(uint64_t q[8], const uint64_t *sk)
+{
+  for (int b = 0; b < 8; ++b) {
+    q[b] ^= sk[b];
+  }
+}
+
+/*!
+ * \brief Encrypts a bitsliced group of four blocks
+ */
+static void aes_ct_encrypt_grp(const uint64_t *sk, const int rounds,
+    uint64_t q[8])
+{
+  aes_ct_add_round_key(q, sk);
+  for (int r = 1; r < rounds; ++r) {
+    aes_ct_sbox(q);
+    aes_ct_shift_rows(q);
+    aes_ct_mix_columns(q);
+    aes_ct_add_round_key(q, sk + 8 * r);
+  }
+  aes_ct_sbox(q);
+  aes_ct_shift_rows(q);
+  aes_ct_add_round_key(q, sk + 8 * rounds);
+}
+
+//----------------------------------------------------------------------
+void aes_ct_keysched(uint64_t *sk, const uint32_t *rk, const int rounds)
+{
+  unsigned char k[AES_CT_GRP * AES_CT_BLK];
+  for (int r = 0; r <= rounds; ++r) {
+    // The reference key schedule stores the first key byte of each word in
+    // the most significant position
+    for (unsigned i = 0; i < AES_CT_BLK; ++i) {
+      k[i] = (unsigned char) (rk[4 * r + i / 4] >> (24 - 8 * (i % 4)));
+    }
+    for (unsigned j = 1; j < AES_CT_GRP; ++j) {
+      memcpy(k + j * AES_CT_BLK, k, AES_CT_BLK);
+    }
+    aes_ct_load(sk + 8 * r, k, AES_CT_GRP);
+  }
+  memset(k, 0, sizeof(k));
+}
+
+//----------------------------------------------------------------------
+void aes_ct_encrypt_blks(const uint64_t *sk, const int rounds,
+    const unsigned char *in, unsigned char *out, const unsigned nblk)
+{
+  uint64_t q[8];
+  for (unsigned i = 0; i < nblk; i += AES_CT_GRP) {
+    const unsigned n = (nblk - i < AES_CT_GRP) ? nblk - i : AES_CT_GRP;
+    aes_ct_load(q, in + i * AES_CT_BLK, n);
+    aes_ct_encrypt_grp(sk, rounds, q);
+    aes_ct_store(q, out + i * AES_CT_BLK, n);
+  }
+  memset(q, 0, sizeof(q));
+}
+
+//----------------------------------------------------------------------
+void aes_ct_ctr32(const uint64_t *sk, const int rounds,
+    const unsigned char *in, unsigned char *out, const unsigned long len,
+    const unsigned char ctr[16], const int ctr_le)
+{
+  unsigned char cb[AES_CT_BATCH * AES_CT_BLK], ks[AES_CT_BATCH * AES_CT_BLK];
+  uint32_t c;
+  if (ctr_le) {
+    c = (uint32_t) ctr[0] | (uint32_t) ctr[1] << 8 | (uint32_t) ctr[2] << 16
+        | (uint32_t) ctr[3] << 24;
+  } else {
+    c = (uint32_t) ctr[12] << 24 | (uint32_t) ctr[13] << 16
+        | (uint32_t) ctr[14] << 8 | (uint32_t) ctr[15];
+  }
+  for (unsigned long i = 0; i < len;) {
+    const unsigned long rem = len - i;
+    const unsigned n = (rem >= sizeof(ks)) ?
+        AES_CT_BATCH : (unsigned) ((rem + AES_CT_BLK - 1) / AES_CT_BLK);
+    for (unsigned j = 0; j < n; ++j, ++c) {
+      unsigned char *b = cb + j * AES_CT_BLK;
+      memcpy(b, ctr, AES_CT_BLK);
+      if (ctr_le) {
+        b[0] = (unsigned char) c;
+        b[1] = (unsigned char) (c >> 8);
+        b[2] = (unsigned char) (c >> 16);
+        b[3] = (unsigned char) (c >> 24);
+      } else {
+        b[12] = (unsigned char) (c >> 24);
+        b[13] = (unsigned char) (c >> 16);
+        b[14] = (unsigned char) (c >> 8);
+        b[15] = (unsigned char) c;
+      }
+    }
+    aes_ct_encrypt_blks(sk, rounds, cb, ks, n);
+    const unsigned long m = (rem < sizeof(ks)) ? rem : sizeof(ks);
+    for (unsigned long j = 0; j < m; ++j) {
+      out[i + j] = in[i + j] ^ ks[j];
+    }
+    i += m;
+  }
+  memset(ks, 0, sizeof(ks));
+}
@@ -0,0 +1,99 @@
+/* Copyright (c) IAIK, Graz University of Technology, 2015.
+ * All rights reserved.
+ * Contact: http://opensource.iaik.tugraz.at
+ * 
+ * This file is part of the Secure Block Device Library.
+ * 
+ * Commercial License Usage
+ * Licensees holding valid commercial licenses may use this file in
+ * accordance with the commercial license agreement provided with the
+ * Software or, alternatively, in accordance with the terms contained in
+ * a written agreement between you and SIC. For further information
+ * contact us at http://opensource.iaik.tugraz.at.
+ * 
+ * Alternatively, this file may be used under the terms of the GNU General
+ * Public License as published by the Free Software Foundation version 2.
+ * 
+ * The Secure Block Device Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with the Secure Block Device Library. If not, see <http://www.gnu.org/licenses/>.
+ */
+///
+/// \file
+/// \brief Specifies a bitsliced, constant time AES encryption implementation
+/// used if the CPU does not support AES-NI.
+///
+/// The table driven reference implementation leaks its key through cache
+/// timing, and it slows down considerably once the cache is contended. The
+/// bitsliced implementation evaluates the S-box as a boolean circuit
+/// (Boyar and Peralta) on 64 bit words that hold one bit of every state byte
+/// of four blocks, so it performs no secret dependent memory accesses or
+/// branches. A single block costs as much as four blocks, so bulk callers
+/// should use the batch entry points.
+///
+#ifndef AES_CT_H_
+#define AES_CT_H_
+
+#include <stdint.h>
+
+#define AES_CT_BATCH 8 //!< The maximum number of blocks of a batch
+#define AES_CT_SKEY_WORDS(rounds) (((rounds) + 1) * 8) //!< The number of 64 bit words of a bitsliced key schedule
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*!
+ * \brief Converts an encryption key schedule of the reference implementation
+ * into a bitsliced key schedule
+ *
+ * @param sk[out] the bitsliced key schedule (AES_CT_SKEY_WORDS(rounds) words)
+ * @param rk[in] the key schedule computed by rijndaelKeySetupEnc
+ * @param rounds[in] the number of rounds of the key schedule
+ */
+void aes_ct_keysched(uint64_t *sk, const uint32_t *rk, const int rounds);
+
+/*!
+ * \brief Encrypts up to AES_CT_BATCH independent blocks
+ *
+ * @param sk[in] the bitsliced key schedule
+ * @param rounds[in] the number of rounds of the key schedule
+ * @param in[in] the plaintext blocks (nblk * 16 bytes)
+ * @param out[out] the ciphertext blocks (may be equal to in)
+ * @param nblk[in] the number of blocks to encrypt (at most AES_CT_BATCH)
+ */
+void aes_ct_encrypt_blks(const uint64_t *sk, const int rounds,
+    const unsigned char *in, unsigned char *out, const unsigned nblk);
+
+/*!
+ * \brief Runs AES in CTR mode with a 32 bit block counter
+ *
+ * The counter handling is identical to aes_ni_ctr32: the counter is either
+ * the last word of the counter block in big endian order (as in GCM and SIV)
+ * or the first word in little endian order (as in AES-GCM-SIV), and it is
+ * incremented modulo 2^32 after each block. The key stream is computed
+ * AES_CT_BATCH blocks at a time.
+ *
+ * @param sk[in] the bitsliced key schedule
+ * @param rounds[in] the number of rounds of the key schedule
+ * @param in[in] the input
+ * @param out[out] the output (may be equal to in)
+ * @param len[in] the length of the input in bytes (need not be a multiple
+ * of 16)
+ * @param ctr[in] the initial 16 byte counter block
+ * @param ctr_le[in] non-zero to use the little endian counter of the first
+ * word
+ */
+void aes_ct_ctr32(const uint64_t *sk, const int rounds,
+    const unsigned char *in, unsigned char *out, const unsigned long len,
+    const unsigned char ctr[16], const int ctr_le);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AES_CT_H_ */
@@ -0,0 +1,300 @@
+/* Copyright (c) IAIK, Graz University of Technology, 2015.
+ * All rights reserved.
+ * Contact: http://opensource.iaik.tugraz.at
+ * 
+ * This file is part of the Secure Block Device Library.
+ * 
+ * Commercial License Usage
+ * Licensees holding valid commercial licenses may use this file in
+ * accordance with the commercial license agreement provided with the
+ * Software or, alternatively, in accordance with the terms contained in
+ * a written agreement between you and SIC. For further information
+ * contact us at http://opensource.iaik.tugraz.at.
+ * 
+ * Alternatively, this file may be used under the terms of the GNU General
+ * Public License as published by the Free Software Foundation version 2.
+ * 
+ * The Secure Block Device Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with the Secure Block Device Library. If not, see <http://www.gnu.org/licenses/>.
+ */
+///
+/// \file
+/// \brief Implements the AES-NI accelerated AES kernels used by the
+/// cryptographic abstraction layers.
+///
+#include "aes_ni.h"
+
+#if AES_NI_SUPPORTED
+# include <cpuid.h>
+# include <immintrin.h>
+# include <stdint.h>
+# include <string.h>
+#endif
+
+#if AES_NI_SUPPORTED
+//----------------------------------------------------------------------
+int aes_ni_is_available(void)
+{
+  static int available = -1;
+  if (available < 0) {
+    unsigned int eax, ebx, ecx, edx;
+    available = __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_AES)
+        && (ecx & bit_SSSE3);
+  }
+  return available;
+}
+
+/*!
+ * \brief Converts a key schedule of aes.h into AES-NI round keys
+ *
+ * The reference implementation stores each round key word as a host
+ * endianess integer with the first key byte in the most significant
+ * position. AES-NI expects the round keys as plain byte strings.
+ *
+ * @param key[in] the key schedule to convert
+ * @param rk[out] the AES-NI round keys (key->rounds + 1 entries)
+ */
+__attribute__((target("aes,ssse3")))
+static inline void aes_ni_load_key(const AES_KEY *key, __m128i rk[AES_MAXNR + 1])
+{
+  const __m128i bswap32 = _mm_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6,
+      7, 0, 1, 2, 3);
+  for (int i = 0; i <= key->rounds; ++i) {
+    rk[i] = _mm_shuffle_epi8(
+        _mm_loadu_si128((const __m128i *) &key->key[4 * i]), bswap32);
+  }
+}
+
+//----------------------------------------------------------------------
+__attribute__((target("aes,ssse3")))
+void aes_ni_cbc_encrypt_x8(const AES_KEY *key,
+    const unsigned char *const in[AES_NI_CBC_LANES],
+    unsigned char *const out[AES_NI_CBC_LANES], const unsigned long nblk,
+    unsigned char iv[AES_NI_CBC_LANES][AES_BLOCK_SIZE])
+{
+  __m128i rk[AES_MAXNR + 1];
+  __m128i s[AES_NI_CBC_LANES];
+  aes_ni_load_key(key, rk);
+  const int nr = key->rounds;
+
+  for (int l = 0; l < AES_NI_CBC_LANES; ++l) {
+    s[l] = _mm_loadu_si128((const __m128i *) iv[l]);
+  }
+  for (unsigned long j = 0; j < nblk; ++j) {
+    const unsigned long o = j * AES_BLOCK_SIZE;
+    for (int l = 0; l < AES_NI_CBC_LANES; ++l) {
+      s[l] = _mm_xor_si128(s[l], _mm_loadu_si128((const __m128i *) (in[l] + o)));
+      s[l] = _mm_xor_si128(s[l], rk[0]);
+    }
+    for (int r = 1; r < nr; ++r) {
+      for (int l = 0; l < AES_NI_CBC_LANES; ++l) {
+        s[l] = _mm_aesenc_si128(s[l], rk[r]);
+      }
+    }
+    for (int l = 0; l < AES_NI_CBC_LANES; ++l) {
+      s[l] = _mm_aesenclast_si128(s[l], rk[nr]);
+      if (out[l]) {
+        _mm_storeu_si128((__m128i *) (out[l] + o), s[l]);
+      }
+    }
+  }
+  for (int l = 0; l < AES_NI_CBC_LANES; ++l) {
+    _mm_storeu_si128((__m128i *) iv[l], s[l]);
+  }
+}
+
+//----------------------------------------------------------------------
+__attribute__((target("aes,ssse3")))
+void aes_ni_cbc_decrypt(const AES_KEY *key, const unsigned char *in,
+    unsigned char *out, const unsigned long nblk,
+    unsigned char iv[AES_BLOCK_SIZE])
+{
+  __m128i rk[AES_MAXNR + 1];
+  // The reference decryption key schedule already is the key schedule of
+  // the equivalent inverse cipher AESDEC expects
+  aes_ni_load_key(key, rk);
+  const int nr = key->rounds;
+  __m128i prev = _mm_loadu_si128((const __m128i *) iv);
+
+  unsigned long j = 0;
+  for (; nblk - j >= AES_NI_CBC_LANES; j += AES_NI_CBC_LANES) {
+    __m128i c[AES_NI_CBC_LANES], s[AES_NI_CBC_LANES];
+    const unsigned char *ib = in + j * AES_BLOCK_SIZE;
+    for (int l = 0; l < AES_NI_CBC_LANES; ++l) {
+      c[l] = _mm_loadu_si128((const __m128i *) (ib + l * AES_BLOCK_SIZE));
+      s[l] = _mm_xor_si128(c[l], rk[0]);
+    }
+    for (int r = 1; r < nr; ++r) {
+      for (int l = 0; l < AES_NI_CBC_LANES; ++l) {
+        s[l] = _mm_aesdec_si128(s[l], rk[r]);
+      }
+    }
+    // All ciphertext blocks are loaded before the first store, so the
+    // decryption may run in place
+    unsigned char *ob = out + j * AES_BLOCK_SIZE;
+    for (int l = 0; l < AES_NI_CBC_LANES; ++l) {
+      s[l] = _mm_aesdeclast_si128(s[l], rk[nr]);
+      _mm_storeu_si128((__m128i *) (ob + l * AES_BLOCK_SIZE),
+          _mm_xor_si128(s[l], l ? c[l - 1] : prev));
+    }
+    prev = c[AES_NI_CBC_LANES - 1];
+  }
+  for (; j < nblk; ++j) {
+    const __m128i c = _mm_loadu_si128(
+        (const __m128i *) (in + j * AES_BLOCK_SIZE));
+    __m128i s = _mm_xor_si128(c, rk[0]);
+    for (int r = 1; r < nr; ++r) {
+      s = _mm_aesdec_si128(s, rk[r]);
+    }
+    s = _mm_aesdeclast_si128(s, rk[nr]);
+    _mm_storeu_si128((__m128i *) (out + j * AES_BLOCK_SIZE),
+        _mm_xor_si128(s, prev));
+    prev = c;
+  }
+  _mm_storeu_si128((__m128i *) iv, prev);
+}
+
+//----------------------------------------------------------------------
+__attribute__((target("aes,ssse3")))
+void aes_ni_ctr_cbcmac(const AES_KEY *ctr_key, const unsigned char *in,
+    unsigned char *out, const unsigned long nblk,
+    const unsigned char ctr[AES_BLOCK_SIZE], const AES_KEY *mac_key,
+    const unsigned long nmac,
+    unsigned char mac[AES_BLOCK_SIZE])
+{
+  __m128i ck[AES_MAXNR + 1], mk[AES_MAXNR + 1];
+  aes_ni_load_key(ctr_key, ck);
+  aes_ni_load_key(mac_key, mk);
+  const int cnr = ctr_key->rounds;
+  const int mnr = mac_key->rounds;
+  const int fuse = (cnr == mnr);
+
+  unsigned char cb[AES_BLOCK_SIZE];
+  memcpy(cb, ctr, AES_BLOCK_SIZE);
+  uint32_t inc = ((uint32_t) cb[12] << 24) | ((uint32_t) cb[13] << 16)
+      | ((uint32_t) cb[14] << 8) | cb[15];
+  __m128i m = _mm_loadu_si128((const __m128i *) mac);
+  // The block the MAC absorbs next. The MAC lags one block behind the CTR
+  // part, so that it can absorb the output of the previous iteration without
+  // a round trip through memory.
+  __m128i prev = _mm_setzero_si128();
+
+  for (unsigned long j = 0; j <= nblk; ++j) {
+    const int do_ctr = j < nblk;
+    const int do_mac = j > 0 && j <= nmac;
+    __m128i k = _mm_loadu_si128((const __m128i *) cb);
+    if (do_mac) {
+      m = _mm_xor_si128(m, prev);
+    }
+    if (do_ctr && do_mac && fuse) {
+      k = _mm_xor_si128(k, ck[0]);
+      m = _mm_xor_si128(m, mk[0]);
+      for (int r = 1; r < cnr; ++r) {
+        k = _mm_aesenc_si128(k, ck[r]);
+        m = _mm_aesenc_si128(m, mk[r]);
+      }
+      k = _mm_aesenclast_si128(k, ck[cnr]);
+      m = _mm_aesenclast_si128(m, mk[mnr]);
+    } else {
+      if (do_ctr) {
+        k = _mm_xor_si128(k, ck[0]);
+        for (int r = 1; r < cnr; ++r) {
+          k = _mm_aesenc_si128(k, ck[r]);
+        }
+        k = _mm_aesenclast_si128(k, ck[cnr]);
+      }
+      if (do_mac) {
+        m = _mm_xor_si128(m, mk[0]);
+        for (int r = 1; r < mnr; ++r) {
+          m = _mm_aesenc_si128(m, mk[r]);
+        }
+        m = _mm_aesenclast_si128(m, mk[mnr]);
+      }
+    }
+    if (do_ctr) {
+      const unsigned long o = j * AES_BLOCK_SIZE;
+      prev = _mm_xor_si128(k, _mm_loadu_si128((const __m128i *) (in + o)));
+      _mm_storeu_si128((__m128i *) (out + o), prev);
+      inc++;
+      cb[12] = (unsigned char) (inc >> 24);
+      cb[13] = (unsigned char) (inc >> 16);
+      cb[14] = (unsigned char) (inc >> 8);
+      cb[15] = (unsigned char) inc;
+    }
+  }
+
+  _mm_storeu_si128((__m128i *) mac, m);
+}
+
+#define AES_NI_CTR_LANES 8
+
+//----------------------------------------------------------------------
+__attribute__((target("aes,ssse3")))
+void aes_ni_ctr32(const AES_KEY *key, const unsigned char *in,
+    unsigned char *out, const unsigned long len,
+    const unsigned char ctr[AES_BLOCK_SIZE], const int ctr_le)
+{
+  __m128i rk[AES_MAXNR + 1];
+  aes_ni_load_key(key, rk);
+  const int nr = key->rounds;
+  // The counter is kept as a host order integer in one of the 32 bit lanes,
+  // so that it can be incremented (and wraps) with a single addition
+  const __m128i swap = ctr_le ?
+      _mm_set_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0) :
+      _mm_set_epi8(12, 13, 14, 15, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+  const __m128i one = ctr_le ?
+      _mm_set_epi32(0, 0, 0, 1) : _mm_set_epi32(1, 0, 0, 0);
+  __m128i cb = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) ctr), swap);
+
+  unsigned long i = 0;
+  for (; len - i >= AES_NI_CTR_LANES * AES_BLOCK_SIZE;
+      i += AES_NI_CTR_LANES * AES_BLOCK_SIZE) {
+    __m128i k[AES_NI_CTR_LANES];
+    for (int j = 0; j < AES_NI_CTR_LANES; ++j) {
+      k[j] = _mm_xor_si128(_mm_shuffle_epi8(cb, swap), rk[0]);
+      cb = _mm_add_epi32(cb, one);
+    }
+    for (int r = 1; r < nr; ++r) {
+      for (int j = 0; j < AES_NI_CTR_LANES; ++j) {
+        k[j] = _mm_aesenc_si128(k[j], rk[r]);
+      }
+    }
+    for (int j = 0; j < AES_NI_CTR_LANES; ++j) {
+      const unsigned long o = i + j * AES_BLOCK_SIZE;
+      k[j] = _mm_aesenclast_si128(k[j], rk[nr]);
+      _mm_storeu_si128((__m128i *) (out + o),
+          _mm_xor_si128(k[j], _mm_loadu_si128((const __m128i *) (in + o))));
+    }
+  }
+  for (; i < len; i += AES_BLOCK_SIZE) {
+    __m128i k = _mm_xor_si128(_mm_shuffle_epi8(cb, swap), rk[0]);
+    cb = _mm_add_epi32(cb, one);
+    for (int r = 1; r < nr; ++r) {
+      k = _mm_aesenc_si128(k, rk[r]);
+    }
+    k = _mm_aesenclast_si128(k, rk[nr]);
+    if (len - i >= AES_BLOCK_SIZE) {
+      _mm_storeu_si128((__m128i *) (out + i),
+          _mm_xor_si128(k, _mm_loadu_si128((const __m128i *) (in + i))));
+    } else {
+      unsigned char ks[AES_BLOCK_SIZE];
+      _mm_storeu_si128((__m128i *) ks, k);
+      for (unsigned long j = 0; j < len - i; ++j) {
+        out[i + j] = in[i + j] ^ ks[j];
+      }
+    }
+  }
+}
+
+#else
+//----------------------------------------------------------------------
+int aes_ni_is_available(void)
+{
+  return 0;
+}
+#endif
@@ -0,0 +1,147 @@
+/* Copyright (c) IAIK, Graz University of Technology, 2015.
+ * All rights reserved.
+ * Contact: http://opensource.iaik.tugraz.at
+ * 
+ * This file is part of the Secure Block Device Library.
+ * 
+ * Commercial License Usage
+ * Licensees holding valid commercial licenses may use this file in
+ * accordance with the commercial license agreement provided with the
+ * Software or, alternatively, in accordance with the terms contained in
+ * a written agreement between you and SIC. For further information
+ * contact us at http://opensource.iaik.tugraz.at.
+ * 
+ * Alternatively, this file may be used under the terms of the GNU General
+ * Public License as published by the Free Software Foundation version 2.
+ * 
+ * The Secure Block Device Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with the Secure Block Device Library. If not, see <http://www.gnu.org/licenses/>.
+ */
+///
+/// \file
+/// \brief Specifies the AES-NI accelerated AES kernels used by the
+/// cryptographic abstraction layers.
+///
+/// The kernels operate on the key schedules of aes.h, so callers do not need
+/// to maintain a second set of round keys. Use aes_ni_is_available to check
+/// if the CPU supports the instructions before calling any of the kernels.
+///
+#ifndef AES_NI_H_
+#define AES_NI_H_
+
+#include "aes.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+# define AES_NI_SUPPORTED 1
+#else
+# define AES_NI_SUPPORTED 0
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*!
+ * \brief Determines if the CPU supports the AES-NI and SSSE3 instructions
+ *
+ * @return non-zero if the AES-NI kernels can be used; zero otherwise
+ */
+int aes_ni_is_available(void);
+
+#if AES_NI_SUPPORTED
+#define AES_NI_CBC_LANES 8 //!< The number of blocks the CBC kernels process in parallel
+
+/*!
+ * \brief Runs AES_NI_CBC_LANES independent CBC encryptions in lock-step
+ *
+ * Each lane l computes iv[l] = AES_{key}(iv[l] ^ in[l][j]) for all nblk
+ * blocks j and stores the intermediate results in out[l] unless out[l] is
+ * NULL. Leaving out[l] NULL turns the lane into a CBC-MAC. The round
+ * functions of the lanes are interleaved to hide the AES latency.
+ *
+ * @param key[in] the AES encryption key schedule
+ * @param in[in] the input of the lanes (nblk blocks each)
+ * @param out[out] the output of the lanes (can be NULL)
+ * @param nblk[in] the number of blocks to process per lane
+ * @param iv[inout] the chaining values of the lanes
+ */
+void aes_ni_cbc_encrypt_x8(const AES_KEY *key,
+    const unsigned char *const in[AES_NI_CBC_LANES],
+    unsigned char *const out[AES_NI_CBC_LANES], const unsigned long nblk,
+    unsigned char iv[AES_NI_CBC_LANES][AES_BLOCK_SIZE]);
+
+/*!
+ * \brief Runs a CBC decryption of nblk whole blocks
+ *
+ * Unlike CBC encryption, the block decryptions are independent, so
+ * AES_NI_CBC_LANES of them are interleaved.
+ *
+ * @param key[in] the AES decryption key schedule (AES_set_decrypt_key)
+ * @param in[in] the ciphertext (nblk blocks)
+ * @param out[out] the plaintext (nblk blocks, may be equal to in)
+ * @param nblk[in] the number of blocks to decrypt
+ * @param iv[inout] the initialization vector; receives the last ciphertext
+ * block
+ */
+void aes_ni_cbc_decrypt(const AES_KEY *key, const unsigned char *in,
+    unsigned char *out, const unsigned long nblk,
+    unsigned char iv[AES_BLOCK_SIZE]);
+
+/*!
+ * \brief Runs a CTR mode decryption and a CBC-MAC over the result in a
+ * single pass
+ *
+ * The CTR part decrypts nblk blocks from in to out. The counter block starts
+ * at ctr and its last 32 bit word is incremented modulo 2^32 (big endian)
+ * after each block, as the SIV mode requires. The CBC-MAC part computes
+ * mac = AES_{mac_key}(mac ^ out[j]) for the first nmac output blocks. Every
+ * block is loaded once and the rounds of both AES pipelines are interleaved.
+ *
+ * @param ctr_key[in] the AES encryption key schedule of the CTR part
+ * @param in[in] the CTR input (nblk blocks)
+ * @param out[out] the CTR output (nblk blocks, may be equal to in)
+ * @param nblk[in] the number of blocks to process in CTR mode
+ * @param ctr[in] the initial counter block
+ * @param mac_key[in] the AES encryption key schedule of the CBC-MAC part
+ * @param nmac[in] the number of blocks to MAC (at most nblk)
+ * @param mac[inout] the CBC-MAC chaining value
+ */
+void aes_ni_ctr_cbcmac(const AES_KEY *ctr_key, const unsigned char *in,
+    unsigned char *out, const unsigned long nblk,
+    const unsigned char ctr[AES_BLOCK_SIZE], const AES_KEY *mac_key,
+    const unsigned long nmac,
+    unsigned char mac[AES_BLOCK_SIZE]);
+
+/*!
+ * \brief Runs AES in CTR mode with a 32 bit block counter
+ *
+ * The counter is either the last word of the counter block in big endian
+ * order (as in GCM and SIV) or the first word in little endian order (as in
+ * AES-GCM-SIV). It is incremented modulo 2^32 after each block; the other
+ * bytes of the counter block stay fixed. Eight blocks are encrypted at a
+ * time to hide the AES latency.
+ *
+ * @param key[in] the AES encryption key schedule
+ * @param in[in] the input
+ * @param out[out] the output (may be equal to in)
+ * @param len[in] the length of the input in bytes (need not be a multiple
+ * of AES_BLOCK_SIZE)
+ * @param ctr[in] the initial counter block
+ * @param ctr_le[in] non-zero to use the little endian counter of the first
+ * word
+ */
+void aes_ni_ctr32(const AES_KEY *key, const unsigned char *in,
+    unsigned char *out, const unsigned long len,
+    const unsigned char ctr[AES_BLOCK_SIZE], const int ctr_le);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AES_NI_H_ */
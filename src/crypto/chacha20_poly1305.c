@@ -0,0 +1,678 @@
+/* Copyright (c) IAIK, Graz University of Technology, 2015.
+ * All rights reserved.
+ * Contact: http://opensource.iaik.tugraz.at
+ * 
+ * This file is part of the Secure Block Device Library.
+ * 
+ * Commercial License Usage
+ * Licensees holding valid commercial licenses may use this file in
+ * accordance with the commercial license agreement provided with the
+ * Software or, alternatively, in accordance with the terms contained in
+ * a written agreement between you and SIC. For further information
+ * contact us at http://opensource.iaik.tugraz.at.
+ * 
+ * Alternatively, this file may be used under the terms of the GNU General
+ * Public License as published by the Free Software Foundation version 2.
+ * 
+ * The Secure Block Device Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with the Secure Block Device Library. If not, see <http://www.gnu.org/licenses/>.
+ */
+///
+/// \file
+/// \brief Implements ChaCha20-Poly1305 (RFC 8439) authenticated encryption.
+///
+/// The SIMD ChaCha20 kernels keep word i of four (SSE2) or eight (AVX2)
+/// consecutive key stream blocks in vector i and transpose the blocks only
+/// for the final XOR. The AVX2 Poly1305 kernel splits the message into four
+/// interleaved block streams, multiplies each stream with r^4 per step and
+/// combines them with r^4 .. r^1 at the end. Both produce the same results
+/// as the portable code.
+///
+#include "chacha20_poly1305.h"
+
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+# define CHACHA20_SIMD_SUPPORTED 1
+# include <cpuid.h>
+# include <immintrin.h>
+#else
+# define CHACHA20_SIMD_SUPPORTED 0
+#endif
+
+#define POLY1305_BLOCK_SIZE 16
+#define POLY1305_MASK26     0x3ffffff
+#define POLY1305_HIBIT      (1u << 24)
+
+static const uint32_t chacha20_sigma[4] = { 0x61707865, 0x3320646e,
+    0x79622d32, 0x6b206574 };
+
+static inline uint32_t chacha20_load_le32(const unsigned char *p)
+{
+  return (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16)
+      | ((uint32_t) p[3] << 24);
+}
+
+static inline void chacha20_store_le32(unsigned char *p, const uint32_t v)
+{
+  p[0] = (unsigned char) v;
+  p[1] = (unsigned char) (v >> 8);
+  p[2] = (unsigned char) (v >> 16);
+  p[3] = (unsigned char) (v >> 24);
+}
+
+static inline uint32_t chacha20_rotl(const uint32_t v, const int n)
+{
+  return (v << n) | (v >> (32 - n));
+}
+
+#define CHACHA20_QR(a, b, c, d) do {                   \
+    a += b; d ^= a; d = chacha20_rotl(d, 16);          \
+    c += d; b ^= c; b = chacha20_rotl(b, 12);          \
+    a += b; d ^= a; d = chacha20_rotl(d, 8);           \
+    c += d; b ^= c; b = chacha20_rotl(b, 7);           \
+  } while (0)
+
+/*!
+ * \brief Sets up the ChaCha20 input state for the given nonce and counter
+ */
+static void chacha20_setup(const chacha20_poly1305_ctx *ctx,
+    const unsigned char *nonce, const uint32_t ctr, uint32_t s[16])
+{
+  memcpy(s, chacha20_sigma, sizeof(chacha20_sigma));
+  memcpy(s + 4, ctx->key, sizeof(ctx->key));
+  s[12] = ctr;
+  s[13] = chacha20_load_le32(nonce);
+  s[14] = chacha20_load_le32(nonce + 4);
+  s[15] = chacha20_load_le32(nonce + 8);
+}
+
+/*!
+ * \brief Computes a single ChaCha20 key stream block
+ */
+static void chacha20_block(const uint32_t s[16],
+    unsigned char ks[CHACHA20_BLOCK_SIZE])
+{
+  uint32_t x[16];
+  memcpy(x, s, sizeof(x));
+  for (int i = 0; i < 10; ++i) {
+    CHACHA20_QR(x[0], x[4], x[8], x[12]);
+    CHACHA20_QR(x[1], x[5], x[9], x[13]);
+    CHACHA20_QR(x[2], x[6], x[10], x[14]);
+    CHACHA20_QR(x[3], x[7], x[11], x[15]);
+    CHACHA20_QR(x[0], x[5], x[10], x[15]);
+    CHACHA20_QR(x[1], x[6], x[11], x[12]);
+    CHACHA20_QR(x[2], x[7], x[8], x[13]);
+    CHACHA20_QR(x[3], x[4], x[9], x[14]);
+  }
+  for (int i = 0; i < 16; ++i) {
+    chacha20_store_le32(ks + 4 * i, x[i] + s[i]);
+  }
+  memset(x, 0, sizeof(x));
+}
+
+#if CHACHA20_SIMD_SUPPORTED
+#define CHACHA20_SSE2_ROTL(v, n) \
+  _mm_or_si128(_mm_slli_epi32(v, n), _mm_srli_epi32(v, 32 - (n)))
+
+#define CHACHA20_SSE2_QR(a, b, c, d) do {                                   \
+    a = _mm_add_epi32(a, b); d = _mm_xor_si128(d, a); d = CHACHA20_SSE2_ROTL(d, 16); \
+    c = _mm_add_epi32(c, d); b = _mm_xor_si128(b, c); b = CHACHA20_SSE2_ROTL(b, 12); \
+    a = _mm_add_epi32(a, b); d = _mm_xor_si128(d, a); d = CHACHA20_SSE2_ROTL(d, 8);  \
+    c = _mm_add_epi32(c, d); b = _mm_xor_si128(b, c); b = CHACHA20_SSE2_ROTL(b, 7);  \
+  } while (0)
+
+/*!
+ * \brief XORs four consecutive key stream blocks onto 256 bytes of input
+ *
+ * @param s[inout] the input state; the block counter is advanced by four
+ */
+__attribute__((target("sse2")))
+static void chacha20_sse2_4blk(uint32_t s[16], const unsigned char *in,
+    unsigned char *out)
+{
+  __m128i x[16], o[16];
+  for (int i = 0; i < 16; ++i) {
+    o[i] = _mm_set1_epi32((int) s[i]);
+  }
+  o[12] = _mm_add_epi32(o[12], _mm_set_epi32(3, 2, 1, 0));
+  memcpy(x, o, sizeof(x));
+  for (int i = 0; i < 10; ++i) {
+    CHACHA20_SSE2_QR(x[0], x[4], x[8], x[12]);
+    CHACHA20_SSE2_QR(x[1], x[5], x[9], x[13]);
+    CHACHA20_SSE2_QR(x[2], x[6], x[10], x[14]);
+    CHACHA20_SSE2_QR(x[3], x[7], x[11], x[15]);
+    CHACHA20_SSE2_QR(x[0], x[5], x[10], x[15]);
+    CHACHA20_SSE2_QR(x[1], x[6], x[11], x[12]);
+    CHACHA20_SSE2_QR(x[2], x[7], x[8], x[13]);
+    CHACHA20_SSE2_QR(x[3], x[4], x[9], x[14]);
+  }
+  for (int g = 0; g < 16; g += 4) {
+    const __m128i a = _mm_add_epi32(x[g], o[g]);
+    const __m128i b = _mm_add_epi32(x[g + 1], o[g + 1]);
+    const __m128i c = _mm_add_epi32(x[g + 2], o[g + 2]);
+    const __m128i d = _mm_add_epi32(x[g + 3], o[g + 3]);
+    const __m128i t0 = _mm_unpacklo_epi32(a, b);
+    const __m128i t1 = _mm_unpacklo_epi32(c, d);
+    const __m128i t2 = _mm_unpackhi_epi32(a, b);
+    const __m128i t3 = _mm_unpackhi_epi32(c, d);
+    const __m128i k[4] = { _mm_unpacklo_epi64(t0, t1), _mm_unpackhi_epi64(t0,
+        t1), _mm_unpacklo_epi64(t2, t3), _mm_unpackhi_epi64(t2, t3) };
+    for (int j = 0; j < 4; ++j) {
+      const int off = j * CHACHA20_BLOCK_SIZE + g * 4;
+      _mm_storeu_si128((__m128i *) (out + off),
+          _mm_xor_si128(k[j], _mm_loadu_si128((const __m128i *) (in + off))));
+    }
+  }
+  s[12] += 4;
+}
+
+#define CHACHA20_AVX2_QR(a, b, c, d) do {                                   \
+    a = _mm256_add_epi32(a, b); d = _mm256_xor_si256(d, a);                 \
+    d = _mm256_shuffle_epi8(d, rot16);                                      \
+    c = _mm256_add_epi32(c, d); b = _mm256_xor_si256(b, c);                 \
+    b = _mm256_or_si256(_mm256_slli_epi32(b, 12), _mm256_srli_epi32(b, 20)); \
+    a = _mm256_add_epi32(a, b); d = _mm256_xor_si256(d, a);                 \
+    d = _mm256_shuffle_epi8(d, rot8);                                       \
+    c = _mm256_add_epi32(c, d); b = _mm256_xor_si256(b, c);                 \
+    b = _mm256_or_si256(_mm256_slli_epi32(b, 7), _mm256_srli_epi32(b, 25)); \
+  } while (0)
+
+/*!
+ * \brief XORs eight consecutive key stream blocks onto 512 bytes of input
+ *
+ * @param s[inout] the input state; the block counter is advanced by eight
+ */
+__attribute__((target("avx2")))
+static void chacha20_avx2_8blk(uint32_t s[16], const unsigned char *in,
+    unsigned char *out)
+{
+  const __m256i rot16 = _mm256_set_epi8(13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7,
+      6, 1, 0, 3, 2, 13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2);
+  const __m256i rot8 = _mm256_set_epi8(14, 13, 12, 15, 10, 9, 8, 11, 6, 5, 4,
+      7, 2, 1, 0, 3, 14, 13, 12, 15, 10, 9, 8, 11, 6, 5, 4, 7, 2, 1, 0, 3);
+  __m256i x[16], o[16];
+  for (int i = 0; i < 16; ++i) {
+    o[i] = _mm256_set1_epi32((int) s[i]);
+  }
+  o[12] = _mm256_add_epi32(o[12], _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+  memcpy(x, o, sizeof(x));
+  for (int i = 0; i < 10; ++i) {
+    CHACHA20_AVX2_QR(x[0], x[4], x[8], x[12]);
+    CHACHA20_AVX2_QR(x[1], x[5], x[9], x[13]);
+    CHACHA20_AVX2_QR(x[2], x[6], x[10], x[14]);
+    CHACHA20_AVX2_QR(x[3], x[7], x[11], x[15]);
+    CHACHA20_AVX2_QR(x[0], x[5], x[10], x[15]);
+    CHACHA20_AVX2_QR(x[1], x[6], x[11], x[12]);
+    CHACHA20_AVX2_QR(x[2], x[7], x[8], x[13]);
+    CHACHA20_AVX2_QR(x[3], x[4], x[9], x[14]);
+  }
+  for (int g = 0; g < 16; g += 4) {
+    const __m256i a = _mm256_add_epi32(x[g], o[g]);
+    const __m256i b = _mm256_add_epi32(x[g + 1], o[g + 1]);
+    const __m256i c = _mm256_add_epi32(x[g + 2], o[g + 2]);
+    const __m256i d = _mm256_add_epi32(x[g + 3], o[g + 3]);
+    const __m256i t0 = _mm256_unpacklo_epi32(a, b);
+    const __m256i t1 = _mm256_unpacklo_epi32(c, d);
+    const __m256i t2 = _mm256_unpackhi_epi32(a, b);
+    const __m256i t3 = _mm256_unpackhi_epi32(c, d);
+    // Each 128 bit lane of k[j] holds the words g .. g + 3 of block j (low
+    // lane) and of block j + 4 (high lane)
+    const __m256i k[4] = { _mm256_unpacklo_epi64(t0, t1),
+        _mm256_unpackhi_epi64(t0, t1), _mm256_unpacklo_epi64(t2, t3),
+        _mm256_unpackhi_epi64(t2, t3) };
+    for (int j = 0; j < 4; ++j) {
+      const int lo = j * CHACHA20_BLOCK_SIZE + g * 4;
+      const int hi = lo + 4 * CHACHA20_BLOCK_SIZE;
+      _mm_storeu_si128((__m128i *) (out + lo),
+          _mm_xor_si128(_mm256_castsi256_si128(k[j]),
+              _mm_loadu_si128((const __m128i *) (in + lo))));
+      _mm_storeu_si128((__m128i *) (out + hi),
+          _mm_xor_si128(_mm256_extracti128_si256(k[j], 1),
+              _mm_loadu_si128((const __m128i *) (in + hi))));
+    }
+  }
+  s[12] += 8;
+}
+
+/*!
+ * \brief Reads the extended control register XCR0
+ *
+ * @return the register state components the operating system saves
+ */
+static inline uint64_t chacha20_xgetbv(void)
+{
+  uint32_t lo, hi;
+  __asm__ __volatile__ ("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+  return ((uint64_t) hi << 32) | lo;
+}
+
+//----------------------------------------------------------------------
+int chacha20_simd_level(void)
+{
+  static int level = -1;
+  if (level < 0) {
+    unsigned int eax, ebx, ecx, edx;
+    level = CHACHA20_SIMD_NONE;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(edx & bit_SSE2)) {
+      return level;
+    }
+    level = CHACHA20_SIMD_SSE2;
+    if (!(ecx & bit_OSXSAVE) || __get_cpuid_max(0, NULL) < 7
+        || (chacha20_xgetbv() & 0x6) != 0x6) {
+      return level;
+    }
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+    if (ebx & bit_AVX2) {
+      level = CHACHA20_SIMD_AVX2;
+    }
+  }
+  return level;
+}
+
+#else
+//----------------------------------------------------------------------
+int chacha20_simd_level(void)
+{
+  return CHACHA20_SIMD_NONE;
+}
+#endif
+
+//----------------------------------------------------------------------
+void chacha20_crypt(const chacha20_poly1305_ctx *ctx,
+    const unsigned char *nonce, const uint32_t ctr, const unsigned char *in,
+    unsigned char *out, const size_t len)
+{
+  uint32_t s[16];
+  unsigned char ks[CHACHA20_BLOCK_SIZE];
+  size_t i = 0;
+  chacha20_setup(ctx, nonce, ctr, s);
+#if CHACHA20_SIMD_SUPPORTED
+  if (ctx->simd >= CHACHA20_SIMD_AVX2) {
+    for (; len - i >= 8 * CHACHA20_BLOCK_SIZE; i += 8 * CHACHA20_BLOCK_SIZE) {
+      chacha20_avx2_8blk(s, in + i, out + i);
+    }
+  }
+  if (ctx->simd >= CHACHA20_SIMD_SSE2) {
+    for (; len - i >= 4 * CHACHA20_BLOCK_SIZE; i += 4 * CHACHA20_BLOCK_SIZE) {
+      chacha20_sse2_4blk(s, in + i, out + i);
+    }
+  }
+#endif
+  for (; i < len; i += CHACHA20_BLOCK_SIZE) {
+    const size_t n = (len - i < CHACHA20_BLOCK_SIZE) ? len - i : CHACHA20_BLOCK_SIZE;
+    chacha20_block(s, ks);
+    for (size_t j = 0; j < n; ++j) {
+      out[i + j] = in[i + j] ^ ks[j];
+    }
+    s[12]++;
+  }
+  memset(s, 0, sizeof(s));
+  memset(ks, 0, sizeof(ks));
+}
+
+/*!
+ * \brief Multiplies a and b modulo 2^130 - 5 in radix 2^26 and partially
+ * reduces the result
+ */
+static inline void poly1305_mul(uint32_t out[5], const uint32_t a[5],
+    const uint32_t b[5])
+{
+  const uint32_t s1 = b[1] * 5, s2 = b[2] * 5, s3 = b[3] * 5, s4 = b[4] * 5;
+  uint64_t d0 = (uint64_t) a[0] * b[0] + (uint64_t) a[1] * s4
+      + (uint64_t) a[2] * s3 + (uint64_t) a[3] * s2 + (uint64_t) a[4] * s1;
+  uint64_t d1 = (uint64_t) a[0] * b[1] + (uint64_t) a[1] * b[0]
+      + (uint64_t) a[2] * s4 + (uint64_t) a[3] * s3 + (uint64_t) a[4] * s2;
+  uint64_t d2 = (uint64_t) a[0] * b[2] + (uint64_t) a[1] * b[1]
+      + (uint64_t) a[2] * b[0] + (uint64_t) a[3] * s4 + (uint64_t) a[4] * s3;
+  uint64_t d3 = (uint64_t) a[0] * b[3] + (uint64_t) a[1] * b[2]
+      + (uint64_t) a[2] * b[1] + (uint64_t) a[3] * b[0] + (uint64_t) a[4] * s4;
+  uint64_t d4 = (uint64_t) a[0] * b[4] + (uint64_t) a[1] * b[3]
+      + (uint64_t) a[2] * b[2] + (uint64_t) a[3] * b[1] + (uint64_t) a[4] * b[0];
+  uint32_t c;
+  c = (uint32_t) (d0 >> 26); out[0] = (uint32_t) d0 & POLY1305_MASK26;
+  d1 += c; c = (uint32_t) (d1 >> 26); out[1] = (uint32_t) d1 & POLY1305_MASK26;
+  d2 += c; c = (uint32_t) (d2 >> 26); out[2] = (uint32_t) d2 & POLY1305_MASK26;
+  d3 += c; c = (uint32_t) (d3 >> 26); out[3] = (uint32_t) d3 & POLY1305_MASK26;
+  d4 += c; c = (uint32_t) (d4 >> 26); out[4] = (uint32_t) d4 & POLY1305_MASK26;
+  out[0] += c * 5;
+  c = out[0] >> 26;
+  out[0] &= POLY1305_MASK26;
+  out[1] += c;
+}
+
+/*!
+ * \brief Splits a 16 byte message block into radix 2^26 limbs
+ */
+static inline void poly1305_load(uint32_t l[5], const unsigned char *m,
+    const uint32_t hibit)
+{
+  l[0] = chacha20_load_le32(m) & POLY1305_MASK26;
+  l[1] = (chacha20_load_le32(m + 3) >> 2) & POLY1305_MASK26;
+  l[2] = (chacha20_load_le32(m + 6) >> 4) & POLY1305_MASK26;
+  l[3] = (chacha20_load_le32(m + 9) >> 6) & POLY1305_MASK26;
+  l[4] = (chacha20_load_le32(m + 12) >> 8) | hibit;
+}
+
+/*!
+ * \brief Absorbs complete message blocks with the portable code
+ */
+static void poly1305_blocks(poly1305_state *st, const unsigned char *m,
+    size_t len, const uint32_t hibit)
+{
+  uint32_t l[5];
+  for (; len >= POLY1305_BLOCK_SIZE; len -= POLY1305_BLOCK_SIZE) {
+    poly1305_load(l, m, hibit);
+    for (int i = 0; i < 5; ++i) {
+      st->h[i] += l[i];
+    }
+    poly1305_mul(st->h, st->h, st->r[0]);
+    m += POLY1305_BLOCK_SIZE;
+  }
+}
+
+#if CHACHA20_SIMD_SUPPORTED
+/*!
+ * \brief Loads limb k of four consecutive message blocks into the 64 bit
+ * lanes of a vector
+ */
+#define POLY1305_AVX2_LANES(l, k) \
+  _mm256_set_epi64x(l[3][k], l[2][k], l[1][k], l[0][k])
+
+/*!
+ * \brief Multiplies the four accumulators in h with the per lane factors in
+ * r (and 5 * r in s) and partially reduces the results
+ */
+__attribute__((target("avx2")))
+static inline void poly1305_avx2_mul(__m256i h[5], const __m256i r[5],
+    const __m256i s[5])
+{
+  const __m256i mask = _mm256_set1_epi64x(POLY1305_MASK26);
+  __m256i d[5];
+#define P(a, b) _mm256_mul_epu32(a, b)
+  d[0] = _mm256_add_epi64(_mm256_add_epi64(P(h[0], r[0]), P(h[1], s[4])),
+      _mm256_add_epi64(_mm256_add_epi64(P(h[2], s[3]), P(h[3], s[2])),
+          P(h[4], s[1])));
+  d[1] = _mm256_add_epi64(_mm256_add_epi64(P(h[0], r[1]), P(h[1], r[0])),
+      _mm256_add_epi64(_mm256_add_epi64(P(h[2], s[4]), P(h[3], s[3])),
+          P(h[4], s[2])));
+  d[2] = _mm256_add_epi64(_mm256_add_epi64(P(h[0], r[2]), P(h[1], r[1])),
+      _mm256_add_epi64(_mm256_add_epi64(P(h[2], r[0]), P(h[3], s[4])),
+          P(h[4], s[3])));
+  d[3] = _mm256_add_epi64(_mm256_add_epi64(P(h[0], r[3]), P(h[1], r[2])),
+      _mm256_add_epi64(_mm256_add_epi64(P(h[2], r[1]), P(h[3], r[0])),
+          P(h[4], s[4])));
+  d[4] = _mm256_add_epi64(_mm256_add_epi64(P(h[0], r[4]), P(h[1], r[3])),
+      _mm256_add_epi64(_mm256_add_epi64(P(h[2], r[2]), P(h[3], r[1])),
+          P(h[4], r[0])));
+#undef P
+  __m256i c = _mm256_srli_epi64(d[0], 26);
+  h[0] = _mm256_and_si256(d[0], mask);
+  for (int i = 1; i < 5; ++i) {
+    d[i] = _mm256_add_epi64(d[i], c);
+    c = _mm256_srli_epi64(d[i], 26);
+    h[i] = _mm256_and_si256(d[i], mask);
+  }
+  h[0] = _mm256_add_epi64(h[0], _mm256_add_epi64(c, _mm256_slli_epi64(c, 2)));
+  c = _mm256_srli_epi64(h[0], 26);
+  h[0] = _mm256_and_si256(h[0], mask);
+  h[1] = _mm256_add_epi64(h[1], c);
+}
+
+/*!
+ * \brief Absorbs a multiple of four complete message blocks with four
+ * interleaved accumulators
+ *
+ * @param len[in] the number of message bytes, a non-zero multiple of 64
+ */
+__attribute__((target("avx2")))
+static void poly1305_blocks_avx2(poly1305_state *st, const unsigned char *m,
+    size_t len)
+{
+  uint32_t l[4][5];
+  __m256i h[5], r4[5], s4[5], rf[5], sf[5];
+  for (int k = 0; k < 5; ++k) {
+    r4[k] = _mm256_set1_epi64x(st->r[3][k]);
+    s4[k] = _mm256_set1_epi64x(st->r[3][k] * 5);
+    // Lane j finally gets multiplied with r^(4 - j)
+    rf[k] = _mm256_set_epi64x(st->r[0][k], st->r[1][k], st->r[2][k],
+        st->r[3][k]);
+    sf[k] = _mm256_set_epi64x(st->r[0][k] * 5, st->r[1][k] * 5,
+        st->r[2][k] * 5, st->r[3][k] * 5);
+  }
+  for (int j = 0; j < 4; ++j) {
+    poly1305_load(l[j], m + j * POLY1305_BLOCK_SIZE, POLY1305_HIBIT);
+  }
+  for (int k = 0; k < 5; ++k) {
+    l[0][k] += st->h[k];
+    h[k] = POLY1305_AVX2_LANES(l, k);
+  }
+  m += 4 * POLY1305_BLOCK_SIZE;
+  len -= 4 * POLY1305_BLOCK_SIZE;
+  for (; len; len -= 4 * POLY1305_BLOCK_SIZE) {
+    poly1305_avx2_mul(h, r4, s4);
+    for (int j = 0; j < 4; ++j) {
+      poly1305_load(l[j], m + j * POLY1305_BLOCK_SIZE, POLY1305_HIBIT);
+    }
+    for (int k = 0; k < 5; ++k) {
+      h[k] = _mm256_add_epi64(h[k], POLY1305_AVX2_LANES(l, k));
+    }
+    m += 4 * POLY1305_BLOCK_SIZE;
+  }
+  poly1305_avx2_mul(h, rf, sf);
+  // Sum up the four lanes and reduce
+  uint64_t d[5];
+  for (int k = 0; k < 5; ++k) {
+    uint64_t t[4];
+    _mm256_storeu_si256((__m256i *) t, h[k]);
+    d[k] = t[0] + t[1] + t[2] + t[3];
+  }
+  uint64_t c = d[0] >> 26;
+  st->h[0] = (uint32_t) d[0] & POLY1305_MASK26;
+  for (int k = 1; k < 5; ++k) {
+    d[k] += c;
+    c = d[k] >> 26;
+    st->h[k] = (uint32_t) d[k] & POLY1305_MASK26;
+  }
+  st->h[0] += (uint32_t) c * 5;
+  c = st->h[0] >> 26;
+  st->h[0] &= POLY1305_MASK26;
+  st->h[1] += (uint32_t) c;
+  memset(l, 0, sizeof(l));
+}
+#endif
+
+//----------------------------------------------------------------------
+void poly1305_init(poly1305_state *st, const unsigned char *key,
+    const int simd)
+{
+  memset(st, 0, sizeof(poly1305_state));
+  // Clamp r
+  st->r[0][0] = chacha20_load_le32(key) & 0x3ffffff;
+  st->r[0][1] = (chacha20_load_le32(key + 3) >> 2) & 0x3ffff03;
+  st->r[0][2] = (chacha20_load_le32(key + 6) >> 4) & 0x3ffc0ff;
+  st->r[0][3] = (chacha20_load_le32(key + 9) >> 6) & 0x3f03fff;
+  st->r[0][4] = (chacha20_load_le32(key + 12) >> 8) & 0x00fffff;
+  for (int i = 0; i < 4; ++i) {
+    st->pad[i] = chacha20_load_le32(key + 16 + 4 * i);
+  }
+  st->simd = CHACHA20_SIMD_SUPPORTED && simd >= CHACHA20_SIMD_AVX2;
+  if (st->simd) {
+    for (int i = 1; i < 4; ++i) {
+      poly1305_mul(st->r[i], st->r[i - 1], st->r[0]);
+    }
+  }
+}
+
+//----------------------------------------------------------------------
+void poly1305_update(poly1305_state *st, const unsigned char *m,
+    size_t len)
+{
+  if (st->leftover) {
+    size_t n = POLY1305_BLOCK_SIZE - st->leftover;
+    if (n > len) {
+      n = len;
+    }
+    memcpy(st->buf + st->leftover, m, n);
+    st->leftover += n;
+    m += n;
+    len -= n;
+    if (st->leftover < POLY1305_BLOCK_SIZE) {
+      return;
+    }
+    poly1305_blocks(st, st->buf, POLY1305_BLOCK_SIZE, POLY1305_HIBIT);
+    st->leftover = 0;
+  }
+#if CHACHA20_SIMD_SUPPORTED
+  if (st->simd && len >= 8 * POLY1305_BLOCK_SIZE) {
+    const size_t n = len & ~(size_t) (4 * POLY1305_BLOCK_SIZE - 1);
+    poly1305_blocks_avx2(st, m, n);
+    m += n;
+    len -= n;
+  }
+#endif
+  if (len >= POLY1305_BLOCK_SIZE) {
+    const size_t n = len & ~(size_t) (POLY1305_BLOCK_SIZE - 1);
+    poly1305_blocks(st, m, n, POLY1305_HIBIT);
+    m += n;
+    len -= n;
+  }
+  if (len) {
+    memcpy(st->buf, m, len);
+    st->leftover = len;
+  }
+}
+
+//----------------------------------------------------------------------
+void poly1305_finish(poly1305_state *st, unsigned char *tag)
+{
+  uint32_t h0, h1, h2, h3, h4, g0, g1, g2, g3, g4, c, mask;
+  uint64_t f;
+  if (st->leftover) {
+    st->buf[st->leftover] = 1;
+    memset(st->buf + st->leftover + 1, 0,
+        POLY1305_BLOCK_SIZE - st->leftover - 1);
+    poly1305_blocks(st, st->buf, POLY1305_BLOCK_SIZE, 0);
+  }
+  // Fully carry h
+  h0 = st->h[0]; h1 = st->h[1]; h2 = st->h[2]; h3 = st->h[3]; h4 = st->h[4];
+  c = h1 >> 26; h1 &= POLY1305_MASK26;
+  h2 += c; c = h2 >> 26; h2 &= POLY1305_MASK26;
+  h3 += c; c = h3 >> 26; h3 &= POLY1305_MASK26;
+  h4 += c; c = h4 >> 26; h4 &= POLY1305_MASK26;
+  h0 += c * 5; c = h0 >> 26; h0 &= POLY1305_MASK26;
+  h1 += c;
+  // Compute h - p = h + 5 - 2^130 and select it if it does not underflow
+  g0 = h0 + 5; c = g0 >> 26; g0 &= POLY1305_MASK26;
+  g1 = h1 + c; c = g1 >> 26; g1 &= POLY1305_MASK26;
+  g2 = h2 + c; c = g2 >> 26; g2 &= POLY1305_MASK26;
+  g3 = h3 + c; c = g3 >> 26; g3 &= POLY1305_MASK26;
+  g4 = h4 + c - (1u << 26);
+  mask = (g4 >> 31) - 1;
+  g0 &= mask; g1 &= mask; g2 &= mask; g3 &= mask; g4 &= mask;
+  mask = ~mask;
+  h0 = (h0 & mask) | g0;
+  h1 = (h1 & mask) | g1;
+  h2 = (h2 & mask) | g2;
+  h3 = (h3 & mask) | g3;
+  h4 = (h4 & mask) | g4;
+  // h = (h + pad) mod 2^128
+  h0 = h0 | (h1 << 26);
+  h1 = (h1 >> 6) | (h2 << 20);
+  h2 = (h2 >> 12) | (h3 << 14);
+  h3 = (h3 >> 18) | (h4 << 8);
+  f = (uint64_t) h0 + st->pad[0];
+  chacha20_store_le32(tag, (uint32_t) f);
+  f = (uint64_t) h1 + st->pad[1] + (f >> 32);
+  chacha20_store_le32(tag + 4, (uint32_t) f);
+  f = (uint64_t) h2 + st->pad[2] + (f >> 32);
+  chacha20_store_le32(tag + 8, (uint32_t) f);
+  f = (uint64_t) h3 + st->pad[3] + (f >> 32);
+  chacha20_store_le32(tag + 12, (uint32_t) f);
+  memset(st, 0, sizeof(poly1305_state));
+}
+
+//----------------------------------------------------------------------
+int chacha20_poly1305_init(chacha20_poly1305_ctx *ctx,
+    const unsigned char *key)
+{
+  if (!ctx || !key) {
+    return -1;
+  }
+  for (int i = 0; i < 8; ++i) {
+    ctx->key[i] = chacha20_load_le32(key + 4 * i);
+  }
+  ctx->simd = chacha20_simd_level();
+  return 0;
+}
+
+//----------------------------------------------------------------------
+void chacha20_poly1305_clear(chacha20_poly1305_ctx *ctx)
+{
+  memset(ctx, 0, sizeof(chacha20_poly1305_ctx));
+}
+
+/*!
+ * \brief Computes the Poly1305 tag over the additional data and the
+ * ciphertext (RFC 8439, section 2.8)
+ */
+static void chacha20_poly1305_tag(const chacha20_poly1305_ctx *ctx,
+    const unsigned char *nonce, const unsigned char *ad, const int ad_len,
+    const unsigned char *c, const int len, unsigned char *tag)
+{
+  static const unsigned char zero[POLY1305_BLOCK_SIZE] = { 0 };
+  unsigned char otk[CHACHA20_BLOCK_SIZE], lb[POLY1305_BLOCK_SIZE];
+  poly1305_state st;
+  // The one-time key is the first half of the key stream block 0
+  memset(otk, 0, sizeof(otk));
+  chacha20_crypt(ctx, nonce, 0, otk, otk, sizeof(otk));
+  poly1305_init(&st, otk, ctx->simd);
+  if (ad_len) {
+    poly1305_update(&st, ad, ad_len);
+    poly1305_update(&st, zero, (POLY1305_BLOCK_SIZE - ad_len % 16) % 16);
+  }
+  poly1305_update(&st, c, len);
+  poly1305_update(&st, zero, (POLY1305_BLOCK_SIZE - len % 16) % 16);
+  chacha20_store_le32(lb, (uint32_t) ad_len);
+  chacha20_store_le32(lb + 4, 0);
+  chacha20_store_le32(lb + 8, (uint32_t) len);
+  chacha20_store_le32(lb + 12, 0);
+  poly1305_update(&st, lb, POLY1305_BLOCK_SIZE);
+  poly1305_finish(&st, tag);
+  memset(otk, 0, sizeof(otk));
+}
+
+//----------------------------------------------------------------------
+void chacha20_poly1305_encrypt(const chacha20_poly1305_ctx *ctx,
+    const unsigned char *nonce, const unsigned char *ad, const int ad_len,
+    const unsigned char *p, unsigned char *c, const int len,
+    unsigned char *tag)
+{
+  chacha20_crypt(ctx, nonce, 1, p, c, len);
+  chacha20_poly1305_tag(ctx, nonce, ad, ad_len, c, len, tag);
+}
+
+//----------------------------------------------------------------------
+int chacha20_poly1305_decrypt(const chacha20_poly1305_ctx *ctx,
+    const unsigned char *nonce, const unsigned char *ad, const int ad_len,
+    const unsigned char *c, unsigned char *p, const int len,
+    const unsigned char *tag)
+{
+  unsigned char t[POLY1305_TAG_SIZE];
+  chacha20_poly1305_tag(ctx, nonce, ad, ad_len, c, len, t);
+  unsigned char d = 0;
+  for (int i = 0; i < POLY1305_TAG_SIZE; ++i) {
+    d |= t[i] ^ tag[i];
+  }
+  if (d) {
+    memset(p, 0, len);
+    return -1;
+  }
+  chacha20_crypt(ctx, nonce, 1, c, p, len);
+  return 1;
+}
@@ -0,0 +1,189 @@
+/* Copyright (c) IAIK, Graz University of Technology, 2015.
+ * All rights reserved.
+ * Contact: http://opensource.iaik.tugraz.at
+ * 
+ * This file is part of the Secure Block Device Library.
+ * 
+ * Commercial License Usage
+ * Licensees holding valid commercial licenses may use this file in
+ * accordance with the commercial license agreement provided with the
+ * Software or, alternatively, in accordance with the terms contained in
+ * a written agreement between you and SIC. For further information
+ * contact us at http://opensource.iaik.tugraz.at.
+ * 
+ * Alternatively, this file may be used under the terms of the GNU General
+ * Public License as published by the Free Software Foundation version 2.
+ * 
+ * The Secure Block Device Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with the Secure Block Device Library. If not, see <http://www.gnu.org/licenses/>.
+ */
+///
+/// \file
+/// \brief Specifies a ChaCha20-Poly1305 (RFC 8439) authenticated encryption
+/// implementation.
+///
+/// ChaCha20-Poly1305 only uses additions, rotations and exclusive ors, which
+/// makes it fast and constant time on CPUs without AES instructions. On x86
+/// the ChaCha20 key stream is computed four blocks at a time with SSE2 or
+/// eight blocks at a time with AVX2, and Poly1305 processes four message
+/// blocks in parallel with AVX2. All other CPUs use the portable code. The
+/// context is never modified after chacha20_poly1305_init.
+///
+#ifndef CHACHA20_POLY1305_H_
+#define CHACHA20_POLY1305_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define CHACHA20_KEY_SIZE    32 //!< The size in bytes of the ChaCha20 key
+#define CHACHA20_NONCE_SIZE  12 //!< The size in bytes of the ChaCha20 nonce
+#define CHACHA20_BLOCK_SIZE  64 //!< The size in bytes of a ChaCha20 key stream block
+#define POLY1305_KEY_SIZE    32 //!< The size in bytes of a Poly1305 one-time key
+#define POLY1305_TAG_SIZE    16 //!< The size in bytes of the Poly1305 tag
+
+#define CHACHA20_SIMD_NONE    0 //!< Use the portable code
+#define CHACHA20_SIMD_SSE2    1 //!< Use the four block SSE2 ChaCha20 kernel
+#define CHACHA20_SIMD_AVX2    2 //!< Use the eight block AVX2 ChaCha20 and the four block AVX2 Poly1305 kernels
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*!
+ * \brief the ChaCha20-Poly1305 context
+ */
+typedef struct chacha20_poly1305_ctx {
+  uint32_t key[8]; //!< the ChaCha20 key as little endian words
+  int simd; //!< the fastest kernels the CPU supports (CHACHA20_SIMD_*)
+} chacha20_poly1305_ctx;
+
+/*!
+ * \brief the state of an incremental Poly1305 computation
+ */
+typedef struct poly1305_state {
+  uint32_t r[4][5]; //!< r^1 .. r^4 in radix 2^26; the powers are only used by the AVX2 kernel
+  uint32_t h[5]; //!< the accumulator in radix 2^26
+  uint32_t pad[4]; //!< the second half of the one-time key
+  unsigned char buf[16]; //!< the buffered incomplete message block
+  size_t leftover; //!< the number of buffered bytes
+  int simd; //!< non-zero if the AVX2 kernel is used
+} poly1305_state;
+
+/*!
+ * \brief Determines the fastest ChaCha20 and Poly1305 kernels the CPU
+ * supports
+ *
+ * @return one of the CHACHA20_SIMD_* constants
+ */
+int chacha20_simd_level(void);
+
+/*!
+ * \brief Initializes a ChaCha20-Poly1305 context with the given key
+ *
+ * @param ctx[out] the context to initialize
+ * @param key[in] the CHACHA20_KEY_SIZE byte key
+ * @return 0 if the initialization was successful; -1 otherwise
+ */
+int chacha20_poly1305_init(chacha20_poly1305_ctx *ctx,
+    const unsigned char *key);
+
+/*!
+ * \brief Overwrites all key material of the given ChaCha20-Poly1305 context
+ *
+ * @param ctx[inout] the context to clear
+ */
+void chacha20_poly1305_clear(chacha20_poly1305_ctx *ctx);
+
+/*!
+ * \brief XORs the ChaCha20 key stream starting at the given block counter
+ * onto the input
+ *
+ * @param ctx[in] the ChaCha20-Poly1305 context which provides the key
+ * @param nonce[in] the CHACHA20_NONCE_SIZE byte nonce
+ * @param ctr[in] the block counter of the first key stream block
+ * @param in[in] the input
+ * @param out[out] the output (may be equal to in)
+ * @param len[in] the length of the input
+ */
+void chacha20_crypt(const chacha20_poly1305_ctx *ctx,
+    const unsigned char *nonce, const uint32_t ctr, const unsigned char *in,
+    unsigned char *out, const size_t len);
+
+/*!
+ * \brief Starts a Poly1305 computation
+ *
+ * @param st[out] the Poly1305 state to initialize
+ * @param key[in] the POLY1305_KEY_SIZE byte one-time key
+ * @param simd[in] one of the CHACHA20_SIMD_* constants
+ */
+void poly1305_init(poly1305_state *st, const unsigned char *key,
+    const int simd);
+
+/*!
+ * \brief Adds message bytes to a Poly1305 computation
+ *
+ * @param st[inout] the Poly1305 state
+ * @param m[in] the message bytes
+ * @param len[in] the number of message bytes
+ */
+void poly1305_update(poly1305_state *st, const unsigned char *m,
+    size_t len);
+
+/*!
+ * \brief Finishes a Poly1305 computation and clears the state
+ *
+ * @param st[inout] the Poly1305 state
+ * @param tag[out] the POLY1305_TAG_SIZE byte tag
+ */
+void poly1305_finish(poly1305_state *st, unsigned char *tag);
+
+/*!
+ * \brief Encrypts and authenticates a message
+ *
+ * @param ctx[in] the ChaCha20-Poly1305 context
+ * @param nonce[in] the CHACHA20_NONCE_SIZE byte nonce
+ * @param ad[in] the additional authenticated data (can be NULL if ad_len is
+ * 0)
+ * @param ad_len[in] the length of the additional authenticated data
+ * @param p[in] the plaintext
+ * @param c[out] the ciphertext (may be equal to p)
+ * @param len[in] the length of the plaintext
+ * @param tag[out] the POLY1305_TAG_SIZE byte authentication tag
+ */
+void chacha20_poly1305_encrypt(const chacha20_poly1305_ctx *ctx,
+    const unsigned char *nonce, const unsigned char *ad, const int ad_len,
+    const unsigned char *p, unsigned char *c, const int len,
+    unsigned char *tag);
+
+/*!
+ * \brief Verifies and decrypts a message
+ *
+ * The ciphertext is only decrypted if the tag is valid. Otherwise the
+ * plaintext buffer is cleared.
+ *
+ * @param ctx[in] the ChaCha20-Poly1305 context
+ * @param nonce[in] the CHACHA20_NONCE_SIZE byte nonce
+ * @param ad[in] the additional authenticated data (can be NULL if ad_len is
+ * 0)
+ * @param ad_len[in] the length of the additional authenticated data
+ * @param c[in] the ciphertext
+ * @param p[out] the plaintext (may be equal to c)
+ * @param len[in] the length of the ciphertext
+ * @param tag[in] the POLY1305_TAG_SIZE byte authentication tag
+ * @return 1 if the tag is valid; -1 otherwise
+ */
+int chacha20_poly1305_decrypt(const chacha20_poly1305_ctx *ctx,
+    const unsigned char *nonce, const unsigned char *ad, const int ad_len,
+    const unsigned char *c, unsigned char *p, const int len,
+    const unsigned char *tag);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CHACHA20_POLY1305_H_ */
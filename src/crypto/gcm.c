@@ -0,0 +1,670 @@
+/* Copyright (c) IAIK, Graz University of Technology, 2015.
+ * All rights reserved.
+ * Contact: http://opensource.iaik.tugraz.at
+ * 
+ * This file is part of the Secure Block Device Library.
+ * 
+ * Commercial License Usage
+ * Licensees holding valid commercial licenses may use this file in
+ * accordance with the commercial license agreement provided with the
+ * Software or, alternatively, in accordance with the terms contained in
+ * a written agreement between you and SIC. For further information
+ * contact us at http://opensource.iaik.tugraz.at.
+ * 
+ * Alternatively, this file may be used under the terms of the GNU General
+ * Public License as published by the Free Software Foundation version 2.
+ * 
+ * The Secure Block Device Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with the Secure Block Device Library. If not, see <http://www.gnu.org/licenses/>.
+ */
+///
+/// \file
+/// \brief Implements AES-GCM (NIST SP 800-38D) authenticated encryption.
+///
+/// The generic code path uses the reference AES implementation and Shoup's 4
+/// bit table driven GHASH multiplication. The accelerated code path runs the
+/// CTR part on AES-NI, eight blocks at a time, and computes GHASH with
+/// PCLMULQDQ. It multiplies eight blocks with the precomputed powers H^8 ..
+/// H^1 and only reduces their sum, which removes the reduction from the
+/// critical path of all but one of the blocks.
+///
+#include "gcm.h"
+#include "aes_ni.h"
+#include "aes_ct.h"
+
+#include <string.h>
+
+#if AES_NI_SUPPORTED
+# include <cpuid.h>
+# include <immintrin.h>
+#endif
+
+#define GCM_BLOCK_SIZE 16
+
+static const uint64_t gcm_last4[16] = { 0x0000, 0x1c20, 0x3840, 0x2460,
+    0x7080, 0x6ca0, 0x48c0, 0x54e0, 0xe100, 0xfd20, 0xd940, 0xc560, 0x9180,
+    0x8da0, 0xa9c0, 0xb5e0 };
+
+static inline uint64_t gcm_load_be64(const unsigned char *p)
+{
+  return ((uint64_t) p[0] << 56) | ((uint64_t) p[1] << 48)
+      | ((uint64_t) p[2] << 40) | ((uint64_t) p[3] << 32)
+      | ((uint64_t) p[4] << 24) | ((uint64_t) p[5] << 16)
+      | ((uint64_t) p[6] << 8) | (uint64_t) p[7];
+}
+
+static inline void gcm_store_be64(unsigned char *p, const uint64_t v)
+{
+  for (int i = 0; i < 8; ++i) {
+    p[i] = (unsigned char) (v >> (56 - 8 * i));
+  }
+}
+
+/*!
+ * \brief Builds the final GHASH input block, which holds the bit lengths of
+ * the additional data and the ciphertext
+ */
+static inline void gcm_len_block(unsigned char b[GCM_BLOCK_SIZE],
+    const int ad_len, const int len)
+{
+  gcm_store_be64(b, (uint64_t) ad_len * 8);
+  gcm_store_be64(b + 8, (uint64_t) len * 8);
+}
+
+/*!
+ * \brief Builds the pre-counter block J0 = IV || 0^31 || 1
+ */
+static inline void gcm_j0(unsigned char j0[GCM_BLOCK_SIZE],
+    const unsigned char *iv)
+{
+  memcpy(j0, iv, GCM_IV_SIZE);
+  j0[12] = 0;
+  j0[13] = 0;
+  j0[14] = 0;
+  j0[15] = 1;
+}
+
+//----------------------------------------------------------------------
+// Generic implementation
+//
+/*!
+ * \brief Precomputes the 4 bit multiplication table of H
+ */
+static void gcm_gen_table(gcm_hkey *hkey,
+    const unsigned char h[GCM_BLOCK_SIZE])
+{
+  uint64_t vh = gcm_load_be64(h);
+  uint64_t vl = gcm_load_be64(h + 8);
+  hkey->HL[8] = vl;
+  hkey->HH[8] = vh;
+  hkey->HL[0] = 0;
+  hkey->HH[0] = 0;
+  for (int i = 4; i > 0; i >>= 1) {
+    const uint64_t t = (vl & 1) * 0xe100000000000000ULL;
+    vl = (vh << 63) | (vl >> 1);
+    vh = (vh >> 1) ^ t;
+    hkey->HL[i] = vl;
+    hkey->HH[i] = vh;
+  }
+  for (int i = 2; i <= 8; i *= 2) {
+    vh = hkey->HH[i];
+    vl = hkey->HL[i];
+    for (int j = 1; j < i; ++j) {
+      hkey->HH[i + j] = vh ^ hkey->HH[j];
+      hkey->HL[i + j] = vl ^ hkey->HL[j];
+    }
+  }
+}
+
+/*!
+ * \brief Multiplies x with H in GF(2^128)
+ */
+static void gcm_mult(const gcm_hkey *hkey, unsigned char x[GCM_BLOCK_SIZE])
+{
+  unsigned char lo = x[15] & 0xf;
+  uint64_t zh = hkey->HH[lo];
+  uint64_t zl = hkey->HL[lo];
+  for (int i = 15; i >= 0; --i) {
+    lo = x[i] & 0xf;
+    const unsigned char hi = (x[i] >> 4) & 0xf;
+    unsigned char rem;
+    if (i != 15) {
+      rem = (unsigned char) zl & 0xf;
+      zl = (zh << 60) | (zl >> 4);
+      zh = (zh >> 4) ^ (gcm_last4[rem] << 48);
+      zh ^= hkey->HH[lo];
+      zl ^= hkey->HL[lo];
+    }
+    rem = (unsigned char) zl & 0xf;
+    zl = (zh << 60) | (zl >> 4);
+    zh = (zh >> 4) ^ (gcm_last4[rem] << 48);
+    zh ^= hkey->HH[hi];
+    zl ^= hkey->HL[hi];
+  }
+  gcm_store_be64(x, zh);
+  gcm_store_be64(x + 8, zl);
+}
+
+/*!
+ * \brief Absorbs len bytes into the GHASH state y; a trailing partial block
+ * is padded with zeros
+ */
+static void gcm_ghash(const gcm_hkey *hkey, unsigned char y[GCM_BLOCK_SIZE],
+    const unsigned char *in, const int len)
+{
+  for (int i = 0; i < len; i += GCM_BLOCK_SIZE) {
+    const int n = (len - i < GCM_BLOCK_SIZE) ? len - i : GCM_BLOCK_SIZE;
+    for (int j = 0; j < n; ++j) {
+      y[j] ^= in[i + j];
+    }
+    gcm_mult(hkey, y);
+  }
+}
+
+/*!
+ * \brief Runs the GCM CTR mode with the 32 bit counter increment
+ */
+static void gcm_ctr(const gcm_ctx *ctx, unsigned char cb[GCM_BLOCK_SIZE],
+    const unsigned char *in, unsigned char *out, const int len)
+{
+  unsigned char ks[GCM_BLOCK_SIZE];
+  if (ctx->key.use_ct) {
+    aes_ct_ctr32(ctx->key.ct_key, ctx->key.rounds, in, out, len, cb, 0);
+    return;
+  }
+  for (int i = 0; i < len; i += GCM_BLOCK_SIZE) {
+    const int n = (len - i < GCM_BLOCK_SIZE) ? len - i : GCM_BLOCK_SIZE;
+    AES_encrypt(cb, ks, &ctx->key);
+    for (int j = 0; j < n; ++j) {
+      out[i + j] = in[i + j] ^ ks[j];
+    }
+    for (int j = 15; j >= 12; --j) {
+      if (++cb[j]) {
+        break;
+      }
+    }
+  }
+  memset(ks, 0, GCM_BLOCK_SIZE);
+}
+
+//----------------------------------------------------------------------
+static void gcm_crypt_generic(const gcm_ctx *ctx, const unsigned char *iv,
+    const unsigned char *ad, const int ad_len, const unsigned char *in,
+    unsigned char *out, const int len, const int enc,
+    unsigned char tag[GCM_TAG_SIZE])
+{
+  unsigned char j0[GCM_BLOCK_SIZE], cb[GCM_BLOCK_SIZE], y[GCM_BLOCK_SIZE];
+  unsigned char lb[GCM_BLOCK_SIZE];
+  gcm_j0(j0, iv);
+  memcpy(cb, j0, GCM_BLOCK_SIZE);
+  cb[15] = 2;
+  memset(y, 0, GCM_BLOCK_SIZE);
+  gcm_ghash(&ctx->hkey, y, ad, ad_len);
+  if (enc) {
+    gcm_ctr(ctx, cb, in, out, len);
+    gcm_ghash(&ctx->hkey, y, out, len);
+  } else {
+    gcm_ghash(&ctx->hkey, y, in, len);
+    gcm_ctr(ctx, cb, in, out, len);
+  }
+  gcm_len_block(lb, ad_len, len);
+  gcm_ghash(&ctx->hkey, y, lb, GCM_BLOCK_SIZE);
+  AES_encrypt(j0, tag, &ctx->key);
+  for (int i = 0; i < GCM_TAG_SIZE; ++i) {
+    tag[i] ^= y[i];
+  }
+}
+
+#if AES_NI_SUPPORTED
+//----------------------------------------------------------------------
+// AES-NI and PCLMULQDQ implementation
+//
+/*!
+ * \brief Converts a key schedule of aes.h into AES-NI round keys
+ *
+ * @see aes_ni_load_key in aes_ni.c
+ */
+__attribute__((target("aes,pclmul,ssse3")))
+static inline void gcm_ni_load_key(const AES_KEY *key,
+    __m128i rk[AES_MAXNR + 1])
+{
+  const __m128i bswap32 = _mm_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6,
+      7, 0, 1, 2, 3);
+  for (int i = 0; i <= key->rounds; ++i) {
+    rk[i] = _mm_shuffle_epi8(
+        _mm_loadu_si128((const __m128i *) &key->key[4 * i]), bswap32);
+  }
+}
+
+/*!
+ * \brief Reverses the byte order of a block, which maps GCM's bit reflected
+ * field elements to the representation the PCLMULQDQ kernels work in
+ */
+__attribute__((target("aes,pclmul,ssse3")))
+static inline __m128i gcm_ni_bswap(const __m128i x)
+{
+  return _mm_shuffle_epi8(x,
+      _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+}
+
+/*!
+ * \brief Computes the unreduced 256 bit carry-less product of a and b and
+ * adds it to lo and hi
+ */
+__attribute__((target("aes,pclmul,ssse3")))
+static inline void gcm_ni_clmul(const __m128i a, const __m128i b, __m128i *lo,
+    __m128i *hi)
+{
+  const __m128i l = _mm_clmulepi64_si128(a, b, 0x00);
+  const __m128i h = _mm_clmulepi64_si128(a, b, 0x11);
+  const __m128i m = _mm_xor_si128(_mm_clmulepi64_si128(a, b, 0x10),
+      _mm_clmulepi64_si128(a, b, 0x01));
+  *lo = _mm_xor_si128(*lo, _mm_xor_si128(l, _mm_slli_si128(m, 8)));
+  *hi = _mm_xor_si128(*hi, _mm_xor_si128(h, _mm_srli_si128(m, 8)));
+}
+
+/*!
+ * \brief Reduces a 256 bit carry-less product modulo the GCM polynomial
+ *
+ * The product of two byte reflected operands is one bit short, so it is
+ * shifted left by one before the reduction (see Intel's white paper on
+ * carry-less multiplication and its use for computing the GCM mode).
+ */
+__attribute__((target("aes,pclmul,ssse3")))
+static inline __m128i gcm_ni_reduce(__m128i lo, __m128i hi)
+{
+  __m128i t7 = _mm_srli_epi32(lo, 31);
+  __m128i t8 = _mm_srli_epi32(hi, 31);
+  lo = _mm_slli_epi32(lo, 1);
+  hi = _mm_slli_epi32(hi, 1);
+  __m128i t9 = _mm_srli_si128(t7, 12);
+  t8 = _mm_slli_si128(t8, 4);
+  t7 = _mm_slli_si128(t7, 4);
+  lo = _mm_or_si128(lo, t7);
+  hi = _mm_or_si128(hi, t8);
+  hi = _mm_or_si128(hi, t9);
+
+  t7 = _mm_slli_epi32(lo, 31);
+  t8 = _mm_slli_epi32(lo, 30);
+  t9 = _mm_slli_epi32(lo, 25);
+  t7 = _mm_xor_si128(t7, t8);
+  t7 = _mm_xor_si128(t7, t9);
+  t8 = _mm_srli_si128(t7, 4);
+  t7 = _mm_slli_si128(t7, 12);
+  lo = _mm_xor_si128(lo, t7);
+
+  __m128i t2 = _mm_srli_epi32(lo, 1);
+  const __m128i t4 = _mm_srli_epi32(lo, 2);
+  const __m128i t5 = _mm_srli_epi32(lo, 7);
+  t2 = _mm_xor_si128(t2, t4);
+  t2 = _mm_xor_si128(t2, t5);
+  t2 = _mm_xor_si128(t2, t8);
+  lo = _mm_xor_si128(lo, t2);
+  return _mm_xor_si128(hi, lo);
+}
+
+/*!
+ * \brief Computes a * b in GF(2^128) (byte reflected representation)
+ */
+__attribute__((target("aes,pclmul,ssse3")))
+static inline __m128i gcm_ni_gfmul(const __m128i a, const __m128i b)
+{
+  __m128i lo = _mm_setzero_si128(), hi = _mm_setzero_si128();
+  gcm_ni_clmul(a, b, &lo, &hi);
+  return gcm_ni_reduce(lo, hi);
+}
+
+/*!
+ * \brief Absorbs GCM_HPOW_CNT full blocks into the GHASH state y with a
+ * single reduction
+ *
+ * The blocks are byte reversed if reflect is non-zero (GHASH). POLYVAL
+ * blocks already are in the representation of the kernels.
+ */
+__attribute__((target("aes,pclmul,ssse3")))
+static inline __m128i gcm_ni_ghash8(const __m128i *hp, const __m128i y,
+    const unsigned char *in, const int reflect)
+{
+  __m128i lo = _mm_setzero_si128(), hi = _mm_setzero_si128();
+  for (int j = 0; j < GCM_HPOW_CNT; ++j) {
+    __m128i b = _mm_loadu_si128((const __m128i *) (in + j * GCM_BLOCK_SIZE));
+    if (reflect) {
+      b = gcm_ni_bswap(b);
+    }
+    if (j == 0) {
+      b = _mm_xor_si128(b, y);
+    }
+    gcm_ni_clmul(b, hp[GCM_HPOW_CNT - 1 - j], &lo, &hi);
+  }
+  return gcm_ni_reduce(lo, hi);
+}
+
+/*!
+ * \brief Absorbs len bytes into the GHASH state y; a trailing partial block
+ * is padded with zeros
+ */
+__attribute__((target("aes,pclmul,ssse3")))
+static __m128i gcm_ni_ghash(const __m128i *hp, __m128i y,
+    const unsigned char *in, const int len, const int reflect)
+{
+  int i = 0;
+  for (; len - i >= GCM_HPOW_CNT * GCM_BLOCK_SIZE;
+      i += GCM_HPOW_CNT * GCM_BLOCK_SIZE) {
+    y = gcm_ni_ghash8(hp, y, in + i, reflect);
+  }
+  for (; i < len; i += GCM_BLOCK_SIZE) {
+    __m128i b;
+    if (len - i >= GCM_BLOCK_SIZE) {
+      b = _mm_loadu_si128((const __m128i *) (in + i));
+    } else {
+      unsigned char pad[GCM_BLOCK_SIZE];
+      memset(pad, 0, GCM_BLOCK_SIZE);
+      memcpy(pad, in + i, len - i);
+      b = _mm_loadu_si128((const __m128i *) pad);
+    }
+    if (reflect) {
+      b = gcm_ni_bswap(b);
+    }
+    y = gcm_ni_gfmul(_mm_xor_si128(y, b), hp[0]);
+  }
+  return y;
+}
+
+/*!
+ * \brief Precomputes H^1 .. H^GCM_HPOW_CNT for the aggregated GHASH
+ */
+__attribute__((target("aes,pclmul,ssse3")))
+static void gcm_ni_init_hpow(gcm_hkey *hkey,
+    const unsigned char h[GCM_BLOCK_SIZE])
+{
+  const __m128i h1 = gcm_ni_bswap(_mm_loadu_si128((const __m128i *) h));
+  __m128i p = h1;
+  for (int i = 0; i < GCM_HPOW_CNT; ++i) {
+    _mm_storeu_si128((__m128i *) hkey->Hpow[i], p);
+    p = gcm_ni_gfmul(p, h1);
+  }
+}
+
+/*!
+ * \brief Absorbs len bytes into the GHASH (reflect non-zero) or POLYVAL
+ * state s, which is kept in the byte order of the generic code path
+ */
+__attribute__((target("aes,pclmul,ssse3")))
+static void gcm_ni_absorb(const gcm_hkey *hkey, unsigned char *s,
+    const unsigned char *in, const int len, const int reflect)
+{
+  __m128i hp[GCM_HPOW_CNT];
+  for (int i = 0; i < GCM_HPOW_CNT; ++i) {
+    hp[i] = _mm_loadu_si128((const __m128i *) hkey->Hpow[i]);
+  }
+  __m128i y = _mm_loadu_si128((const __m128i *) s);
+  if (reflect) {
+    y = gcm_ni_bswap(y);
+  }
+  y = gcm_ni_ghash(hp, y, in, len, reflect);
+  if (reflect) {
+    y = gcm_ni_bswap(y);
+  }
+  _mm_storeu_si128((__m128i *) s, y);
+}
+
+//----------------------------------------------------------------------
+__attribute__((target("aes,pclmul,ssse3")))
+static void gcm_ni_crypt(const gcm_ctx *ctx, const unsigned char *iv,
+    const unsigned char *ad, const int ad_len, const unsigned char *in,
+    unsigned char *out, const int len, const int enc,
+    unsigned char tag[GCM_TAG_SIZE])
+{
+  __m128i rk[AES_MAXNR + 1], hp[GCM_HPOW_CNT];
+  gcm_ni_load_key(&ctx->key, rk);
+  const int nr = ctx->key.rounds;
+  for (int i = 0; i < GCM_HPOW_CNT; ++i) {
+    hp[i] = _mm_loadu_si128((const __m128i *) ctx->hkey.Hpow[i]);
+  }
+  // Keeps the last counter word in host byte order, so that it can be
+  // incremented with a 32 bit addition (which wraps like inc32)
+  const __m128i ctr_swap = _mm_set_epi8(12, 13, 14, 15, 11, 10, 9, 8, 7, 6,
+      5, 4, 3, 2, 1, 0);
+  const __m128i one = _mm_set_epi32(1, 0, 0, 0);
+
+  unsigned char j0[GCM_BLOCK_SIZE];
+  gcm_j0(j0, iv);
+  __m128i cb = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) j0),
+      ctr_swap);
+  __m128i ek0 = _mm_xor_si128(_mm_loadu_si128((const __m128i *) j0), rk[0]);
+  for (int r = 1; r < nr; ++r) {
+    ek0 = _mm_aesenc_si128(ek0, rk[r]);
+  }
+  ek0 = _mm_aesenclast_si128(ek0, rk[nr]);
+
+  __m128i y = gcm_ni_ghash(hp, _mm_setzero_si128(), ad, ad_len, 1);
+
+  int i = 0;
+  for (; len - i >= GCM_HPOW_CNT * GCM_BLOCK_SIZE;
+      i += GCM_HPOW_CNT * GCM_BLOCK_SIZE) {
+    // On decryption the GHASH of the ciphertext does not depend on the CTR
+    // part and runs in its shadow
+    if (!enc) {
+      y = gcm_ni_ghash8(hp, y, in + i, 1);
+    }
+    __m128i k[GCM_HPOW_CNT];
+    for (int j = 0; j < GCM_HPOW_CNT; ++j) {
+      cb = _mm_add_epi32(cb, one);
+      k[j] = _mm_xor_si128(_mm_shuffle_epi8(cb, ctr_swap), rk[0]);
+    }
+    for (int r = 1; r < nr; ++r) {
+      for (int j = 0; j < GCM_HPOW_CNT; ++j) {
+        k[j] = _mm_aesenc_si128(k[j], rk[r]);
+      }
+    }
+    for (int j = 0; j < GCM_HPOW_CNT; ++j) {
+      const int o = i + j * GCM_BLOCK_SIZE;
+      k[j] = _mm_aesenclast_si128(k[j], rk[nr]);
+      _mm_storeu_si128((__m128i *) (out + o),
+          _mm_xor_si128(k[j], _mm_loadu_si128((const __m128i *) (in + o))));
+    }
+    if (enc) {
+      y = gcm_ni_ghash8(hp, y, out + i, 1);
+    }
+  }
+  if (i < len) {
+    if (!enc) {
+      y = gcm_ni_ghash(hp, y, in + i, len - i, 1);
+    }
+    for (int o = i; o < len; o += GCM_BLOCK_SIZE) {
+      cb = _mm_add_epi32(cb, one);
+      __m128i k = _mm_xor_si128(_mm_shuffle_epi8(cb, ctr_swap), rk[0]);
+      for (int r = 1; r < nr; ++r) {
+        k = _mm_aesenc_si128(k, rk[r]);
+      }
+      k = _mm_aesenclast_si128(k, rk[nr]);
+      if (len - o >= GCM_BLOCK_SIZE) {
+        _mm_storeu_si128((__m128i *) (out + o),
+            _mm_xor_si128(k, _mm_loadu_si128((const __m128i *) (in + o))));
+      } else {
+        unsigned char ks[GCM_BLOCK_SIZE];
+        _mm_storeu_si128((__m128i *) ks, k);
+        for (int j = 0; j < len - o; ++j) {
+          out[o + j] = in[o + j] ^ ks[j];
+        }
+      }
+    }
+    if (enc) {
+      y = gcm_ni_ghash(hp, y, out + i, len - i, 1);
+    }
+  }
+  unsigned char lb[GCM_BLOCK_SIZE];
+  gcm_len_block(lb, ad_len, len);
+  y = gcm_ni_ghash(hp, y, lb, GCM_BLOCK_SIZE, 1);
+  _mm_storeu_si128((__m128i *) tag, _mm_xor_si128(gcm_ni_bswap(y), ek0));
+}
+#endif
+
+//----------------------------------------------------------------------
+int gcm_clmul_is_available(void)
+{
+#if AES_NI_SUPPORTED
+  static int available = -1;
+  if (available < 0) {
+    unsigned int eax, ebx, ecx, edx;
+    available = aes_ni_is_available() && __get_cpuid(1, &eax, &ebx, &ecx, &edx)
+        && (ecx & bit_PCLMUL);
+  }
+  return available;
+#else
+  return 0;
+#endif
+}
+
+//----------------------------------------------------------------------
+void gcm_hkey_init(gcm_hkey *hkey, const unsigned char *h)
+{
+  memset(hkey, 0, sizeof(gcm_hkey));
+  gcm_gen_table(hkey, h);
+#if AES_NI_SUPPORTED
+  if (gcm_clmul_is_available()) {
+    gcm_ni_init_hpow(hkey, h);
+    hkey->use_clmul = 1;
+  }
+#endif
+}
+
+//----------------------------------------------------------------------
+void gcm_polyval_hkey_init(gcm_hkey *hkey, const unsigned char *h)
+{
+  unsigned char x[GCM_BLOCK_SIZE];
+  for (int i = 0; i < GCM_BLOCK_SIZE; ++i) {
+    x[i] = h[GCM_BLOCK_SIZE - 1 - i];
+  }
+  // mulX_GHASH
+  uint64_t hi = gcm_load_be64(x);
+  uint64_t lo = gcm_load_be64(x + 8);
+  const uint64_t t = (lo & 1) * 0xe100000000000000ULL;
+  lo = (hi << 63) | (lo >> 1);
+  hi = (hi >> 1) ^ t;
+  gcm_store_be64(x, hi);
+  gcm_store_be64(x + 8, lo);
+  gcm_hkey_init(hkey, x);
+  memset(x, 0, GCM_BLOCK_SIZE);
+}
+
+//----------------------------------------------------------------------
+void gcm_polyval(const gcm_hkey *hkey, unsigned char *s,
+    const unsigned char *in, const int len)
+{
+#if AES_NI_SUPPORTED
+  if (hkey->use_clmul) {
+    gcm_ni_absorb(hkey, s, in, len, 0);
+    return;
+  }
+#endif
+  // POLYVAL(H, X) = ByteReverse(GHASH(H', ByteReverse(X)))
+  unsigned char y[GCM_BLOCK_SIZE];
+  for (int j = 0; j < GCM_BLOCK_SIZE; ++j) {
+    y[j] = s[GCM_BLOCK_SIZE - 1 - j];
+  }
+  for (int i = 0; i < len; i += GCM_BLOCK_SIZE) {
+    const int n = (len - i < GCM_BLOCK_SIZE) ? len - i : GCM_BLOCK_SIZE;
+    for (int j = 0; j < n; ++j) {
+      y[GCM_BLOCK_SIZE - 1 - j] ^= in[i + j];
+    }
+    gcm_mult(hkey, y);
+  }
+  for (int j = 0; j < GCM_BLOCK_SIZE; ++j) {
+    s[j] = y[GCM_BLOCK_SIZE - 1 - j];
+  }
+}
+
+//----------------------------------------------------------------------
+int gcm_init(gcm_ctx *ctx, const unsigned char *key, const int key_bits)
+{
+  unsigned char h[GCM_BLOCK_SIZE];
+  memset(ctx, 0, sizeof(gcm_ctx));
+  if (AES_set_encrypt_key(key, key_bits, &ctx->key) != 0) {
+    return -1;
+  }
+  memset(h, 0, GCM_BLOCK_SIZE);
+  AES_encrypt(h, h, &ctx->key);
+  gcm_hkey_init(&ctx->hkey, h);
+  memset(h, 0, GCM_BLOCK_SIZE);
+  return 0;
+}
+
+//----------------------------------------------------------------------
+void gcm_clear(gcm_ctx *ctx)
+{
+  memset(ctx, 0, sizeof(gcm_ctx));
+}
+
+//----------------------------------------------------------------------
+static void gcm_crypt(const gcm_ctx *ctx, const unsigned char *iv,
+    const unsigned char *ad, const int ad_len, const unsigned char *in,
+    unsigned char *out, const int len, const int enc,
+    unsigned char tag[GCM_TAG_SIZE])
+{
+#if AES_NI_SUPPORTED
+  if (ctx->hkey.use_clmul) {
+    gcm_ni_crypt(ctx, iv, ad, ad_len, in, out, len, enc, tag);
+    return;
+  }
+#endif
+  gcm_crypt_generic(ctx, iv, ad, ad_len, in, out, len, enc, tag);
+}
+
+//----------------------------------------------------------------------
+void gcm_encrypt(const gcm_ctx *ctx, const unsigned char *iv,
+    const unsigned char *ad, const int ad_len, const unsigned char *p,
+    unsigned char *c, const int len, unsigned char *tag)
+{
+  gcm_crypt(ctx, iv, ad, ad_len, p, c, len, 1, tag);
+}
+
+//----------------------------------------------------------------------
+int gcm_decrypt(const gcm_ctx *ctx, const unsigned char *iv,
+    const unsigned char *ad, const int ad_len, const unsigned char *c,
+    unsigned char *p, const int len, const unsigned char *tag)
+{
+  unsigned char t[GCM_TAG_SIZE];
+  gcm_crypt(ctx, iv, ad, ad_len, c, p, len, 0, t);
+  unsigned char d = 0;
+  for (int i = 0; i < GCM_TAG_SIZE; ++i) {
+    d |= t[i] ^ tag[i];
+  }
+  if (d) {
+    memset(p, 0, len);
+    return -1;
+  }
+  return 1;
+}
+
+//----------------------------------------------------------------------
+void gcm_mac(const gcm_ctx *ctx, const unsigned char *iv,
+    const unsigned char *ad, const int ad_len, const unsigned char *m,
+    const int len, unsigned char *tag)
+{
+  unsigned char j0[GCM_BLOCK_SIZE], y[GCM_BLOCK_SIZE], lb[GCM_BLOCK_SIZE];
+  gcm_len_block(lb, ad_len, len);
+  memset(y, 0, GCM_BLOCK_SIZE);
+#if AES_NI_SUPPORTED
+  if (ctx->hkey.use_clmul) {
+    gcm_ni_absorb(&ctx->hkey, y, ad, ad_len, 1);
+    gcm_ni_absorb(&ctx->hkey, y, m, len, 1);
+    gcm_ni_absorb(&ctx->hkey, y, lb, GCM_BLOCK_SIZE, 1);
+  } else
+#endif
+  {
+    gcm_ghash(&ctx->hkey, y, ad, ad_len);
+    gcm_ghash(&ctx->hkey, y, m, len);
+    gcm_ghash(&ctx->hkey, y, lb, GCM_BLOCK_SIZE);
+  }
+  gcm_j0(j0, iv);
+  AES_encrypt(j0, tag, &ctx->key);
+  for (int i = 0; i < GCM_TAG_SIZE; ++i) {
+    tag[i] ^= y[i];
+  }
+}
@@ -0,0 +1,185 @@
+/* Copyright (c) IAIK, Graz University of Technology, 2015.
+ * All rights reserved.
+ * Contact: http://opensource.iaik.tugraz.at
+ * 
+ * This file is part of the Secure Block Device Library.
+ * 
+ * Commercial License Usage
+ * Licensees holding valid commercial licenses may use this file in
+ * accordance with the commercial license agreement provided with the
+ * Software or, alternatively, in accordance with the terms contained in
+ * a written agreement between you and SIC. For further information
+ * contact us at http://opensource.iaik.tugraz.at.
+ * 
+ * Alternatively, this file may be used under the terms of the GNU General
+ * Public License as published by the Free Software Foundation version 2.
+ * 
+ * The Secure Block Device Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with the Secure Block Device Library. If not, see <http://www.gnu.org/licenses/>.
+ */
+///
+/// \file
+/// \brief Specifies an AES-GCM (NIST SP 800-38D) authenticated encryption
+/// implementation.
+///
+/// The implementation uses AES-NI for the CTR part and PCLMULQDQ for GHASH
+/// if the CPU supports both instruction set extensions. Otherwise it falls
+/// back to the reference AES implementation and a 4 bit table driven GHASH.
+/// The context is never modified after gcm_init, so a single context can be
+/// shared by concurrent encryptions and decryptions.
+///
+#ifndef GCM_H_
+#define GCM_H_
+
+#include "aes.h"
+
+#include <stdint.h>
+
+#define GCM_IV_SIZE   12 //!< The size in bytes of the GCM initialization vector
+#define GCM_TAG_SIZE  16 //!< The size in bytes of the GCM authentication tag
+#define GCM_HPOW_CNT   8 //!< The number of powers of H precomputed for aggregated GHASH
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*!
+ * \brief a GHASH (or POLYVAL) hash key in the representations of both the
+ * generic and the PCLMULQDQ code path
+ */
+typedef struct gcm_hkey {
+  uint64_t HL[16]; //!< the low halves of the 4 bit GHASH multiplication table
+  uint64_t HH[16]; //!< the high halves of the 4 bit GHASH multiplication table
+  unsigned char Hpow[GCM_HPOW_CNT][16]; //!< H^1 .. H^8 in the byte reflected representation of the PCLMULQDQ kernels
+  int use_clmul; //!< non-zero if the PCLMULQDQ kernels are used
+} gcm_hkey;
+
+/*!
+ * \brief the AES-GCM context
+ */
+typedef struct gcm_ctx {
+  AES_KEY key; //!< the AES encryption key schedule
+  gcm_hkey hkey; //!< the GHASH key H = AES_K(0^128)
+} gcm_ctx;
+
+/*!
+ * \brief Determines if the CPU supports the AES-NI, SSSE3 and PCLMULQDQ
+ * instructions the accelerated code path requires
+ *
+ * @return non-zero if the accelerated code path is used; zero otherwise
+ */
+int gcm_clmul_is_available(void);
+
+/*!
+ * \brief Initializes a GHASH key
+ *
+ * @param hkey[out] the hash key to initialize
+ * @param h[in] the 16 byte hash key H
+ */
+void gcm_hkey_init(gcm_hkey *hkey, const unsigned char *h);
+
+/*!
+ * \brief Initializes a POLYVAL (RFC 8452) key
+ *
+ * POLYVAL is computed as a GHASH over byte reversed blocks with the key
+ * mulX_GHASH(ByteReverse(H)) (RFC 8452, appendix A), so the POLYVAL key
+ * shares the representation and the kernels of the GHASH key.
+ *
+ * @param hkey[out] the hash key to initialize
+ * @param h[in] the 16 byte POLYVAL key H
+ */
+void gcm_polyval_hkey_init(gcm_hkey *hkey, const unsigned char *h);
+
+/*!
+ * \brief Absorbs len bytes into the POLYVAL state s; a trailing partial
+ * block is padded with zeros
+ *
+ * @param hkey[in] a hash key initialized with gcm_polyval_hkey_init
+ * @param s[inout] the 16 byte POLYVAL state
+ * @param in[in] the input
+ * @param len[in] the length of the input
+ */
+void gcm_polyval(const gcm_hkey *hkey, unsigned char *s,
+    const unsigned char *in, const int len);
+
+/*!
+ * \brief Initializes a GCM context with the given key
+ *
+ * @param ctx[out] the context to initialize
+ * @param key[in] the AES key
+ * @param key_bits[in] the size of the AES key in bits (128, 192 or 256)
+ * @return 0 if the initialization was successful; -1 otherwise
+ */
+int gcm_init(gcm_ctx *ctx, const unsigned char *key, const int key_bits);
+
+/*!
+ * \brief Overwrites all key material of the given GCM context
+ *
+ * @param ctx[inout] the context to clear
+ */
+void gcm_clear(gcm_ctx *ctx);
+
+/*!
+ * \brief Encrypts and authenticates a message
+ *
+ * @param ctx[in] the GCM context
+ * @param iv[in] the GCM_IV_SIZE byte initialization vector
+ * @param ad[in] the additional authenticated data (can be NULL if ad_len is 0)
+ * @param ad_len[in] the length of the additional authenticated data
+ * @param p[in] the plaintext
+ * @param c[out] the ciphertext (may be equal to p)
+ * @param len[in] the length of the plaintext
+ * @param tag[out] the GCM_TAG_SIZE byte authentication tag
+ */
+void gcm_encrypt(const gcm_ctx *ctx, const unsigned char *iv,
+    const unsigned char *ad, const int ad_len, const unsigned char *p,
+    unsigned char *c, const int len, unsigned char *tag);
+
+/*!
+ * \brief Verifies and decrypts a message
+ *
+ * If the tag does not match, the plaintext buffer is cleared.
+ *
+ * @param ctx[in] the GCM context
+ * @param iv[in] the GCM_IV_SIZE byte initialization vector
+ * @param ad[in] the additional authenticated data (can be NULL if ad_len is 0)
+ * @param ad_len[in] the length of the additional authenticated data
+ * @param c[in] the ciphertext
+ * @param p[out] the plaintext (may be equal to c)
+ * @param len[in] the length of the ciphertext
+ * @param tag[in] the GCM_TAG_SIZE byte authentication tag
+ * @return 1 if the tag is valid; -1 otherwise
+ */
+int gcm_decrypt(const gcm_ctx *ctx, const unsigned char *iv,
+    const unsigned char *ad, const int ad_len, const unsigned char *c,
+    unsigned char *p, const int len, const unsigned char *tag);
+
+/*!
+ * \brief Computes the GCM tag of a message without encrypting it
+ *
+ * The message takes the place of the GCM ciphertext. The result equals the
+ * tag gcm_encrypt computes for a plaintext that encrypts to m, and for an
+ * empty message it is the GMAC of the additional data.
+ *
+ * @param ctx[in] the GCM context
+ * @param iv[in] the GCM_IV_SIZE byte initialization vector
+ * @param ad[in] the additional authenticated data (can be NULL if ad_len is 0)
+ * @param ad_len[in] the length of the additional authenticated data
+ * @param m[in] the message to authenticate (can be NULL if len is 0)
+ * @param len[in] the length of the message
+ * @param tag[out] the GCM_TAG_SIZE byte authentication tag
+ */
+void gcm_mac(const gcm_ctx *ctx, const unsigned char *iv,
+    const unsigned char *ad, const int ad_len, const unsigned char *m,
+    const int len, unsigned char *tag);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GCM_H_ */
@@ -0,0 +1,199 @@
+/* Copyright (c) IAIK, Graz University of Technology, 2015.
+ * All rights reserved.
+ * Contact: http://opensource.iaik.tugraz.at
+ * 
+ * This file is part of the Secure Block Device Library.
+ * 
+ * Commercial License Usage
+ * Licensees holding valid commercial licenses may use this file in
+ * accordance with the commercial license agreement provided with the
+ * Software or, alternatively, in accordance with the terms contained in
+ * a written agreement between you and SIC. For further information
+ * contact us at http://opensource.iaik.tugraz.at.
+ * 
+ * Alternatively, this file may be used under the terms of the GNU General
+ * Public License as published by the Free Software Foundation version 2.
+ * 
+ * The Secure Block Device Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with the Secure Block Device Library. If not, see <http://www.gnu.org/licenses/>.
+ */
+///
+/// \file
+/// \brief Implements AES-GCM-SIV (RFC 8452).
+///
+#include "gcm_siv.h"
+#include "gcm.h"
+#include "aes_ni.h"
+#include "aes_ct.h"
+
+#include <string.h>
+
+#define GCM_SIV_BLOCK_SIZE 16
+#define GCM_SIV_MAX_KEY_BLKS 6
+
+/*!
+ * \brief Stores v in little endian byte order
+ */
+static inline void gcm_siv_store_le64(unsigned char *p, const uint64_t v)
+{
+  for (int i = 0; i < 8; ++i) {
+    p[i] = (unsigned char) (v >> (8 * i));
+  }
+}
+
+/*!
+ * \brief Runs the AES-GCM-SIV CTR mode, which increments the first 32 bits
+ * of the counter block as a little endian integer
+ */
+static void gcm_siv_ctr(const gcm_siv_ctx *ctx, const AES_KEY *key,
+    const unsigned char ctr[GCM_SIV_BLOCK_SIZE], const unsigned char *in,
+    unsigned char *out, const int len)
+{
+#if AES_NI_SUPPORTED
+  if (ctx->use_ni) {
+    aes_ni_ctr32(key, in, out, len, ctr, 1);
+    return;
+  }
+#endif
+  if (key->use_ct) {
+    aes_ct_ctr32(key->ct_key, key->rounds, in, out, len, ctr, 1);
+    return;
+  }
+  unsigned char cb[GCM_SIV_BLOCK_SIZE], ks[GCM_SIV_BLOCK_SIZE];
+  memcpy(cb, ctr, GCM_SIV_BLOCK_SIZE);
+  for (int i = 0; i < len; i += GCM_SIV_BLOCK_SIZE) {
+    const int n = (len - i < GCM_SIV_BLOCK_SIZE) ? len - i : GCM_SIV_BLOCK_SIZE;
+    AES_encrypt(cb, ks, key);
+    for (int j = 0; j < n; ++j) {
+      out[i + j] = in[i + j] ^ ks[j];
+    }
+    for (int j = 0; j < 4; ++j) {
+      if (++cb[j]) {
+        break;
+      }
+    }
+  }
+  memset(ks, 0, GCM_SIV_BLOCK_SIZE);
+}
+
+/*!
+ * \brief Derives the per nonce message authentication and message
+ * encryption keys (RFC 8452, section 4)
+ *
+ * The key derivation encrypts the blocks LE32(i) || nonce, which is the
+ * key stream of the AES-GCM-SIV CTR mode for the initial counter block
+ * LE32(0) || nonce.
+ */
+static void gcm_siv_derive_keys(const gcm_siv_ctx *ctx,
+    const unsigned char *nonce, gcm_hkey *hkey, AES_KEY *enc_key)
+{
+  unsigned char ctr[GCM_SIV_BLOCK_SIZE];
+  unsigned char ks[GCM_SIV_MAX_KEY_BLKS * GCM_SIV_BLOCK_SIZE];
+  unsigned char k[GCM_SIV_MAX_KEY_BLKS / 2 * GCM_SIV_BLOCK_SIZE];
+  const int nblk = (ctx->key_bits == 256) ? 6 : 4;
+  memset(ctr, 0, 4);
+  memcpy(ctr + 4, nonce, GCM_SIV_NONCE_SIZE);
+  memset(ks, 0, sizeof(ks));
+  gcm_siv_ctr(ctx, &ctx->kgk, ctr, ks, ks, nblk * GCM_SIV_BLOCK_SIZE);
+  // Only the first half of each block is used
+  for (int i = 0; i < nblk; ++i) {
+    memcpy(k + i * 8, ks + i * GCM_SIV_BLOCK_SIZE, 8);
+  }
+  gcm_polyval_hkey_init(hkey, k);
+  if (!ctx->use_ni) {
+    hkey->use_clmul = 0;
+  }
+  AES_set_encrypt_key(k + GCM_SIV_BLOCK_SIZE, ctx->key_bits, enc_key);
+  memset(ks, 0, sizeof(ks));
+  memset(k, 0, sizeof(k));
+}
+
+/*!
+ * \brief Computes the AES-GCM-SIV tag of the given plaintext
+ */
+static void gcm_siv_tag(const gcm_hkey *hkey, const AES_KEY *enc_key,
+    const unsigned char *nonce, const unsigned char *ad, const int ad_len,
+    const unsigned char *p, const int len,
+    unsigned char tag[GCM_SIV_TAG_SIZE])
+{
+  unsigned char s[GCM_SIV_BLOCK_SIZE], lb[GCM_SIV_BLOCK_SIZE];
+  memset(s, 0, GCM_SIV_BLOCK_SIZE);
+  gcm_polyval(hkey, s, ad, ad_len);
+  gcm_polyval(hkey, s, p, len);
+  gcm_siv_store_le64(lb, (uint64_t) ad_len * 8);
+  gcm_siv_store_le64(lb + 8, (uint64_t) len * 8);
+  gcm_polyval(hkey, s, lb, GCM_SIV_BLOCK_SIZE);
+  for (int i = 0; i < GCM_SIV_NONCE_SIZE; ++i) {
+    s[i] ^= nonce[i];
+  }
+  s[GCM_SIV_BLOCK_SIZE - 1] &= 0x7f;
+  AES_encrypt(s, tag, enc_key);
+}
+
+//----------------------------------------------------------------------
+int gcm_siv_init(gcm_siv_ctx *ctx, const unsigned char *key,
+    const int key_bits)
+{
+  memset(ctx, 0, sizeof(gcm_siv_ctx));
+  if ((key_bits != 128 && key_bits != 256)
+      || AES_set_encrypt_key(key, key_bits, &ctx->kgk) != 0) {
+    return -1;
+  }
+  ctx->key_bits = key_bits;
+  ctx->use_ni = gcm_clmul_is_available();
+  return 0;
+}
+
+//----------------------------------------------------------------------
+void gcm_siv_clear(gcm_siv_ctx *ctx)
+{
+  memset(ctx, 0, sizeof(gcm_siv_ctx));
+}
+
+//----------------------------------------------------------------------
+void gcm_siv_encrypt(const gcm_siv_ctx *ctx, const unsigned char *nonce,
+    const unsigned char *ad, const int ad_len, const unsigned char *p,
+    unsigned char *c, const int len, unsigned char *tag)
+{
+  gcm_hkey hkey;
+  AES_KEY enc_key;
+  unsigned char ctr[GCM_SIV_BLOCK_SIZE];
+  gcm_siv_derive_keys(ctx, nonce, &hkey, &enc_key);
+  gcm_siv_tag(&hkey, &enc_key, nonce, ad, ad_len, p, len, tag);
+  memcpy(ctr, tag, GCM_SIV_BLOCK_SIZE);
+  ctr[GCM_SIV_BLOCK_SIZE - 1] |= 0x80;
+  gcm_siv_ctr(ctx, &enc_key, ctr, p, c, len);
+  memset(&hkey, 0, sizeof(gcm_hkey));
+  memset(&enc_key, 0, sizeof(AES_KEY));
+}
+
+//----------------------------------------------------------------------
+int gcm_siv_decrypt(const gcm_siv_ctx *ctx, const unsigned char *nonce,
+    const unsigned char *ad, const int ad_len, const unsigned char *c,
+    unsigned char *p, const int len, const unsigned char *tag)
+{
+  gcm_hkey hkey;
+  AES_KEY enc_key;
+  unsigned char ctr[GCM_SIV_BLOCK_SIZE], t[GCM_SIV_TAG_SIZE];
+  gcm_siv_derive_keys(ctx, nonce, &hkey, &enc_key);
+  memcpy(ctr, tag, GCM_SIV_BLOCK_SIZE);
+  ctr[GCM_SIV_BLOCK_SIZE - 1] |= 0x80;
+  gcm_siv_ctr(ctx, &enc_key, ctr, c, p, len);
+  gcm_siv_tag(&hkey, &enc_key, nonce, ad, ad_len, p, len, t);
+  memset(&hkey, 0, sizeof(gcm_hkey));
+  memset(&enc_key, 0, sizeof(AES_KEY));
+  unsigned char d = 0;
+  for (int i = 0; i < GCM_SIV_TAG_SIZE; ++i) {
+    d |= t[i] ^ tag[i];
+  }
+  if (d) {
+    memset(p, 0, len);
+    return -1;
+  }
+  return 1;
+}
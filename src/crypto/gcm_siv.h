@@ -0,0 +1,119 @@
+/* Copyright (c) IAIK, Graz University of Technology, 2015.
+ * All rights reserved.
+ * Contact: http://opensource.iaik.tugraz.at
+ * 
+ * This file is part of the Secure Block Device Library.
+ * 
+ * Commercial License Usage
+ * Licensees holding valid commercial licenses may use this file in
+ * accordance with the commercial license agreement provided with the
+ * Software or, alternatively, in accordance with the terms contained in
+ * a written agreement between you and SIC. For further information
+ * contact us at http://opensource.iaik.tugraz.at.
+ * 
+ * Alternatively, this file may be used under the terms of the GNU General
+ * Public License as published by the Free Software Foundation version 2.
+ * 
+ * The Secure Block Device Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with the Secure Block Device Library. If not, see <http://www.gnu.org/licenses/>.
+ */
+///
+/// \file
+/// \brief Specifies an AES-GCM-SIV (RFC 8452) nonce misuse resistant
+/// authenticated encryption implementation.
+///
+/// AES-GCM-SIV derives a fresh authentication and encryption key from every
+/// nonce, authenticates the plaintext with POLYVAL, and uses the resulting
+/// tag as the initial counter of the CTR encryption. Repeating a nonce only
+/// reveals whether the same message was encrypted twice. POLYVAL uses the
+/// PCLMULQDQ kernels of gcm.c and CTR uses the AES-NI kernels of aes_ni.c if
+/// the CPU supports them. The context is never modified after
+/// gcm_siv_init.
+///
+#ifndef GCM_SIV_H_
+#define GCM_SIV_H_
+
+#include "aes.h"
+
+#define GCM_SIV_NONCE_SIZE 12 //!< The size in bytes of the AES-GCM-SIV nonce
+#define GCM_SIV_TAG_SIZE   16 //!< The size in bytes of the AES-GCM-SIV tag
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*!
+ * \brief the AES-GCM-SIV context
+ */
+typedef struct gcm_siv_ctx {
+  AES_KEY kgk; //!< the key schedule of the key-generating key
+  int key_bits; //!< the size of the key-generating key in bits
+  int use_ni; //!< non-zero if the AES-NI and PCLMULQDQ kernels are used
+} gcm_siv_ctx;
+
+/*!
+ * \brief Initializes an AES-GCM-SIV context with the given key-generating
+ * key
+ *
+ * @param ctx[out] the context to initialize
+ * @param key[in] the key-generating key
+ * @param key_bits[in] the size of the key in bits (128 or 256)
+ * @return 0 if the initialization was successful; -1 otherwise
+ */
+int gcm_siv_init(gcm_siv_ctx *ctx, const unsigned char *key,
+    const int key_bits);
+
+/*!
+ * \brief Overwrites all key material of the given AES-GCM-SIV context
+ *
+ * @param ctx[inout] the context to clear
+ */
+void gcm_siv_clear(gcm_siv_ctx *ctx);
+
+/*!
+ * \brief Encrypts and authenticates a message
+ *
+ * @param ctx[in] the AES-GCM-SIV context
+ * @param nonce[in] the GCM_SIV_NONCE_SIZE byte nonce
+ * @param ad[in] the additional authenticated data (can be NULL if ad_len is
+ * 0)
+ * @param ad_len[in] the length of the additional authenticated data
+ * @param p[in] the plaintext
+ * @param c[out] the ciphertext (may be equal to p)
+ * @param len[in] the length of the plaintext
+ * @param tag[out] the GCM_SIV_TAG_SIZE byte authentication tag
+ */
+void gcm_siv_encrypt(const gcm_siv_ctx *ctx, const unsigned char *nonce,
+    const unsigned char *ad, const int ad_len, const unsigned char *p,
+    unsigned char *c, const int len, unsigned char *tag);
+
+/*!
+ * \brief Decrypts and verifies a message
+ *
+ * If the tag does not match, the plaintext buffer is cleared.
+ *
+ * @param ctx[in] the AES-GCM-SIV context
+ * @param nonce[in] the GCM_SIV_NONCE_SIZE byte nonce
+ * @param ad[in] the additional authenticated data (can be NULL if ad_len is
+ * 0)
+ * @param ad_len[in] the length of the additional authenticated data
+ * @param c[in] the ciphertext
+ * @param p[out] the plaintext (may be equal to c)
+ * @param len[in] the length of the ciphertext
+ * @param tag[in] the GCM_SIV_TAG_SIZE byte authentication tag
+ * @return 1 if the tag is valid; -1 otherwise
+ */
+int gcm_siv_decrypt(const gcm_siv_ctx *ctx, const unsigned char *nonce,
+    const unsigned char *ad, const int ad_len, const unsigned char *c,
+    unsigned char *p, const int len, const unsigned char *tag);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GCM_SIV_H_ */
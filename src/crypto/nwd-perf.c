@@ -48,6 +48,11 @@
 #include "sbdi_ocb.h"
 #include "sbdi_siv.h"
 #include "sbdi_hmac.h"
+#include "sbdi_gcm.h"
+#include "sbdi_gcm_siv.h"
+#include "sbdi_chacha.h"
+#include "sbdi_aegis.h"
+#include "sbdi_gmac.h"
 #include "sbdi_buffer.h"
 
 static const sbdi_key_t key = {
@@ -129,6 +134,26 @@ int main(void)
   // HMAC mode
   nwd_perf_test("hmac", NWD_PERF_MAX_BLOCK_COUNT,
                 &sbdi_hmac_create, &sbdi_hmac_destroy);
+
+  // GCM mode
+  nwd_perf_test("gcm", NWD_PERF_MAX_BLOCK_COUNT,
+                &sbdi_gcm_create, &sbdi_gcm_destroy);
+
+  // AES-GCM-SIV mode
+  nwd_perf_test("gcm-siv", NWD_PERF_MAX_BLOCK_COUNT,
+                &sbdi_gcm_siv_create, &sbdi_gcm_siv_destroy);
+
+  // ChaCha20-Poly1305
+  nwd_perf_test("chacha20-poly1305", NWD_PERF_MAX_BLOCK_COUNT,
+                &sbdi_chacha_create, &sbdi_chacha_destroy);
+
+  // AEGIS-128L
+  nwd_perf_test("aegis128l", NWD_PERF_MAX_BLOCK_COUNT,
+                &sbdi_aegis_create, &sbdi_aegis_destroy);
+
+  // GMAC
+  nwd_perf_test("gmac", NWD_PERF_MAX_BLOCK_COUNT,
+                &sbdi_gmac_create, &sbdi_gmac_destroy);
   return 0;
 }
 
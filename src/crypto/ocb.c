@@ -68,6 +68,11 @@
 /  in better performance.                                                  */
 #define L_TABLE_SZ_IS_ENOUGH 1
 
+/* Set USE_VAES non-zero to let ae_init select VAES/AVX-512 or VAES/AVX2
+/  kernels for the bulk of ae_encrypt and ae_decrypt at runtime. This needs
+/  USE_REFERENCE_AES and L_TABLE_SZ_IS_ENOUGH; it is ignored otherwise.   */
+#define USE_VAES             1
+
 #define DONT_USE_SSE 1
 
 /* ----------------------------------------------------------------------- */
@@ -75,6 +80,7 @@
 /* ----------------------------------------------------------------------- */
 
 #include "ae.h"
+#include "ocb_vaes.h"
 #include <stdlib.h>
 #include <string.h>
 
@@ -346,23 +352,46 @@ static inline void AES_ecb_decrypt_blks(block *blks, unsigned nblks, AES_KEY *ke
 /*-------------------*/
 
 #include "rijndael-alg-fst.h"              /* Barreto's Public-Domain Code */
+#include "aes_ct.h"                  /* Bitsliced encryption without AES-NI */
+
+/* aes_ni.h cannot be included, as its aes.h clashes with AES_KEY below */
+int aes_ni_is_available(void);
+
+/* Encryption keys carry a bitsliced copy of the round keys, which replaces
+   the T-tables if the CPU does not support AES-NI */
 #if (OCB_KEY_LEN == 0)
-	typedef struct { uint32_t rd_key[60]; int rounds; } AES_KEY;
+	typedef struct { uint32_t rd_key[60]; int rounds;
+	                 uint64_t ct_key[AES_CT_SKEY_WORDS(14)]; int use_ct; } AES_KEY;
 	#define ROUNDS(ctx) ((ctx)->rounds)
 	#define AES_set_encrypt_key(x, y, z) \
-	 do {rijndaelKeySetupEnc((z)->rd_key, x, y); (z)->rounds = y/32+6;} while (0)
+	 do {rijndaelKeySetupEnc((z)->rd_key, x, y); (z)->rounds = y/32+6; \
+	     AES_ct_setup(z);} while (0)
 	#define AES_set_decrypt_key(x, y, z) \
-	 do {rijndaelKeySetupDec((z)->rd_key, x, y); (z)->rounds = y/32+6;} while (0)
+	 do {rijndaelKeySetupDec((z)->rd_key, x, y); (z)->rounds = y/32+6; \
+	     (z)->use_ct = 0;} while (0)
 #else
-	typedef struct { uint32_t rd_key[OCB_KEY_LEN+28]; } AES_KEY;
+	typedef struct { uint32_t rd_key[OCB_KEY_LEN+28];
+	                 uint64_t ct_key[AES_CT_SKEY_WORDS(6+OCB_KEY_LEN/4)]; int use_ct; } AES_KEY;
 	#define ROUNDS(ctx) (6+OCB_KEY_LEN/4)
-	#define AES_set_encrypt_key(x, y, z) rijndaelKeySetupEnc((z)->rd_key, x, y)
-	#define AES_set_decrypt_key(x, y, z) rijndaelKeySetupDec((z)->rd_key, x, y)
+	#define AES_set_encrypt_key(x, y, z) \
+	 do {rijndaelKeySetupEnc((z)->rd_key, x, y); AES_ct_setup(z);} while (0)
+	#define AES_set_decrypt_key(x, y, z) \
+	 do {rijndaelKeySetupDec((z)->rd_key, x, y); (z)->use_ct = 0;} while (0)
 #endif
-#define AES_encrypt(x,y,z) rijndaelEncrypt((z)->rd_key, ROUNDS(z), x, y)
+#define AES_ct_setup(z) \
+	 do {(z)->use_ct = !aes_ni_is_available(); \
+	     if ((z)->use_ct) aes_ct_keysched((z)->ct_key, (z)->rd_key, ROUNDS(z));} while (0)
+#define AES_encrypt(x,y,z) ((z)->use_ct ? \
+	 aes_ct_encrypt_blks((z)->ct_key, ROUNDS(z), x, y, 1) : \
+	 rijndaelEncrypt((z)->rd_key, ROUNDS(z), x, y))
 #define AES_decrypt(x,y,z) rijndaelDecrypt((z)->rd_key, ROUNDS(z), x, y)
 
 static void AES_ecb_encrypt_blks(block *blks, unsigned nblks, AES_KEY *key) {
+	if (key->use_ct) {
+		aes_ct_encrypt_blks(key->ct_key, ROUNDS(key), (unsigned char *)blks,
+		                    (unsigned char *)blks, nblks);
+		return;
+	}
 	while (nblks) {
 		--nblks;
 		AES_encrypt((unsigned char *)(blks+nblks), (unsigned char *)(blks+nblks), key);
@@ -556,6 +585,8 @@ static inline void AES_ecb_decrypt_blks(block *blks, unsigned nblks, AES_KEY *ke
 
 #endif
 
+#define OCB_USE_VAES (USE_VAES && USE_REFERENCE_AES && L_TABLE_SZ_IS_ENOUGH)
+
 /* ----------------------------------------------------------------------- */
 /* Define OCB context structure.                                           */
 /* ----------------------------------------------------------------------- */
@@ -587,6 +618,11 @@ struct _ae_ctx {
     #if (OCB_TAG_LEN == 0)
     unsigned tag_len;
     #endif
+    #if OCB_USE_VAES
+    block vaes_prefix[OCB_VAES_CHUNK];     /* Memory correct               */
+    ocb_vaes_fp_t vaes_encrypt;            /* NULL if not supported        */
+    ocb_vaes_fp_t vaes_decrypt;            /* NULL if not supported        */
+    #endif
 };
 
 /* ----------------------------------------------------------------------- */
@@ -696,9 +732,33 @@ int ae_init(ae_ctx *ctx, const void *key, int key_len, int nonce_len, int tag_le
     	(void) tag_len;  /* Suppress var not used error */
     #endif
 
+    #if OCB_USE_VAES
+    /* Offsets of the first OCB_VAES_CHUNK-1 blocks of a chunk relative to
+       the offset in front of the chunk; the last one depends on the block
+       number and is added by the kernels */
+    ocb_vaes_select(&ctx->vaes_encrypt, &ctx->vaes_decrypt, OCB_VAES_WIDTH_MAX);
+    ctx->vaes_prefix[0] = ctx->L[0];
+    for (i = 1; i < OCB_VAES_CHUNK - 1; i++)
+    	ctx->vaes_prefix[i] = xor_block(ctx->vaes_prefix[i-1], ctx->L[ntz(i+1)]);
+    ctx->vaes_prefix[OCB_VAES_CHUNK-1] = ctx->vaes_prefix[OCB_VAES_CHUNK-2];
+    #endif
+
     return AE_SUCCESS;
 }
 
+/* ----------------------------------------------------------------------- */
+
+unsigned ocb_vaes_set_width(ae_ctx *ctx, unsigned max_width)
+{
+    #if OCB_USE_VAES
+    return ocb_vaes_select(&ctx->vaes_encrypt, &ctx->vaes_decrypt, max_width);
+    #else
+    (void) ctx;
+    (void) max_width;
+    return 0;
+    #endif
+}
+
 /* ----------------------------------------------------------------------- */
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wunused-variable"
@@ -891,6 +951,24 @@ int ae_encrypt(ae_ctx     *  ctx,
     offset = ctx->offset;
     checksum  = ctx->checksum;
     i = pt_len/(BPI*16);
+    #if OCB_USE_VAES
+    /* Hand whole chunks to the wide kernel, if there is one */
+    if (ctx->vaes_encrypt && i >= OCB_VAES_CHUNK/BPI
+    		&& (ctx->blocks_processed % OCB_VAES_CHUNK) == 0) {
+    	unsigned n = i / (OCB_VAES_CHUNK/BPI);
+    	ctx->vaes_encrypt(ctx->encrypt_key.rd_key, ROUNDS(&ctx->encrypt_key),
+    			(const unsigned char *)ptp, (unsigned char *)ctp, n,
+    			(unsigned char *)&offset, (unsigned char *)&checksum,
+    			(const unsigned char *)ctx->vaes_prefix,
+    			(const unsigned char *)ctx->L, ctx->blocks_processed);
+    	ptp += n*OCB_VAES_CHUNK;
+    	ctp += n*OCB_VAES_CHUNK;
+    	i -= n*(OCB_VAES_CHUNK/BPI);
+    	ctx->offset = offset;
+    	ctx->blocks_processed += n*OCB_VAES_CHUNK;
+    	ctx->checksum = checksum;
+    }
+    #endif
     if (i) {
     	block oa[BPI];
     	unsigned block_num = ctx->blocks_processed;
@@ -1107,6 +1185,24 @@ int ae_decrypt(ae_ctx     *ctx,
     offset = ctx->offset;
     checksum  = ctx->checksum;
     i = ct_len/(BPI*16);
+    #if OCB_USE_VAES
+    /* Hand whole chunks to the wide kernel, if there is one */
+    if (ctx->vaes_decrypt && i >= OCB_VAES_CHUNK/BPI
+    		&& (ctx->blocks_processed % OCB_VAES_CHUNK) == 0) {
+    	unsigned n = i / (OCB_VAES_CHUNK/BPI);
+    	ctx->vaes_decrypt(ctx->decrypt_key.rd_key, ROUNDS(&ctx->decrypt_key),
+    			(const unsigned char *)ctp, (unsigned char *)ptp, n,
+    			(unsigned char *)&offset, (unsigned char *)&checksum,
+    			(const unsigned char *)ctx->vaes_prefix,
+    			(const unsigned char *)ctx->L, ctx->blocks_processed);
+    	ptp += n*OCB_VAES_CHUNK;
+    	ctp += n*OCB_VAES_CHUNK;
+    	i -= n*(OCB_VAES_CHUNK/BPI);
+    	ctx->offset = offset;
+    	ctx->blocks_processed += n*OCB_VAES_CHUNK;
+    	ctx->checksum = checksum;
+    }
+    #endif
     if (i) {
     	block oa[BPI];
     	unsigned block_num = ctx->blocks_processed;
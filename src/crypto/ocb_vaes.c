@@ -0,0 +1,330 @@
+/* Copyright (c) IAIK, Graz University of Technology, 2015.
+ * All rights reserved.
+ * Contact: http://opensource.iaik.tugraz.at
+ * 
+ * This file is part of the Secure Block Device Library.
+ * 
+ * Commercial License Usage
+ * Licensees holding valid commercial licenses may use this file in
+ * accordance with the commercial license agreement provided with the
+ * Software or, alternatively, in accordance with the terms contained in
+ * a written agreement between you and SIC. For further information
+ * contact us at http://opensource.iaik.tugraz.at.
+ * 
+ * Alternatively, this file may be used under the terms of the GNU General
+ * Public License as published by the Free Software Foundation version 2.
+ * 
+ * The Secure Block Device Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with the Secure Block Device Library. If not, see <http://www.gnu.org/licenses/>.
+ */
+///
+/// \file
+/// \brief Implements the VAES accelerated OCB bulk kernels.
+///
+/// The offsets of a chunk are computed in vector registers: the offset of
+/// block j + 1 of a chunk is the offset in front of the chunk xor prefix[j].
+/// Only the last block of a chunk depends on the block number, its L value
+/// gets inserted into the highest lane.
+///
+#include "ocb_vaes.h"
+
+#include <stddef.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+# define OCB_VAES_SUPPORTED 1
+# include <cpuid.h>
+# include <immintrin.h>
+#else
+# define OCB_VAES_SUPPORTED 0
+#endif
+
+#if OCB_VAES_SUPPORTED
+#define OCB_VAES_MAXNR 14
+
+/*!
+ * \brief Converts a rijndael-alg-fst round key into a byte string round key
+ *
+ * @param rk[in] the first of the four round key words
+ * @return the round key as AES-NI expects it
+ */
+__attribute__((target("ssse3")))
+static inline __m128i ocb_vaes_load_rk(const uint32_t *rk)
+{
+  const __m128i bswap32 = _mm_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6,
+      7, 0, 1, 2, 3);
+  return _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) rk), bswap32);
+}
+
+/*!
+ * \brief Processes OCB chunks with four 512 bit registers per chunk
+ *
+ * @see ocb_vaes_fp_t
+ * @param decrypt[in] non-zero to decrypt; zero to encrypt
+ */
+__attribute__((target("vaes,avx512f")))
+static inline void ocb_vaes512_crypt(const uint32_t *rk, int rounds,
+    const unsigned char *in, unsigned char *out, unsigned nchunks,
+    unsigned char *offset, unsigned char *checksum,
+    const unsigned char *prefix, const unsigned char *L, unsigned block_num,
+    const int decrypt)
+{
+  __m512i k[OCB_VAES_MAXNR + 1];
+  for (int r = 0; r <= rounds; ++r) {
+    k[r] = _mm512_broadcast_i32x4(ocb_vaes_load_rk(rk + 4 * r));
+  }
+  const __m512i p0 = _mm512_loadu_si512((const void *) (prefix + 0));
+  const __m512i p1 = _mm512_loadu_si512((const void *) (prefix + 64));
+  const __m512i p2 = _mm512_loadu_si512((const void *) (prefix + 128));
+  const __m512i p3 = _mm512_loadu_si512((const void *) (prefix + 192));
+  __m128i off = _mm_loadu_si128((const __m128i *) offset);
+  __m512i sum = _mm512_setzero_si512();
+
+  for (unsigned c = 0; c < nchunks; ++c) {
+    block_num += OCB_VAES_CHUNK;
+    const __m512i o = _mm512_broadcast_i32x4(off);
+    const __m128i l = _mm_loadu_si128(
+        (const __m128i *) (L + 16 * __builtin_ctz(block_num)));
+    const __m512i o0 = _mm512_xor_si512(o, p0);
+    const __m512i o1 = _mm512_xor_si512(o, p1);
+    const __m512i o2 = _mm512_xor_si512(o, p2);
+    const __m512i o3 = _mm512_xor_si512(_mm512_xor_si512(o, p3),
+        _mm512_inserti32x4(_mm512_setzero_si512(), l, 3));
+    const __m512i x0 = _mm512_loadu_si512((const void *) (in + 0));
+    const __m512i x1 = _mm512_loadu_si512((const void *) (in + 64));
+    const __m512i x2 = _mm512_loadu_si512((const void *) (in + 128));
+    const __m512i x3 = _mm512_loadu_si512((const void *) (in + 192));
+    __m512i t0 = _mm512_xor_si512(_mm512_xor_si512(x0, o0), k[0]);
+    __m512i t1 = _mm512_xor_si512(_mm512_xor_si512(x1, o1), k[0]);
+    __m512i t2 = _mm512_xor_si512(_mm512_xor_si512(x2, o2), k[0]);
+    __m512i t3 = _mm512_xor_si512(_mm512_xor_si512(x3, o3), k[0]);
+    if (decrypt) {
+      for (int r = 1; r < rounds; ++r) {
+        t0 = _mm512_aesdec_epi128(t0, k[r]);
+        t1 = _mm512_aesdec_epi128(t1, k[r]);
+        t2 = _mm512_aesdec_epi128(t2, k[r]);
+        t3 = _mm512_aesdec_epi128(t3, k[r]);
+      }
+      t0 = _mm512_aesdeclast_epi128(t0, k[rounds]);
+      t1 = _mm512_aesdeclast_epi128(t1, k[rounds]);
+      t2 = _mm512_aesdeclast_epi128(t2, k[rounds]);
+      t3 = _mm512_aesdeclast_epi128(t3, k[rounds]);
+    } else {
+      sum = _mm512_xor_si512(sum,
+          _mm512_xor_si512(_mm512_xor_si512(x0, x1), _mm512_xor_si512(x2, x3)));
+      for (int r = 1; r < rounds; ++r) {
+        t0 = _mm512_aesenc_epi128(t0, k[r]);
+        t1 = _mm512_aesenc_epi128(t1, k[r]);
+        t2 = _mm512_aesenc_epi128(t2, k[r]);
+        t3 = _mm512_aesenc_epi128(t3, k[r]);
+      }
+      t0 = _mm512_aesenclast_epi128(t0, k[rounds]);
+      t1 = _mm512_aesenclast_epi128(t1, k[rounds]);
+      t2 = _mm512_aesenclast_epi128(t2, k[rounds]);
+      t3 = _mm512_aesenclast_epi128(t3, k[rounds]);
+    }
+    t0 = _mm512_xor_si512(t0, o0);
+    t1 = _mm512_xor_si512(t1, o1);
+    t2 = _mm512_xor_si512(t2, o2);
+    t3 = _mm512_xor_si512(t3, o3);
+    if (decrypt) {
+      sum = _mm512_xor_si512(sum,
+          _mm512_xor_si512(_mm512_xor_si512(t0, t1), _mm512_xor_si512(t2, t3)));
+    }
+    _mm512_storeu_si512((void *) (out + 0), t0);
+    _mm512_storeu_si512((void *) (out + 64), t1);
+    _mm512_storeu_si512((void *) (out + 128), t2);
+    _mm512_storeu_si512((void *) (out + 192), t3);
+    off = _mm512_extracti32x4_epi32(o3, 3);
+    in += 16 * OCB_VAES_CHUNK;
+    out += 16 * OCB_VAES_CHUNK;
+  }
+
+  __m128i s = _mm_loadu_si128((const __m128i *) checksum);
+  s = _mm_xor_si128(s, _mm512_extracti32x4_epi32(sum, 0));
+  s = _mm_xor_si128(s, _mm512_extracti32x4_epi32(sum, 1));
+  s = _mm_xor_si128(s, _mm512_extracti32x4_epi32(sum, 2));
+  s = _mm_xor_si128(s, _mm512_extracti32x4_epi32(sum, 3));
+  _mm_storeu_si128((__m128i *) checksum, s);
+  _mm_storeu_si128((__m128i *) offset, off);
+}
+
+//----------------------------------------------------------------------
+__attribute__((target("vaes,avx512f")))
+static void ocb_vaes512_encrypt(const uint32_t *rk, int rounds,
+    const unsigned char *in, unsigned char *out, unsigned nchunks,
+    unsigned char *offset, unsigned char *checksum,
+    const unsigned char *prefix, const unsigned char *L, unsigned block_num)
+{
+  ocb_vaes512_crypt(rk, rounds, in, out, nchunks, offset, checksum, prefix, L,
+      block_num, 0);
+}
+
+//----------------------------------------------------------------------
+__attribute__((target("vaes,avx512f")))
+static void ocb_vaes512_decrypt(const uint32_t *rk, int rounds,
+    const unsigned char *in, unsigned char *out, unsigned nchunks,
+    unsigned char *offset, unsigned char *checksum,
+    const unsigned char *prefix, const unsigned char *L, unsigned block_num)
+{
+  ocb_vaes512_crypt(rk, rounds, in, out, nchunks, offset, checksum, prefix, L,
+      block_num, 1);
+}
+
+/*!
+ * \brief Processes OCB chunks with eight 256 bit registers per chunk
+ *
+ * @see ocb_vaes_fp_t
+ * @param decrypt[in] non-zero to decrypt; zero to encrypt
+ */
+__attribute__((target("vaes,avx2")))
+static inline void ocb_vaes256_crypt(const uint32_t *rk, int rounds,
+    const unsigned char *in, unsigned char *out, unsigned nchunks,
+    unsigned char *offset, unsigned char *checksum,
+    const unsigned char *prefix, const unsigned char *L, unsigned block_num,
+    const int decrypt)
+{
+  __m256i k[OCB_VAES_MAXNR + 1];
+  __m256i p[8], o[8], t[8];
+  for (int r = 0; r <= rounds; ++r) {
+    k[r] = _mm256_broadcastsi128_si256(ocb_vaes_load_rk(rk + 4 * r));
+  }
+  for (int j = 0; j < 8; ++j) {
+    p[j] = _mm256_loadu_si256((const __m256i *) (prefix + 32 * j));
+  }
+  __m128i off = _mm_loadu_si128((const __m128i *) offset);
+  __m256i sum = _mm256_setzero_si256();
+
+  for (unsigned c = 0; c < nchunks; ++c) {
+    block_num += OCB_VAES_CHUNK;
+    const __m256i ob = _mm256_broadcastsi128_si256(off);
+    const __m128i l = _mm_loadu_si128(
+        (const __m128i *) (L + 16 * __builtin_ctz(block_num)));
+    for (int j = 0; j < 8; ++j) {
+      o[j] = _mm256_xor_si256(ob, p[j]);
+    }
+    o[7] = _mm256_xor_si256(o[7],
+        _mm256_inserti128_si256(_mm256_setzero_si256(), l, 1));
+    for (int j = 0; j < 8; ++j) {
+      const __m256i x = _mm256_loadu_si256((const __m256i *) (in + 32 * j));
+      if (!decrypt) {
+        sum = _mm256_xor_si256(sum, x);
+      }
+      t[j] = _mm256_xor_si256(_mm256_xor_si256(x, o[j]), k[0]);
+    }
+    if (decrypt) {
+      for (int r = 1; r < rounds; ++r) {
+        for (int j = 0; j < 8; ++j) {
+          t[j] = _mm256_aesdec_epi128(t[j], k[r]);
+        }
+      }
+      for (int j = 0; j < 8; ++j) {
+        t[j] = _mm256_aesdeclast_epi128(t[j], k[rounds]);
+      }
+    } else {
+      for (int r = 1; r < rounds; ++r) {
+        for (int j = 0; j < 8; ++j) {
+          t[j] = _mm256_aesenc_epi128(t[j], k[r]);
+        }
+      }
+      for (int j = 0; j < 8; ++j) {
+        t[j] = _mm256_aesenclast_epi128(t[j], k[rounds]);
+      }
+    }
+    for (int j = 0; j < 8; ++j) {
+      t[j] = _mm256_xor_si256(t[j], o[j]);
+      if (decrypt) {
+        sum = _mm256_xor_si256(sum, t[j]);
+      }
+      _mm256_storeu_si256((__m256i *) (out + 32 * j), t[j]);
+    }
+    off = _mm256_extracti128_si256(o[7], 1);
+    in += 16 * OCB_VAES_CHUNK;
+    out += 16 * OCB_VAES_CHUNK;
+  }
+
+  __m128i s = _mm_loadu_si128((const __m128i *) checksum);
+  s = _mm_xor_si128(s, _mm256_extracti128_si256(sum, 0));
+  s = _mm_xor_si128(s, _mm256_extracti128_si256(sum, 1));
+  _mm_storeu_si128((__m128i *) checksum, s);
+  _mm_storeu_si128((__m128i *) offset, off);
+}
+
+//----------------------------------------------------------------------
+__attribute__((target("vaes,avx2")))
+static void ocb_vaes256_encrypt(const uint32_t *rk, int rounds,
+    const unsigned char *in, unsigned char *out, unsigned nchunks,
+    unsigned char *offset, unsigned char *checksum,
+    const unsigned char *prefix, const unsigned char *L, unsigned block_num)
+{
+  ocb_vaes256_crypt(rk, rounds, in, out, nchunks, offset, checksum, prefix, L,
+      block_num, 0);
+}
+
+//----------------------------------------------------------------------
+__attribute__((target("vaes,avx2")))
+static void ocb_vaes256_decrypt(const uint32_t *rk, int rounds,
+    const unsigned char *in, unsigned char *out, unsigned nchunks,
+    unsigned char *offset, unsigned char *checksum,
+    const unsigned char *prefix, const unsigned char *L, unsigned block_num)
+{
+  ocb_vaes256_crypt(rk, rounds, in, out, nchunks, offset, checksum, prefix, L,
+      block_num, 1);
+}
+
+/*!
+ * \brief Reads the extended control register XCR0
+ *
+ * @return the register state components the operating system saves
+ */
+static inline uint64_t ocb_vaes_xgetbv(void)
+{
+  uint32_t lo, hi;
+  __asm__ __volatile__ ("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+  return ((uint64_t) hi << 32) | lo;
+}
+
+//----------------------------------------------------------------------
+unsigned ocb_vaes_select(ocb_vaes_fp_t *enc, ocb_vaes_fp_t *dec,
+    unsigned max_width)
+{
+  unsigned int eax, ebx, ecx, edx;
+  *enc = NULL;
+  *dec = NULL;
+  if (max_width < 256 || !__get_cpuid(1, &eax, &ebx, &ecx, &edx)
+      || !(ecx & bit_OSXSAVE) || !(ecx & bit_SSSE3)
+      || __get_cpuid_max(0, NULL) < 7) {
+    return 0;
+  }
+  const uint64_t xcr0 = ocb_vaes_xgetbv();
+  __cpuid_count(7, 0, eax, ebx, ecx, edx);
+  if (!(ecx & bit_VAES) || (xcr0 & 0x6) != 0x6) {
+    return 0;
+  }
+  if (max_width >= 512 && (ebx & bit_AVX512F) && (xcr0 & 0xe6) == 0xe6) {
+    *enc = &ocb_vaes512_encrypt;
+    *dec = &ocb_vaes512_decrypt;
+    return 512;
+  } else if (ebx & bit_AVX2) {
+    *enc = &ocb_vaes256_encrypt;
+    *dec = &ocb_vaes256_decrypt;
+    return 256;
+  }
+  return 0;
+}
+
+#else
+//----------------------------------------------------------------------
+unsigned ocb_vaes_select(ocb_vaes_fp_t *enc, ocb_vaes_fp_t *dec,
+    unsigned max_width)
+{
+  (void) max_width;
+  *enc = NULL;
+  *dec = NULL;
+  return 0;
+}
+#endif
@@ -0,0 +1,110 @@
+/* Copyright (c) IAIK, Graz University of Technology, 2015.
+ * All rights reserved.
+ * Contact: http://opensource.iaik.tugraz.at
+ * 
+ * This file is part of the Secure Block Device Library.
+ * 
+ * Commercial License Usage
+ * Licensees holding valid commercial licenses may use this file in
+ * accordance with the commercial license agreement provided with the
+ * Software or, alternatively, in accordance with the terms contained in
+ * a written agreement between you and SIC. For further information
+ * contact us at http://opensource.iaik.tugraz.at.
+ * 
+ * Alternatively, this file may be used under the terms of the GNU General
+ * Public License as published by the Free Software Foundation version 2.
+ * 
+ * The Secure Block Device Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with the Secure Block Device Library. If not, see <http://www.gnu.org/licenses/>.
+ */
+///
+/// \file
+/// \brief Specifies the VAES accelerated OCB bulk kernels.
+///
+/// The kernels process whole chunks of OCB_VAES_CHUNK blocks with 256 bit
+/// (VAES/AVX2) or 512 bit (VAES/AVX-512) registers. They only cover the bulk
+/// part of ae_encrypt and ae_decrypt; partial chunks, the final blocks and
+/// the tag are left to the generic OCB code. ae_init selects a kernel with
+/// ocb_vaes_select.
+///
+#ifndef OCB_VAES_H_
+#define OCB_VAES_H_
+
+#include "ae.h"
+
+#include <stdint.h>
+
+#define OCB_VAES_CHUNK 16 //!< The number of blocks the kernels process per iteration
+#define OCB_VAES_WIDTH_MAX 512u //!< The register width in bits of the widest kernels
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*!
+ * \brief Defines a function pointer to an OCB bulk kernel
+ *
+ * The kernel encrypts (or decrypts) nchunks * OCB_VAES_CHUNK blocks. All
+ * blocks are memory correct 16 byte strings. The number of blocks processed
+ * before the first block of in must be a multiple of OCB_VAES_CHUNK, so that
+ * the offsets of all but the last block of a chunk can be derived from the
+ * prefix table.
+ *
+ * @param rk[in] the rijndael-alg-fst key schedule (encryption schedule for
+ * encryption kernels, decryption schedule for decryption kernels)
+ * @param rounds[in] the number of AES rounds
+ * @param in[in] the input blocks
+ * @param out[out] the output blocks (may be equal to in)
+ * @param nchunks[in] the number of chunks to process
+ * @param offset[inout] the OCB offset of the last processed block
+ * @param checksum[inout] the OCB plaintext checksum
+ * @param prefix[in] prefix[j] is the xor of L[ntz(k)] for k = 1 .. j + 1
+ * (j < OCB_VAES_CHUNK - 1); prefix[OCB_VAES_CHUNK - 1] equals
+ * prefix[OCB_VAES_CHUNK - 2]
+ * @param L[in] the OCB L table
+ * @param block_num[in] the number of blocks processed before in
+ */
+typedef void (*ocb_vaes_fp_t)(const uint32_t *rk, int rounds,
+    const unsigned char *in, unsigned char *out, unsigned nchunks,
+    unsigned char *offset, unsigned char *checksum,
+    const unsigned char *prefix, const unsigned char *L, unsigned block_num);
+
+/*!
+ * \brief Selects the widest OCB bulk kernels the CPU supports, up to the
+ * given register width
+ *
+ * @param enc[out] the encryption kernel (NULL if none is selected)
+ * @param dec[out] the decryption kernel (NULL if none is selected)
+ * @param max_width[in] the maximum register width in bits; 0 selects none
+ * @return the register width in bits of the selected kernels; 0 if none is
+ * selected
+ */
+unsigned ocb_vaes_select(ocb_vaes_fp_t *enc, ocb_vaes_fp_t *dec,
+    unsigned max_width);
+
+/*!
+ * \brief Reselects the OCB bulk kernels of an initialized context
+ *
+ * ae_init selects the widest kernels the CPU supports. This function limits
+ * the kernels to the given register width, e.g. to compare the kernels with
+ * each other and with the generic code path, which is used if no kernel is
+ * selected.
+ *
+ * @param ctx[in] the OCB context initialized by ae_init
+ * @param max_width[in] the maximum register width in bits; 0 selects the
+ * generic code path
+ * @return the register width in bits of the selected kernels; 0 if the
+ * generic code path is used
+ */
+unsigned ocb_vaes_set_width(ae_ctx *ctx, unsigned max_width);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OCB_VAES_H_ */
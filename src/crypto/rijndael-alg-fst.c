@@ -1219,3 +1219,25 @@ void rijndaelDecrypt(const u32 rk[/*4*(Nr + 1)*/], int Nr, const u8 ct[16], u8 p
 		rk[3];
 	PUTU32(pt + 12, s3);
 }
+
+/**
+ * Applies a single full encryption round (SubBytes, ShiftRows, MixColumns
+ * and AddRoundKey) to the state, with the round key given as a byte array.
+ * This is the operation of the AESENC instruction.
+ */
+void rijndaelEncryptRound(const u8 in[16], const u8 rk[16], u8 out[16]) {
+	u32 s0, s1, s2, s3, t0, t1, t2, t3;
+
+	s0 = GETU32(in     );
+	s1 = GETU32(in +  4);
+	s2 = GETU32(in +  8);
+	s3 = GETU32(in + 12);
+	t0 = Te0[s0 >> 24] ^ Te1[(s1 >> 16) & 0xff] ^ Te2[(s2 >>  8) & 0xff] ^ Te3[s3 & 0xff] ^ GETU32(rk     );
+	t1 = Te0[s1 >> 24] ^ Te1[(s2 >> 16) & 0xff] ^ Te2[(s3 >>  8) & 0xff] ^ Te3[s0 & 0xff] ^ GETU32(rk +  4);
+	t2 = Te0[s2 >> 24] ^ Te1[(s3 >> 16) & 0xff] ^ Te2[(s0 >>  8) & 0xff] ^ Te3[s1 & 0xff] ^ GETU32(rk +  8);
+	t3 = Te0[s3 >> 24] ^ Te1[(s0 >> 16) & 0xff] ^ Te2[(s1 >>  8) & 0xff] ^ Te3[s2 & 0xff] ^ GETU32(rk + 12);
+	PUTU32(out     , t0);
+	PUTU32(out +  4, t1);
+	PUTU32(out +  8, t2);
+	PUTU32(out + 12, t3);
+}
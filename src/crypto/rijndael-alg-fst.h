@@ -36,5 +36,6 @@ int rijndaelKeySetupEnc(uint32_t rk[/*4*(Nr + 1)*/], const uint8_t cipherKey[],
 int rijndaelKeySetupDec(uint32_t rk[/*4*(Nr + 1)*/], const uint8_t cipherKey[], int keyBits);
 void rijndaelEncrypt(const uint32_t rk[/*4*(Nr + 1)*/], int Nr, const uint8_t pt[16], uint8_t ct[16]);
 void rijndaelDecrypt(const uint32_t rk[/*4*(Nr + 1)*/], int Nr, const uint8_t ct[16], uint8_t pt[16]);
+void rijndaelEncryptRound(const uint8_t in[16], const uint8_t rk[16], uint8_t out[16]);
 
 #endif /* LIB_CRYPTO_RIJNDAEL_ALG_FST_H */
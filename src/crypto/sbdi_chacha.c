@@ -0,0 +1,270 @@
+/* Copyright (c) IAIK, Graz University of Technology, 2015.
+ * All rights reserved.
+ * Contact: http://opensource.iaik.tugraz.at
+ * 
+ * This file is part of the Secure Block Device Library.
+ * 
+ * Commercial License Usage
+ * Licensees holding valid commercial licenses may use this file in
+ * accordance with the commercial license agreement provided with the
+ * Software or, alternatively, in accordance with the terms contained in
+ * a written agreement between you and SIC. For further information
+ * contact us at http://opensource.iaik.tugraz.at.
+ * 
+ * Alternatively, this file may be used under the terms of the GNU General
+ * Public License as published by the Free Software Foundation version 2.
+ * 
+ * The Secure Block Device Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with the Secure Block Device Library. If not, see <http://www.gnu.org/licenses/>.
+ */
+///
+/// \file
+/// \brief Implements Secure Block Device Library cryptographic abstraction
+/// layer that uses ChaCha20-Poly1305 (RFC 8439) for data block protection
+/// and AES CMAC for management block protection.
+///
+/// The ChaCha20-Poly1305 nonce is derived from the block counter exactly
+/// like the OCB and GCM nonces.
+///
+#include "sbdi_chacha.h"
+#include "sbdi_buffer.h"
+
+#include "chacha20_poly1305.h"
+#include "siv.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// NOTE ChaCha20-Poly1305 truncates counter to 12 bytes
+
+#define SBDI_CHACHA_AD_SIZE     (4u + (SBDI_BLOCK_CTR_SIZE))
+#define SBDI_CHACHA_CMAC_KEY_SIZE 32u
+
+/*!
+ * \brief Wraps the two sub-contexts required by the ChaCha20-Poly1305
+ * cryptographic abstraction layer
+ *
+ * Neither sub-context is modified after creation, which allows the
+ * ChaCha20-Poly1305 cryptographic abstraction layer to provide batch
+ * operations.
+ */
+typedef struct sbdi_chacha_ctx {
+  chacha20_poly1305_ctx cp_ctx; //!< the ChaCha20-Poly1305 authenticating encryption context
+  siv_ctx siv_ctx; //!< the SIV context which is used for computing the CMAC
+} sbdi_chacha_ctx_t;
+
+/*!
+ * \brief Serializes the block number and the block counter into ad
+ *
+ * @param ad[out] the buffer receiving the block number and the counter
+ * @param blk_nbr[in] the physical block number
+ * @param ctr[in] the block counter, if pkd_ctr is NULL
+ * @param pkd_ctr[in] the packed block counter (can be NULL)
+ * @return a pointer to the CHACHA20_NONCE_SIZE byte nonce within ad
+ */
+static const unsigned char *sbdi_chacha_nonce(uint8_t ad[SBDI_CHACHA_AD_SIZE],
+    const uint32_t blk_nbr, const sbdi_ctr_128b_t *ctr, const uint8_t *pkd_ctr)
+{
+  sbdi_buffer_t b;
+  memset(&b, 0, sizeof(sbdi_buffer_t));
+  memset(ad, 0, SBDI_CHACHA_AD_SIZE);
+  sbdi_buffer_init(&b, ad, SBDI_CHACHA_AD_SIZE);
+  sbdi_buffer_write_uint32_t(&b, blk_nbr);
+  // Truncate the 4 highermost bytes of the counter!
+  const unsigned char *np = sbdi_buffer_get_cptr(&b) + 4;
+  if (pkd_ctr) {
+    sbdi_buffer_write_bytes(&b, pkd_ctr, SBDI_BLOCK_CTR_SIZE);
+  } else {
+    sbdi_buffer_write_ctr_128b(&b, ctr);
+  }
+  return np;
+}
+
+//----------------------------------------------------------------------
+sbdi_error_t sbdi_chacha_encrypt(void *ctx, const uint8_t *pt, const int pt_len,
+    const sbdi_ctr_128b_t *ctr, const uint32_t blk_nbr, uint8_t *ct,
+    sbdi_tag_t tag)
+{
+  SBDI_CHK_PARAM(
+      ctx && pt && pt_len > 0 && ctr && sbdi_block_is_valid_phy(blk_nbr) && ct
+          && tag);
+  const chacha20_poly1305_ctx *c_ctx = &((sbdi_chacha_ctx_t *) ctx)->cp_ctx;
+  uint8_t ad[SBDI_CHACHA_AD_SIZE];
+  const unsigned char *np = sbdi_chacha_nonce(ad, blk_nbr, ctr, NULL);
+  chacha20_poly1305_encrypt(c_ctx, np, ad, 4, pt, ct, pt_len, tag);
+  return SBDI_SUCCESS;
+}
+
+//----------------------------------------------------------------------
+sbdi_error_t sbdi_chacha_decrypt(void *ctx, const uint8_t *ct, const int ct_len,
+    const sbdi_ctr_pkd_t ctr, const uint32_t blk_nbr, uint8_t *pt,
+    const sbdi_tag_t tag)
+{
+  SBDI_CHK_PARAM(
+      ctx && ct && ct_len > 0 && ctr && sbdi_block_is_valid_phy(blk_nbr) && pt
+          && tag);
+  const chacha20_poly1305_ctx *c_ctx = &((sbdi_chacha_ctx_t *) ctx)->cp_ctx;
+  uint8_t ad[SBDI_CHACHA_AD_SIZE];
+  const unsigned char *np = sbdi_chacha_nonce(ad, blk_nbr, NULL, ctr);
+  if (chacha20_poly1305_decrypt(c_ctx, np, ad, 4, ct, pt, ct_len, tag) != 1) {
+    return SBDI_ERR_TAG_MISMATCH;
+  }
+  return SBDI_SUCCESS;
+}
+
+//----------------------------------------------------------------------
+sbdi_error_t sbdi_chacha_encrypt_n(void *ctx, const int n,
+    const uint8_t *const *pt, const int pt_len, const sbdi_ctr_128b_t *ctr,
+    const uint32_t *blk_nbr, uint8_t *const *ct, uint8_t *const *tag)
+{
+  SBDI_CHK_PARAM(
+      ctx && n >= 0 && pt && pt_len > 0 && ctr && blk_nbr && ct && tag);
+  for (int i = 0; i < n; ++i) {
+    SBDI_ERR_CHK(
+        sbdi_chacha_encrypt(ctx, pt[i], pt_len, &ctr[i], blk_nbr[i], ct[i],
+            tag[i]));
+  }
+  return SBDI_SUCCESS;
+}
+
+//----------------------------------------------------------------------
+sbdi_error_t sbdi_chacha_decrypt_n(void *ctx, const int n,
+    const uint8_t *const *ct, const int ct_len, const uint8_t *const *ctr,
+    const uint32_t *blk_nbr, uint8_t *const *pt, const uint8_t *const *tag)
+{
+  SBDI_CHK_PARAM(
+      ctx && n >= 0 && ct && ct_len > 0 && ctr && blk_nbr && pt && tag);
+  sbdi_error_t r = SBDI_SUCCESS;
+  for (int i = 0; i < n; ++i) {
+    const sbdi_error_t cr = sbdi_chacha_decrypt(ctx, ct[i], ct_len, ctr[i],
+        blk_nbr[i], pt[i], tag[i]);
+    if (cr != SBDI_SUCCESS) {
+      r = cr;
+    }
+  }
+  return r;
+}
+
+//----------------------------------------------------------------------
+sbdi_error_t sbdi_chacha_mac(void *ctx, const unsigned char *msg, const int mlen,
+    unsigned char *C, const unsigned char *ad, const int ad_len)
+{
+  SBDI_CHK_PARAM(ctx && msg && mlen > 0 && C && ad && ad_len > 0);
+  siv_ctx *siv_ctx = &((sbdi_chacha_ctx_t *) ctx)->siv_ctx;
+  sbdi_bl_aes_cmac(siv_ctx, ad, ad_len, msg, mlen, C);
+  return SBDI_SUCCESS;
+}
+
+//----------------------------------------------------------------------
+sbdi_error_t sbdi_chacha_mac_n(void *ctx, const int n,
+    const unsigned char *const *msg, const int mlen, unsigned char *const *C,
+    const unsigned char *const *ad, const int ad_len)
+{
+  SBDI_CHK_PARAM(ctx && n >= 0 && msg && mlen > 0 && C && ad && ad_len > 0);
+  siv_ctx *siv_ctx = &((sbdi_chacha_ctx_t *) ctx)->siv_ctx;
+  sbdi_bl_aes_cmac_n(siv_ctx, ad, ad_len, msg, mlen, C, n);
+  return SBDI_SUCCESS;
+}
+
+/*!
+ * \brief Derives the ChaCha20-Poly1305 key and the CMAC key from the key of
+ * the secure block device
+ *
+ * The derived keys are the first 64 bytes of the ChaCha20 key stream for the
+ * device key and the all zero nonce. The device key itself is never used for
+ * data, so this key stream block never collides with a data block key stream.
+ *
+ * @param key[in] the key of the secure block device
+ * @param cp_key[out] the CHACHA20_KEY_SIZE byte ChaCha20-Poly1305 key
+ * @param cmac_key[out] the SBDI_CHACHA_CMAC_KEY_SIZE byte SIV key
+ * @return 0 if the derivation was successful; -1 otherwise
+ */
+static int sbdi_chacha_derive_keys(const sbdi_key_t key,
+    unsigned char cp_key[CHACHA20_KEY_SIZE],
+    unsigned char cmac_key[SBDI_CHACHA_CMAC_KEY_SIZE])
+{
+  static const unsigned char nonce[CHACHA20_NONCE_SIZE] = { 0 };
+  unsigned char ks[CHACHA20_KEY_SIZE + SBDI_CHACHA_CMAC_KEY_SIZE];
+  chacha20_poly1305_ctx kdf;
+  if (chacha20_poly1305_init(&kdf, key) != 0) {
+    return -1;
+  }
+  memset(ks, 0, sizeof(ks));
+  chacha20_crypt(&kdf, nonce, 0, ks, ks, sizeof(ks));
+  memcpy(cp_key, ks, CHACHA20_KEY_SIZE);
+  memcpy(cmac_key, ks + CHACHA20_KEY_SIZE, SBDI_CHACHA_CMAC_KEY_SIZE);
+  chacha20_poly1305_clear(&kdf);
+  memset(ks, 0, sizeof(ks));
+  return 0;
+}
+
+//----------------------------------------------------------------------
+sbdi_error_t sbdi_chacha_create(sbdi_crypto_t **crypto, const sbdi_key_t key)
+{
+  SBDI_CHK_PARAM(crypto && key);
+  sbdi_chacha_ctx_t *c_ctx = NULL;
+  sbdi_crypto_t *c = NULL;
+  unsigned char cp_key[CHACHA20_KEY_SIZE];
+  unsigned char cmac_key[SBDI_CHACHA_CMAC_KEY_SIZE];
+
+  sbdi_error_t r = SBDI_ERR_UNSPECIFIED;
+  c_ctx = calloc(1, sizeof(sbdi_chacha_ctx_t));
+  if (!c_ctx) {
+    r = SBDI_ERR_OUT_Of_MEMORY;
+    goto FAIL;
+  }
+  c = calloc(1, sizeof(sbdi_crypto_t));
+  if (!c) {
+    r = SBDI_ERR_OUT_Of_MEMORY;
+    goto FAIL;
+  }
+  if (sbdi_chacha_derive_keys(key, cp_key, cmac_key) != 0
+      || chacha20_poly1305_init(&c_ctx->cp_ctx, cp_key) != 0
+      || siv_init(&c_ctx->siv_ctx, cmac_key, SIV_256) == -1) {
+    r = SBDI_ERR_CRYPTO_FAIL;
+    goto FAIL;
+  }
+  memset(cp_key, 0, sizeof(cp_key));
+  memset(cmac_key, 0, sizeof(cmac_key));
+  c->ctx = c_ctx;
+  c->enc = &sbdi_chacha_encrypt;
+  c->dec = &sbdi_chacha_decrypt;
+  c->mac = &sbdi_chacha_mac;
+  c->enc_n = &sbdi_chacha_encrypt_n;
+  c->dec_n = &sbdi_chacha_decrypt_n;
+  c->mac_n = &sbdi_chacha_mac_n;
+  *crypto = c;
+  return SBDI_SUCCESS;
+
+  FAIL: memset(cp_key, 0, sizeof(cp_key));
+  memset(cmac_key, 0, sizeof(cmac_key));
+  if (c_ctx) {
+    chacha20_poly1305_clear(&c_ctx->cp_ctx);
+    memset(&c_ctx->siv_ctx, 0, sizeof(siv_ctx));
+    free(c_ctx);
+  }
+  if (c) {
+    free(c);
+  }
+  return r;
+}
+
+//----------------------------------------------------------------------
+void sbdi_chacha_destroy(sbdi_crypto_t *crypto)
+{
+  if (crypto) {
+    sbdi_chacha_ctx_t *ctx = (sbdi_chacha_ctx_t *) crypto->ctx;
+    if (ctx) {
+      chacha20_poly1305_clear(&ctx->cp_ctx);
+      memset(&ctx->siv_ctx, 0, sizeof(siv_ctx));
+      free(ctx);
+    }
+    memset(crypto, 0, sizeof(sbdi_crypto_t));
+    free(crypto);
+  }
+}
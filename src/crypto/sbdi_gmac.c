@@ -0,0 +1,253 @@
+/* Copyright (c) IAIK, Graz University of Technology, 2015.
+ * All rights reserved.
+ * Contact: http://opensource.iaik.tugraz.at
+ * 
+ * This file is part of the Secure Block Device Library.
+ * 
+ * Commercial License Usage
+ * Licensees holding valid commercial licenses may use this file in
+ * accordance with the commercial license agreement provided with the
+ * Software or, alternatively, in accordance with the terms contained in
+ * a written agreement between you and SIC. For further information
+ * contact us at http://opensource.iaik.tugraz.at.
+ * 
+ * Alternatively, this file may be used under the terms of the GNU General
+ * Public License as published by the Free Software Foundation version 2.
+ * 
+ * The Secure Block Device Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with the Secure Block Device Library. If not, see <http://www.gnu.org/licenses/>.
+ */
+///
+/// \file
+/// \brief Implements Secure Block Device Library cryptographic abstraction
+/// layer that authenticates data blocks with AES-GMAC without encrypting
+/// them, and uses AES CMAC for management block protection.
+///
+/// The data block tag is the GCM tag with the plain text in place of the
+/// cipher text, so it is computed by GHASH alone and does not need the GCM
+/// key stream. The nonce and the additional data are the same as in the GCM
+/// cryptographic abstraction layer.
+///
+#include "sbdi_gmac.h"
+#include "sbdi_buffer.h"
+
+#include "gcm.h"
+#include "siv.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// NOTE GMAC truncates counter to 12 bytes
+
+#define SBDI_GMAC_KEY_SIZE    16u
+#define SBDI_GMAC_MAC_KEY_IDX 16u
+#define SBDI_GMAC_AD_SIZE     (4u + (SBDI_BLOCK_CTR_SIZE))
+
+/*!
+ * \brief Wraps the two sub-contexts required by the GMAC cryptographic
+ * abstraction layer
+ *
+ * Neither sub-context is modified after creation, which allows the GMAC
+ * cryptographic abstraction layer to provide batch operations.
+ */
+typedef struct sbdi_gmac_ctx {
+  gcm_ctx gcm_ctx; //!< the GCM context which is used for computing the GMAC
+  siv_ctx siv_ctx; //!< the SIV context which is used for computing the CMAC
+} sbdi_gmac_ctx_t;
+
+/*!
+ * \brief Serializes the block number and the block counter into ad
+ *
+ * @param ad[out] the buffer receiving the block number and the counter
+ * @param blk_nbr[in] the physical block number
+ * @param ctr[in] the block counter, if pkd_ctr is NULL
+ * @param pkd_ctr[in] the packed block counter (can be NULL)
+ * @return a pointer to the GCM_IV_SIZE byte nonce within ad
+ */
+static const unsigned char *sbdi_gmac_nonce(uint8_t ad[SBDI_GMAC_AD_SIZE],
+    const uint32_t blk_nbr, const sbdi_ctr_128b_t *ctr, const uint8_t *pkd_ctr)
+{
+  sbdi_buffer_t b;
+  memset(&b, 0, sizeof(sbdi_buffer_t));
+  memset(ad, 0, SBDI_GMAC_AD_SIZE);
+  sbdi_buffer_init(&b, ad, SBDI_GMAC_AD_SIZE);
+  sbdi_buffer_write_uint32_t(&b, blk_nbr);
+  // Truncate the 4 highermost bytes of the counter!
+  const unsigned char *np = sbdi_buffer_get_cptr(&b) + 4;
+  if (pkd_ctr) {
+    sbdi_buffer_write_bytes(&b, pkd_ctr, SBDI_BLOCK_CTR_SIZE);
+  } else {
+    sbdi_buffer_write_ctr_128b(&b, ctr);
+  }
+  return np;
+}
+
+//----------------------------------------------------------------------
+sbdi_error_t sbdi_gmac_encrypt(void *ctx, const uint8_t *pt, const int pt_len,
+    const sbdi_ctr_128b_t *ctr, const uint32_t blk_nbr, uint8_t *ct,
+    sbdi_tag_t tag)
+{
+  SBDI_CHK_PARAM(
+      ctx && pt && pt_len > 0 && ctr && sbdi_block_is_valid_phy(blk_nbr) && ct
+          && tag);
+  const gcm_ctx *g_ctx = &((sbdi_gmac_ctx_t *) ctx)->gcm_ctx;
+  uint8_t ad[SBDI_GMAC_AD_SIZE];
+  const unsigned char *np = sbdi_gmac_nonce(ad, blk_nbr, ctr, NULL);
+  gcm_mac(g_ctx, np, ad, 4, pt, pt_len, tag);
+  if (ct != pt) {
+    memcpy(ct, pt, pt_len);
+  }
+  return SBDI_SUCCESS;
+}
+
+//----------------------------------------------------------------------
+sbdi_error_t sbdi_gmac_decrypt(void *ctx, const uint8_t *ct, const int ct_len,
+    const sbdi_ctr_pkd_t ctr, const uint32_t blk_nbr, uint8_t *pt,
+    const sbdi_tag_t tag)
+{
+  SBDI_CHK_PARAM(
+      ctx && ct && ct_len > 0 && ctr && sbdi_block_is_valid_phy(blk_nbr) && pt
+          && tag);
+  const gcm_ctx *g_ctx = &((sbdi_gmac_ctx_t *) ctx)->gcm_ctx;
+  uint8_t ad[SBDI_GMAC_AD_SIZE];
+  const unsigned char *np = sbdi_gmac_nonce(ad, blk_nbr, NULL, ctr);
+  unsigned char t[GCM_TAG_SIZE];
+  gcm_mac(g_ctx, np, ad, 4, ct, ct_len, t);
+  unsigned char d = 0;
+  for (int i = 0; i < GCM_TAG_SIZE; ++i) {
+    d |= t[i] ^ tag[i];
+  }
+  if (d) {
+    memset(pt, 0, ct_len);
+    return SBDI_ERR_TAG_MISMATCH;
+  }
+  if (pt != ct) {
+    memcpy(pt, ct, ct_len);
+  }
+  return SBDI_SUCCESS;
+}
+
+//----------------------------------------------------------------------
+sbdi_error_t sbdi_gmac_encrypt_n(void *ctx, const int n,
+    const uint8_t *const *pt, const int pt_len, const sbdi_ctr_128b_t *ctr,
+    const uint32_t *blk_nbr, uint8_t *const *ct, uint8_t *const *tag)
+{
+  SBDI_CHK_PARAM(
+      ctx && n >= 0 && pt && pt_len > 0 && ctr && blk_nbr && ct && tag);
+  for (int i = 0; i < n; ++i) {
+    SBDI_ERR_CHK(
+        sbdi_gmac_encrypt(ctx, pt[i], pt_len, &ctr[i], blk_nbr[i], ct[i],
+            tag[i]));
+  }
+  return SBDI_SUCCESS;
+}
+
+//----------------------------------------------------------------------
+sbdi_error_t sbdi_gmac_decrypt_n(void *ctx, const int n,
+    const uint8_t *const *ct, const int ct_len, const uint8_t *const *ctr,
+    const uint32_t *blk_nbr, uint8_t *const *pt, const uint8_t *const *tag)
+{
+  SBDI_CHK_PARAM(
+      ctx && n >= 0 && ct && ct_len > 0 && ctr && blk_nbr && pt && tag);
+  sbdi_error_t r = SBDI_SUCCESS;
+  for (int i = 0; i < n; ++i) {
+    const sbdi_error_t cr = sbdi_gmac_decrypt(ctx, ct[i], ct_len, ctr[i],
+        blk_nbr[i], pt[i], tag[i]);
+    if (cr != SBDI_SUCCESS) {
+      r = cr;
+    }
+  }
+  return r;
+}
+
+//----------------------------------------------------------------------
+sbdi_error_t sbdi_gmac_cmac(void *ctx, const unsigned char *msg, const int mlen,
+    unsigned char *C, const unsigned char *ad, const int ad_len)
+{
+  SBDI_CHK_PARAM(ctx && msg && mlen > 0 && C && ad && ad_len > 0);
+  siv_ctx *siv_ctx = &((sbdi_gmac_ctx_t *) ctx)->siv_ctx;
+  sbdi_bl_aes_cmac(siv_ctx, ad, ad_len, msg, mlen, C);
+  return SBDI_SUCCESS;
+}
+
+//----------------------------------------------------------------------
+sbdi_error_t sbdi_gmac_cmac_n(void *ctx, const int n,
+    const unsigned char *const *msg, const int mlen, unsigned char *const *C,
+    const unsigned char *const *ad, const int ad_len)
+{
+  SBDI_CHK_PARAM(ctx && n >= 0 && msg && mlen > 0 && C && ad && ad_len > 0);
+  siv_ctx *siv_ctx = &((sbdi_gmac_ctx_t *) ctx)->siv_ctx;
+  sbdi_bl_aes_cmac_n(siv_ctx, ad, ad_len, msg, mlen, C, n);
+  return SBDI_SUCCESS;
+}
+
+//----------------------------------------------------------------------
+sbdi_error_t sbdi_gmac_create(sbdi_crypto_t **crypto, const sbdi_key_t key)
+{
+  SBDI_CHK_PARAM(crypto && key);
+  sbdi_gmac_ctx_t *gm_ctx = NULL;
+  sbdi_crypto_t *c = NULL;
+
+  sbdi_error_t r = SBDI_ERR_UNSPECIFIED;
+  gm_ctx = calloc(1, sizeof(sbdi_gmac_ctx_t));
+  if (!gm_ctx) {
+    r = SBDI_ERR_OUT_Of_MEMORY;
+    goto FAIL;
+  }
+  c = calloc(1, sizeof(sbdi_crypto_t));
+  if (!c) {
+    r = SBDI_ERR_OUT_Of_MEMORY;
+    goto FAIL;
+  }
+  // Use the upper 16 bytes of the 32 byte key for GMAC
+  int cr = gcm_init(&gm_ctx->gcm_ctx, key + SBDI_GMAC_MAC_KEY_IDX,
+      SBDI_GMAC_KEY_SIZE * 8);
+  if (cr != 0) {
+    r = SBDI_ERR_CRYPTO_FAIL;
+    goto FAIL;
+  }
+  cr = siv_init(&gm_ctx->siv_ctx, key, SIV_256);
+  if (cr == -1) {
+    r = SBDI_ERR_CRYPTO_FAIL;
+    goto FAIL;
+  }
+  c->ctx = gm_ctx;
+  c->enc = &sbdi_gmac_encrypt;
+  c->dec = &sbdi_gmac_decrypt;
+  c->mac = &sbdi_gmac_cmac;
+  c->enc_n = &sbdi_gmac_encrypt_n;
+  c->dec_n = &sbdi_gmac_decrypt_n;
+  c->mac_n = &sbdi_gmac_cmac_n;
+  *crypto = c;
+  return SBDI_SUCCESS;
+
+  FAIL: if (gm_ctx) {
+    gcm_clear(&gm_ctx->gcm_ctx);
+    memset(&gm_ctx->siv_ctx, 0, sizeof(siv_ctx));
+    free(gm_ctx);
+  }
+  if (c) {
+    free(c);
+  }
+  return r;
+}
+
+//----------------------------------------------------------------------
+void sbdi_gmac_destroy(sbdi_crypto_t *crypto)
+{
+  if (crypto) {
+    sbdi_gmac_ctx_t *ctx = (sbdi_gmac_ctx_t *) crypto->ctx;
+    if (ctx) {
+      gcm_clear(&ctx->gcm_ctx);
+      memset(&ctx->siv_ctx, 0, sizeof(siv_ctx));
+      free(ctx);
+    }
+    memset(crypto, 0, sizeof(sbdi_crypto_t));
+    free(crypto);
+  }
+}
@@ -31,13 +31,15 @@
 #include "sbdi_buffer.h"
 #include "aes.h"
 
-// Pull-in the SHA implementation from the merkle tree
-#include "../../../merkle-tree/src/sha.h"
-
 #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+# include <cpuid.h>
+# include <immintrin.h>
+#endif
+
 // Define as non-zero the create insecure tags and/or IVs (for testing)
 #define SBDI_HMAC_INSECURE_TAG     0
 #define SBDI_HMAC_INSECURE_IV      0
@@ -46,6 +48,13 @@
 // Define as non-zero to enable memory zeroization code
 #define SBDI_HMAC_ZEROIZE_MEMORY   0
 
+// Define as non-zero to use the x86 SHA extensions (if the CPU has them)
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+# define SBDI_HMAC_USE_SHA_NI      1
+#else
+# define SBDI_HMAC_USE_SHA_NI      0
+#endif
+
 #define SHA256_BLOCK_SIZE 64
 #define SHA256_HASH_SIZE  32
 
@@ -58,81 +67,357 @@
 # define SBDI_STMT_ZEROIZE(stmt) do { } while(0)
 #endif
 
+// SHA-256 compression function: process nblk consecutive 64-byte blocks
+typedef void (*sbdi_sha256_compress_fn)(uint32_t state[8],
+                                        const uint8_t *blk, size_t nblk);
+
+// Streaming SHA-256 state (resumable from a precomputed midstate)
+typedef struct sbdi_sha256 {
+  uint32_t state[8];
+  uint8_t buf[SHA256_BLOCK_SIZE];
+  size_t buf_len;
+  uint64_t total_len;
+} sbdi_sha256_t;
+
 typedef struct sbdi_cbc_hmac {
   AES_KEY dec_key;
   AES_KEY enc_key;
   uint8_t mac_master_key[SHA256_HASH_SIZE];
+  uint32_t ipad_state[8]; // SHA-256 midstate after (K_mac ^ ipad)
+  uint32_t opad_state[8]; // SHA-256 midstate after (K_mac ^ opad)
+  sbdi_sha256_compress_fn compress;
 } sbdi_cbc_hmac_t;
 
-#define SHA256_CHECKED(expr)                    \
-  do {                                          \
-    if ((expr) != shaSuccess) {                 \
-      goto fail;                                \
-    }                                           \
-  } while(0)
+//----------------------------------------------------------------------
+// SHA-256
+//
+static const uint32_t SHA256_K[64] = {
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+  0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+  0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+  0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+  0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+  0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+  0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+  0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+  0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static const uint32_t SHA256_H0[8] = {
+  0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+  0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+#define SHA256_ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+static inline uint32_t sha256_load_be32(const uint8_t *p)
+{
+  return ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) |
+         ((uint32_t) p[2] << 8) | (uint32_t) p[3];
+}
+
+static inline void sha256_store_be32(uint8_t *p, uint32_t v)
+{
+  p[0] = (uint8_t) (v >> 24);
+  p[1] = (uint8_t) (v >> 16);
+  p[2] = (uint8_t) (v >> 8);
+  p[3] = (uint8_t) v;
+}
+
+//----------------------------------------------------------------------
+static void sha256_compress_generic(uint32_t state[8], const uint8_t *blk,
+                                    size_t nblk)
+{
+  uint32_t w[64];
+
+  for (; nblk > 0; --nblk, blk += SHA256_BLOCK_SIZE) {
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+
+    for (size_t i = 0; i < 16; ++i) {
+      w[i] = sha256_load_be32(blk + 4 * i);
+    }
+    for (size_t i = 16; i < 64; ++i) {
+      uint32_t s0 = SHA256_ROTR(w[i - 15], 7) ^ SHA256_ROTR(w[i - 15], 18) ^
+                    (w[i - 15] >> 3);
+      uint32_t s1 = SHA256_ROTR(w[i - 2], 17) ^ SHA256_ROTR(w[i - 2], 19) ^
+                    (w[i - 2] >> 10);
+      w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    for (size_t i = 0; i < 64; ++i) {
+      uint32_t s1 = SHA256_ROTR(e, 6) ^ SHA256_ROTR(e, 11) ^ SHA256_ROTR(e, 25);
+      uint32_t ch = (e & f) ^ (~e & g);
+      uint32_t t1 = h + s1 + ch + SHA256_K[i] + w[i];
+      uint32_t s0 = SHA256_ROTR(a, 2) ^ SHA256_ROTR(a, 13) ^ SHA256_ROTR(a, 22);
+      uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+      uint32_t t2 = s0 + maj;
+      h = g;
+      g = f;
+      f = e;
+      e = d + t1;
+      d = c;
+      c = b;
+      b = a;
+      a = t1 + t2;
+    }
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+  }
+  SBDI_STMT_ZEROIZE(memset(w, 0, sizeof(w)));
+}
+
+#if SBDI_HMAC_USE_SHA_NI
+//----------------------------------------------------------------------
+__attribute__((target("sha,sse4.1,ssse3")))
+static void sha256_compress_shani(uint32_t state[8], const uint8_t *blk,
+                                  size_t nblk)
+{
+  const __m128i bswap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL,
+                                       0x0405060700010203ULL);
+  __m128i st0, st1, tmp, msg, m[4];
+
+  // Reorder the state into the ABEF / CDGH layout used by SHA256RNDS2
+  tmp = _mm_loadu_si128((const __m128i *) &state[0]);
+  st1 = _mm_loadu_si128((const __m128i *) &state[4]);
+  tmp = _mm_shuffle_epi32(tmp, 0xB1);
+  st1 = _mm_shuffle_epi32(st1, 0x1B);
+  st0 = _mm_alignr_epi8(tmp, st1, 8);
+  st1 = _mm_blend_epi16(st1, tmp, 0xF0);
+
+  for (; nblk > 0; --nblk, blk += SHA256_BLOCK_SIZE) {
+    const __m128i abef = st0;
+    const __m128i cdgh = st1;
+
+    for (size_t j = 0; j < 16; ++j) {
+      if (j < 4) {
+        m[j] = _mm_shuffle_epi8(
+            _mm_loadu_si128((const __m128i *) (blk + 16 * j)), bswap);
+      } else {
+        // W[4j..4j+3] from W[4j-16..4j-1]
+        tmp = _mm_add_epi32(_mm_sha256msg1_epu32(m[j & 3], m[(j - 3) & 3]),
+                            _mm_alignr_epi8(m[(j - 1) & 3], m[(j - 2) & 3], 4));
+        m[j & 3] = _mm_sha256msg2_epu32(tmp, m[(j - 1) & 3]);
+      }
+      msg = _mm_add_epi32(m[j & 3],
+                          _mm_loadu_si128((const __m128i *) &SHA256_K[4 * j]));
+      st1 = _mm_sha256rnds2_epu32(st1, st0, msg);
+      msg = _mm_shuffle_epi32(msg, 0x0E);
+      st0 = _mm_sha256rnds2_epu32(st0, st1, msg);
+    }
+
+    st0 = _mm_add_epi32(st0, abef);
+    st1 = _mm_add_epi32(st1, cdgh);
+  }
+
+  // Back to the A..H word order
+  tmp = _mm_shuffle_epi32(st0, 0x1B);
+  st1 = _mm_shuffle_epi32(st1, 0xB1);
+  st0 = _mm_blend_epi16(tmp, st1, 0xF0);
+  st1 = _mm_alignr_epi8(st1, tmp, 8);
+  _mm_storeu_si128((__m128i *) &state[0], st0);
+  _mm_storeu_si128((__m128i *) &state[4], st1);
+}
+
+//----------------------------------------------------------------------
+static bool sha256_cpu_has_shani(void)
+{
+  unsigned int eax, ebx, ecx, edx;
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(ecx & bit_SSE4_1) ||
+      !(ecx & bit_SSSE3)) {
+    return false;
+  }
+  if (__get_cpuid_max(0, NULL) < 7) {
+    return false;
+  }
+  __cpuid_count(7, 0, eax, ebx, ecx, edx);
+  return (ebx & bit_SHA) != 0;
+}
+#endif
+
+//----------------------------------------------------------------------
+static sbdi_sha256_compress_fn sha256_select_compress(void)
+{
+#if SBDI_HMAC_USE_SHA_NI
+  if (sha256_cpu_has_shani()) {
+    return &sha256_compress_shani;
+  }
+#endif
+  return &sha256_compress_generic;
+}
+
+//----------------------------------------------------------------------
+static void sha256_init(sbdi_sha256_t *md, const uint32_t state[8],
+                        uint64_t done_len)
+{
+  memcpy(md->state, state, sizeof(md->state));
+  md->buf_len = 0;
+  md->total_len = done_len;
+}
+
+//----------------------------------------------------------------------
+static void sha256_update(sbdi_sha256_t *md, sbdi_sha256_compress_fn compress,
+                          const uint8_t *data, size_t len)
+{
+  md->total_len += len;
+
+  if (md->buf_len > 0) {
+    size_t n = SBDI_HMAC_MIN(len, SHA256_BLOCK_SIZE - md->buf_len);
+    memcpy(md->buf + md->buf_len, data, n);
+    md->buf_len += n;
+    data += n;
+    len -= n;
+    if (md->buf_len < SHA256_BLOCK_SIZE) {
+      return;
+    }
+    compress(md->state, md->buf, 1);
+    md->buf_len = 0;
+  }
+
+  // Hash all complete blocks straight from the input
+  if (len >= SHA256_BLOCK_SIZE) {
+    size_t nblk = len / SHA256_BLOCK_SIZE;
+    compress(md->state, data, nblk);
+    data += nblk * SHA256_BLOCK_SIZE;
+    len -= nblk * SHA256_BLOCK_SIZE;
+  }
+
+  memcpy(md->buf, data, len);
+  md->buf_len = len;
+}
+
+//----------------------------------------------------------------------
+static void sha256_final(sbdi_sha256_t *md, sbdi_sha256_compress_fn compress,
+                         uint8_t digest[SHA256_HASH_SIZE])
+{
+  const uint64_t bits = md->total_len * 8;
+
+  md->buf[md->buf_len++] = 0x80;
+  if (md->buf_len > SHA256_BLOCK_SIZE - 8) {
+    memset(md->buf + md->buf_len, 0, SHA256_BLOCK_SIZE - md->buf_len);
+    compress(md->state, md->buf, 1);
+    md->buf_len = 0;
+  }
+  memset(md->buf + md->buf_len, 0, SHA256_BLOCK_SIZE - 8 - md->buf_len);
+  sha256_store_be32(md->buf + SHA256_BLOCK_SIZE - 8, (uint32_t) (bits >> 32));
+  sha256_store_be32(md->buf + SHA256_BLOCK_SIZE - 4, (uint32_t) bits);
+  compress(md->state, md->buf, 1);
+
+  for (size_t i = 0; i < 8; ++i) {
+    sha256_store_be32(digest + 4 * i, md->state[i]);
+  }
+  SBDI_STMT_ZEROIZE(memset(md, 0, sizeof(sbdi_sha256_t)));
+}
 
 //----------------------------------------------------------------------
 // HMAC-SHA256
 //
-static sbdi_error_t sbdi_hmac_sha256(uint8_t mac[SHA256_HASH_SIZE],
-                                     const uint8_t *data0, size_t data0_len,
-                                     const uint8_t *data1, size_t data1_len,
-                                     const uint8_t *ukey, size_t ukey_len)
+// The inner and outer pads only depend on K_mac. Their SHA-256 midstates are
+// computed once by sbdi_hmac_precompute_pads and every tag computation
+// resumes from them, saving two compressions per tag.
+//
+static void sbdi_hmac_precompute_pads(sbdi_cbc_hmac_t *ctx,
+                                      const uint8_t *ukey, size_t ukey_len)
 {
   uint8_t pad[SHA256_BLOCK_SIZE];
-  SHA256Context md;
+  sbdi_sha256_t md;
 
   // Key scheduling
   memset(pad, 0, SHA256_BLOCK_SIZE);
 
   if (ukey_len > SHA256_BLOCK_SIZE) {
     // key = H(ukey) || [0x00 ...]
-    SHA256_CHECKED(SHA256Reset(&md));
-    SHA256_CHECKED(SHA256Input(&md, ukey, ukey_len));
-    SHA256_CHECKED(SHA256Result(&md, pad));
+    sha256_init(&md, SHA256_H0, 0);
+    sha256_update(&md, ctx->compress, ukey, ukey_len);
+    sha256_final(&md, ctx->compress, pad);
 
   } else {
     // key = ukey || [0x00 ..]
     memcpy(pad, ukey, ukey_len);
   }
 
-  // Setup ipad = key ^ 0x36
+  // Setup ipad = key ^ 0x36 and hash it
   for (size_t i = 0; i < SHA256_BLOCK_SIZE; ++i) {
     pad[i] ^= 0x36;
   }
+  memcpy(ctx->ipad_state, SHA256_H0, sizeof(ctx->ipad_state));
+  ctx->compress(ctx->ipad_state, pad, 1);
+
+  // Setup opad = key ^ 0x5C = ipad ^ (0x5C ^ 0x36) and hash it
+  for (size_t i = 0; i < SHA256_BLOCK_SIZE; ++i) {
+    pad[i] ^= (0x36 ^ 0x5C);
+  }
+  memcpy(ctx->opad_state, SHA256_H0, sizeof(ctx->opad_state));
+  ctx->compress(ctx->opad_state, pad, 1);
 
-  // Compute the inner hash
-  SHA256_CHECKED(SHA256Reset(&md));
-  SHA256_CHECKED(SHA256Input(&md, pad, SHA256_BLOCK_SIZE));
+  // Cleanup
+  SBDI_STMT_ZEROIZE(memset(pad, 0, SHA256_BLOCK_SIZE));
+}
+
+//----------------------------------------------------------------------
+static void sbdi_hmac_sha256(const sbdi_cbc_hmac_t *ctx,
+                             uint8_t mac[SHA256_HASH_SIZE],
+                             const uint8_t *data0, size_t data0_len,
+                             const uint8_t *data1, size_t data1_len)
+{
+  sbdi_sha256_t md;
+
+  // Compute the inner hash (resuming after the ipad block)
+  sha256_init(&md, ctx->ipad_state, SHA256_BLOCK_SIZE);
   if (data0_len > 0) {
-    SHA256_CHECKED(SHA256Input(&md, data0, data0_len));
+    sha256_update(&md, ctx->compress, data0, data0_len);
   }
   if (data1_len > 0) {
-    SHA256_CHECKED(SHA256Input(&md, data1, data1_len));
+    sha256_update(&md, ctx->compress, data1, data1_len);
   }
-  SHA256_CHECKED(SHA256Result(&md, mac));
+  sha256_final(&md, ctx->compress, mac);
 
-  // Setup opad = key ^ 0x5C = ipad ^ (0x5C ^ 0x36)
-  for (size_t i = 0; i < SHA256_BLOCK_SIZE; ++i) {
-    pad[i] ^= (0x36 ^ 0x5C);
-  }
+  // Compute the outer hash (resuming after the opad block)
+  sha256_init(&md, ctx->opad_state, SHA256_BLOCK_SIZE);
+  sha256_update(&md, ctx->compress, mac, SHA256_HASH_SIZE);
+  sha256_final(&md, ctx->compress, mac);
+}
 
-  // Compute the outer hash
-  SHA256_CHECKED(SHA256Reset(&md));
-  SHA256_CHECKED(SHA256Input(&md, pad, SHA256_BLOCK_SIZE));
-  SHA256_CHECKED(SHA256Input(&md, mac, SHA256_HASH_SIZE));
-  SHA256_CHECKED(SHA256Result(&md, mac));
+//----------------------------------------------------------------------
+sbdi_error_t sbdi_hmac_sha256_compute(sbdi_hmac_sha256_impl_t impl,
+    const uint8_t *key, size_t key_len, const uint8_t *msg0, size_t len0,
+    const uint8_t *msg1, size_t len1, uint8_t *mac)
+{
+  sbdi_cbc_hmac_t ctx;
+  SBDI_CHK_PARAM(key && (msg0 || !len0) && (msg1 || !len1) && mac);
+
+  switch (impl) {
+  case SBDI_HMAC_SHA256_AUTO:
+    ctx.compress = sha256_select_compress();
+    break;
+  case SBDI_HMAC_SHA256_GENERIC:
+    ctx.compress = &sha256_compress_generic;
+    break;
+  case SBDI_HMAC_SHA256_SHA_NI:
+#if SBDI_HMAC_USE_SHA_NI
+    if (sha256_cpu_has_shani()) {
+      ctx.compress = &sha256_compress_shani;
+      break;
+    }
+#endif
+    return SBDI_ERR_UNSUPPORTED;
+  default:
+    return SBDI_ERR_ILLEGAL_PARAM;
+  }
 
-  // Cleanup
-  SBDI_STMT_ZEROIZE(memset(pad, 0, SHA256_BLOCK_SIZE));
-  SBDI_STMT_ZEROIZE(memset(&md, 0, sizeof(SHA256Context)));
+  sbdi_hmac_precompute_pads(&ctx, key, key_len);
+  sbdi_hmac_sha256(&ctx, mac, msg0, len0, msg1, len1);
+  SBDI_STMT_ZEROIZE(memset(&ctx, 0, sizeof(ctx)));
   return SBDI_SUCCESS;
-
- fail:
-  SBDI_STMT_ZEROIZE(memset(pad, 0, SHA256_BLOCK_SIZE));
-  SBDI_STMT_ZEROIZE(memset(&md, 0, sizeof(SHA256Context)));
-  SBDI_STMT_ZEROIZE(memset(mac, 0, SHA256_HASH_SIZE));
-  return SBDI_ERR_UNSPECIFIED;
 }
 
 //----------------------------------------------------------------------
@@ -140,7 +425,6 @@ sbdi_error_t sbdi_hmac_mac(void *pctx, const unsigned char *msg,
     const int mlen, unsigned char *C, const unsigned char *ad, const int ad_len)
 {
   sbdi_cbc_hmac_t *ctx = pctx;
-  sbdi_error_t ret = SBDI_ERR_UNSPECIFIED;
   uint8_t mac[SHA256_HASH_SIZE];
 
   assert(ctx);
@@ -150,18 +434,12 @@ sbdi_error_t sbdi_hmac_mac(void *pctx, const unsigned char *msg,
   memset(C, 0, SBDI_BLOCK_TAG_SIZE);
 
   // Compute the tag as HMAC_{K_mac}(ad || msg)
-  ret = sbdi_hmac_sha256(mac, ad, ad_len, msg, mlen,
-                         ctx->mac_master_key, SHA256_HASH_SIZE);
-  if (ret != SBDI_SUCCESS) {
-    goto fail;
-  }
+  sbdi_hmac_sha256(ctx, mac, ad, ad_len, msg, mlen);
 
   // Success, copy the MAC (truncate/zero-extend if needed)
   memcpy(C, mac, SBDI_HMAC_MIN(SHA256_HASH_SIZE, SBDI_BLOCK_TAG_SIZE));
-  ret = SBDI_SUCCESS;
-
- fail:
-  return ret;
+  SBDI_STMT_ZEROIZE(memset(mac, 0, SHA256_HASH_SIZE));
+  return SBDI_SUCCESS;
 }
 
 //----------------------------------------------------------------------
@@ -287,6 +565,67 @@ static sbdi_error_t sbdi_hmac_encrypt(void *pctx, const uint8_t *pt,
   return ret;
 }
 
+//----------------------------------------------------------------------
+static sbdi_error_t sbdi_hmac_encrypt_n(void *pctx, const int n,
+                                        const uint8_t *const *pt,
+                                        const int pt_len,
+                                        const sbdi_ctr_128b_t *ctr,
+                                        const uint32_t *blk_nbr,
+                                        uint8_t *const *ct,
+                                        uint8_t *const *tag)
+{
+  sbdi_cbc_hmac_t *ctx = pctx;
+  uint8_t iv[AES_MB_LANES][AES_BLOCK_SIZE];
+  uint8_t iv_copy[AES_MB_LANES][AES_BLOCK_SIZE];
+  sbdi_error_t ret = SBDI_SUCCESS;
+  assert(ctx);
+  SBDI_CHK_PARAM(n >= 0 && pt && ctr && blk_nbr && ct && pt_len > 0 && tag);
+
+  if ((pt_len % AES_BLOCK_SIZE) != 0) {
+    // Partial blocks need the CBC tail handling of AES_cbc_encrypt
+    for (int i = 0; i < n && ret == SBDI_SUCCESS; ++i) {
+      ret = sbdi_hmac_encrypt(pctx, pt[i], pt_len, &ctr[i], blk_nbr[i], ct[i],
+                              tag[i]);
+    }
+    return ret;
+  }
+
+  for (int o = 0; o < n; o += AES_MB_LANES) {
+    const int k = SBDI_HMAC_MIN(n - o, AES_MB_LANES);
+
+    // Prepare the IVs (dependent on K_enc, ctr and blk_nbr)
+    for (int i = 0; i < k; ++i) {
+      SBDI_CHK_PARAM(pt[o + i] && ct[o + i] && tag[o + i]);
+      sbdi_hmac_aes_iv(iv[i], ctx, &ctr[o + i], blk_nbr[o + i], true);
+    }
+
+#if SBDI_HMAC_INSECURE_CIPHER
+    // Dummy encryption (for testing)
+    for (int i = 0; i < k; ++i) {
+      memmove(ct[o + i], pt[o + i], pt_len);
+    }
+#else
+    // Encrypt the blocks with interleaved CBC chains (the chaining values
+    // are destroyed, keep the IVs for the tag computation)
+    memcpy(iv_copy, iv, sizeof(iv));
+    AES_cbc_encrypt_mb(pt + o, ct + o, pt_len / AES_BLOCK_SIZE, &ctx->enc_key,
+                       iv_copy, k);
+#endif
+
+    // Create the authentication tags (given the IV and ciphertext)
+    for (int i = 0; i < k; ++i) {
+      ret = sbdi_hmac_sha256_tag(tag[o + i], ctx, ct[o + i], pt_len, iv[i]);
+      if (ret != SBDI_SUCCESS) {
+        goto fail;
+      }
+    }
+  }
+
+ fail:
+  SBDI_STMT_ZEROIZE(memset(iv_copy, 0, sizeof(iv_copy)));
+  return ret;
+}
+
 //----------------------------------------------------------------------
 sbdi_error_t sbdi_hmac_decrypt(void *pctx, const uint8_t *ct,
     const int ct_len, const sbdi_ctr_pkd_t ctr, const uint32_t blk_nbr,
@@ -351,12 +690,18 @@ sbdi_error_t sbdi_hmac_create(sbdi_crypto_t **crypto, const sbdi_key_t key)
     goto fail;
   }
 
+  // Pick the fastest SHA-256 compression function supported by the CPU
+  ctx->compress = sha256_select_compress();
+
   // Derive a master key K_mac for computing the block MACs
   // (we just hash the AES encryption key for this purpose)
-  SHA256Context md;
-  SHA256_CHECKED(SHA256Reset(&md));
-  SHA256_CHECKED(SHA256Input(&md, key, sizeof(sbdi_key_t)));
-  SHA256_CHECKED(SHA256Result(&md, ctx->mac_master_key));
+  sbdi_sha256_t md;
+  sha256_init(&md, SHA256_H0, 0);
+  sha256_update(&md, ctx->compress, key, sizeof(sbdi_key_t));
+  sha256_final(&md, ctx->compress, ctx->mac_master_key);
+
+  // Precompute the HMAC inner and outer pad midstates for K_mac
+  sbdi_hmac_precompute_pads(ctx, ctx->mac_master_key, SHA256_HASH_SIZE);
 
   sbdi_crypto_t *c = calloc(1, sizeof(sbdi_crypto_t));
   if (!c) {
@@ -367,11 +712,11 @@ sbdi_error_t sbdi_hmac_create(sbdi_crypto_t **crypto, const sbdi_key_t key)
   c->enc = &sbdi_hmac_encrypt;
   c->dec = &sbdi_hmac_decrypt;
   c->mac = &sbdi_hmac_mac;
+  c->enc_n = &sbdi_hmac_encrypt_n;
   *crypto = c;
   return SBDI_SUCCESS;
 
  fail:
-  SBDI_STMT_ZEROIZE(memset(&md, 0, sizeof(md)));
   SBDI_STMT_ZEROIZE(memset(ctx, 0, sizeof(sbdi_cbc_hmac_t)));
   free(ctx);
 
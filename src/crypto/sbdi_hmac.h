@@ -38,9 +38,46 @@ extern "C" {
 
 #include "sbdi_crypto.h"
 
+#include <stddef.h>
+#include <stdint.h>
+
+#define SBDI_HMAC_SHA256_SIZE 32u //!< The size in bytes of an HMAC-SHA256 value
+
+/*!
+ * \brief the SHA-256 compression function implementations
+ */
+typedef enum sbdi_hmac_sha256_impl {
+  SBDI_HMAC_SHA256_AUTO = 0, //!< the fastest implementation the CPU supports
+  SBDI_HMAC_SHA256_GENERIC,  //!< the portable implementation
+  SBDI_HMAC_SHA256_SHA_NI    //!< the implementation using the x86 SHA extensions
+} sbdi_hmac_sha256_impl_t;
+
 sbdi_error_t sbdi_hmac_create(sbdi_crypto_t **crypto, const sbdi_key_t key);
 void sbdi_hmac_destroy(sbdi_crypto_t *crypto);
 
+/*!
+ * \brief Computes HMAC-SHA256 over the concatenation of two messages with
+ * the given SHA-256 compression function
+ *
+ * The computation takes the same path as the block tags: the padded key is
+ * hashed into inner and outer midstates once, and the MAC resumes from them.
+ *
+ * @param impl[in] the SHA-256 compression function to use
+ * @param key[in] the HMAC key
+ * @param key_len[in] the length of the key in bytes
+ * @param msg0[in] the first part of the message (can be NULL if len0 is 0)
+ * @param len0[in] the length of the first part in bytes
+ * @param msg1[in] the second part of the message (can be NULL if len1 is 0)
+ * @param len1[in] the length of the second part in bytes
+ * @param mac[out] the SBDI_HMAC_SHA256_SIZE bytes of the MAC
+ * @return SBDI_SUCCESS if the MAC could be computed;
+ *         SBDI_ERR_UNSUPPORTED if the CPU does not support impl;
+ *         SBDI_ERR_ILLEGAL_PARAM if a parameter is NULL.
+ */
+sbdi_error_t sbdi_hmac_sha256_compute(sbdi_hmac_sha256_impl_t impl,
+    const uint8_t *key, size_t key_len, const uint8_t *msg0, size_t len0,
+    const uint8_t *msg1, size_t len1, uint8_t *mac);
+
 #endif /* SBDI_HMAC_H_ */
 
 #ifdef __cplusplus
@@ -83,6 +83,55 @@ sbdi_error_t sbdi_nocrypto_mac(void *ctx, const unsigned char *msg,
   return SBDI_SUCCESS;
 }
 
+sbdi_error_t sbdi_nocrypto_encrypt_n(void *ctx, const int n,
+    const uint8_t *const *pt, const int pt_len, const sbdi_ctr_128b_t *ctr,
+    const uint32_t *blk_nbr, uint8_t *const *ct, uint8_t *const *tag)
+{
+  // if the context is non-null then this is used incorrectly
+  assert(!ctx);
+  SBDI_CHK_PARAM(n >= 0 && pt && ctr && pt_len > 0 && ct && tag);
+  int i;
+  for (i = 0; i < n; ++i) {
+    SBDI_CHK_PARAM(pt[i] && ct[i] && tag[i]);
+    memset(tag[i], 0xFF, SBDI_BLOCK_TAG_SIZE);
+    if (pt[i] != ct[i]) {
+      memcpy(ct[i], pt[i], pt_len);
+    }
+  }
+  return SBDI_SUCCESS;
+}
+
+sbdi_error_t sbdi_nocrypto_decrypt_n(void *ctx, const int n,
+    const uint8_t *const *ct, const int ct_len, const uint8_t *const *ctr,
+    const uint32_t *blk_nbr, uint8_t *const *pt, const uint8_t *const *tag)
+{
+  // if the context is non-null then this is used incorrectly
+  assert(!ctx);
+  SBDI_CHK_PARAM(n >= 0 && ct && ct_len > 0 && ctr && blk_nbr && pt && tag);
+  int i;
+  for (i = 0; i < n; ++i) {
+    SBDI_ERR_CHK(
+        sbdi_nocrypto_decrypt(ctx, ct[i], ct_len, ctr[i], blk_nbr[i], pt[i],
+            tag[i]));
+  }
+  return SBDI_SUCCESS;
+}
+
+sbdi_error_t sbdi_nocrypto_mac_n(void *ctx, const int n,
+    const unsigned char *const *msg, const int mlen, unsigned char *const *C,
+    const unsigned char *const *ad, const int ad_len)
+{
+  // if their is a context, then something is wrong
+  assert(!ctx);
+  SBDI_CHK_PARAM(n >= 0 && msg && mlen > 0 && C);
+  int i;
+  for (i = 0; i < n; ++i) {
+    SBDI_CHK_PARAM(msg[i] && C[i]);
+    memset(C[i], 0x00, SBDI_BLOCK_TAG_SIZE);
+  }
+  return SBDI_SUCCESS;
+}
+
 sbdi_error_t sbdi_nocrypto_create(sbdi_crypto_t **crypto, const sbdi_key_t key)
 {
   sbdi_crypto_t *c = calloc(1, sizeof(sbdi_crypto_t));
@@ -92,6 +141,9 @@ sbdi_error_t sbdi_nocrypto_create(sbdi_crypto_t **crypto, const sbdi_key_t key)
   c->enc = &sbdi_nocrypto_encrypt;
   c->dec = &sbdi_nocrypto_decrypt;
   c->mac = &sbdi_nocrypto_mac;
+  c->enc_n = &sbdi_nocrypto_encrypt_n;
+  c->dec_n = &sbdi_nocrypto_decrypt_n;
+  c->mac_n = &sbdi_nocrypto_mac_n;
   *crypto = c;
   return SBDI_SUCCESS;
 }
@@ -130,6 +130,17 @@ sbdi_error_t sbdi_ocb_mac(void *ctx, const unsigned char *msg, const int mlen,
   return SBDI_SUCCESS;
 }
 
+//----------------------------------------------------------------------
+sbdi_error_t sbdi_ocb_mac_n(void *ctx, const int n,
+    const unsigned char *const *msg, const int mlen, unsigned char *const *C,
+    const unsigned char *const *ad, const int ad_len)
+{
+  SBDI_CHK_PARAM(ctx && n >= 0 && msg && mlen > 0 && C && ad && ad_len > 0);
+  siv_ctx *siv_ctx = ((sbdi_ocb_ctx_t *) ctx)->siv_ctx;
+  sbdi_bl_aes_cmac_n(siv_ctx, ad, ad_len, msg, mlen, C, n);
+  return SBDI_SUCCESS;
+}
+
 //----------------------------------------------------------------------
 sbdi_error_t sbdi_ocb_create(sbdi_crypto_t **crypto, const sbdi_key_t key)
 {
@@ -178,6 +189,10 @@ sbdi_error_t sbdi_ocb_create(sbdi_crypto_t **crypto, const sbdi_key_t key)
   c->enc = &sbdi_ocb_encrypt;
   c->dec = &sbdi_ocb_decrypt;
   c->mac = &sbdi_ocb_mac;
+  // OCB already processes BPI blocks of a message in parallel, so there is
+  // nothing to gain from interleaving several messages. Only the CMAC of the
+  // management blocks gets a batch kernel.
+  c->mac_n = &sbdi_ocb_mac_n;
   *crypto = c;
   return SBDI_SUCCESS;
   FAIL: if (ae_ctx) {
@@ -37,6 +37,8 @@
 #include <assert.h>
 
 #define SBDI_SIV_AD_SIZE (4u + (SBDI_BLOCK_CTR_SIZE))
+#define SBDI_SIV_BATCH_SIZE 16
+#define SBDI_SIV_MIN(a,b) ((a) < (b) ? (a) : (b))
 
 void sbdi_siv_decrypt_dep(siv_ctx *ctx, const unsigned char *c,
     unsigned char *p, const int len, unsigned char *counter, const int nad, ...)
@@ -114,7 +116,8 @@ sbdi_error_t sbdi_siv_decrypt(void *ctx, const uint8_t *ct, const int ct_len,
   sbdi_buffer_write_uint32_t(&b, blk_nbr);
   sbdi_buffer_write_bytes(&b, ctr, SBDI_BLOCK_CTR_SIZE);
 
-  int r = siv_decrypt(s_ctx, ct, pt, ct_len, counter, 1, ad, SBDI_SIV_AD_SIZE);
+  int r = siv_decrypt_fused(s_ctx, ct, pt, ct_len, counter, ad,
+      SBDI_SIV_AD_SIZE);
   if (r != 1) {
     return SBDI_ERR_TAG_MISMATCH;
   } else {
@@ -131,6 +134,76 @@ sbdi_error_t sbdi_siv_cmac(void *ctx, const unsigned char *msg, const int mlen,
   return SBDI_SUCCESS;
 }
 
+sbdi_error_t sbdi_siv_cmac_n(void *ctx, const int n,
+    const unsigned char *const *msg, const int mlen, unsigned char *const *C,
+    const unsigned char *const *ad, const int ad_len)
+{
+  SBDI_CHK_PARAM(ctx && n >= 0 && msg && mlen > 0 && C && ad && ad_len > 0);
+  siv_ctx *s_ctx = (siv_ctx *) ctx;
+  sbdi_bl_aes_cmac_n(s_ctx, ad, ad_len, msg, mlen, C, n);
+  return SBDI_SUCCESS;
+}
+
+sbdi_error_t sbdi_siv_encrypt_n(void *ctx, const int n,
+    const uint8_t *const *pt, const int pt_len, const sbdi_ctr_128b_t *ctr,
+    const uint32_t *blk_nbr, uint8_t *const *ct, uint8_t *const *tag)
+{
+  SBDI_CHK_PARAM(
+      ctx && n >= 0 && pt && pt_len > 0 && ctr && blk_nbr && ct && tag);
+  siv_ctx *s_ctx = (siv_ctx *) ctx;
+  uint8_t ad_dat[SBDI_SIV_BATCH_SIZE][SBDI_SIV_AD_SIZE];
+  const unsigned char *ad[SBDI_SIV_BATCH_SIZE];
+  sbdi_buffer_t b;
+  memset(&b, 0, sizeof(sbdi_buffer_t));
+
+  for (int o = 0; o < n; o += SBDI_SIV_BATCH_SIZE) {
+    const int k = SBDI_SIV_MIN(n - o, SBDI_SIV_BATCH_SIZE);
+    for (int i = 0; i < k; ++i) {
+      SBDI_CHK_PARAM(pt[o + i] && ct[o + i] && tag[o + i]
+          && sbdi_block_is_valid_phy(blk_nbr[o + i]));
+      sbdi_buffer_init(&b, ad_dat[i], SBDI_SIV_AD_SIZE);
+      sbdi_buffer_write_uint32_t(&b, blk_nbr[o + i]);
+      sbdi_buffer_write_ctr_128b(&b, &ctr[o + i]);
+      ad[i] = ad_dat[i];
+    }
+    // The S2V of all blocks runs interleaved, then each block is encrypted
+    // with its synthetic IV
+    s2v_n(s_ctx, ad, SBDI_SIV_AD_SIZE, pt + o, pt_len, tag + o, k);
+    for (int i = 0; i < k; ++i) {
+      siv_aes_ctr(s_ctx, pt[o + i], pt_len, ct[o + i], tag[o + i]);
+    }
+  }
+  return SBDI_SUCCESS;
+}
+
+sbdi_error_t sbdi_siv_decrypt_n(void *ctx, const int n,
+    const uint8_t *const *ct, const int ct_len, const uint8_t *const *ctr,
+    const uint32_t *blk_nbr, uint8_t *const *pt, const uint8_t *const *tag)
+{
+  SBDI_CHK_PARAM(
+      ctx && n >= 0 && ct && ct_len > 0 && ctr && blk_nbr && pt && tag);
+  siv_ctx *s_ctx = (siv_ctx *) ctx;
+  uint8_t ad[SBDI_SIV_AD_SIZE];
+  sbdi_error_t r = SBDI_SUCCESS;
+  sbdi_buffer_t b;
+  memset(&b, 0, sizeof(sbdi_buffer_t));
+
+  for (int i = 0; i < n; ++i) {
+    SBDI_CHK_PARAM(ct[i] && ctr[i] && pt[i] && tag[i]
+        && sbdi_block_is_valid_phy(blk_nbr[i]));
+    sbdi_buffer_init(&b, ad, SBDI_SIV_AD_SIZE);
+    sbdi_buffer_write_uint32_t(&b, blk_nbr[i]);
+    sbdi_buffer_write_bytes(&b, ctr[i], SBDI_BLOCK_CTR_SIZE);
+    // The fused kernel decrypts and MACs each block in a single pass and
+    // does not modify the shared context
+    if (siv_decrypt_fused(s_ctx, ct[i], pt[i], ct_len, tag[i], ad,
+        SBDI_SIV_AD_SIZE) != 1) {
+      r = SBDI_ERR_TAG_MISMATCH;
+    }
+  }
+  return r;
+}
+
 sbdi_error_t sbdi_siv_init(siv_ctx *ctx, const sbdi_key_t key)
 {
   SBDI_CHK_PARAM(ctx && key);
@@ -171,6 +244,9 @@ sbdi_error_t sbdi_siv_create(sbdi_crypto_t **crypto, const sbdi_key_t key)
   c->enc = &sbdi_siv_encrypt;
   c->dec = &sbdi_siv_decrypt;
   c->mac = &sbdi_siv_cmac;
+  c->enc_n = &sbdi_siv_encrypt_n;
+  c->dec_n = &sbdi_siv_decrypt_n;
+  c->mac_n = &sbdi_siv_cmac_n;
   *crypto = c;
   return SBDI_SUCCESS;
 
@@ -36,6 +36,7 @@
  * license (including the GNU public license).
  */
 #include "siv.h"
+#include "aes_ni.h"
 
 #include <stdio.h>
 #include <string.h>
@@ -52,6 +53,7 @@
  */
 
 #define Rb    0x87
+#define SIV_CTR_BATCH 8 /* number of key stream blocks per AES call */
 
 const static unsigned char zero[AES_BLOCK_SIZE] = { 0x00, 0x00, 0x00, 0x00,
     0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
@@ -184,6 +186,70 @@ void sbdi_bl_aes_cmac(siv_ctx *ctx, const unsigned char *ad,
   do_aes_cmac_work(ctx, msg, mlen, C);
 }
 
+/*
+ * cmac_last_block()
+ *  prepare the last (padded and K1/K2 xor'd) block of an AES-CMAC over
+ *  msg and return the number of whole blocks in front of it
+ */
+static int cmac_last_block(siv_ctx *ctx, const unsigned char *msg, int mlen,
+    unsigned char *Mn)
+{
+  int n, slop;
+
+  n = (mlen + (AES_BLOCK_SIZE - 1)) / AES_BLOCK_SIZE;
+  memset(Mn, 0, AES_BLOCK_SIZE);
+  if ((slop = (mlen % AES_BLOCK_SIZE)) != 0) {
+    memcpy(Mn, msg + (n - 1) * AES_BLOCK_SIZE, slop);
+    pad(Mn, slop);
+    xor(Mn, ctx->K2);
+  } else if (msg != NULL && mlen != 0) {
+    memcpy(Mn, msg + (n - 1) * AES_BLOCK_SIZE, AES_BLOCK_SIZE);
+    xor(Mn, ctx->K1);
+  } else {
+    pad(Mn, 0);
+    xor(Mn, ctx->K2);
+    return 0;
+  }
+  return n - 1;
+}
+
+void sbdi_bl_aes_cmac_n(siv_ctx *ctx, const unsigned char *const *ad,
+    const int ad_len, const unsigned char *const *msg, const int mlen,
+    unsigned char *const *C, const int n)
+{
+  unsigned char S[AES_MB_LANES][AES_BLOCK_SIZE];
+  unsigned char Mn[AES_MB_LANES][AES_BLOCK_SIZE];
+  const unsigned char *in[AES_MB_LANES];
+  int g, l, k, nb = 0;
+
+  assert(ad_len == AES_BLOCK_SIZE);
+
+  /*
+   * all lanes have the same length, so they can run the CBC part of
+   * AES-CMAC in lock-step
+   */
+  for (g = 0; g < n; g += AES_MB_LANES) {
+    k = (n - g < AES_MB_LANES) ? n - g : AES_MB_LANES;
+    memset(S, 0, sizeof(S));
+    for (l = 0; l < k; l++) {
+      in[l] = ad[g + l];
+    }
+    AES_cbc_encrypt_mb(in, NULL, 1, &ctx->s2v_sched, S, k);
+    for (l = 0; l < k; l++) {
+      nb = cmac_last_block(ctx, msg[g + l], mlen, Mn[l]);
+      in[l] = msg[g + l];
+    }
+    AES_cbc_encrypt_mb(in, NULL, nb, &ctx->s2v_sched, S, k);
+    for (l = 0; l < k; l++) {
+      in[l] = Mn[l];
+    }
+    AES_cbc_encrypt_mb(in, NULL, 1, &ctx->s2v_sched, S, k);
+    for (l = 0; l < k; l++) {
+      memcpy(C[g + l], S[l], AES_BLOCK_SIZE);
+    }
+  }
+}
+
 /*
  * s2v_final()
  *  input the last chunk into the s2v, output the digest
@@ -287,6 +353,77 @@ int s2v_final(siv_ctx *ctx, const unsigned char *X, int xlen,
   return 0;
 }
 
+/*
+ * s2v_n()
+ *  compute S2V(ad, p) for n independent (ad, p) pairs of the same lengths
+ *  without touching the running state of ctx. Equivalent to
+ *  s2v_update(ad); s2v_final(p) on a freshly restarted context.
+ */
+void s2v_n(siv_ctx *ctx, const unsigned char *const *ad, const int ad_len,
+    const unsigned char *const *p, const int len, unsigned char *const *V,
+    const int n)
+{
+  unsigned char S[AES_MB_LANES][AES_BLOCK_SIZE];
+  unsigned char Mn[AES_MB_LANES][AES_BLOCK_SIZE];
+  unsigned char D[AES_BLOCK_SIZE];
+  const unsigned char *in[AES_MB_LANES];
+  siv_ctx tmp;
+  int g, l, k, nb = 0;
+
+  if (len <= AES_BLOCK_SIZE || (len % AES_BLOCK_SIZE) != 0) {
+    /*
+     * short or partial final blocks need the xor-end/pad special cases,
+     * just run the serial code on a copy of the context
+     */
+    for (l = 0; l < n; l++) {
+      memcpy(&tmp, ctx, sizeof(siv_ctx));
+      s2v_update(&tmp, ad[l], ad_len);
+      s2v_final(&tmp, p[l], len, V[l]);
+    }
+    memset(&tmp, 0, sizeof(siv_ctx));
+    return;
+  }
+
+  times_two(D, ctx->T);
+  for (g = 0; g < n; g += AES_MB_LANES) {
+    k = (n - g < AES_MB_LANES) ? n - g : AES_MB_LANES;
+    /*
+     * Y = AES-CMAC(ad)
+     */
+    memset(S, 0, sizeof(S));
+    for (l = 0; l < k; l++) {
+      nb = cmac_last_block(ctx, ad[g + l], ad_len, Mn[l]);
+      in[l] = ad[g + l];
+    }
+    AES_cbc_encrypt_mb(in, NULL, nb, &ctx->s2v_sched, S, k);
+    for (l = 0; l < k; l++) {
+      in[l] = Mn[l];
+    }
+    AES_cbc_encrypt_mb(in, NULL, 1, &ctx->s2v_sched, S, k);
+    /*
+     * T = dbl(T) ^ Y, then AES-CMAC over p with T xor-ended onto the
+     * last (whole) block
+     */
+    for (l = 0; l < k; l++) {
+      memcpy(Mn[l], p[g + l] + len - AES_BLOCK_SIZE, AES_BLOCK_SIZE);
+      xor(Mn[l], S[l]);
+      xor(Mn[l], D);
+      xor(Mn[l], ctx->K1);
+      in[l] = p[g + l];
+    }
+    memset(S, 0, sizeof(S));
+    AES_cbc_encrypt_mb(in, NULL, len / AES_BLOCK_SIZE - 1, &ctx->s2v_sched,
+        S, k);
+    for (l = 0; l < k; l++) {
+      in[l] = Mn[l];
+    }
+    AES_cbc_encrypt_mb(in, NULL, 1, &ctx->s2v_sched, S, k);
+    for (l = 0; l < k; l++) {
+      memcpy(V[g + l], S[l], AES_BLOCK_SIZE);
+    }
+  }
+}
+
 /*
  * s2v_add()
  *  add an sPRF'd string to s2v
@@ -406,14 +543,19 @@ void vprf(siv_ctx *ctx, unsigned char *outp, const int nad, ...)
 
 /*
  * siv_aes_ctr()
- *      aes in CTR mode for SIV
+ *      aes in CTR mode for SIV. The key stream is generated SIV_CTR_BATCH
+ *      blocks at a time, with interleaved AES-NI rounds if the CPU
+ *      supports them and with a batched AES call otherwise.
  */
 void siv_aes_ctr(siv_ctx *ctx, const unsigned char *p, const int lenp,
     unsigned char *c, const unsigned char *iv)
 {
-  int i, j;
-  unsigned char ctr[AES_BLOCK_SIZE], ecr[AES_BLOCK_SIZE];
+  int i, j, n, nblk;
+  unsigned char ctr[AES_BLOCK_SIZE];
+  unsigned char cbs[SIV_CTR_BATCH * AES_BLOCK_SIZE];
+  unsigned char ecr[SIV_CTR_BATCH * AES_BLOCK_SIZE];
   unsigned long inc;
+  uint64_t x, k;
 
   memcpy(ctr, iv, AES_BLOCK_SIZE);
   /*
@@ -425,19 +567,37 @@ void siv_aes_ctr(siv_ctx *ctx, const unsigned char *p, const int lenp,
    */
   ctr[12] &= 0x7f;
   ctr[8] &= 0x7f;
+#if AES_NI_SUPPORTED
+  if (aes_ni_is_available()) {
+    aes_ni_ctr32(&ctx->ctr_sched, p, c, lenp, ctr, 0);
+    return;
+  }
+#endif
   inc = GETU32(ctr + 12);
-  for (i = 0; i < lenp; i += AES_BLOCK_SIZE) {
-    AES_encrypt(ctr, ecr, &ctx->ctr_sched);
-    for (j = 0; j < AES_BLOCK_SIZE; j++) {
-      if ((i + j) == lenp) {
-        return;
-      }
+  for (i = 0; i < lenp; i += n) {
+    nblk = (lenp - i + AES_BLOCK_SIZE - 1) / AES_BLOCK_SIZE;
+    if (nblk > SIV_CTR_BATCH) {
+      nblk = SIV_CTR_BATCH;
+    }
+    for (j = 0; j < nblk; j++) {
+      memcpy(cbs + j * AES_BLOCK_SIZE, ctr, AES_BLOCK_SIZE);
+      PUTU32(cbs + j * AES_BLOCK_SIZE + 12, inc);
+      inc++;
+      inc &= 0xffffffff;
+    }
+    AES_encrypt_blks(cbs, ecr, nblk, &ctx->ctr_sched);
+    n = (lenp - i < nblk * AES_BLOCK_SIZE) ? lenp - i : nblk * AES_BLOCK_SIZE;
+    for (j = 0; j + (int) sizeof(x) <= n; j += sizeof(x)) {
+      memcpy(&x, p + i + j, sizeof(x));
+      memcpy(&k, ecr + j, sizeof(k));
+      x ^= k;
+      memcpy(c + i + j, &x, sizeof(x));
+    }
+    for (; j < n; j++) {
       c[i + j] = p[i + j] ^ ecr[j];
     }
-    inc++;
-    inc &= 0xffffffff;
-    PUTU32(ctr + 12, inc);
   }
+  memset(ecr, 0, sizeof(ecr));
 }
 
 /*
@@ -519,3 +679,61 @@ int siv_decrypt(siv_ctx *ctx, const unsigned char *c, unsigned char *p,
     return 1;
   }
 }
+
+/*
+ * siv_decrypt_fused()
+ *      same as siv_decrypt with a single associated data string, but
+ *      leaves ctx untouched (it must be in the restarted state). If the
+ *      CPU supports AES-NI and len is a multiple of the block size, the
+ *      CTR decryption and the AES-CMAC over the recovered plaintext run
+ *      in a single pass over the data.
+ */
+int siv_decrypt_fused(siv_ctx *ctx, const unsigned char *c, unsigned char *p,
+    const int len, const unsigned char *counter, const unsigned char *ad,
+    const int ad_len)
+{
+  unsigned char ctr[AES_BLOCK_SIZE], S[AES_BLOCK_SIZE];
+  unsigned char D[AES_BLOCK_SIZE], Y[AES_BLOCK_SIZE];
+  siv_ctx tmp;
+  int r, blocks;
+
+#if AES_NI_SUPPORTED
+  if (aes_ni_is_available() && len > AES_BLOCK_SIZE
+      && (len % AES_BLOCK_SIZE) == 0) {
+    blocks = len / AES_BLOCK_SIZE;
+    /*
+     * D = dbl(T) ^ AES-CMAC(ad)
+     */
+    aes_cmac(ctx, ad, ad_len, Y);
+    times_two(D, ctx->T);
+    xor(D, Y);
+    memcpy(ctr, counter, AES_BLOCK_SIZE);
+    ctr[12] &= 0x7f;
+    ctr[8] &= 0x7f;
+    /*
+     * CTR over all blocks, AES-CMAC over all but the last plaintext block
+     */
+    memset(S, 0, AES_BLOCK_SIZE);
+    aes_ni_ctr_cbcmac(&ctx->ctr_sched, c, p, blocks, ctr, &ctx->s2v_sched,
+        blocks - 1, S);
+    /*
+     * xor-end D onto the last (whole) block and finish AES-CMAC
+     */
+    memcpy(Y, p + len - AES_BLOCK_SIZE, AES_BLOCK_SIZE);
+    xor(Y, D);
+    xor(Y, ctx->K1);
+    xor(S, Y);
+    AES_encrypt(S, S, &ctx->s2v_sched);
+    if (memcmp(S, counter, AES_BLOCK_SIZE)) {
+      memset(p, 0, len);
+      return -1; /* FAIL */
+    }
+    return 1;
+  }
+#endif
+  memcpy(&tmp, ctx, sizeof(siv_ctx));
+  memcpy(ctr, counter, AES_BLOCK_SIZE);
+  r = siv_decrypt(&tmp, c, p, len, ctr, 1, ad, ad_len);
+  memset(&tmp, 0, sizeof(siv_ctx));
+  return r;
+}
@@ -87,6 +87,9 @@ void s2v_benchmark(siv_ctx *);
 void s2v_add(siv_ctx *, const unsigned char *);
 void s2v_update(siv_ctx *, const unsigned char *, int);
 int s2v_final(siv_ctx *, const unsigned char *, int, unsigned char *);
+void s2v_n(siv_ctx *, const unsigned char *const *, const int,
+    const unsigned char *const *, const int, unsigned char *const *,
+    const int);
 void vprf(siv_ctx *, unsigned char *, const int, ...);
 void siv_restart(siv_ctx *);
 void siv_aes_ctr(siv_ctx *, const unsigned char *, const int, unsigned char *,
@@ -95,6 +98,8 @@ int siv_encrypt(siv_ctx *, const unsigned char *, unsigned char *, const int,
     unsigned char *, const int, ...);
 int siv_decrypt(siv_ctx *, const unsigned char *, unsigned char *, const int,
     unsigned char *, const int, ...);
+int siv_decrypt_fused(siv_ctx *, const unsigned char *, unsigned char *,
+    const int, const unsigned char *, const unsigned char *, const int);
 
 /*!
  *
@@ -113,6 +118,24 @@ void sbdi_bl_aes_cmac(siv_ctx *ctx, const unsigned char *ad,
     const int ad_len, const unsigned char *msg, const int mlen,
     unsigned char *C);
 
+/*!
+ * \brief Computes sbdi_bl_aes_cmac for n independent messages at once
+ *
+ * All messages must have the same length. The messages are processed in
+ * groups of AES_MB_LANES, whose CBC chains are interleaved.
+ *
+ * @param ctx[in] the siv context providing the key for the MAC operation
+ * @param ad[in] the additional data of each message
+ * @param ad_len[in] the length of the additional data (must be
+ * AES_BLOCK_SIZE)
+ * @param msg[in] the messages to compute the CMACs of
+ * @param mlen[in] the length of each message
+ * @param C[out] the resulting CMACs
+ * @param n[in] the number of messages
+ */
+void sbdi_bl_aes_cmac_n(siv_ctx *ctx, const unsigned char *const *ad,
+    const int ad_len, const unsigned char *const *msg, const int mlen,
+    unsigned char *const *C, const int n);
 
 #ifdef __cplusplus
 }
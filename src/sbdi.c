@@ -35,6 +35,11 @@
 #include "sbdi_nocrypto.h"
 #include "sbdi_ocb.h"
 #include "sbdi_hmac.h"
+#include "sbdi_gcm.h"
+#include "sbdi_gcm_siv.h"
+#include "sbdi_chacha.h"
+#include "sbdi_aegis.h"
+#include "sbdi_gmac.h"
 
 #include "SecureBlockDeviceInterface.h"
 
@@ -56,10 +61,12 @@ static inline void sbdi_init(sbdi_t *sbdi, sbdi_pio_t *pio, mt_t *mt,
 //----------------------------------------------------------------------
 sbdi_t *sbdi_create(sbdi_pio_t *pio)
 {
-  sbdi_t *sbdi = calloc(1, sizeof(sbdi_t));
-  if (!sbdi) {
+  sbdi_t *sbdi = NULL;
+  // The write and batch stores are aligned for direct I/O back ends
+  if (posix_memalign((void **) &sbdi, SBDI_BL_ALIGN, sizeof(sbdi_t))) {
     return NULL;
   }
+  memset(sbdi, 0, sizeof(sbdi_t));
   mt_t *mt = mt_create();
   if (!mt) {
     free(sbdi);
@@ -72,7 +79,20 @@ sbdi_t *sbdi_create(sbdi_pio_t *pio)
     free(sbdi);
     return NULL;
   }
+  sbdi_cm_t *cm = sbdi_cm_create(pio);
+  if (!cm) {
+    sbdi_bc_cache_destroy(cache);
+    mt_delete(mt);
+    free(sbdi);
+    return NULL;
+  }
   sbdi_init(sbdi, pio, mt, cache);
+  sbdi->cm = cm;
+  sbdi_bc_set_sync_n(cache, &sbdi_bl_sync_n);
+#if SBDI_WORKER_THREADS > 0
+  // Without a worker pool all blocks are processed on the calling thread
+  sbdi->wp = sbdi_wp_create(SBDI_WORKER_THREADS);
+#endif
   return sbdi;
 }
 
@@ -97,6 +117,21 @@ static inline void sbdi_crypto_destroy(sbdi_crypto_t *crypto,
     case SBDI_HDR_KEY_TYPE_HMAC:
       sbdi_hmac_destroy(crypto);
       break;
+    case SBDI_HDR_KEY_TYPE_GCM:
+      sbdi_gcm_destroy(crypto);
+      break;
+    case SBDI_HDR_KEY_TYPE_GCM_SIV:
+      sbdi_gcm_siv_destroy(crypto);
+      break;
+    case SBDI_HDR_KEY_TYPE_CHACHA:
+      sbdi_chacha_destroy(crypto);
+      break;
+    case SBDI_HDR_KEY_TYPE_AEGIS:
+      sbdi_aegis_destroy(crypto);
+      break;
+    case SBDI_HDR_KEY_TYPE_GMAC:
+      sbdi_gmac_destroy(crypto);
+      break;
     }
   }
 }
@@ -107,6 +142,8 @@ void sbdi_delete(sbdi_t *sbdi)
   if (!sbdi) {
     return;
   }
+  sbdi_wp_destroy(sbdi->wp);
+  sbdi_cm_destroy(sbdi->cm);
   sbdi_bc_cache_destroy(sbdi->cache);
   mt_delete(sbdi->mt);
   sbdi_crypto_destroy(sbdi->crypto, sbdi->hdr);
@@ -116,6 +153,26 @@ void sbdi_delete(sbdi_t *sbdi)
   free(sbdi);
 }
 
+/*!
+ * \brief Expands the given master key into the master key context of the
+ * secure block device
+ *
+ * @param sbdi[inout] the secure block device to store the context in
+ * @param mkey[in] the master key to expand
+ * @return SBDI_SUCCESS if the context could be initialized;
+ *         SBDI_ERR_CRYPTO_FAIL otherwise
+ */
+static sbdi_error_t sbdi_mctx_init(sbdi_t *sbdi, sbdi_sym_mst_key_t mkey)
+{
+  if (siv_init(&sbdi->mctx, mkey, SIV_256) == -1) {
+    memset(&sbdi->mctx, 0, sizeof(siv_ctx));
+    memset(sbdi->mkey, 0, sizeof(sbdi_sym_mst_key_t));
+    return SBDI_ERR_CRYPTO_FAIL;
+  }
+  memcpy(sbdi->mkey, mkey, sizeof(sbdi_sym_mst_key_t));
+  return SBDI_SUCCESS;
+}
+
 //----------------------------------------------------------------------
 sbdi_error_t sbdi_open(sbdi_t **s, sbdi_pio_t *pio, sbdi_crypto_type_t ct,
     sbdi_sym_mst_key_t mkey, mt_hash_t root)
@@ -125,28 +182,26 @@ sbdi_error_t sbdi_open(sbdi_t **s, sbdi_pio_t *pio, sbdi_crypto_type_t ct,
   ct = SBDI_CRYPTO_TYPE;
 #endif
   // variables that need explicit cleaning
-  siv_ctx mctx;
-  memset(&mctx, 0, sizeof(siv_ctx));
   sbdi_hdr_v1_sym_key_t key;
   memset(&key, 0, sizeof(sbdi_hdr_v1_sym_key_t));
   sbdi_error_t r = SBDI_ERR_UNSPECIFIED;
   // Start body of function
-  sbdi_t *sbdi = NULL;
-  int cr = siv_init(&mctx, mkey, SIV_256);
-  if (cr == -1) {
-    r = SBDI_ERR_CRYPTO_FAIL;
+  sbdi_t *sbdi = sbdi_create(pio);
+  if (!sbdi) {
     goto FAIL;
   }
-  sbdi = sbdi_create(pio);
-  if (!sbdi) {
+  // The master key context lives as long as the secure block device
+  r = sbdi_mctx_init(sbdi, mkey);
+  if (r != SBDI_SUCCESS) {
     goto FAIL;
   }
-  r = sbdi_hdr_v1_read(sbdi, &mctx);
+  siv_ctx *mctx = &sbdi->mctx;
+  r = sbdi_hdr_v1_read(sbdi, mctx);
   if (r == SBDI_ERR_IO_MISSING_BLOCK) {
     // Empty block device ==> create header
     uint8_t nonce[SBDI_HDR_V1_KEY_MAX_SIZE];
     pio->genseed(nonce, SBDI_HDR_V1_KEY_MAX_SIZE);
-    sbdi_hdr_v1_derive_key(&mctx, key, nonce, SBDI_HDR_V1_KEY_MAX_SIZE/2,
+    sbdi_hdr_v1_derive_key(mctx, key, nonce, SBDI_HDR_V1_KEY_MAX_SIZE/2,
         nonce + SBDI_HDR_V1_KEY_MAX_SIZE/2, SBDI_HDR_V1_KEY_MAX_SIZE/2);
     // For now we only support SIV
     sbdi_hdr_v1_key_type_t ktype = SBDI_HDR_KEY_TYPE_INVALID;
@@ -176,6 +231,41 @@ sbdi_error_t sbdi_open(sbdi_t **s, sbdi_pio_t *pio, sbdi_crypto_type_t ct,
       }
       ktype = SBDI_HDR_KEY_TYPE_HMAC;
       break;
+    case SBDI_CRYPTO_GCM:
+      r = sbdi_gcm_create(&sbdi->crypto, key);
+      if (r != SBDI_SUCCESS) {
+        goto FAIL;
+      }
+      ktype = SBDI_HDR_KEY_TYPE_GCM;
+      break;
+    case SBDI_CRYPTO_GCM_SIV:
+      r = sbdi_gcm_siv_create(&sbdi->crypto, key);
+      if (r != SBDI_SUCCESS) {
+        goto FAIL;
+      }
+      ktype = SBDI_HDR_KEY_TYPE_GCM_SIV;
+      break;
+    case SBDI_CRYPTO_CHACHA:
+      r = sbdi_chacha_create(&sbdi->crypto, key);
+      if (r != SBDI_SUCCESS) {
+        goto FAIL;
+      }
+      ktype = SBDI_HDR_KEY_TYPE_CHACHA;
+      break;
+    case SBDI_CRYPTO_AEGIS:
+      r = sbdi_aegis_create(&sbdi->crypto, key);
+      if (r != SBDI_SUCCESS) {
+        goto FAIL;
+      }
+      ktype = SBDI_HDR_KEY_TYPE_AEGIS;
+      break;
+    case SBDI_CRYPTO_GMAC:
+      r = sbdi_gmac_create(&sbdi->crypto, key);
+      if (r != SBDI_SUCCESS) {
+        goto FAIL;
+      }
+      ktype = SBDI_HDR_KEY_TYPE_GMAC;
+      break;
     default:
       ktype = SBDI_HDR_KEY_TYPE_INVALID;
       r = SBDI_ERR_UNSUPPORTED;
@@ -185,7 +275,8 @@ sbdi_error_t sbdi_open(sbdi_t **s, sbdi_pio_t *pio, sbdi_crypto_type_t ct,
     if (r != SBDI_SUCCESS) {
       goto FAIL;
     }
-    r = sbdi_hdr_v1_write(sbdi, &mctx);
+    memset(key, 0, sizeof(sbdi_hdr_v1_sym_key_t));
+    r = sbdi_hdr_v1_write(sbdi, mctx);
     if (r != SBDI_SUCCESS) {
       // TODO additional error handling required!
       goto FAIL;
@@ -199,47 +290,87 @@ sbdi_error_t sbdi_open(sbdi_t **s, sbdi_pio_t *pio, sbdi_crypto_type_t ct,
   *s = sbdi;
   return SBDI_SUCCESS;
 
-  FAIL: memset(&mctx, 0, sizeof(siv_ctx));
-  memset(key, 0, sizeof(sbdi_hdr_v1_sym_key_t));
+  FAIL: memset(key, 0, sizeof(sbdi_hdr_v1_sym_key_t));
   sbdi_delete(sbdi);
   return r;
 }
 
-//----------------------------------------------------------------------
-sbdi_error_t sbdi_sync(sbdi_t *sbdi, sbdi_sym_mst_key_t mkey, mt_hash_t root)
+/*!
+ * \brief Writes all dirty state of the secure block device to the back end
+ *
+ * Must be called with the device lock held.
+ *
+ * @param sbdi[in] the secure block device to write out
+ * @param mkey[in] the master key
+ * @param root[out] the Merkle tree root after writing (can be NULL)
+ * @return SBDI_SUCCESS if the state has been written; an error code
+ * otherwise
+ */
+static sbdi_error_t sbdi_sync_i(sbdi_t *sbdi, sbdi_sym_mst_key_t mkey,
+    mt_hash_t root)
 {
-  SBDI_CHK_PARAM(sbdi && mkey);
-  siv_ctx mctx;
-  memset(&mctx, 0, sizeof(siv_ctx));
-
-  // TODO The cache and header sync must be atomic, do something about that
+  // NOTE The cache and header sync are only atomic if the back end is a
+  // write-ahead log (see sbdi_jnl.h)
   sbdi_error_t r = SBDI_ERR_UNSPECIFIED;
-  int cr = siv_init(&mctx, mkey, SIV_256);
-  if (cr == -1) {
-    r = SBDI_ERR_CRYPTO_FAIL;
-    goto FAIL;
-  }
-  r = sbdi_hdr_v1_write(sbdi, &mctx);
-  if (r != SBDI_SUCCESS) {
-    // TODO Potentially partially written header! Additional error handling required!
-    goto FAIL;
+  if (memcmp(sbdi->mkey, mkey, sizeof(sbdi_sym_mst_key_t))) {
+    // A new master key requires re-encrypting the header key
+    r = sbdi_mctx_init(sbdi, mkey);
+    if (r != SBDI_SUCCESS) {
+      return r;
+    }
+    sbdi_hdr_v1_mark_dirty(sbdi);
   }
+  // Flush the cache first; the data block writes advance the counter the
+  // header has to account for
   r = sbdi_bc_sync(sbdi->cache);
   if (r != SBDI_SUCCESS) {
     // TODO Potentially inconsistent state! Additional error handling required!
-    goto FAIL;
+    return r;
+  }
+  if (sbdi_hdr_v1_is_dirty(sbdi)) {
+    r = sbdi_hdr_v1_write(sbdi, &sbdi->mctx);
+    if (r != SBDI_SUCCESS) {
+      // TODO Potentially partially written header! Additional error handling required!
+      return r;
+    }
   }
   if (root) {
     r = sbdi_mt_sbdi_err_conv(mt_get_root(sbdi->mt, root));
     if (r != SBDI_SUCCESS) {
       // this should not happen, because it should have failed earlier
-      goto FAIL;
+      return r;
     }
   }
   return SBDI_SUCCESS;
+}
 
-  FAIL: memset(&mctx, 0, sizeof(siv_ctx));
-  return r;
+//----------------------------------------------------------------------
+sbdi_error_t sbdi_sync(sbdi_t *sbdi, sbdi_sym_mst_key_t mkey, mt_hash_t root)
+{
+  SBDI_CHK_PARAM(sbdi && mkey);
+  sbdi_cm_lock(sbdi->cm);
+  sbdi_error_t r = sbdi_sync_i(sbdi, mkey, root);
+  if (r != SBDI_SUCCESS) {
+    sbdi_cm_unlock(sbdi->cm);
+    return r;
+  }
+  // Close the back end transaction before other threads can write again
+  if (sbdi->pio->commit && sbdi->pio->commit(sbdi->pio->iod) == -1) {
+    sbdi_cm_unlock(sbdi->cm);
+    return SBDI_ERR_IO;
+  }
+  uint64_t ticket = sbdi_cm_enqueue(sbdi->cm);
+  sbdi_cm_unlock(sbdi->cm);
+  // Other threads can access the device while we wait for the back end
+  return sbdi_cm_flush(sbdi->cm, ticket);
+}
+
+//----------------------------------------------------------------------
+sbdi_error_t sbdi_get_sync_stats(sbdi_t *sbdi, sbdi_cm_stats_t *stats)
+{
+  SBDI_CHK_PARAM(sbdi && stats);
+  sbdi_cm_get_stats(sbdi->cm, stats);
+  return SBDI_SUCCESS;
 }
 
 //----------------------------------------------------------------------
@@ -349,8 +480,8 @@ static inline sbdi_error_t os_add_off_size(const size_t a, const off_t b)
 }
 
 //----------------------------------------------------------------------
-sbdi_error_t sbdi_pread(ssize_t *rd, sbdi_t *sbdi, void *buf, size_t nbyte,
-    off_t offset)
+static sbdi_error_t sbdi_pread_i(ssize_t *rd, sbdi_t *sbdi, void *buf,
+    size_t nbyte, off_t offset)
 {
   SBDI_CHK_PARAM(rd && sbdi && buf);
   // Make sure offset is non-negative and less than or equal to the max sbd size
@@ -385,6 +516,20 @@ sbdi_error_t sbdi_pread(ssize_t *rd, sbdi_t *sbdi, void *buf, size_t nbyte,
   size_t to_read =
       ((rlen + adr) > SBDI_BLOCK_SIZE) ? (SBDI_BLOCK_SIZE - adr) : rlen;
   while (rlen) {
+    if (adr == 0 && rlen >= 2 * SBDI_BLOCK_SIZE) {
+      // Several full blocks ==> read, verify and decrypt them as a batch
+      uint32_t n = rlen / SBDI_BLOCK_SIZE;
+      n = (n > SBDI_BL_BATCH_SIZE) ? SBDI_BL_BATCH_SIZE : n;
+      SBDI_ERR_CHK(sbdi_bl_read_data_blocks(sbdi, ptr, idx, n));
+      to_read = n * SBDI_BLOCK_SIZE;
+      *rd += to_read;
+      rlen -= to_read;
+      ptr += to_read;
+      assert(os_add_uint32(idx, n));
+      idx += n;
+      to_read = (rlen > SBDI_BLOCK_SIZE) ? SBDI_BLOCK_SIZE : rlen;
+      continue;
+    }
     // TODO Testcase for writing past a block boundary
     SBDI_ERR_CHK(sbdi_bl_read_data_block(sbdi, ptr, idx, adr, to_read));
     *rd += to_read;
@@ -400,7 +545,18 @@ sbdi_error_t sbdi_pread(ssize_t *rd, sbdi_t *sbdi, void *buf, size_t nbyte,
 }
 
 //----------------------------------------------------------------------
-sbdi_error_t sbdi_pwrite(ssize_t *wr, sbdi_t *sbdi, const void *buf,
+sbdi_error_t sbdi_pread(ssize_t *rd, sbdi_t *sbdi, void *buf, size_t nbyte,
+    off_t offset)
+{
+  SBDI_CHK_PARAM(sbdi);
+  sbdi_cm_lock(sbdi->cm);
+  sbdi_error_t r = sbdi_pread_i(rd, sbdi, buf, nbyte, offset);
+  sbdi_cm_unlock(sbdi->cm);
+  return r;
+}
+
+//----------------------------------------------------------------------
+static sbdi_error_t sbdi_pwrite_i(ssize_t *wr, sbdi_t *sbdi, const void *buf,
     size_t nbyte, off_t offset)
 {
   SBDI_CHK_PARAM(wr && sbdi && buf);
@@ -447,6 +603,176 @@ sbdi_error_t sbdi_pwrite(ssize_t *wr, sbdi_t *sbdi, const void *buf,
   return SBDI_SUCCESS;
 }
 
+//----------------------------------------------------------------------
+sbdi_error_t sbdi_pwrite(ssize_t *wr, sbdi_t *sbdi, const void *buf,
+    size_t nbyte, off_t offset)
+{
+  SBDI_CHK_PARAM(sbdi);
+  sbdi_cm_lock(sbdi->cm);
+  sbdi_error_t r = sbdi_pwrite_i(wr, sbdi, buf, nbyte, offset);
+  sbdi_cm_unlock(sbdi->cm);
+  return r;
+}
+
+/*!
+ * \brief Releases the whole data blocks of the given range in the back end
+ *
+ * Consecutive logical blocks of a management group are physically
+ * consecutive, so there is one discard per group the range touches.
+ *
+ * @param sbdi[in] the secure block device
+ * @param first[in] the logical index of the first block to discard
+ * @param last[in] the logical index one past the last block to discard
+ * @return SBDI_SUCCESS if the back end discarded all blocks; SBDI_ERR_IO
+ * otherwise
+ */
+static sbdi_error_t sbdi_discard_i(sbdi_t *sbdi, uint32_t first, uint32_t last)
+{
+  while (first < last) {
+    uint32_t end = first + 1;
+    while (end < last
+        && sbdi_blic_log_to_mng_blk_nbr(end)
+            == sbdi_blic_log_to_mng_blk_nbr(first)) {
+      end += 1;
+    }
+    const off_t phy = (off_t) sbdi_blic_log_to_phy_dat_blk(first)
+        * SBDI_BLOCK_SIZE;
+    if (sbdi->pio->discard(sbdi->pio->iod, phy,
+        (size_t) (end - first) * SBDI_BLOCK_SIZE) == -1) {
+      return SBDI_ERR_IO;
+    }
+    first = end;
+  }
+  return SBDI_SUCCESS;
+}
+
+//----------------------------------------------------------------------
+static sbdi_error_t sbdi_punch_hole_i(sbdi_t *sbdi, off_t offset, size_t len)
+{
+  SBDI_CHK_PARAM(sbdi && offset >= 0 && offset <= SBDI_SIZE_MAX);
+  SBDI_CHK_PARAM(os_add_size((size_t )offset, len));
+  const size_t sbdi_size = sbdi_hdr_v1_get_size(sbdi);
+  if (len == 0 || offset >= sbdi_size) {
+    return SBDI_SUCCESS;
+  }
+  const size_t end = size_min(offset + len, sbdi_size);
+  // Bytes past the end of the device do not matter, so a hole reaching the
+  // end covers the last block completely
+  const uint32_t first = (offset + SBDI_BLOCK_SIZE - 1) / SBDI_BLOCK_SIZE;
+  const uint32_t last = (end == sbdi_size) ?
+      (end + SBDI_BLOCK_SIZE - 1) / SBDI_BLOCK_SIZE : end / SBDI_BLOCK_SIZE;
+  uint8_t zero[SBDI_BLOCK_SIZE];
+  memset(zero, 0, SBDI_BLOCK_SIZE);
+  // Partially covered blocks at the edges are overwritten with zeros
+  if (offset % SBDI_BLOCK_SIZE) {
+    const size_t n = size_min((size_t) first * SBDI_BLOCK_SIZE, end) - offset;
+    SBDI_ERR_CHK(sbdi_bl_write_data_block(sbdi, zero,
+        offset / SBDI_BLOCK_SIZE, offset % SBDI_BLOCK_SIZE, n));
+  }
+  if (last >= first && (size_t) last * SBDI_BLOCK_SIZE < end) {
+    SBDI_ERR_CHK(sbdi_bl_write_data_block(sbdi, zero, last, 0,
+        end - (size_t) last * SBDI_BLOCK_SIZE));
+  }
+  if (first >= last) {
+    return SBDI_SUCCESS;
+  }
+  for (uint32_t idx = first; idx < last; ++idx) {
+    SBDI_ERR_CHK(sbdi_bl_discard_data_block(sbdi, idx));
+  }
+  if (!sbdi->pio->discard) {
+    return SBDI_SUCCESS;
+  }
+  // The updated management blocks must be written out before the data
+  // blocks they no longer reference are released
+  SBDI_ERR_CHK(sbdi_bc_sync(sbdi->cache));
+  return sbdi_discard_i(sbdi, first, last);
+}
+
+/*!
+ * \brief Deallocates the given range of the secure block device
+ *
+ * Whole data blocks in the range are marked as never written in their
+ * management blocks and released in the back end if it supports discarding;
+ * nothing is encrypted for them. Partially covered blocks at the edges are
+ * overwritten with zeros. Afterwards the range reads as zeros and the size
+ * of the device is unchanged. Like a write, this is committed by the next
+ * sbdi_sync.
+ *
+ * @param sbdi[in] the secure block device
+ * @param offset[in] the offset of the range
+ * @param len[in] the length of the range
+ * @return SBDI_SUCCESS if successful; an error code otherwise
+ */
+sbdi_error_t sbdi_punch_hole(sbdi_t *sbdi, off_t offset, size_t len)
+{
+  SBDI_CHK_PARAM(sbdi);
+  sbdi_cm_lock(sbdi->cm);
+  sbdi_error_t r = sbdi_punch_hole_i(sbdi, offset, len);
+  sbdi_cm_unlock(sbdi->cm);
+  return r;
+}
+
+//----------------------------------------------------------------------
+static sbdi_error_t sbdi_ftruncate_i(sbdi_t *sbdi, off_t length)
+{
+  SBDI_CHK_PARAM(length >= 0 && length <= SBDI_SIZE_MAX);
+  const size_t sbdi_size = sbdi_hdr_v1_get_size(sbdi);
+  if ((size_t) length >= sbdi_size) {
+    if ((size_t) length > sbdi_size) {
+      // Reads up to the new end need their management blocks in place
+      SBDI_ERR_CHK(sbdi_bl_grow(sbdi, (length - 1) / SBDI_BLOCK_SIZE));
+      sbdi_hdr_v1_update_size(sbdi, length);
+    }
+    return SBDI_SUCCESS;
+  }
+  // The data blocks and management groups still needed
+  const uint32_t blks = (length + SBDI_BLOCK_SIZE - 1) / SBDI_BLOCK_SIZE;
+  const uint32_t mngs = (blks == 0) ? 0 : sbdi_blic_log_to_mng_blk_nbr(blks - 1) + 1;
+  // Without truncation the removed groups would show up again when opening,
+  // so they are kept and punched like the rest of the last group
+  size_t end = sbdi_size;
+  if (sbdi->pio->truncate) {
+    // Removing the groups first keeps their cached blocks from being synced
+    SBDI_ERR_CHK(sbdi_bl_truncate_mngt_blocks(sbdi, mngs));
+    end = size_min(end, (size_t) mngs * SBDI_MNGT_BLOCK_ENTRIES * SBDI_BLOCK_SIZE);
+  }
+  // Zeroes the partial tail block and releases the rest of the last group
+  SBDI_ERR_CHK(sbdi_punch_hole_i(sbdi, length, end - length));
+  if (sbdi->pio->truncate) {
+    const off_t phy_end = (blks == 0) ?
+        SBDI_BLOCK_SIZE :
+        ((off_t) sbdi_blic_log_to_phy_dat_blk(blks - 1) + 1) * SBDI_BLOCK_SIZE;
+    if (sbdi->pio->truncate(sbdi->pio->iod, phy_end) == -1) {
+      return SBDI_ERR_IO;
+    }
+  }
+  sbdi_hdr_v1_update_size(sbdi, length);
+  return SBDI_SUCCESS;
+}
+
+/*!
+ * \brief Shrinks or extends the secure block device to the given length
+ *
+ * Extending creates the management blocks up to the new end; the new range
+ * reads as zeros. Shrinking zeroes the rest of the last block. If the back
+ * end supports truncation, the management groups past the new end are
+ * removed from the Merkle tree and the back end is cut behind the last
+ * block; otherwise the removed range is punched like with sbdi_punch_hole.
+ * Like a write, this is committed by the next sbdi_sync.
+ *
+ * @param sbdi[in] the secure block device
+ * @param length[in] the new size of the device
+ * @return SBDI_SUCCESS if successful; an error code otherwise
+ */
+sbdi_error_t sbdi_ftruncate(sbdi_t *sbdi, off_t length)
+{
+  SBDI_CHK_PARAM(sbdi);
+  sbdi_cm_lock(sbdi->cm);
+  sbdi_error_t r = sbdi_ftruncate_i(sbdi, length);
+  sbdi_cm_unlock(sbdi->cm);
+  return r;
+}
+
 //----------------------------------------------------------------------
 sbdi_error_t sbdi_lseek(off_t *new_off, sbdi_t *sbdi, off_t offset,
     sbdi_whence_t whence)
@@ -121,9 +121,12 @@ static int bl_is_valid_read_dest(const sbdi_t *sbdi, const uint8_t *mem,
 {
   const uint8_t *c_s = &sbdi->cache->store[0][0];
   const uint8_t *w_s = &sbdi->write_store_dat[0][0];
+  const uint8_t *b_s = &sbdi->batch_store_dat[0][0];
   int incache = mem >= c_s && mem <= c_s + SBDI_CACHE_SIZE - len;
   int instore = mem >= w_s && mem <= w_s + (2 * SBDI_BLOCK_SIZE) - len;
-  return (incache || instore);
+  int inbatch = mem >= b_s
+      && mem <= b_s + (SBDI_BL_BATCH_SIZE * SBDI_BLOCK_SIZE) - len;
+  return (incache || instore || inbatch);
 }
 
 //----------------------------------------------------------------------
@@ -175,45 +178,86 @@ sbdi_error_t bl_aes_cmac(const sbdi_t *sbdi, const sbdi_block_t *blk,
       sizeof(sbdi_ctr_128b_t));
 }
 
+/*!
+ * \brief A wrapper to call AES CMAC on several independent management
+ * blocks at once.
+ *
+ * This function produces the same tags as calling bl_aes_cmac for every
+ * block, but allows the cryptographic abstraction layer to interleave the
+ * MAC computations.
+ *
+ * @param sbdi the secure block device interface to CMAC something for
+ * (provides the key)
+ * @param blks the blocks the CMACs should be computed for
+ * @param tags the CMAC result tags
+ * @param n the number of blocks (at most SBDI_BL_BATCH_SIZE)
+ * @return an error depending on the underlying mac implementation
+ */
+static sbdi_error_t bl_aes_cmac_n(const sbdi_t *sbdi, const sbdi_block_t *blks,
+    sbdi_tag_t *tags, uint32_t n)
+{
+  sbdi_ctr_128b_t ctr[SBDI_BL_BATCH_SIZE];
+  const unsigned char *ad[SBDI_BL_BATCH_SIZE];
+  const unsigned char *msg[SBDI_BL_BATCH_SIZE];
+  unsigned char *C[SBDI_BL_BATCH_SIZE];
+
+  assert(n <= SBDI_BL_BATCH_SIZE);
+  for (uint32_t i = 0; i < n; ++i) {
+    sbdi_ctr_128b_init(&ctr[i], 0, blks[i].idx);
+    ad[i] = (unsigned char *) &ctr[i];
+    msg[i] = *blks[i].data;
+    C[i] = tags[i];
+  }
+  return sbdi_crypto_mac_n(sbdi->crypto, n, msg, sizeof(sbdi_bl_data_t), C,
+      ad, sizeof(sbdi_ctr_128b_t));
+}
+
 //----------------------------------------------------------------------
 sbdi_error_t sbdi_bl_verify_block_layer(sbdi_t *sbdi, mt_hash_t root)
 {
-  uint32_t i = 0;
-  uint32_t mng_phy = 0;
+  uint32_t nxt = 0;
+  uint32_t n = 0;
   uint32_t read = -1;
-  sbdi_block_t *mng;
-  sbdi_tag_t tag;
+  int eof = 0;
+  sbdi_block_t mng[SBDI_BL_BATCH_SIZE];
+  sbdi_tag_t tags[SBDI_BL_BATCH_SIZE];
   mt_hash_t check_root;
 
   SBDI_CHK_PARAM(sbdi && root);
-  mng = &sbdi->write_store[0];
-  memset(tag, 0, sizeof(tag));
+  memset(tags, 0, sizeof(tags));
   memset(check_root, 0, sizeof(mt_hash_t));
-  memset(*sbdi->write_store[0].data, 0, SBDI_BLOCK_SIZE);
-
-  for (i = 0;;i++) {
-    mng_phy = sbdi_blic_mng_blk_nbr_to_mng_phy(i);
 
-    sbdi_block_init(mng, mng_phy, sbdi->write_store[0].data);
-    sbdi_error_t r = sbdi_bl_read_block(sbdi, mng, SBDI_BLOCK_SIZE, &read);
-    if (r == SBDI_ERR_IO_MISSING_BLOCK && read == 0) {
-      // Note: Block does not yet exist, create empty block.
-      SBDI_ERR_CHK(sbdi_mt_sbdi_err_conv(mt_get_root(sbdi->mt, check_root)));
-      if (memcmp(root, check_root, sizeof(mt_hash_t))) {
-        return SBDI_ERR_TAG_MISMATCH;
+  while (!eof) {
+    // Read a batch of consecutive management blocks
+    for (n = 0; n < SBDI_BL_BATCH_SIZE; ++n) {
+      sbdi_block_init(&mng[n], sbdi_blic_mng_blk_nbr_to_mng_phy(nxt + n),
+          &sbdi->batch_store_dat[n]);
+      sbdi_error_t r = sbdi_bl_read_block(sbdi, &mng[n], SBDI_BLOCK_SIZE,
+          &read);
+      if (r == SBDI_ERR_IO_MISSING_BLOCK && read == 0) {
+        // Note: Block does not yet exist, this is the end of the device.
+        eof = 1;
+        break;
+      } else if (r != SBDI_SUCCESS) {
+        // I/O error => stop open!
+        return r;
       }
-      return SBDI_SUCCESS;
-    } else if (r != SBDI_SUCCESS) {
-      // I/O error => stop open!
-      return r;
-    } else {
-      // BLock found, MAC it and add it to Merkle-Tree
-      SBDI_ERR_CHK(bl_aes_cmac(sbdi, mng, tag));
+    }
+    // Blocks found, MAC them and add them to Merkle-Tree (in order)
+    if (n > 0) {
+      SBDI_ERR_CHK(bl_aes_cmac_n(sbdi, mng, tags, n));
+    }
+    for (uint32_t i = 0; i < n; ++i) {
       SBDI_ERR_CHK(
-          sbdi_mt_sbdi_err_conv(mt_add(sbdi->mt, tag, sizeof(sbdi_tag_t))));
+          sbdi_mt_sbdi_err_conv(mt_add(sbdi->mt, tags[i], sizeof(sbdi_tag_t))));
     }
+    nxt += n;
+  }
+  SBDI_ERR_CHK(sbdi_mt_sbdi_err_conv(mt_get_root(sbdi->mt, check_root)));
+  if (memcmp(root, check_root, sizeof(mt_hash_t))) {
+    return SBDI_ERR_TAG_MISMATCH;
   }
-  return SBDI_ERR_ILLEGAL_STATE;
+  return SBDI_SUCCESS;
 }
 
 //----------------------------------------------------------------------
@@ -380,6 +424,168 @@ sbdi_error_t sbdi_bl_read_data_block(sbdi_t *sbdi, unsigned char *ptr,
   return SBDI_SUCCESS;
 }
 
+/*!
+ * \brief The shared state of a parallel batch decryption
+ */
+typedef struct bl_dec_job {
+  const sbdi_crypto_t *crypto;              //!< the crypto abstraction layer
+  const uint8_t *ct[SBDI_BL_BATCH_SIZE];    //!< the ciphertexts
+  const uint8_t *ctr[SBDI_BL_BATCH_SIZE];   //!< the data block counters
+  const uint8_t *tag[SBDI_BL_BATCH_SIZE];   //!< the data block tags
+  uint8_t *pt[SBDI_BL_BATCH_SIZE];          //!< the plaintext destinations
+  uint32_t blk_nbr[SBDI_BL_BATCH_SIZE];     //!< the physical block indices
+  uint32_t n;                               //!< the number of data blocks
+  uint32_t njobs;                           //!< the number of slices
+  sbdi_error_t err[SBDI_BL_BATCH_SIZE];     //!< the result of every slice
+} bl_dec_job_t;
+
+/*!
+ * \brief Worker pool job that verifies and decrypts one contiguous slice of
+ * a batch
+ *
+ * @param data the bl_dec_job_t describing the batch
+ * @param job the number of the slice to decrypt
+ */
+static void bl_dec_job(void *data, uint32_t job)
+{
+  bl_dec_job_t *j = data;
+  const uint32_t s = (j->n * job) / j->njobs;
+  const uint32_t e = (j->n * (job + 1)) / j->njobs;
+  j->err[job] = sbdi_crypto_dec_n(j->crypto, e - s, &j->ct[s],
+      SBDI_BLOCK_SIZE, &j->ctr[s], &j->blk_nbr[s], &j->pt[s], &j->tag[s]);
+}
+
+/*!
+ * \brief Reads a run of physically consecutive data blocks into the batch
+ * store using a single backend read
+ *
+ * Blocks that lie completely beyond the end of the backend are reported as
+ * missing, just like sbdi_bl_read_block does for a single block.
+ *
+ * @param sbdi the secure block device interface to read from
+ * @param pos the position of the first block in the batch store
+ * @param phy the physical index of the first block
+ * @param k the number of blocks to read
+ * @param missing[out] set to one for every block that does not exist yet
+ * @return SBDI_SUCCESS if the run could be read; SBDI_ERR_IO or
+ * SBDI_ERR_IO_MISSING_DATA otherwise
+ */
+static sbdi_error_t bl_read_run(sbdi_t *sbdi, uint32_t pos, uint32_t phy,
+    uint32_t k, int *missing)
+{
+  const size_t len = k * SBDI_BLOCK_SIZE;
+  uint8_t *dst = sbdi->batch_store_dat[pos];
+  // Paranoia assertion
+  assert(bl_is_valid_read_dest(sbdi, dst, len));
+  ssize_t r = sbdi->pio->pread(sbdi->pio->iod, dst, len,
+      (off_t) phy * SBDI_BLOCK_SIZE);
+  if (r == -1) {
+    return SBDI_ERR_IO;
+  }
+  for (uint32_t j = 0; j < k; ++j) {
+    const ssize_t b_s = (ssize_t) j * SBDI_BLOCK_SIZE;
+    if (r <= b_s) {
+      missing[pos + j] = 1;
+    } else if (r < b_s + SBDI_BLOCK_SIZE) {
+      return SBDI_ERR_IO_MISSING_DATA;
+    }
+  }
+  return SBDI_SUCCESS;
+}
+
+//----------------------------------------------------------------------
+sbdi_error_t sbdi_bl_read_data_blocks(sbdi_t *sbdi, unsigned char *ptr,
+    uint32_t idx, uint32_t n)
+{
+  SBDI_CHK_PARAM(
+      sbdi && ptr && n > 0 && n <= SBDI_BL_BATCH_SIZE && sbdi_block_is_valid_log(idx) && (n - 1) <= (UINT32_MAX - idx) && sbdi_block_is_valid_log(idx + n - 1));
+  sbdi_tag_t tags[SBDI_BL_BATCH_SIZE];
+  uint8_t ctrs[SBDI_BL_BATCH_SIZE][SBDI_BLOCK_CTR_SIZE];
+  uint32_t phy[SBDI_BL_BATCH_SIZE];
+  uint32_t dst[SBDI_BL_BATCH_SIZE];
+  int missing[SBDI_BL_BATCH_SIZE];
+  uint32_t m = 0;
+  memset(missing, 0, sizeof(missing));
+  // Serve cached blocks from the cache and collect the tags and counters of
+  // all other blocks. The management blocks may evict (and thus sync) other
+  // blocks, which is why the tags and counters are copied right away.
+  for (uint32_t i = 0; i < n; ++i) {
+    uint8_t *out = ptr + (i * SBDI_BLOCK_SIZE);
+    uint32_t tag_idx = sbdi_blic_log_to_mng_tag_pos(idx + i);
+    sbdi_block_pair_t pair;
+    bl_pair_init(&pair, sbdi_blic_log_to_phy_mng_blk(idx + i),
+        sbdi_blic_log_to_phy_dat_blk(idx + i));
+    SBDI_ERR_CHK(sbdi_bc_find_blk(sbdi->cache, pair.blk));
+    if (pair.blk->data) {
+      memcpy(out, *pair.blk->data, SBDI_BLOCK_SIZE);
+      continue;
+    }
+    SBDI_ERR_CHK(sbdi_bc_find_blk(sbdi->cache, pair.mng));
+    if (!pair.mng->data) {
+      SBDI_ERR_CHK(bl_read_mngt_block(sbdi, pair.mng));
+    }
+    // Check if block has never been written
+    if (!memcmp(bl_get_tag_address(pair.mng, tag_idx), ZERO,
+    SBDI_BLOCK_TAG_SIZE)) {
+      memset(out, 0, SBDI_BLOCK_SIZE);
+      continue;
+    }
+    memcpy(tags[m], bl_get_tag_address(pair.mng, tag_idx),
+        SBDI_BLOCK_TAG_SIZE);
+    memcpy(ctrs[m], bl_get_ctr_address(pair.mng, tag_idx),
+        SBDI_BLOCK_CTR_SIZE);
+    phy[m] = pair.blk->idx;
+    dst[m] = i;
+    m++;
+  }
+  if (m == 0) {
+    return SBDI_SUCCESS;
+  }
+  // Fetch the ciphertexts with one backend read per physically contiguous
+  // run of blocks
+  for (uint32_t s = 0, e = 1; s < m; s = e++) {
+    while (e < m && phy[e] == phy[e - 1] + 1) {
+      e++;
+    }
+    SBDI_ERR_CHK(bl_read_run(sbdi, s, phy[s], e - s, missing));
+  }
+  // Verify and decrypt on the worker pool
+  bl_dec_job_t job;
+  memset(&job, 0, sizeof(bl_dec_job_t));
+  job.crypto = sbdi->crypto;
+  for (uint32_t i = 0; i < m; ++i) {
+    if (missing[i]) {
+      // Note: Block does not yet exist, create empty block.
+      memset(ptr + (dst[i] * SBDI_BLOCK_SIZE), 0, SBDI_BLOCK_SIZE);
+      continue;
+    }
+    job.ct[job.n] = sbdi->batch_store_dat[i];
+    job.ctr[job.n] = ctrs[i];
+    job.tag[job.n] = tags[i];
+    job.pt[job.n] = ptr + (dst[i] * SBDI_BLOCK_SIZE);
+    job.blk_nbr[job.n] = phy[i];
+    job.n++;
+  }
+  if (job.n == 0) {
+    return SBDI_SUCCESS;
+  }
+  // Layers without a reentrant batch decryption run on the calling thread
+  job.njobs = (sbdi->crypto->dec_n) ? sbdi_wp_get_concurrency(sbdi->wp) : 1;
+  if (job.njobs > job.n) {
+    job.njobs = job.n;
+  }
+  sbdi_wp_run((job.njobs > 1) ? sbdi->wp : NULL, &bl_dec_job, &job,
+      job.njobs);
+  for (uint32_t i = 0; i < job.njobs; ++i) {
+    if (job.err[i] != SBDI_SUCCESS) {
+      // Do not hand out any unverified plaintext
+      memset(ptr, 0, n * SBDI_BLOCK_SIZE);
+      return SBDI_ERR_TAG_MISMATCH;
+    }
+  }
+  return SBDI_SUCCESS;
+}
+
 sbdi_error_t sbdi_bl_verify_header(sbdi_t *sbdi, sbdi_block_t *hdr)
 {
   SBDI_CHK_PARAM(sbdi && hdr && hdr->idx == 0 && hdr->data);
@@ -410,10 +616,13 @@ static int bl_is_valid_write_source(const sbdi_t *sbdi, const uint8_t *mem,
 {
   const uint8_t *c_s = &sbdi->cache->store[0][0];
   const uint8_t *w_s = &sbdi->write_store_dat[0][0];
+  const uint8_t *b_s = &sbdi->batch_store_dat[0][0];
   int incache = mem >= c_s && mem <= c_s + (SBDI_CACHE_SIZE) - len;
   // Management block may only be written from block 0
   int instore = mem >= w_s && mem <= w_s + (SBDI_BLOCK_SIZE) - len;
-  return incache || instore;
+  int inbatch = mem >= b_s
+      && mem <= b_s + (SBDI_BL_BATCH_SIZE * SBDI_BLOCK_SIZE) - len;
+  return incache || instore || inbatch;
 }
 
 //----------------------------------------------------------------------
@@ -469,24 +678,35 @@ static sbdi_error_t bl_mac_write_mngt(sbdi_t *sbdi, sbdi_block_t *mng,
  */
 static sbdi_error_t bl_ensure_mngt_blocks_exist(sbdi_t *sbdi, uint32_t log)
 {
-  sbdi_tag_t mng_tag;
-  memset(mng_tag, 0, sizeof(sbdi_tag_t));
-  // Clear write buffer
-  memset(sbdi->write_store[0].data, 0, SBDI_BLOCK_SIZE);
+  sbdi_block_t mng[SBDI_BL_BATCH_SIZE];
+  sbdi_tag_t mng_tags[SBDI_BL_BATCH_SIZE];
   uint32_t mng_blk_nbr = sbdi_blic_log_to_mng_blk_nbr(log) + 1;
   uint32_t s = mt_get_size(sbdi->mt);
   assert(s > 0); // There must always be the header block present!
   s -= 1; // Deduct header block
   while (s < mng_blk_nbr) {
-    sbdi->write_store[0].idx = sbdi_blic_mng_blk_nbr_to_mng_phy(s);
-    sbdi_buffer_t b;
-    sbdi_buffer_init(&b, *sbdi->write_store[0].data, SBDI_BLOCK_CTR_SIZE);
-    sbdi_buffer_write_ctr_128b(&b, &sbdi->hdr->ctr);
-    sbdi_ctr_128b_inc(&sbdi->hdr->ctr);
-    SBDI_ERR_CHK(bl_mac_write_mngt(sbdi, &sbdi->write_store[0], mng_tag));
-    SBDI_ERR_CHK(
-        sbdi_mt_sbdi_err_conv(mt_add(sbdi->mt, mng_tag, sizeof(sbdi_tag_t))));
-    s += 1;
+    // Create a batch of new management blocks, MAC them together and append
+    // them in order
+    uint32_t n = mng_blk_nbr - s;
+    if (n > SBDI_BL_BATCH_SIZE) {
+      n = SBDI_BL_BATCH_SIZE;
+    }
+    for (uint32_t i = 0; i < n; ++i) {
+      sbdi_block_init(&mng[i], sbdi_blic_mng_blk_nbr_to_mng_phy(s + i),
+          &sbdi->batch_store_dat[i]);
+      // All entries of a new management block read as never written, so the
+      // block stays all zero; it only reserves a counter value
+      memset(sbdi->batch_store_dat[i], 0, SBDI_BLOCK_SIZE);
+      SBDI_ERR_CHK(sbdi_ctr_128b_inc(&sbdi->hdr->ctr));
+    }
+    SBDI_ERR_CHK(bl_aes_cmac_n(sbdi, mng, mng_tags, n));
+    for (uint32_t i = 0; i < n; ++i) {
+      // TODO I do not need to write the whole block, just the updated part is sufficient
+      SBDI_ERR_CHK(sbdi_bl_write_block(sbdi, &mng[i], SBDI_BLOCK_SIZE));
+      SBDI_ERR_CHK(
+          sbdi_mt_sbdi_err_conv(mt_add(sbdi->mt, mng_tags[i], sizeof(sbdi_tag_t))));
+    }
+    s += n;
   }
   return SBDI_SUCCESS;
 }
@@ -519,6 +739,112 @@ sbdi_error_t sbdi_bl_write_data_block(sbdi_t *sbdi, unsigned char *ptr,
 // * Write back new block access counter and tag to management block (also in cache)
 }
 
+//----------------------------------------------------------------------
+sbdi_error_t sbdi_bl_discard_data_block(sbdi_t *sbdi, uint32_t idx)
+{
+  SBDI_CHK_PARAM(sbdi && sbdi_block_is_valid_log(idx));
+  if (sbdi_blic_log_to_mng_blk_nbr(idx) + 1 >= mt_get_size(sbdi->mt)) {
+    // The management block does not exist ==> never written
+    return SBDI_SUCCESS;
+  }
+  uint32_t tag_idx = sbdi_blic_log_to_mng_tag_pos(idx);
+  sbdi_block_pair_t pair;
+  bl_pair_init(&pair, sbdi_blic_log_to_phy_mng_blk(idx),
+      sbdi_blic_log_to_phy_dat_blk(idx));
+  // Drop a cached copy of the data block; pending changes are void
+  SBDI_ERR_CHK(sbdi_bc_find_blk(sbdi->cache, pair.blk));
+  if (pair.blk->data) {
+    SBDI_ERR_CHK(sbdi_bc_evict_blk(sbdi->cache, pair.blk->idx));
+  }
+  SBDI_ERR_CHK(sbdi_bc_find_blk(sbdi->cache, pair.mng));
+  if (!pair.mng->data) {
+    SBDI_ERR_CHK(bl_read_mngt_block(sbdi, pair.mng));
+  }
+  uint8_t *tag = bl_get_tag_address(pair.mng, tag_idx);
+  if (!memcmp(tag, ZERO, SBDI_BLOCK_TAG_SIZE)) {
+    return SBDI_SUCCESS;
+  }
+  // An all zero tag marks the block as never written, see bl_cache_decrypt
+  memset(tag, 0, SBDI_BLOCK_TAG_SIZE + SBDI_BLOCK_CTR_SIZE);
+  return sbdi_bc_dirty_blk(sbdi->cache, pair.mng->idx);
+}
+
+//----------------------------------------------------------------------
+sbdi_error_t sbdi_bl_grow(sbdi_t *sbdi, uint32_t idx)
+{
+  SBDI_CHK_PARAM(sbdi && sbdi_block_is_valid_log(idx));
+  return bl_ensure_mngt_blocks_exist(sbdi, idx);
+}
+
+/*!
+ * \brief Builds a Merkle tree over the header and the first n management
+ * blocks of the back end
+ *
+ * Every block is verified against the current Merkle tree before it is
+ * added, so the new tree only vouches for what the current one does.
+ *
+ * @param sbdi[in] the secure block device interface
+ * @param mt[in] the empty Merkle tree to build
+ * @param n[in] the number of management blocks to add
+ * @return SBDI_SUCCESS if the tree has been built; SBDI_ERR_TAG_MISMATCH if a
+ * block does not match the current tree; an I/O error otherwise
+ */
+static sbdi_error_t bl_rebuild_mt(sbdi_t *sbdi, mt_t *mt, uint32_t n)
+{
+  sbdi_block_t blks[SBDI_BL_BATCH_SIZE];
+  sbdi_tag_t tags[SBDI_BL_BATCH_SIZE];
+  uint32_t read = 0;
+  // Leaf 0 is the header, leaf i + 1 the management block i
+  for (uint32_t nxt = 0; nxt < n + 1;) {
+    uint32_t k = n + 1 - nxt;
+    if (k > SBDI_BL_BATCH_SIZE) {
+      k = SBDI_BL_BATCH_SIZE;
+    }
+    for (uint32_t i = 0; i < k; ++i) {
+      const uint32_t leaf = nxt + i;
+      sbdi_block_init(&blks[i],
+          (leaf == 0) ? 0 : sbdi_blic_mng_blk_nbr_to_mng_phy(leaf - 1),
+          &sbdi->batch_store_dat[i]);
+      SBDI_ERR_CHK(sbdi_bl_read_block(sbdi, &blks[i], SBDI_BLOCK_SIZE, &read));
+    }
+    SBDI_ERR_CHK(bl_aes_cmac_n(sbdi, blks, tags, k));
+    for (uint32_t i = 0; i < k; ++i) {
+      SBDI_ERR_CHK(
+          sbdi_mt_sbdi_err_conv(mt_verify(sbdi->mt, tags[i], sizeof(sbdi_tag_t), nxt + i)));
+      SBDI_ERR_CHK(
+          sbdi_mt_sbdi_err_conv(mt_add(mt, tags[i], sizeof(sbdi_tag_t))));
+    }
+    nxt += k;
+  }
+  return SBDI_SUCCESS;
+}
+
+//----------------------------------------------------------------------
+sbdi_error_t sbdi_bl_truncate_mngt_blocks(sbdi_t *sbdi, uint32_t n)
+{
+  SBDI_CHK_PARAM(sbdi);
+  assert(mt_get_size(sbdi->mt) > 0);
+  if (n + 1 >= mt_get_size(sbdi->mt)) {
+    return SBDI_SUCCESS;
+  }
+  // The Merkle tree cannot shrink, so build a new one without the leaves of
+  // the removed management blocks
+  mt_t *mt = mt_create();
+  if (!mt) {
+    return SBDI_ERR_OUT_Of_MEMORY;
+  }
+  sbdi_error_t r = bl_rebuild_mt(sbdi, mt, n);
+  if (r != SBDI_SUCCESS) {
+    mt_delete(mt);
+    return r;
+  }
+  mt_delete(sbdi->mt);
+  sbdi->mt = mt;
+  // Cached blocks of the removed groups must never be synced
+  return sbdi_bc_evict_blks_from(sbdi->cache,
+      sbdi_blic_mng_blk_nbr_to_mng_phy(n));
+}
+
 //----------------------------------------------------------------------
 sbdi_error_t sbdi_bl_write_hdr_block(sbdi_t *sbdi, sbdi_block_t *hdr)
 {
@@ -547,7 +873,7 @@ static sbdi_error_t bl_encrypt_write_update_mngt(sbdi_t *sbdi,
 }
 
 static inline void bl_update_mng_blk(sbdi_block_t *mng, uint32_t idx,
-    sbdi_ctr_128b_t *ctr, sbdi_tag_t tag)
+    const sbdi_ctr_128b_t *ctr, sbdi_tag_t tag)
 {
   // TODO Use data buffer for this?
   unsigned char *tag_addr = bl_get_tag_address(mng, idx);
@@ -559,8 +885,6 @@ static inline void bl_update_mng_blk(sbdi_block_t *mng, uint32_t idx,
   memset(&b, 0, sizeof(sbdi_buffer_t));
   sbdi_buffer_init(&b, ctr_addr, SBDI_BLOCK_CTR_SIZE);
   sbdi_buffer_write_ctr_128b(&b, ctr);
-
-  sbdi_ctr_128b_inc(ctr);
 }
 
 static sbdi_error_t bl_encrypt_write_data(sbdi_t *sbdi, sbdi_block_t *blk)
@@ -583,6 +907,7 @@ static sbdi_error_t bl_encrypt_write_data(sbdi_t *sbdi, sbdi_block_t *blk)
   uint32_t tag_idx = sbdi_blic_phy_dat_to_log(
       blk->idx) % SBDI_MNGT_BLOCK_ENTRIES;
   bl_update_mng_blk(&mng, tag_idx, &sbdi->hdr->ctr, data_tag);
+  SBDI_ERR_CHK(sbdi_ctr_128b_inc(&sbdi->hdr->ctr));
   sbdi_tag_t mng_tag;
   memset(mng_tag, 0, sizeof(sbdi_tag_t));
   // TODO for the next four steps we need absolute consistency!
@@ -638,3 +963,148 @@ sbdi_error_t sbdi_bl_sync(void *sbdi, sbdi_block_t *blk)
   sbdi_t *t_sbdi = (sbdi_t *) sbdi;
   return bl_sync(t_sbdi, blk);
 }
+
+/*!
+ * \brief The shared state of a parallel batch encryption
+ */
+typedef struct bl_enc_job {
+  sbdi_t *sbdi;                            //!< the secure block device
+  const sbdi_block_t *blks;                //!< the data blocks to encrypt
+  const sbdi_ctr_128b_t *ctr;              //!< the pre-assigned counters
+  sbdi_tag_t *tags;                        //!< the resulting data tags
+  uint32_t n;                              //!< the number of data blocks
+  uint32_t njobs;                          //!< the number of slices
+  sbdi_error_t err[SBDI_BL_BATCH_SIZE];    //!< the result of every slice
+} bl_enc_job_t;
+
+/*!
+ * \brief Worker pool job that encrypts one contiguous slice of a batch into
+ * the batch store
+ *
+ * @param data the bl_enc_job_t describing the batch
+ * @param job the number of the slice to encrypt
+ */
+static void bl_enc_job(void *data, uint32_t job)
+{
+  bl_enc_job_t *j = data;
+  const uint32_t s = (j->n * job) / j->njobs;
+  const uint32_t e = (j->n * (job + 1)) / j->njobs;
+  const uint8_t *pt[SBDI_BL_BATCH_SIZE];
+  uint8_t *ct[SBDI_BL_BATCH_SIZE];
+  uint8_t *tag[SBDI_BL_BATCH_SIZE];
+  uint32_t blk_nbr[SBDI_BL_BATCH_SIZE];
+  for (uint32_t i = s; i < e; ++i) {
+    pt[i - s] = *j->blks[i].data;
+    ct[i - s] = j->sbdi->batch_store_dat[i];
+    tag[i - s] = j->tags[i];
+    blk_nbr[i - s] = j->blks[i].idx;
+  }
+  j->err[job] = sbdi_crypto_enc_n(j->sbdi->crypto, e - s, pt, SBDI_BLOCK_SIZE,
+      &j->ctr[s], blk_nbr, ct, tag);
+}
+
+/*!
+ * \brief Encrypts and writes several dirty data blocks and updates their
+ * management blocks
+ *
+ * The counters are assigned in the order of the given blocks, exactly as if
+ * the blocks were synchronized one by one. The encryption runs on the worker
+ * pool. Afterwards the data blocks are written in order, and every affected
+ * management block is MACed, written and updated in the Merkle tree once.
+ *
+ * @param sbdi the secure block device interface the blocks belong to
+ * @param blks the data blocks to synchronize
+ * @param n the number of data blocks (at most SBDI_BL_BATCH_SIZE)
+ * @return SBDI_SUCCESS if all blocks could be synchronized; an error code
+ * otherwise
+ */
+static sbdi_error_t bl_encrypt_write_data_n(sbdi_t *sbdi, sbdi_block_t *blks,
+    uint32_t n)
+{
+  sbdi_ctr_128b_t ctr[SBDI_BL_BATCH_SIZE];
+  sbdi_tag_t tags[SBDI_BL_BATCH_SIZE];
+  sbdi_block_t mng[SBDI_BL_BATCH_SIZE];
+  uint32_t mng_pos[SBDI_BL_BATCH_SIZE];
+  sbdi_tag_t mng_tags[SBDI_BL_BATCH_SIZE];
+  uint32_t m = 0;
+  assert(n > 1 && n <= SBDI_BL_BATCH_SIZE);
+  memset(mng, 0, sizeof(mng));
+  // All management blocks must be in cache before anything is changed
+  for (uint32_t i = 0; i < n; ++i) {
+    assert(sbdi_blic_is_phy_dat_blk(blks[i].idx));
+    uint32_t mng_idx = sbdi_blic_phy_dat_to_phy_mng_blk(blks[i].idx);
+    if (!sbdi_bc_idx_is_valid(sbdi_bc_find_blk_idx_pos(sbdi->cache, mng_idx))) {
+      // Management Block not found ==> IllegalState.
+      return SBDI_ERR_ILLEGAL_STATE;
+    }
+  }
+  // Pre-assign the counters in the order of the blocks
+  for (uint32_t i = 0; i < n; ++i) {
+    ctr[i] = sbdi->hdr->ctr;
+    SBDI_ERR_CHK(sbdi_ctr_128b_inc(&sbdi->hdr->ctr));
+  }
+  bl_enc_job_t job;
+  memset(&job, 0, sizeof(bl_enc_job_t));
+  job.sbdi = sbdi;
+  job.blks = blks;
+  job.ctr = ctr;
+  job.tags = tags;
+  job.n = n;
+  job.njobs = sbdi_wp_get_concurrency(sbdi->wp);
+  if (job.njobs > n) {
+    job.njobs = n;
+  }
+  sbdi_wp_run(sbdi->wp, &bl_enc_job, &job, job.njobs);
+  for (uint32_t i = 0; i < job.njobs; ++i) {
+    SBDI_ERR_CHK(job.err[i]);
+  }
+  // Write the data blocks and update the management blocks in order
+  for (uint32_t i = 0; i < n; ++i) {
+    sbdi_block_t ct;
+    sbdi_block_init(&ct, blks[i].idx, &sbdi->batch_store_dat[i]);
+    SBDI_ERR_CHK(sbdi_bl_write_block(sbdi, &ct, SBDI_BLOCK_SIZE));
+    uint32_t mng_idx = sbdi_blic_phy_dat_to_phy_mng_blk(blks[i].idx);
+    uint32_t k = 0;
+    while (k < m && mng[k].idx != mng_idx) {
+      k++;
+    }
+    if (k == m) {
+      mng_pos[m] = sbdi_bc_find_blk_idx_pos(sbdi->cache, mng_idx);
+      sbdi_block_init(&mng[m], mng_idx,
+          sbdi_bc_get_db_for_cache_idx(sbdi->cache, mng_pos[m]));
+      m++;
+    }
+    uint32_t tag_idx = sbdi_blic_phy_dat_to_log(
+        blks[i].idx) % SBDI_MNGT_BLOCK_ENTRIES;
+    bl_update_mng_blk(&mng[k], tag_idx, &ctr[i], tags[i]);
+  }
+  // Write every affected management block once
+  SBDI_ERR_CHK(bl_aes_cmac_n(sbdi, mng, mng_tags, m));
+  for (uint32_t k = 0; k < m; ++k) {
+    SBDI_ERR_CHK(sbdi_bl_write_block(sbdi, &mng[k], SBDI_BLOCK_SIZE));
+    SBDI_ERR_CHK(
+        sbdi_mt_sbdi_err_conv(mt_update(sbdi->mt, mng_tags[k], sizeof(sbdi_tag_t), (sbdi_blic_phy_mng_to_mng_blk_nbr(mng[k].idx) + 1))));
+    sbdi_bc_clear_blk_dirty(sbdi->cache, mng_pos[k]);
+  }
+  return SBDI_SUCCESS;
+}
+
+//----------------------------------------------------------------------
+sbdi_error_t sbdi_bl_sync_n(void *sbdi, sbdi_block_t *blks, uint32_t n)
+{
+  SBDI_CHK_PARAM(sbdi && blks && n > 0 && n <= SBDI_BL_BATCH_SIZE);
+  sbdi_t *t_sbdi = (sbdi_t *) sbdi;
+  for (uint32_t i = 0; i < n; ++i) {
+    SBDI_CHK_PARAM(
+        blks[i].data && sbdi_block_is_valid_phy(blks[i].idx) && sbdi_blic_is_phy_dat_blk(blks[i].idx));
+  }
+  if (n == 1 || !t_sbdi->crypto->enc_n) {
+    // No batch encryption available (e.g. OCB, whose context is not
+    // reentrant) ==> sync block by block
+    for (uint32_t i = 0; i < n; ++i) {
+      SBDI_ERR_CHK(bl_encrypt_write_data(t_sbdi, &blks[i]));
+    }
+    return SBDI_SUCCESS;
+  }
+  return bl_encrypt_write_data_n(t_sbdi, blks, n);
+}
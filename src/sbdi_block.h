@@ -46,6 +46,7 @@ extern "C" {
 #include "sbdi_ctr_128b.h"
 
 sbdi_error_t sbdi_bl_sync(void *sbdi, sbdi_block_t *blk);
+sbdi_error_t sbdi_bl_sync_n(void *sbdi, sbdi_block_t *blks, uint32_t n);
 
 sbdi_error_t sbdi_bl_read_block(const sbdi_t *sbdi, sbdi_block_t *blk,
     size_t len, uint32_t *read);
@@ -53,9 +54,18 @@ sbdi_error_t sbdi_bl_read_block(const sbdi_t *sbdi, sbdi_block_t *blk,
 sbdi_error_t sbdi_bl_read_data_block(sbdi_t *sbdi, unsigned char *ptr,
     uint32_t idx, size_t off, size_t len);
 
+sbdi_error_t sbdi_bl_read_data_blocks(sbdi_t *sbdi, unsigned char *ptr,
+    uint32_t idx, uint32_t n);
+
 sbdi_error_t sbdi_bl_write_data_block(sbdi_t *sbdi, unsigned char *ptr,
     uint32_t idx, size_t off, size_t len);
 
+sbdi_error_t sbdi_bl_discard_data_block(sbdi_t *sbdi, uint32_t idx);
+
+sbdi_error_t sbdi_bl_grow(sbdi_t *sbdi, uint32_t idx);
+
+sbdi_error_t sbdi_bl_truncate_mngt_blocks(sbdi_t *sbdi, uint32_t n);
+
 sbdi_error_t sbdi_bl_verify_block_layer(sbdi_t *sbdi, mt_hash_t root);
 
 sbdi_error_t sbdi_bl_verify_header(sbdi_t *sbdi, sbdi_block_t *hdr);
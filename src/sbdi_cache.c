@@ -124,15 +124,17 @@ sbdi_bc_t *sbdi_bc_cache_create(void *sync_data, sbdi_bc_sync_fp_t sync,
   if (!sync || !sync_data || !in_scope) {
     return NULL;
   }
-  sbdi_bc_t *cache = calloc(1, sizeof(sbdi_bc_t));
-  if (!cache) {
+  sbdi_bc_t *cache = NULL;
+  // The store is aligned for direct I/O back ends
+  if (posix_memalign((void **) &cache, SBDI_BL_ALIGN, sizeof(sbdi_bc_t))) {
     return NULL;
   }
+  memset(cache, 0, sizeof(sbdi_bc_t));
   // set sync callback
   cache->cbs.sync = sync;
   cache->cbs.sync_data = sync_data;
   cache->cbs.in_scope = in_scope;
-  // Initialize lru (Superfluous under calloc)
+  // Initialize lru (Superfluous after memset)
   cache->index.lru = 0;
   // Initialize block cache index numbers
   for (uint32_t i = 0; i < SBDI_CACHE_MAX_SIZE; ++i) {
@@ -140,7 +142,7 @@ sbdi_bc_t *sbdi_bc_cache_create(void *sync_data, sbdi_bc_sync_fp_t sync,
     idx_invalidate_phy_idx(cache, i);
     // set cache index
     idx_set_cache_idx(cache, i, i);
-    // clear flags (Superfluous under calloc)
+    // clear flags (Superfluous after memset)
     cache->index.list[i].flags = 0;
   }
   return cache;
@@ -156,6 +158,13 @@ void sbdi_bc_cache_destroy(sbdi_bc_t *cache)
   free(cache);
 }
 
+//----------------------------------------------------------------------
+void sbdi_bc_set_sync_n(sbdi_bc_t *cache, sbdi_bc_sync_n_fp_t sync_n)
+{
+  assert(cache);
+  cache->cbs.sync_n = sync_n;
+}
+
 /*!
  * \brief Swaps to elements in the block cache index
  * @param idx the block cache index type instance
@@ -227,6 +236,47 @@ static inline sbdi_error_t bc_sync_blk(sbdi_bc_t *cache, uint32_t idx_pos)
   return SBDI_SUCCESS;
 }
 
+/*!
+ * \brief Synchronizes the dirty data block at the given cache index position
+ * together with up to SBDI_BL_BATCH_SIZE - 1 further dirty data blocks
+ *
+ * The further blocks are collected walking from the given position towards
+ * the most recently used end of the cache index. If the cache has no batch
+ * sync callback, only the block at the given position is synchronized.
+ *
+ * @param cache the cache data type instance which contains the data blocks
+ * to synchronize
+ * @param idx_pos the position of the first dirty data block to sync
+ * @return SBDI_SUCCESS if the synchronization operation succeeds, otherwise
+ * it forwards the error code returned by the sync callback.
+ */
+static sbdi_error_t bc_sync_data_blks(sbdi_bc_t *cache, uint32_t idx_pos)
+{
+  assert(cache && sbdi_bc_is_elem_valid_and_dirty(cache, idx_pos));
+  assert(!sbdi_bc_is_elem_mngt_blk(cache, idx_pos));
+  if (!cache->cbs.sync_n) {
+    return bc_sync_blk(cache, idx_pos);
+  }
+  sbdi_block_t to_sync[SBDI_BL_BATCH_SIZE];
+  uint32_t pos[SBDI_BL_BATCH_SIZE];
+  uint32_t n = 0;
+  uint32_t cdt = idx_pos;
+  do {
+    if (sbdi_bc_is_elem_valid_and_dirty(cache, cdt)
+        && !sbdi_bc_is_elem_mngt_blk(cache, cdt)) {
+      sbdi_block_init(&to_sync[n], idx_get_phy_idx(cache, cdt),
+          sbdi_bc_get_db_for_cache_idx(cache, cdt));
+      pos[n++] = cdt;
+    }
+    SBDI_BC_INC_IDX(cdt);
+  } while (cdt != idx_pos && n < SBDI_BL_BATCH_SIZE);
+  SBDI_ERR_CHK(cache->cbs.sync_n(cache->cbs.sync_data, to_sync, n));
+  for (uint32_t i = 0; i < n; ++i) {
+    sbdi_bc_clear_blk_dirty(cache, pos[i]);
+  }
+  return SBDI_SUCCESS;
+}
+
 /*!
  * \brief finds the most recently used element in the cache index that is
  * in-scope of the management block specified by its physical block index and
@@ -342,9 +392,10 @@ sbdi_error_t sbdi_bc_cache_blk(sbdi_bc_t *cache, sbdi_block_t *blk,
           break;
         }
       } else {
-        /* Data block ==> sync if dirty */
+        /* Data block ==> sync if dirty (together with the next dirty data
+         * blocks that are about to be evicted) */
         if (sbdi_bc_is_elem_dirty(cache, lru)) {
-          SBDI_ERR_CHK(bc_sync_blk(cache, lru));
+          SBDI_ERR_CHK(bc_sync_data_blks(cache, lru));
         }
         break;
       }
@@ -399,6 +450,24 @@ sbdi_error_t sbdi_bc_evict_blk(sbdi_bc_t *cache, uint32_t phy_idx)
   return SBDI_SUCCESS;
 }
 
+//----------------------------------------------------------------------
+sbdi_error_t sbdi_bc_evict_blks_from(sbdi_bc_t *cache, uint32_t phy_idx)
+{
+  SBDI_CHK_PARAM(cache);
+  uint32_t i = 0;
+  while (i < SBDI_CACHE_MAX_SIZE) {
+    const uint32_t phy = idx_get_phy_idx(cache, i);
+    if (sbdi_block_is_valid_phy(phy) && phy >= phy_idx) {
+      // Evicting reorders the index ==> start over
+      SBDI_ERR_CHK(sbdi_bc_evict_blk(cache, phy));
+      i = 0;
+    } else {
+      i += 1;
+    }
+  }
+  return SBDI_SUCCESS;
+}
+
 //----------------------------------------------------------------------
 sbdi_error_t sbdi_bc_sync(sbdi_bc_t *cache)
 {
@@ -411,7 +480,8 @@ sbdi_error_t sbdi_bc_sync(sbdi_bc_t *cache)
     if (sbdi_bc_is_elem_valid_and_dirty(cache, i)
         && !sbdi_bc_is_elem_mngt_blk(cache, i)) {
       // Not a management block, but dirty ==> sync in the first round
-      SBDI_ERR_CHK(bc_sync_blk(cache, i));
+      // (batched with the following dirty data blocks, if possible)
+      SBDI_ERR_CHK(bc_sync_data_blks(cache, i));
     }
   }
   // Second round: sync out all remaining dirty management blocks
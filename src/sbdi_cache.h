@@ -62,6 +62,21 @@ typedef enum sbdi_block_cache_block_type {
 
 typedef sbdi_error_t (*sbdi_bc_sync_fp_t)(void *sync_data, sbdi_block_t *blk);
 
+/*!
+ * \brief Synchronizes several independent dirty data blocks at once
+ *
+ * The result must be the same as calling the sync callback for each block
+ * in the given order.
+ *
+ * @param sync_data[in] the sync data pointer of the cache
+ * @param blks[in] the data blocks to synchronize
+ * @param n[in] the number of data blocks (at most SBDI_BL_BATCH_SIZE)
+ * @return SBDI_SUCCESS if all blocks could be synchronized; an error code
+ *         otherwise
+ */
+typedef sbdi_error_t (*sbdi_bc_sync_n_fp_t)(void *sync_data,
+    sbdi_block_t *blks, uint32_t n);
+
 /*!
  * \brief Determines if the given data block specified by blk is in scope of
  * the management block specified by mng and returns true if this is the case
@@ -90,6 +105,7 @@ typedef struct sbdi_block_cache_index {
 typedef struct sbdi_block_cache_callbacks {
   void *sync_data;
   sbdi_bc_sync_fp_t sync;
+  sbdi_bc_sync_n_fp_t sync_n;
   sbdi_bc_is_in_scope_fp_t in_scope;
 } sbdi_bc_cb_t;
 
@@ -101,7 +117,7 @@ typedef struct sbdi_block_cache {
 #endif
   sbdi_bc_cb_t cbs;
   sbdi_bc_idx_t index;
-  sbdi_bl_data_t store[SBDI_CACHE_MAX_SIZE];
+  sbdi_bl_data_t store[SBDI_CACHE_MAX_SIZE] SBDI_BL_ALIGNED;
 } sbdi_bc_t;
 
 /*!
@@ -138,6 +154,18 @@ sbdi_bc_t *sbdi_bc_cache_create(void *sync_data, sbdi_bc_sync_fp_t sync,
  */
 void sbdi_bc_cache_destroy(sbdi_bc_t *cache);
 
+/*!
+ * \brief Sets the optional batch sync callback of the given cache
+ *
+ * If set, the cache synchronizes dirty data blocks in batches of up to
+ * SBDI_BL_BATCH_SIZE blocks, both when synchronizing the whole cache and
+ * when it has to evict a dirty data block.
+ *
+ * @param cache[in] the cache to set the batch sync callback for
+ * @param sync_n[in] the batch sync callback function (can be NULL)
+ */
+void sbdi_bc_set_sync_n(sbdi_bc_t *cache, sbdi_bc_sync_n_fp_t sync_n);
+
 /*!
  * \brief Determines a cache data block element index based on the position
  * of a specific cache index element
@@ -202,6 +230,7 @@ sbdi_error_t sbdi_bc_cache_blk(sbdi_bc_t *cache, sbdi_block_t *blk,
     sbdi_bc_bt_t blk_type);
 sbdi_error_t sbdi_bc_dirty_blk(sbdi_bc_t *cache, uint32_t phy_idx);
 sbdi_error_t sbdi_bc_evict_blk(sbdi_bc_t *cache, uint32_t phy_idx);
+sbdi_error_t sbdi_bc_evict_blks_from(sbdi_bc_t *cache, uint32_t phy_idx);
 sbdi_error_t sbdi_bc_sync(sbdi_bc_t *cache);
 
 /*!
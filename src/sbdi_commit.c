@@ -0,0 +1,186 @@
+/* Copyright (c) IAIK, Graz University of Technology, 2015.
+ * All rights reserved.
+ * Contact: http://opensource.iaik.tugraz.at
+ * 
+ * This file is part of the Secure Block Device Library.
+ * 
+ * Commercial License Usage
+ * Licensees holding valid commercial licenses may use this file in
+ * accordance with the commercial license agreement provided with the
+ * Software or, alternatively, in accordance with the terms contained in
+ * a written agreement between you and SIC. For further information
+ * contact us at http://opensource.iaik.tugraz.at.
+ * 
+ * Alternatively, this file may be used under the terms of the GNU General
+ * Public License as published by the Free Software Foundation version 2.
+ * 
+ * The Secure Block Device Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with the Secure Block Device Library. If not, see <http://www.gnu.org/licenses/>.
+ */
+///
+/// \file
+/// \brief Implements the Secure Block Device Library's group commit.
+///
+#include "sbdi_commit.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+struct sbdi_commit {
+  pthread_mutex_t dev;       //!< the device lock
+  pthread_mutex_t lock;      //!< protects all of the following fields
+  pthread_cond_t done;       //!< signaled if a flush finished
+  sbdi_pio_t *pio;           //!< the back end to flush
+  uint64_t enqueued;         //!< the ticket of the last enqueued sync request
+  uint64_t durable;          //!< all tickets up to this one are durable
+  uint64_t failed;           //!< all tickets up to this one failed, even if durable is beyond
+  int flushing;              //!< set while a flush is in flight
+  sbdi_cm_stats_t stats;     //!< the sync and flush statistics
+};
+
+/*!
+ * \brief Determines the current time of a monotonic clock in nanoseconds
+ *
+ * @return the current time in nanoseconds
+ */
+static uint64_t cm_now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * UINT64_C(1000000000) + ts.tv_nsec;
+}
+
+//----------------------------------------------------------------------
+sbdi_cm_t *sbdi_cm_create(sbdi_pio_t *pio)
+{
+  sbdi_cm_t *cm = calloc(1, sizeof(sbdi_cm_t));
+  if (!cm) {
+    return NULL;
+  }
+  if (pthread_mutex_init(&cm->dev, NULL)) {
+    free(cm);
+    return NULL;
+  }
+  if (pthread_mutex_init(&cm->lock, NULL)) {
+    pthread_mutex_destroy(&cm->dev);
+    free(cm);
+    return NULL;
+  }
+  if (pthread_cond_init(&cm->done, NULL)) {
+    pthread_mutex_destroy(&cm->lock);
+    pthread_mutex_destroy(&cm->dev);
+    free(cm);
+    return NULL;
+  }
+  cm->pio = pio;
+  return cm;
+}
+
+//----------------------------------------------------------------------
+void sbdi_cm_destroy(sbdi_cm_t *cm)
+{
+  if (!cm) {
+    return;
+  }
+  pthread_cond_destroy(&cm->done);
+  pthread_mutex_destroy(&cm->lock);
+  pthread_mutex_destroy(&cm->dev);
+  memset(cm, 0, sizeof(sbdi_cm_t));
+  free(cm);
+}
+
+//----------------------------------------------------------------------
+void sbdi_cm_lock(sbdi_cm_t *cm)
+{
+  pthread_mutex_lock(&cm->dev);
+}
+
+//----------------------------------------------------------------------
+void sbdi_cm_unlock(sbdi_cm_t *cm)
+{
+  pthread_mutex_unlock(&cm->dev);
+}
+
+//----------------------------------------------------------------------
+uint64_t sbdi_cm_enqueue(sbdi_cm_t *cm)
+{
+  pthread_mutex_lock(&cm->lock);
+  uint64_t ticket = ++cm->enqueued;
+  pthread_mutex_unlock(&cm->lock);
+  return ticket;
+}
+
+//----------------------------------------------------------------------
+sbdi_error_t sbdi_cm_flush(sbdi_cm_t *cm, uint64_t ticket)
+{
+  sbdi_error_t r = SBDI_SUCCESS;
+  if (!cm->pio->flush) {
+    pthread_mutex_lock(&cm->lock);
+    cm->stats.syncs += 1;
+    pthread_mutex_unlock(&cm->lock);
+    return r;
+  }
+  uint64_t start = cm_now();
+  pthread_mutex_lock(&cm->lock);
+  cm->stats.syncs += 1;
+  for (;;) {
+    // A failure sticks: the back end might have dropped the data of a failed
+    // flush, so a later successful flush does not make it durable
+    if (cm->failed >= ticket) {
+      r = SBDI_ERR_IO;
+      break;
+    } else if (cm->durable >= ticket) {
+      break;
+    }
+    if (cm->flushing) {
+      pthread_cond_wait(&cm->done, &cm->lock);
+      continue;
+    }
+    // Become the leader and flush on behalf of everything enqueued so far
+    uint64_t target = cm->enqueued;
+    uint64_t batch = target - cm->durable;
+    cm->flushing = 1;
+    pthread_mutex_unlock(&cm->lock);
+    uint64_t f_start = cm_now();
+    int fr = cm->pio->flush(cm->pio->iod);
+    uint64_t f_time = cm_now() - f_start;
+    pthread_mutex_lock(&cm->lock);
+    cm->flushing = 0;
+    if (fr == 0) {
+      cm->durable = target;
+    } else {
+      cm->failed = target;
+    }
+    cm->stats.flushes += 1;
+    cm->stats.flush_time += f_time;
+    if (f_time > cm->stats.max_flush_time) {
+      cm->stats.max_flush_time = f_time;
+    }
+    if (batch > cm->stats.max_batch) {
+      cm->stats.max_batch = batch;
+    }
+    pthread_cond_broadcast(&cm->done);
+  }
+  uint64_t w_time = cm_now() - start;
+  cm->stats.wait_time += w_time;
+  if (w_time > cm->stats.max_wait_time) {
+    cm->stats.max_wait_time = w_time;
+  }
+  pthread_mutex_unlock(&cm->lock);
+  return r;
+}
+
+//----------------------------------------------------------------------
+void sbdi_cm_get_stats(sbdi_cm_t *cm, sbdi_cm_stats_t *stats)
+{
+  pthread_mutex_lock(&cm->lock);
+  *stats = cm->stats;
+  pthread_mutex_unlock(&cm->lock);
+}
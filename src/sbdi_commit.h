@@ -0,0 +1,143 @@
+/* Copyright (c) IAIK, Graz University of Technology, 2015.
+ * All rights reserved.
+ * Contact: http://opensource.iaik.tugraz.at
+ * 
+ * This file is part of the Secure Block Device Library.
+ * 
+ * Commercial License Usage
+ * Licensees holding valid commercial licenses may use this file in
+ * accordance with the commercial license agreement provided with the
+ * Software or, alternatively, in accordance with the terms contained in
+ * a written agreement between you and SIC. For further information
+ * contact us at http://opensource.iaik.tugraz.at.
+ * 
+ * Alternatively, this file may be used under the terms of the GNU General
+ * Public License as published by the Free Software Foundation version 2.
+ * 
+ * The Secure Block Device Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with the Secure Block Device Library. If not, see <http://www.gnu.org/licenses/>.
+ */
+///
+/// \file
+/// \brief Specifies the Secure Block Device Library's group commit.
+///
+/// A sync consists of two phases. First the dirty state of the secure block
+/// device is written to the back end and committed (see bl_commit) while
+/// holding the device lock. Then the back end is asked to make the written
+/// data durable. The second phase runs without holding the device lock, and
+/// sync requests that arrive while a flush is in flight join the next flush. A single back end flush (e.g. one
+/// fdatasync) thus covers all sync requests that were written before it
+/// started.
+///
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef SBDI_COMMIT_H_
+#define SBDI_COMMIT_H_
+
+#include "sbdi_config.h"
+#include "sbdi_pio.h"
+
+#include <stdint.h>
+
+/*!
+ * \brief sync and back end flush statistics of a secure block device
+ *
+ * All times are in nanoseconds. The average number of sync requests per
+ * flush is syncs / flushes.
+ */
+typedef struct sbdi_commit_stats {
+  uint64_t syncs;        //!< the number of sync requests that asked for durability
+  uint64_t flushes;      //!< the number of back end flushes
+  uint64_t max_batch;    //!< the maximum number of sync requests covered by one flush
+  uint64_t flush_time;   //!< the total time spent in back end flushes
+  uint64_t max_flush_time; //!< the longest back end flush
+  uint64_t wait_time;    //!< the total time sync requests waited for durability
+  uint64_t max_wait_time;  //!< the longest time a sync request waited for durability
+} sbdi_cm_stats_t;
+
+typedef struct sbdi_commit sbdi_cm_t;
+
+/*!
+ * \brief Creates a new group commit for the given back end
+ *
+ * Use sbdi_cm_destroy to free the group commit.
+ *
+ * @param pio[in] the back end to flush; if its flush function is NULL
+ * sbdi_cm_flush returns immediately
+ * @return a pointer to the new group commit if successful; NULL otherwise
+ */
+sbdi_cm_t *sbdi_cm_create(sbdi_pio_t *pio);
+
+/*!
+ * \brief Frees the given group commit
+ *
+ * No thread may use the group commit anymore.
+ *
+ * @param cm[in] the group commit to destroy (can be NULL)
+ */
+void sbdi_cm_destroy(sbdi_cm_t *cm);
+
+/*!
+ * \brief Acquires the device lock that serializes all accesses to the
+ * secure block device state
+ *
+ * @param cm[in] the group commit of the secure block device
+ */
+void sbdi_cm_lock(sbdi_cm_t *cm);
+
+/*!
+ * \brief Releases the device lock
+ *
+ * @param cm[in] the group commit of the secure block device
+ */
+void sbdi_cm_unlock(sbdi_cm_t *cm);
+
+/*!
+ * \brief Registers a sync request whose data has been written to the back
+ * end
+ *
+ * Must be called with the device lock held, after all data of the sync
+ * request has been written.
+ *
+ * @param cm[in] the group commit of the secure block device
+ * @return the ticket to pass to sbdi_cm_flush
+ */
+uint64_t sbdi_cm_enqueue(sbdi_cm_t *cm);
+
+/*!
+ * \brief Waits until the data of the sync request with the given ticket is
+ * durable
+ *
+ * Must be called without holding the device lock. If no flush is in flight
+ * the calling thread flushes the back end on behalf of all sync requests
+ * enqueued so far. Otherwise it waits for the in-flight flush and, if that
+ * flush does not cover its ticket, joins the next one.
+ *
+ * @param cm[in] the group commit of the secure block device
+ * @param ticket[in] the ticket returned by sbdi_cm_enqueue
+ * @return SBDI_SUCCESS if the data is durable;
+ *         SBDI_ERR_IO if a back end flush covering the ticket failed, even
+ *         if a later flush succeeded.
+ */
+sbdi_error_t sbdi_cm_flush(sbdi_cm_t *cm, uint64_t ticket);
+
+/*!
+ * \brief Retrieves the sync and flush statistics of the given group commit
+ *
+ * @param cm[in] the group commit of the secure block device
+ * @param stats[out] the statistics
+ */
+void sbdi_cm_get_stats(sbdi_cm_t *cm, sbdi_cm_stats_t *stats);
+
+#endif /* SBDI_COMMIT_H_ */
+
+#ifdef __cplusplus
+}
+#endif
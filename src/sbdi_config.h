@@ -59,6 +59,11 @@ typedef uint8_t sbdi_ctr_pkd_t[SBDI_BLOCK_CTR_SIZE];
  */
 typedef uint8_t sbdi_bl_data_t[SBDI_BLOCK_SIZE];
 
+/*!
+ * \brief aligns an array of block data to SBDI_BL_ALIGN bytes
+ */
+#define SBDI_BL_ALIGNED __attribute__((aligned(SBDI_BL_ALIGN)))
+
 typedef struct secure_block_device_interface sbdi_t;
 
 /*!
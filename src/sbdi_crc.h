@@ -0,0 +1,57 @@
+/* Copyright (c) IAIK, Graz University of Technology, 2015.
+ * All rights reserved.
+ * Contact: http://opensource.iaik.tugraz.at
+ * 
+ * This file is part of the Secure Block Device Library.
+ * 
+ * Commercial License Usage
+ * Licensees holding valid commercial licenses may use this file in
+ * accordance with the commercial license agreement provided with the
+ * Software or, alternatively, in accordance with the terms contained in
+ * a written agreement between you and SIC. For further information
+ * contact us at http://opensource.iaik.tugraz.at.
+ * 
+ * Alternatively, this file may be used under the terms of the GNU General
+ * Public License as published by the Free Software Foundation version 2.
+ * 
+ * The Secure Block Device Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with the Secure Block Device Library. If not, see <http://www.gnu.org/licenses/>.
+ */
+///
+/// \file
+/// \brief Specifies the CRC-32 used by the Secure Block Device Library's
+/// logging back ends to detect torn records.
+///
+/// The checksum only detects incomplete writes; the integrity of the secure
+/// block device is protected by the cryptographic layer.
+///
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef SBDI_CRC_H_
+#define SBDI_CRC_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*!
+ * \brief Computes the CRC-32 (IEEE 802.3) of the given data
+ *
+ * @param crc[in] the CRC of the preceding data (0 to start)
+ * @param d[in] the data
+ * @param len[in] the length of the data in bytes
+ * @return the CRC over the preceding data and the given data
+ */
+uint32_t sbdi_crc32(uint32_t crc, const uint8_t *d, size_t len);
+
+#endif /* SBDI_CRC_H_ */
+
+#ifdef __cplusplus
+}
+#endif
@@ -58,13 +58,134 @@ typedef sbdi_error_t (*sbdi_decrypt)(void *ctx, const uint8_t *ct,
 typedef sbdi_error_t (*sbdi_mac)(void *ctx, const unsigned char *msg,
     const int mlen, unsigned char *C, const unsigned char *ad, const int ad_len);
 
+/*!
+ * \brief Encrypts n independent blocks at once
+ *
+ * Batched variant of sbdi_encrypt. Block i is encrypted from pt[i] to ct[i]
+ * under counter ctr[i] and block number blk_nbr[i]; its tag is written to
+ * tag[i]. The result must be identical to n calls of the corresponding
+ * sbdi_encrypt function.
+ */
+typedef sbdi_error_t (*sbdi_encrypt_n)(void *ctx, const int n,
+    const uint8_t *const *pt, const int pt_len, const sbdi_ctr_128b_t *ctr,
+    const uint32_t *blk_nbr, uint8_t *const *ct, uint8_t *const *tag);
+
+/*!
+ * \brief Decrypts and verifies n independent blocks at once
+ *
+ * Batched variant of sbdi_decrypt. Block i is decrypted from ct[i] to pt[i]
+ * under the packed counter ctr[i], block number blk_nbr[i] and tag tag[i].
+ * If any of the blocks fails verification, the whole batch fails.
+ */
+typedef sbdi_error_t (*sbdi_decrypt_n)(void *ctx, const int n,
+    const uint8_t *const *ct, const int ct_len, const uint8_t *const *ctr,
+    const uint32_t *blk_nbr, uint8_t *const *pt, const uint8_t *const *tag);
+
+/*!
+ * \brief Computes the MACs of n independent messages of the same length at
+ * once
+ *
+ * Batched variant of sbdi_mac. The MAC of msg[i] and ad[i] is written to
+ * C[i].
+ */
+typedef sbdi_error_t (*sbdi_mac_n)(void *ctx, const int n,
+    const unsigned char *const *msg, const int mlen, unsigned char *const *C,
+    const unsigned char *const *ad, const int ad_len);
+
+/*!
+ * \brief the cryptographic abstraction layer
+ *
+ * The batch operations enc_n, dec_n and mac_n are optional and may be NULL.
+ * Use the sbdi_crypto_*_n helpers, which fall back to the single block
+ * operations if a layer does not provide a batch operation. A layer must only
+ * provide a batch operation if it does not modify ctx, because the block
+ * layer calls batch operations concurrently from its worker threads.
+ */
 typedef struct sbdi_crypto {
   void *ctx;
   sbdi_encrypt enc;
   sbdi_decrypt dec;
   sbdi_mac mac;
+  sbdi_encrypt_n enc_n;
+  sbdi_decrypt_n dec_n;
+  sbdi_mac_n mac_n;
 } sbdi_crypto_t;
 
+/*!
+ * \brief Encrypts n independent blocks using the batch encryption of the
+ * given cryptographic abstraction layer, if it has one, or a loop over its
+ * single block encryption otherwise
+ *
+ * @see sbdi_encrypt_n
+ * @return SBDI_SUCCESS if all blocks could be encrypted; the error of the
+ * first failing encryption otherwise
+ */
+static inline sbdi_error_t sbdi_crypto_enc_n(const sbdi_crypto_t *crypto,
+    const int n, const uint8_t *const *pt, const int pt_len,
+    const sbdi_ctr_128b_t *ctr, const uint32_t *blk_nbr, uint8_t *const *ct,
+    uint8_t *const *tag)
+{
+  assert(crypto);
+  if (crypto->enc_n) {
+    return crypto->enc_n(crypto->ctx, n, pt, pt_len, ctr, blk_nbr, ct, tag);
+  }
+  for (int i = 0; i < n; ++i) {
+    SBDI_ERR_CHK(
+        crypto->enc(crypto->ctx, pt[i], pt_len, &ctr[i], blk_nbr[i], ct[i],
+            tag[i]));
+  }
+  return SBDI_SUCCESS;
+}
+
+/*!
+ * \brief Decrypts n independent blocks using the batch decryption of the
+ * given cryptographic abstraction layer, if it has one, or a loop over its
+ * single block decryption otherwise
+ *
+ * @see sbdi_decrypt_n
+ * @return SBDI_SUCCESS if all blocks could be decrypted and verified; the
+ * error of the first failing decryption otherwise
+ */
+static inline sbdi_error_t sbdi_crypto_dec_n(const sbdi_crypto_t *crypto,
+    const int n, const uint8_t *const *ct, const int ct_len,
+    const uint8_t *const *ctr, const uint32_t *blk_nbr, uint8_t *const *pt,
+    const uint8_t *const *tag)
+{
+  assert(crypto);
+  if (crypto->dec_n) {
+    return crypto->dec_n(crypto->ctx, n, ct, ct_len, ctr, blk_nbr, pt, tag);
+  }
+  for (int i = 0; i < n; ++i) {
+    SBDI_ERR_CHK(
+        crypto->dec(crypto->ctx, ct[i], ct_len, ctr[i], blk_nbr[i], pt[i],
+            tag[i]));
+  }
+  return SBDI_SUCCESS;
+}
+
+/*!
+ * \brief Computes n independent MACs using the batch MAC of the given
+ * cryptographic abstraction layer, if it has one, or a loop over its single
+ * MAC operation otherwise
+ *
+ * @see sbdi_mac_n
+ * @return SBDI_SUCCESS if all MACs could be computed; the error of the
+ * first failing MAC operation otherwise
+ */
+static inline sbdi_error_t sbdi_crypto_mac_n(const sbdi_crypto_t *crypto,
+    const int n, const unsigned char *const *msg, const int mlen,
+    unsigned char *const *C, const unsigned char *const *ad, const int ad_len)
+{
+  assert(crypto);
+  if (crypto->mac_n) {
+    return crypto->mac_n(crypto->ctx, n, msg, mlen, C, ad, ad_len);
+  }
+  for (int i = 0; i < n; ++i) {
+    SBDI_ERR_CHK(crypto->mac(crypto->ctx, msg[i], mlen, C[i], ad[i], ad_len));
+  }
+  return SBDI_SUCCESS;
+}
+
 #endif /* SBDI_CRYPTO_H_ */
 
 #ifdef __cplusplus
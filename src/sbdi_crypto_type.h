@@ -47,6 +47,11 @@ typedef enum sbdi_crypto_type {
   SBDI_CRYPTO_SIV = SBDI_CRYPTO_TYPE_SIV, /*!< Crypto operations implemented using the SIV authenticated encryption mode of operation with AES *///!< SBDI_CRYPTO_SIV
   SBDI_CRYPTO_OCB = SBDI_CRYPTO_TYPE_OCB, /*!< Crypto operations implemented using the OCB authenticated encryption mode of operation with AES */ //!< SBDI_CRYPTO_OCB
   SBDI_CRYPTO_HMAC = SBDI_CRYPTO_TYPE_HMAC, /*!< Cryptographic abstraction layer that uses CBC and HMAC for its cryptographic operations */
+  SBDI_CRYPTO_GCM = SBDI_CRYPTO_TYPE_GCM, /*!< Crypto operations implemented using the GCM authenticated encryption mode of operation with AES */
+  SBDI_CRYPTO_GCM_SIV = SBDI_CRYPTO_TYPE_GCM_SIV, /*!< Crypto operations implemented using the nonce misuse resistant AES-GCM-SIV authenticated encryption mode */
+  SBDI_CRYPTO_CHACHA = SBDI_CRYPTO_TYPE_CHACHA, /*!< Crypto operations implemented using the ChaCha20-Poly1305 authenticated encryption scheme */
+  SBDI_CRYPTO_AEGIS = SBDI_CRYPTO_TYPE_AEGIS, /*!< Crypto operations implemented using the AEGIS-128L authenticated encryption scheme */
+  SBDI_CRYPTO_GMAC = SBDI_CRYPTO_TYPE_GMAC, /*!< Crypto operations that authenticate data blocks with AES-GMAC, but do not encrypt them */
 } sbdi_crypto_type_t;
 
 #endif /* SBDI_CRYPTO_TYPE_H_ */
@@ -88,6 +88,21 @@ sbdi_error_t sbdi_ctr_128b_dec(sbdi_ctr_128b_t *ctr)
   return SBDI_SUCCESS;
 }
 //----------------------------------------------------------------------
+sbdi_error_t sbdi_ctr_128b_add(sbdi_ctr_128b_t *ctr, uint64_t val)
+{
+  if (!ctr) {
+    return SBDI_ERR_ILLEGAL_PARAM;
+  }
+  if (ctr->lo > UINT64_MAX - val) {
+    if (ctr->hi == UINT64_MAX) {
+      return SBDI_ERR_ILLEGAL_STATE;
+    }
+    ctr->hi += 1;
+  }
+  ctr->lo += val;
+  return SBDI_SUCCESS;
+}
+//----------------------------------------------------------------------
 sbdi_error_t sbdi_ctr_128b_cmp(const sbdi_ctr_128b_t *ctr1,
     const sbdi_ctr_128b_t *ctr2, int *res)
 {
@@ -47,6 +47,7 @@ sbdi_error_t sbdi_ctr_128b_init(sbdi_ctr_128b_t *ctr, uint64_t hi, uint64_t lo);
 sbdi_error_t sbdi_ctr_128b_reset(sbdi_ctr_128b_t *ctr);
 sbdi_error_t sbdi_ctr_128b_inc(sbdi_ctr_128b_t *ctr);
 sbdi_error_t sbdi_ctr_128b_dec(sbdi_ctr_128b_t *ctr);
+sbdi_error_t sbdi_ctr_128b_add(sbdi_ctr_128b_t *ctr, uint64_t val);
 sbdi_error_t sbdi_ctr_128b_cmp(const sbdi_ctr_128b_t *ctr1, const sbdi_ctr_128b_t *ctr2,
     int *res);
 void sbdi_ctr_128b_print(sbdi_ctr_128b_t *ctr);
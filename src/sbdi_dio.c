@@ -0,0 +1,250 @@
+/* Copyright (c) IAIK, Graz University of Technology, 2015.
+ * All rights reserved.
+ * Contact: http://opensource.iaik.tugraz.at
+ * 
+ * This file is part of the Secure Block Device Library.
+ * 
+ * Commercial License Usage
+ * Licensees holding valid commercial licenses may use this file in
+ * accordance with the commercial license agreement provided with the
+ * Software or, alternatively, in accordance with the terms contained in
+ * a written agreement between you and SIC. For further information
+ * contact us at http://opensource.iaik.tugraz.at.
+ * 
+ * Alternatively, this file may be used under the terms of the GNU General
+ * Public License as published by the Free Software Foundation version 2.
+ * 
+ * The Secure Block Device Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with the Secure Block Device Library. If not, see <http://www.gnu.org/licenses/>.
+ */
+///
+/// \file
+/// \brief Implements the Secure Block Device Library's direct I/O back end.
+///
+/// The back end keeps track of the end of the file itself. Read-modify-write
+/// cycles that extend the file write whole sectors and then cut the file back
+/// to the end of the written data, so that reads of blocks that have never
+/// been written still come up short.
+///
+#define _GNU_SOURCE 1
+#include "sbdi_dio.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+typedef struct sbdi_dio {
+  sbdi_pio_t pio;            //!< the direct I/O pio handed out to the user
+  int fd;                    //!< the file descriptor of the backing file
+  int flags;                 //!< the file status flags before creation
+  int direct;                //!< set if O_DIRECT is in effect
+  pthread_mutex_t lock;      //!< serializes writes and protects the following fields
+  uint8_t *bounce;           //!< the aligned bounce buffer
+  size_t b_len;              //!< the size of the bounce buffer
+  uint64_t size;             //!< the end of the file
+} sbdi_dio_t;
+
+static int dio_is_aligned(const void *buf, size_t n, uint64_t off)
+{
+  return (uintptr_t) buf % SBDI_BL_ALIGN == 0 && n % SBDI_BL_ALIGN == 0
+      && off % SBDI_BL_ALIGN == 0;
+}
+
+static ssize_t dio_pwrite_full(int fd, const uint8_t *buf, size_t n,
+    uint64_t off)
+{
+  size_t done = 0;
+  while (done < n) {
+    ssize_t r = pwrite(fd, buf + done, n - done, off + done);
+    if (r == -1) {
+      return -1;
+    }
+    done += r;
+  }
+  return done;
+}
+
+/*!
+ * \brief Gets a bounce buffer of at least the given size
+ *
+ * Must be called with the lock held.
+ *
+ * @param d[in] the direct I/O back end
+ * @param len[in] the required size of the bounce buffer
+ * @return a pointer to the bounce buffer; NULL if it cannot be allocated
+ */
+static uint8_t *dio_bounce(sbdi_dio_t *d, size_t len)
+{
+  if (len > d->b_len) {
+    void *p = NULL;
+    if (posix_memalign(&p, SBDI_BL_ALIGN, len)) {
+      return NULL;
+    }
+    free(d->bounce);
+    d->bounce = p;
+    d->b_len = len;
+  }
+  return d->bounce;
+}
+
+//----------------------------------------------------------------------
+static ssize_t dio_pread_i(void *iod, void *buf, size_t nbyte, off_t offset)
+{
+  sbdi_dio_t *d = iod;
+  if (offset < 0) {
+    errno = EINVAL;
+    return -1;
+  } else if (dio_is_aligned(buf, nbyte, offset)) {
+    return pread(d->fd, buf, nbyte, offset);
+  }
+  const uint64_t a0 = offset - offset % SBDI_BL_ALIGN;
+  const uint64_t a1 = ((offset + nbyte + SBDI_BL_ALIGN - 1) / SBDI_BL_ALIGN)
+      * SBDI_BL_ALIGN;
+  const uint64_t lead = offset - a0;
+  pthread_mutex_lock(&d->lock);
+  uint8_t *b = dio_bounce(d, a1 - a0);
+  if (!b) {
+    pthread_mutex_unlock(&d->lock);
+    errno = ENOMEM;
+    return -1;
+  }
+  // A short read means the end of the file
+  ssize_t r = pread(d->fd, b, a1 - a0, a0);
+  if (r != -1) {
+    r = ((uint64_t) r > lead) ? r - lead : 0;
+    r = ((size_t) r > nbyte) ? nbyte : r;
+    memcpy(buf, b + lead, r);
+  }
+  pthread_mutex_unlock(&d->lock);
+  return r;
+}
+
+/*!
+ * \brief Writes data that is not aligned by reading, modifying and writing
+ * back the covering sectors
+ *
+ * Must be called with the lock held.
+ *
+ * @param d[in] the direct I/O back end
+ * @param buf[in] the data to write
+ * @param nbyte[in] the number of bytes to write
+ * @param offset[in] the file offset to write to
+ * @return the number of bytes written if successful; -1 otherwise
+ */
+static ssize_t dio_pwrite_rmw(sbdi_dio_t *d, const void *buf, size_t nbyte,
+    uint64_t offset)
+{
+  const uint64_t a0 = offset - offset % SBDI_BL_ALIGN;
+  const uint64_t a1 = ((offset + nbyte + SBDI_BL_ALIGN - 1) / SBDI_BL_ALIGN)
+      * SBDI_BL_ALIGN;
+  uint8_t *b = dio_bounce(d, a1 - a0);
+  if (!b) {
+    errno = ENOMEM;
+    return -1;
+  }
+  // Sectors beyond the end of the file need not be read
+  ssize_t r = (a0 < d->size) ? pread(d->fd, b, a1 - a0, a0) : 0;
+  if (r == -1) {
+    return -1;
+  }
+  memset(b + r, 0, (a1 - a0) - r);
+  memcpy(b + (offset - a0), buf, nbyte);
+  if (dio_pwrite_full(d->fd, b, a1 - a0, a0) == -1) {
+    return -1;
+  }
+  const uint64_t end = (offset + nbyte > d->size) ? offset + nbyte : d->size;
+  if (a1 > end && ftruncate(d->fd, end)) {
+    return -1;
+  }
+  return nbyte;
+}
+
+//----------------------------------------------------------------------
+static ssize_t dio_pwrite_i(void *iod, const void *buf, size_t nbyte,
+    off_t offset)
+{
+  sbdi_dio_t *d = iod;
+  if (offset < 0) {
+    errno = EINVAL;
+    return -1;
+  }
+  pthread_mutex_lock(&d->lock);
+  ssize_t r = dio_is_aligned(buf, nbyte, offset) ?
+      dio_pwrite_full(d->fd, buf, nbyte, offset) :
+      dio_pwrite_rmw(d, buf, nbyte, offset);
+  if (r > 0 && (uint64_t) offset + r > d->size) {
+    d->size = offset + r;
+  }
+  pthread_mutex_unlock(&d->lock);
+  return r;
+}
+
+//----------------------------------------------------------------------
+static int dio_flush_i(void *iod)
+{
+  sbdi_dio_t *d = iod;
+  // Direct I/O bypasses the page cache, but not the device's write cache
+  return fdatasync(d->fd);
+}
+
+//----------------------------------------------------------------------
+sbdi_pio_t *sbdi_dio_create(int fd)
+{
+  struct stat s;
+  if (fd < 0 || fstat(fd, &s)) {
+    return NULL;
+  }
+  int flags = fcntl(fd, F_GETFL);
+  if (flags == -1) {
+    return NULL;
+  }
+  sbdi_dio_t *d = calloc(1, sizeof(sbdi_dio_t));
+  if (!d) {
+    return NULL;
+  }
+  if (pthread_mutex_init(&d->lock, NULL)) {
+    free(d);
+    return NULL;
+  }
+  d->fd = fd;
+  d->flags = flags;
+  d->size = s.st_size;
+  // File systems without direct I/O support refuse the flag
+  d->direct = (fcntl(fd, F_SETFL, flags | O_DIRECT) == 0);
+  d->pio.iod = d;
+  d->pio.pread = &dio_pread_i;
+  d->pio.pwrite = &dio_pwrite_i;
+  d->pio.flush = &dio_flush_i;
+  d->pio.genseed = &sbdi_pio_generate_seed;
+  return &d->pio;
+}
+
+//----------------------------------------------------------------------
+int sbdi_dio_is_direct(const sbdi_pio_t *pio)
+{
+  return pio && ((const sbdi_dio_t *) pio->iod)->direct;
+}
+
+//----------------------------------------------------------------------
+void sbdi_dio_delete(sbdi_pio_t *pio)
+{
+  if (!pio) {
+    return;
+  }
+  sbdi_dio_t *d = pio->iod;
+  fcntl(d->fd, F_SETFL, d->flags);
+  pthread_mutex_destroy(&d->lock);
+  free(d->bounce);
+  memset(d, 0, sizeof(sbdi_dio_t));
+  free(d);
+}
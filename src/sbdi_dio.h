@@ -0,0 +1,86 @@
+/* Copyright (c) IAIK, Graz University of Technology, 2015.
+ * All rights reserved.
+ * Contact: http://opensource.iaik.tugraz.at
+ * 
+ * This file is part of the Secure Block Device Library.
+ * 
+ * Commercial License Usage
+ * Licensees holding valid commercial licenses may use this file in
+ * accordance with the commercial license agreement provided with the
+ * Software or, alternatively, in accordance with the terms contained in
+ * a written agreement between you and SIC. For further information
+ * contact us at http://opensource.iaik.tugraz.at.
+ * 
+ * Alternatively, this file may be used under the terms of the GNU General
+ * Public License as published by the Free Software Foundation version 2.
+ * 
+ * The Secure Block Device Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with the Secure Block Device Library. If not, see <http://www.gnu.org/licenses/>.
+ */
+///
+/// \file
+/// \brief Specifies the Secure Block Device Library's direct I/O back end.
+///
+/// The direct I/O back end opens the backing file for O_DIRECT access, so
+/// ciphertext is not buffered a second time in the kernel's page cache next
+/// to the block cache of the secure block device. Direct I/O requires the
+/// buffer, the file offset and the length of every transfer to be aligned to
+/// the sector size of the storage. The back end uses SBDI_BL_ALIGN, which is
+/// a multiple of all common sector sizes, as alignment.
+///
+/// Aligned transfers go straight to the caller's buffer; the block buffers of
+/// the secure block device are aligned accordingly. Transfers that are not
+/// aligned, e.g. a single block that is smaller than a sector, go through an
+/// aligned bounce buffer. Writes then read, modify and write back the
+/// covering sectors.
+///
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef SBDI_DIO_H_
+#define SBDI_DIO_H_
+
+#include "sbdi_config.h"
+#include "sbdi_pio.h"
+
+/*!
+ * \brief Creates a direct I/O block device abstraction layer on top of the
+ * given file
+ *
+ * This function enables O_DIRECT on the given file descriptor. If the file
+ * system does not support direct I/O the pio falls back to buffered I/O with
+ * the same semantics. Use sbdi_dio_delete to free the pio; the file
+ * descriptor remains owned by the caller.
+ *
+ * @param fd[in] the file descriptor of the backing file, opened for reading
+ * and writing
+ * @return a pointer to the direct I/O pio if successful; NULL otherwise
+ */
+sbdi_pio_t *sbdi_dio_create(int fd);
+
+/*!
+ * \brief Checks if the given direct I/O pio bypasses the page cache
+ *
+ * @param pio[in] the direct I/O pio
+ * @return 1 if O_DIRECT is in effect; 0 if the pio fell back to buffered I/O
+ */
+int sbdi_dio_is_direct(const sbdi_pio_t *pio);
+
+/*!
+ * \brief Frees the given direct I/O pio
+ *
+ * @param pio[in] the direct I/O pio to delete (can be NULL)
+ */
+void sbdi_dio_delete(sbdi_pio_t *pio);
+
+#endif /* SBDI_DIO_H_ */
+
+#ifdef __cplusplus
+}
+#endif
@@ -30,6 +30,11 @@
 #include "sbdi_nocrypto.h"
 #include "sbdi_ocb.h"
 #include "sbdi_hmac.h"
+#include "sbdi_gcm.h"
+#include "sbdi_gcm_siv.h"
+#include "sbdi_chacha.h"
+#include "sbdi_aegis.h"
+#include "sbdi_gmac.h"
 #include "sbdi_hdr.h"
 #include "sbdi_buffer.h"
 
@@ -56,7 +61,12 @@ void sbdi_hdr_v1_derive_key(siv_ctx *master, sbdi_hdr_v1_sym_key_t key,
 static inline int hdr_is_key_type_valid(const sbdi_hdr_v1_key_type_t type)
 {
   return (type == SBDI_HDR_KEY_TYPE_NONE) || (type == SBDI_HDR_KEY_TYPE_OCB)
-    || (type == SBDI_HDR_KEY_TYPE_SIV) || (type == SBDI_HDR_KEY_TYPE_HMAC);
+    || (type == SBDI_HDR_KEY_TYPE_SIV) || (type == SBDI_HDR_KEY_TYPE_HMAC)
+    || (type == SBDI_HDR_KEY_TYPE_GCM)
+    || (type == SBDI_HDR_KEY_TYPE_GCM_SIV)
+    || (type == SBDI_HDR_KEY_TYPE_CHACHA)
+    || (type == SBDI_HDR_KEY_TYPE_AEGIS)
+    || (type == SBDI_HDR_KEY_TYPE_GMAC);
 }
 
 //----------------------------------------------------------------------
@@ -80,6 +90,7 @@ sbdi_error_t sbdi_hdr_v1_create(sbdi_hdr_v1_t **hdr,
 // Tag will be created once the header is written
 // Copy previously created key into header
   memcpy(h->key, key, sizeof(sbdi_hdr_v1_sym_key_t));
+  h->dirty = 1;
   *hdr = h;
   return SBDI_SUCCESS;
 }
@@ -173,6 +184,46 @@ sbdi_error_t sbdi_hdr_v1_read(sbdi_t *sbdi, siv_ctx *master)
       return r;
     }
     break;
+  case SBDI_HDR_KEY_TYPE_GCM:
+    r = sbdi_gcm_create(&sbdi->crypto, h->key);
+    if (r != SBDI_SUCCESS) {
+      // Cleanup of header SIV must be handled next layer up
+      free(h);
+      return r;
+    }
+    break;
+  case SBDI_HDR_KEY_TYPE_GCM_SIV:
+    r = sbdi_gcm_siv_create(&sbdi->crypto, h->key);
+    if (r != SBDI_SUCCESS) {
+      // Cleanup of header SIV must be handled next layer up
+      free(h);
+      return r;
+    }
+    break;
+  case SBDI_HDR_KEY_TYPE_CHACHA:
+    r = sbdi_chacha_create(&sbdi->crypto, h->key);
+    if (r != SBDI_SUCCESS) {
+      // Cleanup of header SIV must be handled next layer up
+      free(h);
+      return r;
+    }
+    break;
+  case SBDI_HDR_KEY_TYPE_AEGIS:
+    r = sbdi_aegis_create(&sbdi->crypto, h->key);
+    if (r != SBDI_SUCCESS) {
+      // Cleanup of header SIV must be handled next layer up
+      free(h);
+      return r;
+    }
+    break;
+  case SBDI_HDR_KEY_TYPE_GMAC:
+    r = sbdi_gmac_create(&sbdi->crypto, h->key);
+    if (r != SBDI_SUCCESS) {
+      // Cleanup of header SIV must be handled next layer up
+      free(h);
+      return r;
+    }
+    break;
   default:
     free(h);
     return SBDI_ERR_UNSUPPORTED;
@@ -182,6 +233,8 @@ sbdi_error_t sbdi_hdr_v1_read(sbdi_t *sbdi, siv_ctx *master)
     free(h);
     return r;
   }
+  // All counter values below the stored one might have been used already
+  h->ctr_rsv = h->ctr;
   sbdi->hdr = h;
   return SBDI_SUCCESS;
 }
@@ -191,6 +244,8 @@ sbdi_error_t sbdi_hdr_v1_write(sbdi_t *sbdi, siv_ctx *master)
 {
   SBDI_CHK_PARAM(sbdi);
   sbdi_hdr_v1_t *hdr = sbdi->hdr;
+  sbdi_ctr_128b_t rsv = hdr->ctr;
+  SBDI_ERR_CHK(sbdi_ctr_128b_add(&rsv, SBDI_HDR_CTR_RESERVE));
   uint8_t *wrt_buf = *sbdi->write_store[0].data;
   memset(wrt_buf, 0, SBDI_BLOCK_SIZE);
   sbdi_buffer_t b;
@@ -199,19 +254,39 @@ sbdi_error_t sbdi_hdr_v1_write(sbdi_t *sbdi, siv_ctx *master)
   sbdi_buffer_write_bytes(&b, hdr->id.magic, SBDI_HDR_MAGIC_LEN);
   sbdi_buffer_write_uint32_t(&b, hdr->id.version);
   sbdi_buffer_write_uint64_t(&b, hdr->size);
-  sbdi_buffer_write_ctr_128b(&b, &hdr->ctr);
+  sbdi_buffer_write_ctr_128b(&b, &rsv);
   sbdi_buffer_write_uint32_t(&b, hdr->type);
   uint8_t *kptr = sbdi_buffer_get_cptr(&b);
   sbdi_buffer_add_pos(&b, SBDI_HDR_V1_KEY_MAX_SIZE);
   uint8_t *tptr = sbdi_buffer_get_cptr(&b);
   siv_encrypt(master, hdr->key, kptr, SBDI_HDR_V1_KEY_MAX_SIZE, tptr, 0);
-  return sbdi_bl_write_hdr_block(sbdi, sbdi->write_store);
+  SBDI_ERR_CHK(sbdi_bl_write_hdr_block(sbdi, sbdi->write_store));
+  hdr->ctr_rsv = rsv;
+  hdr->dirty = 0;
+  return SBDI_SUCCESS;
+}
+
+//----------------------------------------------------------------------
+int sbdi_hdr_v1_is_dirty(sbdi_t *sbdi)
+{
+  int res = 0;
+  sbdi_ctr_128b_cmp(&sbdi->hdr->ctr, &sbdi->hdr->ctr_rsv, &res);
+  return sbdi->hdr->dirty || res > 0;
+}
+
+//----------------------------------------------------------------------
+void sbdi_hdr_v1_mark_dirty(sbdi_t *sbdi)
+{
+  sbdi->hdr->dirty = 1;
 }
 
 //----------------------------------------------------------------------
 void sbdi_hdr_v1_update_size(sbdi_t *sbdi, const size_t size)
 {
-  sbdi->hdr->size = size;
+  if (sbdi->hdr->size != size) {
+    sbdi->hdr->size = size;
+    sbdi->hdr->dirty = 1;
+  }
 }
 
 //----------------------------------------------------------------------
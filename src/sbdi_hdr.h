@@ -54,6 +54,11 @@ extern "C" {
 #define SBDI_HDR_V1_KEY_SIV      1
 #define SBDI_HDR_V1_KEY_OCB      2
 #define SBDI_HDR_V1_KEY_HMAC     3
+#define SBDI_HDR_V1_KEY_GCM      4
+#define SBDI_HDR_V1_KEY_GCM_SIV  5
+#define SBDI_HDR_V1_KEY_CHACHA   6
+#define SBDI_HDR_V1_KEY_AEGIS    7
+#define SBDI_HDR_V1_KEY_GMAC     8
 #define SBDI_HDR_V1_KEY_NONE 65535
 
 typedef uint8_t sbdi_hdr_magic_t[SBDI_HDR_MAGIC_LEN];
@@ -65,6 +70,11 @@ typedef enum sbdi_hdr_v1_key_type {
   SBDI_HDR_KEY_TYPE_SIV = SBDI_HDR_V1_KEY_SIV,
   SBDI_HDR_KEY_TYPE_OCB = SBDI_HDR_V1_KEY_OCB,
   SBDI_HDR_KEY_TYPE_HMAC = SBDI_HDR_V1_KEY_HMAC,
+  SBDI_HDR_KEY_TYPE_GCM = SBDI_HDR_V1_KEY_GCM,
+  SBDI_HDR_KEY_TYPE_GCM_SIV = SBDI_HDR_V1_KEY_GCM_SIV,
+  SBDI_HDR_KEY_TYPE_CHACHA = SBDI_HDR_V1_KEY_CHACHA,
+  SBDI_HDR_KEY_TYPE_AEGIS = SBDI_HDR_V1_KEY_AEGIS,
+  SBDI_HDR_KEY_TYPE_GMAC = SBDI_HDR_V1_KEY_GMAC,
 } sbdi_hdr_v1_key_type_t;
 
 static const sbdi_hdr_magic_t SBDI_HDR_MAGIC = { 0xA1, 0x1D, 0x1F, 0xDE, 0xAD,
@@ -89,6 +99,8 @@ typedef struct secure_block_device_interface_header_v1 {
   sbdi_hdr_v1_key_type_t type; //!< type of the key used to protect the secure block device
   sbdi_hdr_v1_sym_key_t key; //!< the plaintext secure block device key
   sbdi_tag_t tag; //!< the tag protecting the integrity of the key
+  sbdi_ctr_128b_t ctr_rsv; //!< the counter value persisted by the last header write (not stored)
+  int dirty; //!< set if the header has to be rewritten on the next sync (not stored)
 } sbdi_hdr_v1_t;
 
 void sbdi_hdr_v1_derive_key(siv_ctx *master, sbdi_hdr_v1_sym_key_t key,
@@ -153,6 +165,11 @@ sbdi_error_t sbdi_hdr_v1_read(sbdi_t *sbdi, siv_ctx *master);
  * \brief Writes a secure block device interface header v1 to the SBDI
  *
  * This function encrypts the SBDI specific key before writing the header.
+ * Instead of the current counter value the header stores the counter value
+ * plus SBDI_HDR_CTR_RESERVE. After re-opening the secure block device the
+ * counter continues from this reserved value, which allows skipping header
+ * writes until the reserved counter values are used up (see
+ * sbdi_hdr_v1_is_dirty).
  *
  * @param sbdi[in] a pointer to the secure block device interface to write
  * the header to, and it also contains the header to write
@@ -169,6 +186,28 @@ sbdi_error_t sbdi_hdr_v1_read(sbdi_t *sbdi, siv_ctx *master);
  */
 sbdi_error_t sbdi_hdr_v1_write(sbdi_t *sbdi, siv_ctx *master);
 
+/*!
+ * \brief Determines if the header has to be rewritten to persist the state
+ * of the secure block device
+ *
+ * This is the case if the size changed, the header has been explicitly
+ * marked dirty, or the counter has used up the counter values reserved by
+ * the last header write.
+ *
+ * @param sbdi[in] a pointer to the secure block device interface that
+ * contains the header to check
+ * @return true if the header needs to be written; false otherwise
+ */
+int sbdi_hdr_v1_is_dirty(sbdi_t *sbdi);
+
+/*!
+ * \brief Forces a rewrite of the header on the next sync
+ *
+ * @param sbdi[in] a pointer to the secure block device interface that
+ * contains the header to mark dirty
+ */
+void sbdi_hdr_v1_mark_dirty(sbdi_t *sbdi);
+
 /*!
  * \brief Updates the current size of the secure block device in the header
  *
@@ -0,0 +1,620 @@
+/* Copyright (c) IAIK, Graz University of Technology, 2015.
+ * All rights reserved.
+ * Contact: http://opensource.iaik.tugraz.at
+ * 
+ * This file is part of the Secure Block Device Library.
+ * 
+ * Commercial License Usage
+ * Licensees holding valid commercial licenses may use this file in
+ * accordance with the commercial license agreement provided with the
+ * Software or, alternatively, in accordance with the terms contained in
+ * a written agreement between you and SIC. For further information
+ * contact us at http://opensource.iaik.tugraz.at.
+ * 
+ * Alternatively, this file may be used under the terms of the GNU General
+ * Public License as published by the Free Software Foundation version 2.
+ * 
+ * The Secure Block Device Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with the Secure Block Device Library. If not, see <http://www.gnu.org/licenses/>.
+ */
+///
+/// \file
+/// \brief Implements the Secure Block Device Library's write-ahead log.
+///
+/// The log starts with a small header that holds a generation number and the
+/// offset of the first record that has not been checkpointed yet. Records
+/// follow back to back. A record consists of a record header (magic, type,
+/// generation, device offset, payload length and a CRC-32 over the record
+/// header and the payload) and its payload. Records of an older generation
+/// or with an invalid checksum end the log. Once everything has been
+/// checkpointed the log starts over with a new generation.
+///
+#include "sbdi_jnl.h"
+#include "sbdi_buffer.h"
+#include "sbdi_crc.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#define JNL_MAGIC_LEN       8u
+#define JNL_HDR_PACKED_SIZE 28u //!< magic, generation, start offset and CRC
+#define JNL_HDR_SIZE        64u //!< the space reserved for the log header
+#define JNL_REC_SIZE        32u //!< the packed size of a record header
+#define JNL_REC_CRC_OFF     28u //!< the offset of the CRC in a record header
+#define JNL_REC_MAGIC       UINT32_C(0x4A524543)
+#define JNL_REC_WRITE       1u  //!< a block write, the payload is the block
+#define JNL_REC_COMMIT      2u  //!< commits all preceding block writes
+
+static const uint8_t JNL_MAGIC[JNL_MAGIC_LEN] = { 0x53, 0x42, 0x44, 0x49, 0x4A,
+    0x4E, 0x4C, 0x31 };
+
+/*!
+ * \brief the log state of a single block
+ *
+ * Log offsets point to the payload of a write record; 0 means none, because
+ * the log header precedes all records.
+ */
+typedef struct sbdi_jnl_entry {
+  uint64_t cur; //!< log offset of the latest version of the block
+  uint64_t cmt; //!< log offset of the latest committed version that still needs checkpointing
+} jnl_ent_t;
+
+typedef struct sbdi_jnl {
+  sbdi_pio_t pio;            //!< the write-ahead log pio handed out to the user
+  sbdi_pio_t *data;          //!< the data back end
+  sbdi_pio_t *log;           //!< the log back end
+  pthread_mutex_t lock;      //!< protects all of the following fields
+  pthread_cond_t work;       //!< signaled if a checkpoint is due or on shutdown
+  pthread_t ckpt;            //!< the checkpoint thread
+  int ckpt_req;              //!< set if a checkpoint is due
+  int shutdown;              //!< set to stop the checkpoint thread
+  uint64_t gen;              //!< the generation of the log
+  uint64_t start;            //!< the offset of the first record to replay
+  uint64_t end;              //!< the offset where the next record goes
+  uint64_t durable;          //!< the log is durable up to this offset
+  uint64_t open;             //!< the offset of the first record written since the last commit
+  uint64_t dev_end;          //!< the end of the device including logged blocks
+  jnl_ent_t *ents;           //!< the log state of all blocks
+  uint32_t n_ents;           //!< the number of entries in ents
+  uint32_t live;             //!< the number of blocks with a version in the log
+  uint32_t *dirty;           //!< the blocks written since the last commit
+  uint32_t n_dirty;          //!< the number of blocks in dirty
+  uint32_t c_dirty;          //!< the capacity of dirty
+  uint8_t rec[JNL_REC_SIZE + SBDI_BLOCK_SIZE]; //!< record assembly buffer
+} sbdi_jnl_t;
+
+static sbdi_error_t jnl_pread_full(sbdi_pio_t *p, void *buf, size_t n,
+    uint64_t off)
+{
+  ssize_t r = p->pread(p->iod, buf, n, off);
+  if (r == -1) {
+    return SBDI_ERR_IO;
+  }
+  return ((size_t) r == n) ? SBDI_SUCCESS : SBDI_ERR_IO_MISSING_DATA;
+}
+
+static sbdi_error_t jnl_pwrite_full(sbdi_pio_t *p, const void *buf, size_t n,
+    uint64_t off)
+{
+  ssize_t r = p->pwrite(p->iod, buf, n, off);
+  return (r != -1 && (size_t) r == n) ? SBDI_SUCCESS : SBDI_ERR_IO;
+}
+
+static sbdi_error_t jnl_flush_pio(sbdi_pio_t *p)
+{
+  return (!p->flush || p->flush(p->iod) == 0) ? SBDI_SUCCESS : SBDI_ERR_IO;
+}
+
+//----------------------------------------------------------------------
+static sbdi_error_t jnl_write_hdr(sbdi_jnl_t *j)
+{
+  uint8_t h[JNL_HDR_PACKED_SIZE];
+  sbdi_buffer_t b;
+  sbdi_buffer_init(&b, h, JNL_HDR_PACKED_SIZE);
+  sbdi_buffer_write_bytes(&b, JNL_MAGIC, JNL_MAGIC_LEN);
+  sbdi_buffer_write_uint64_t(&b, j->gen);
+  sbdi_buffer_write_uint64_t(&b, j->start);
+  sbdi_buffer_write_uint32_t(&b, sbdi_crc32(0, h, JNL_HDR_PACKED_SIZE - 4));
+  return jnl_pwrite_full(j->log, h, JNL_HDR_PACKED_SIZE, 0);
+}
+
+//----------------------------------------------------------------------
+static sbdi_error_t jnl_read_hdr(sbdi_jnl_t *j)
+{
+  uint8_t h[JNL_HDR_PACKED_SIZE];
+  uint8_t magic[JNL_MAGIC_LEN];
+  ssize_t r = j->log->pread(j->log->iod, h, JNL_HDR_PACKED_SIZE, 0);
+  if (r == -1) {
+    return SBDI_ERR_IO;
+  } else if (r == 0) {
+    return SBDI_ERR_IO_MISSING_BLOCK;
+  } else if (r != JNL_HDR_PACKED_SIZE) {
+    return SBDI_ERR_IO_MISSING_DATA;
+  }
+  sbdi_buffer_t b;
+  sbdi_buffer_init(&b, h, JNL_HDR_PACKED_SIZE);
+  sbdi_buffer_read_bytes(&b, magic, JNL_MAGIC_LEN);
+  j->gen = sbdi_buffer_read_uint64_t(&b);
+  j->start = sbdi_buffer_read_uint64_t(&b);
+  uint32_t crc = sbdi_buffer_read_uint32_t(&b);
+  if (memcmp(magic, JNL_MAGIC, JNL_MAGIC_LEN)
+      || crc != sbdi_crc32(0, h, JNL_HDR_PACKED_SIZE - 4)
+      || j->start < JNL_HDR_SIZE) {
+    return SBDI_ERR_ILLEGAL_STATE;
+  }
+  return SBDI_SUCCESS;
+}
+
+/*!
+ * \brief Appends a record to the log
+ *
+ * Must be called with the lock held.
+ *
+ * @param j[in] the write-ahead log
+ * @param type[in] the record type
+ * @param off[in] the device offset of the payload
+ * @param payload[in] the payload (can be NULL if len is 0)
+ * @param len[in] the length of the payload (at most SBDI_BLOCK_SIZE)
+ * @param pl_off[out] the log offset of the payload (can be NULL)
+ * @return SBDI_SUCCESS if the record could be appended; SBDI_ERR_IO
+ * otherwise
+ */
+static sbdi_error_t jnl_append(sbdi_jnl_t *j, uint32_t type, uint64_t off,
+    const void *payload, uint32_t len, uint64_t *pl_off)
+{
+  assert(len <= SBDI_BLOCK_SIZE);
+  sbdi_buffer_t b;
+  sbdi_buffer_init(&b, j->rec, JNL_REC_SIZE + len);
+  sbdi_buffer_write_uint32_t(&b, JNL_REC_MAGIC);
+  sbdi_buffer_write_uint32_t(&b, type);
+  sbdi_buffer_write_uint64_t(&b, j->gen);
+  sbdi_buffer_write_uint64_t(&b, off);
+  sbdi_buffer_write_uint32_t(&b, len);
+  if (len) {
+    memcpy(j->rec + JNL_REC_SIZE, payload, len);
+  }
+  uint32_t crc = sbdi_crc32(0, j->rec, JNL_REC_CRC_OFF);
+  crc = sbdi_crc32(crc, j->rec + JNL_REC_SIZE, len);
+  sbdi_buffer_write_uint32_t(&b, crc);
+  SBDI_ERR_CHK(jnl_pwrite_full(j->log, j->rec, JNL_REC_SIZE + len, j->end));
+  if (pl_off) {
+    *pl_off = j->end + JNL_REC_SIZE;
+  }
+  j->end += JNL_REC_SIZE + len;
+  return SBDI_SUCCESS;
+}
+
+/*!
+ * \brief Gets the log state of the given block
+ *
+ * Must be called with the lock held.
+ *
+ * @param j[in] the write-ahead log
+ * @param blk[in] the block number
+ * @param create[in] if set the entry table is grown to contain the block
+ * @return a pointer to the entry; NULL if there is none and create is not
+ * set, or if growing the entry table fails
+ */
+static jnl_ent_t *jnl_get_ent(sbdi_jnl_t *j, uint32_t blk, int create)
+{
+  if (blk < j->n_ents) {
+    return &j->ents[blk];
+  } else if (!create) {
+    return NULL;
+  }
+  uint32_t n = (j->n_ents < 64) ? 64 : j->n_ents;
+  while (n <= blk) {
+    n *= 2;
+  }
+  jnl_ent_t *e = realloc(j->ents, n * sizeof(jnl_ent_t));
+  if (!e) {
+    return NULL;
+  }
+  memset(e + j->n_ents, 0, (n - j->n_ents) * sizeof(jnl_ent_t));
+  j->ents = e;
+  j->n_ents = n;
+  return &j->ents[blk];
+}
+
+//----------------------------------------------------------------------
+static ssize_t jnl_pread_i(void *iod, void *buf, size_t nbyte, off_t offset)
+{
+  sbdi_jnl_t *j = iod;
+  uint8_t *ptr = buf;
+  if (offset < 0 || offset % SBDI_BLOCK_SIZE) {
+    errno = EINVAL;
+    return -1;
+  }
+  size_t done = 0;
+  pthread_mutex_lock(&j->lock);
+  while (done < nbyte) {
+    uint64_t pos = (uint64_t) offset + done;
+    size_t n = (nbyte - done > SBDI_BLOCK_SIZE) ? SBDI_BLOCK_SIZE : nbyte - done;
+    jnl_ent_t *e = jnl_get_ent(j, pos / SBDI_BLOCK_SIZE, 0);
+    if (e && e->cur) {
+      if (jnl_pread_full(j->log, ptr + done, n, e->cur) != SBDI_SUCCESS) {
+        pthread_mutex_unlock(&j->lock);
+        errno = EIO;
+        return -1;
+      }
+      done += n;
+      continue;
+    }
+    ssize_t r = j->data->pread(j->data->iod, ptr + done, n, pos);
+    if (r == -1) {
+      pthread_mutex_unlock(&j->lock);
+      return -1;
+    }
+    // Blocks between logged blocks that were never written read as zeros
+    size_t avail = (j->dev_end > pos) ? j->dev_end - pos : 0;
+    avail = (avail > n) ? n : avail;
+    if ((size_t) r < avail) {
+      memset(ptr + done + r, 0, avail - r);
+      r = avail;
+    }
+    done += r;
+    if ((size_t) r < n) {
+      break;
+    }
+  }
+  pthread_mutex_unlock(&j->lock);
+  return done;
+}
+
+//----------------------------------------------------------------------
+static ssize_t jnl_pwrite_i(void *iod, const void *buf, size_t nbyte,
+    off_t offset)
+{
+  sbdi_jnl_t *j = iod;
+  if (offset < 0 || offset % SBDI_BLOCK_SIZE || nbyte != SBDI_BLOCK_SIZE) {
+    errno = EINVAL;
+    return -1;
+  }
+  pthread_mutex_lock(&j->lock);
+  jnl_ent_t *e = jnl_get_ent(j, offset / SBDI_BLOCK_SIZE, 1);
+  if (!e) {
+    pthread_mutex_unlock(&j->lock);
+    errno = ENOMEM;
+    return -1;
+  }
+  if (e->cur == e->cmt) {
+    // Block not yet written since the last commit
+    if (j->n_dirty == j->c_dirty) {
+      uint32_t c = j->c_dirty ? 2 * j->c_dirty : 64;
+      uint32_t *d = realloc(j->dirty, c * sizeof(uint32_t));
+      if (!d) {
+        pthread_mutex_unlock(&j->lock);
+        errno = ENOMEM;
+        return -1;
+      }
+      j->dirty = d;
+      j->c_dirty = c;
+    }
+    if (!j->n_dirty) {
+      // The first record of a new transaction goes here
+      j->open = j->end;
+    }
+    j->dirty[j->n_dirty++] = offset / SBDI_BLOCK_SIZE;
+  }
+  uint64_t pl = 0;
+  if (jnl_append(j, JNL_REC_WRITE, offset, buf, nbyte, &pl) != SBDI_SUCCESS) {
+    pthread_mutex_unlock(&j->lock);
+    errno = EIO;
+    return -1;
+  }
+  if (!e->cur) {
+    j->live += 1;
+  }
+  e->cur = pl;
+  if (offset + nbyte > j->dev_end) {
+    j->dev_end = offset + nbyte;
+  }
+  pthread_mutex_unlock(&j->lock);
+  return nbyte;
+}
+
+//----------------------------------------------------------------------
+static int jnl_commit_i(void *iod)
+{
+  sbdi_jnl_t *j = iod;
+  pthread_mutex_lock(&j->lock);
+  if (j->n_dirty) {
+    if (jnl_append(j, JNL_REC_COMMIT, 0, NULL, 0, NULL) != SBDI_SUCCESS) {
+      pthread_mutex_unlock(&j->lock);
+      return -1;
+    }
+    for (uint32_t i = 0; i < j->n_dirty; ++i) {
+      jnl_ent_t *e = &j->ents[j->dirty[i]];
+      e->cmt = e->cur;
+    }
+    j->n_dirty = 0;
+    j->open = 0;
+  }
+  pthread_mutex_unlock(&j->lock);
+  return 0;
+}
+
+//----------------------------------------------------------------------
+static int jnl_flush_i(void *iod)
+{
+  sbdi_jnl_t *j = iod;
+  pthread_mutex_lock(&j->lock);
+  // Records behind the last commit record are flushed as well, but they stay
+  // an incomplete transaction until the next commit
+  const uint64_t gen = j->gen;
+  const uint64_t target = j->end;
+  if (target == j->durable) {
+    pthread_mutex_unlock(&j->lock);
+    return 0;
+  }
+  pthread_mutex_unlock(&j->lock);
+  if (jnl_flush_pio(j->log) != SBDI_SUCCESS) {
+    return -1;
+  }
+  pthread_mutex_lock(&j->lock);
+  // The log might have started over while flushing
+  if (gen == j->gen && target > j->durable) {
+    j->durable = target;
+  }
+  if (j->durable - j->start >= SBDI_JNL_CHECKPOINT_SIZE) {
+    j->ckpt_req = 1;
+    pthread_cond_signal(&j->work);
+  }
+  pthread_mutex_unlock(&j->lock);
+  return 0;
+}
+
+/*!
+ * \brief Writes all durably committed blocks to their place in the data back
+ * end and advances the start of the log
+ *
+ * Runs concurrently to reads, writes and flushes of the write-ahead log.
+ *
+ * @param j[in] the write-ahead log
+ * @return SBDI_SUCCESS if the checkpoint succeeds; an error code otherwise
+ */
+static sbdi_error_t jnl_checkpoint(sbdi_jnl_t *j)
+{
+  uint8_t blk[SBDI_BLOCK_SIZE];
+  pthread_mutex_lock(&j->lock);
+  const uint64_t upto = j->durable;
+  uint32_t n = 0;
+  for (uint32_t i = 0; i < j->n_ents; ++i) {
+    n += (j->ents[i].cmt && j->ents[i].cmt < upto);
+  }
+  uint32_t *idx = n ? malloc(n * sizeof(uint32_t)) : NULL;
+  uint64_t *src = n ? malloc(n * sizeof(uint64_t)) : NULL;
+  if (n && (!idx || !src)) {
+    pthread_mutex_unlock(&j->lock);
+    free(src);
+    free(idx);
+    return SBDI_ERR_OUT_Of_MEMORY;
+  }
+  for (uint32_t i = 0, k = 0; i < j->n_ents; ++i) {
+    if (j->ents[i].cmt && j->ents[i].cmt < upto) {
+      idx[k] = i;
+      src[k++] = j->ents[i].cmt;
+    }
+  }
+  pthread_mutex_unlock(&j->lock);
+  // The log is append only below upto, so copy without holding the lock
+  sbdi_error_t r = SBDI_SUCCESS;
+  for (uint32_t k = 0; k < n && r == SBDI_SUCCESS; ++k) {
+    r = jnl_pread_full(j->log, blk, SBDI_BLOCK_SIZE, src[k]);
+    if (r == SBDI_SUCCESS) {
+      r = jnl_pwrite_full(j->data, blk, SBDI_BLOCK_SIZE,
+          (uint64_t) idx[k] * SBDI_BLOCK_SIZE);
+    }
+  }
+  if (r == SBDI_SUCCESS) {
+    r = jnl_flush_pio(j->data);
+  }
+  if (r != SBDI_SUCCESS) {
+    free(src);
+    free(idx);
+    return r;
+  }
+  pthread_mutex_lock(&j->lock);
+  for (uint32_t k = 0; k < n; ++k) {
+    jnl_ent_t *e = &j->ents[idx[k]];
+    if (e->cmt != src[k]) {
+      // Committed again in the meantime
+      continue;
+    }
+    if (e->cur == e->cmt) {
+      e->cur = 0;
+      j->live -= 1;
+    }
+    e->cmt = 0;
+  }
+  if (j->live == 0 && j->end == j->durable) {
+    // Everything is in place ==> start over with a new generation
+    j->gen += 1;
+    j->start = j->end = j->durable = JNL_HDR_SIZE;
+  } else {
+    // Records of the open transaction must be replayed with its commit
+    const uint64_t start = (j->n_dirty && j->open < upto) ? j->open : upto;
+    j->start = (start > j->start) ? start : j->start;
+  }
+  // Losing this update only means replaying checkpointed records again
+  r = jnl_write_hdr(j);
+  pthread_mutex_unlock(&j->lock);
+  free(src);
+  free(idx);
+  return r;
+}
+
+static void *jnl_thread(void *arg)
+{
+  sbdi_jnl_t *j = arg;
+  pthread_mutex_lock(&j->lock);
+  while (!j->shutdown) {
+    if (j->ckpt_req) {
+      j->ckpt_req = 0;
+      pthread_mutex_unlock(&j->lock);
+      // A failed checkpoint is retried with the next one
+      jnl_checkpoint(j);
+      pthread_mutex_lock(&j->lock);
+      continue;
+    }
+    pthread_cond_wait(&j->work, &j->lock);
+  }
+  pthread_mutex_unlock(&j->lock);
+  return NULL;
+}
+
+/*!
+ * \brief Replays all committed records of the log into the data back end and
+ * starts a new log generation
+ *
+ * @param j[in] the write-ahead log
+ * @return SBDI_SUCCESS if the recovery succeeds; an error code otherwise
+ */
+static sbdi_error_t jnl_recover(sbdi_jnl_t *j)
+{
+  sbdi_error_t r = jnl_read_hdr(j);
+  if (r == SBDI_ERR_IO_MISSING_BLOCK) {
+    // New log
+    j->gen = 1;
+    j->start = JNL_HDR_SIZE;
+  } else if (r != SBDI_SUCCESS) {
+    return r;
+  }
+  uint64_t pos = j->start;
+  uint64_t *pnd = NULL;
+  uint32_t n_pnd = 0, c_pnd = 0;
+  for (;;) {
+    uint8_t *rec = j->rec;
+    if (jnl_pread_full(j->log, rec, JNL_REC_SIZE, pos) != SBDI_SUCCESS) {
+      break;
+    }
+    sbdi_buffer_t b;
+    sbdi_buffer_init(&b, rec, JNL_REC_SIZE);
+    uint32_t magic = sbdi_buffer_read_uint32_t(&b);
+    uint32_t type = sbdi_buffer_read_uint32_t(&b);
+    uint64_t gen = sbdi_buffer_read_uint64_t(&b);
+    uint64_t off = sbdi_buffer_read_uint64_t(&b);
+    uint32_t len = sbdi_buffer_read_uint32_t(&b);
+    uint32_t crc = sbdi_buffer_read_uint32_t(&b);
+    if (magic != JNL_REC_MAGIC || gen != j->gen
+        || !((type == JNL_REC_WRITE && len == SBDI_BLOCK_SIZE
+            && off % SBDI_BLOCK_SIZE == 0)
+            || (type == JNL_REC_COMMIT && len == 0))) {
+      break;
+    }
+    if (len && jnl_pread_full(j->log, rec + JNL_REC_SIZE, len,
+        pos + JNL_REC_SIZE) != SBDI_SUCCESS) {
+      break;
+    }
+    if (crc != sbdi_crc32(sbdi_crc32(0, rec, JNL_REC_CRC_OFF),
+        rec + JNL_REC_SIZE, len)) {
+      break;
+    }
+    if (type == JNL_REC_WRITE) {
+      if (n_pnd == c_pnd) {
+        c_pnd = c_pnd ? 2 * c_pnd : 64;
+        uint64_t *p = realloc(pnd, 2 * c_pnd * sizeof(uint64_t));
+        if (!p) {
+          free(pnd);
+          return SBDI_ERR_OUT_Of_MEMORY;
+        }
+        pnd = p;
+      }
+      pnd[2 * n_pnd] = off;
+      pnd[2 * n_pnd + 1] = pos + JNL_REC_SIZE;
+      n_pnd += 1;
+    } else {
+      // Apply the transaction in log order
+      for (uint32_t i = 0; i < n_pnd && r == SBDI_SUCCESS; ++i) {
+        r = jnl_pread_full(j->log, rec + JNL_REC_SIZE, SBDI_BLOCK_SIZE,
+            pnd[2 * i + 1]);
+        if (r == SBDI_SUCCESS) {
+          r = jnl_pwrite_full(j->data, rec + JNL_REC_SIZE, SBDI_BLOCK_SIZE,
+              pnd[2 * i]);
+        }
+      }
+      if (r != SBDI_SUCCESS) {
+        free(pnd);
+        return r;
+      }
+      n_pnd = 0;
+    }
+    pos += JNL_REC_SIZE + len;
+  }
+  // Records of an incomplete transaction are dropped
+  free(pnd);
+  SBDI_ERR_CHK(jnl_flush_pio(j->data));
+  j->gen += 1;
+  j->start = j->end = j->durable = JNL_HDR_SIZE;
+  SBDI_ERR_CHK(jnl_write_hdr(j));
+  return jnl_flush_pio(j->log);
+}
+
+//----------------------------------------------------------------------
+sbdi_pio_t *sbdi_jnl_create(sbdi_pio_t *data, sbdi_pio_t *log)
+{
+  if (!data || !log) {
+    return NULL;
+  }
+  sbdi_jnl_t *j = calloc(1, sizeof(sbdi_jnl_t));
+  if (!j) {
+    return NULL;
+  }
+  j->data = data;
+  j->log = log;
+  if (jnl_recover(j) != SBDI_SUCCESS) {
+    free(j);
+    return NULL;
+  }
+  if (pthread_mutex_init(&j->lock, NULL)) {
+    free(j);
+    return NULL;
+  }
+  if (pthread_cond_init(&j->work, NULL)) {
+    pthread_mutex_destroy(&j->lock);
+    free(j);
+    return NULL;
+  }
+  if (pthread_create(&j->ckpt, NULL, &jnl_thread, j)) {
+    pthread_cond_destroy(&j->work);
+    pthread_mutex_destroy(&j->lock);
+    free(j);
+    return NULL;
+  }
+  j->pio.iod = j;
+  j->pio.pread = &jnl_pread_i;
+  j->pio.pwrite = &jnl_pwrite_i;
+  j->pio.flush = &jnl_flush_i;
+  j->pio.commit = &jnl_commit_i;
+  j->pio.genseed = data->genseed;
+  return &j->pio;
+}
+
+//----------------------------------------------------------------------
+void sbdi_jnl_delete(sbdi_pio_t *pio)
+{
+  if (!pio) {
+    return;
+  }
+  sbdi_jnl_t *j = pio->iod;
+  pthread_mutex_lock(&j->lock);
+  j->shutdown = 1;
+  pthread_cond_signal(&j->work);
+  pthread_mutex_unlock(&j->lock);
+  pthread_join(j->ckpt, NULL);
+  // Best effort; whatever is not checkpointed is replayed on the next create
+  jnl_checkpoint(j);
+  pthread_cond_destroy(&j->work);
+  pthread_mutex_destroy(&j->lock);
+  free(j->dirty);
+  free(j->ents);
+  memset(j, 0, sizeof(sbdi_jnl_t));
+  free(j);
+}
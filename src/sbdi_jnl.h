@@ -0,0 +1,83 @@
+/* Copyright (c) IAIK, Graz University of Technology, 2015.
+ * All rights reserved.
+ * Contact: http://opensource.iaik.tugraz.at
+ * 
+ * This file is part of the Secure Block Device Library.
+ * 
+ * Commercial License Usage
+ * Licensees holding valid commercial licenses may use this file in
+ * accordance with the commercial license agreement provided with the
+ * Software or, alternatively, in accordance with the terms contained in
+ * a written agreement between you and SIC. For further information
+ * contact us at http://opensource.iaik.tugraz.at.
+ * 
+ * Alternatively, this file may be used under the terms of the GNU General
+ * Public License as published by the Free Software Foundation version 2.
+ * 
+ * The Secure Block Device Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with the Secure Block Device Library. If not, see <http://www.gnu.org/licenses/>.
+ */
+///
+/// \file
+/// \brief Specifies the Secure Block Device Library's write-ahead log.
+///
+/// The write-ahead log is a block device abstraction layer that wraps a data
+/// back end and a sidecar log back end. Every block write is appended to the
+/// log as a checksummed record. A commit appends a commit record and a flush
+/// flushes the log only, so a sync of the secure block device turns into one
+/// sequential append and a single flush. The secure block device commits
+/// while it holds the device lock, so the state of a sync becomes durable
+/// atomically, even if other threads write while its flush is in flight.
+///
+/// Committed blocks are checkpointed, i.e. written to their place in the
+/// data back end, lazily by a background thread once the log grows beyond
+/// SBDI_JNL_CHECKPOINT_SIZE bytes, and when the write-ahead log is deleted.
+/// Creating a write-ahead log replays all committed records that have not
+/// been checkpointed before a crash and discards incomplete transactions.
+///
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef SBDI_JNL_H_
+#define SBDI_JNL_H_
+
+#include "sbdi_config.h"
+#include "sbdi_pio.h"
+
+/*!
+ * \brief Creates a write-ahead log block device abstraction layer on top of
+ * the given data and log back ends
+ *
+ * This function replays all committed but not yet checkpointed records of
+ * the log into the data back end. The resulting pio supports block aligned
+ * reads and writes of whole blocks only, which is what the secure block
+ * device uses. Blocks become durable once they have been committed with the
+ * commit function of the pio and the log has been flushed afterwards. Use sbdi_jnl_delete to free it; the back ends remain owned by
+ * the caller and must outlive the write-ahead log.
+ *
+ * @param data[in] the back end holding the secure block device
+ * @param log[in] the back end holding the log
+ * @return a pointer to the write-ahead log pio if successful; NULL otherwise
+ */
+sbdi_pio_t *sbdi_jnl_create(sbdi_pio_t *data, sbdi_pio_t *log);
+
+/*!
+ * \brief Checkpoints all committed blocks and frees the given write-ahead log
+ *
+ * Blocks written after the last commit are discarded.
+ *
+ * @param pio[in] the write-ahead log pio to delete (can be NULL)
+ */
+void sbdi_jnl_delete(sbdi_pio_t *pio);
+
+#endif /* SBDI_JNL_H_ */
+
+#ifdef __cplusplus
+}
+#endif
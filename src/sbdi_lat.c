@@ -0,0 +1,242 @@
+/* Copyright (c) IAIK, Graz University of Technology, 2015.
+ * All rights reserved.
+ * Contact: http://opensource.iaik.tugraz.at
+ * 
+ * This file is part of the Secure Block Device Library.
+ * 
+ * Commercial License Usage
+ * Licensees holding valid commercial licenses may use this file in
+ * accordance with the commercial license agreement provided with the
+ * Software or, alternatively, in accordance with the terms contained in
+ * a written agreement between you and SIC. For further information
+ * contact us at http://opensource.iaik.tugraz.at.
+ * 
+ * Alternatively, this file may be used under the terms of the GNU General
+ * Public License as published by the Free Software Foundation version 2.
+ * 
+ * The Secure Block Device Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with the Secure Block Device Library. If not, see <http://www.gnu.org/licenses/>.
+ */
+///
+/// \file
+/// \brief Implements the Secure Block Device Library's latency injecting back
+/// end.
+///
+/// A call first waits for a free queue slot. Its transfer then starts once
+/// the link is free, occupies the link for nbyte / bandwidth seconds, and the
+/// call completes the latency plus jitter after the transfer has ended. The
+/// wrapped back end is called right away; the call returns at its completion
+/// time.
+///
+#include "sbdi_lat.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#define LAT_NS_PER_SEC UINT64_C(1000000000)
+
+typedef struct sbdi_lat {
+  sbdi_pio_t pio;            //!< the latency injecting pio handed out to the user
+  sbdi_pio_t *inner;         //!< the wrapped back end
+  sbdi_lat_cfg_t cfg;        //!< the storage model
+  pthread_mutex_t lock;      //!< protects all of the following fields
+  pthread_cond_t slot;       //!< signaled when a call leaves the queue
+  uint32_t inflight;         //!< the number of calls in flight
+  uint64_t link_free;        //!< the time the link becomes free
+  unsigned int seed;         //!< the jitter random number generator state
+  sbdi_lat_stats_t stats;    //!< the call statistics
+} sbdi_lat_t;
+
+static uint64_t lat_now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * LAT_NS_PER_SEC + ts.tv_nsec;
+}
+
+/*!
+ * \brief Enters the queue and computes the completion time of a call
+ *
+ * @param l[in] the latency injecting back end
+ * @param nbyte[in] the number of bytes transferred by the call
+ * @param lat[in] the latency of the call in microseconds
+ * @return the completion time of the call
+ */
+static uint64_t lat_enter(sbdi_lat_t *l, size_t nbyte, uint32_t lat)
+{
+  pthread_mutex_lock(&l->lock);
+  while (l->cfg.queue_depth && l->inflight >= l->cfg.queue_depth) {
+    pthread_cond_wait(&l->slot, &l->lock);
+  }
+  l->inflight += 1;
+  if (l->inflight > l->stats.max_inflight) {
+    l->stats.max_inflight = l->inflight;
+  }
+  const uint64_t now = lat_now();
+  uint64_t t = (l->link_free > now) ? l->link_free : now;
+  if (l->cfg.bandwidth) {
+    t += (uint64_t) nbyte * LAT_NS_PER_SEC / l->cfg.bandwidth;
+    l->link_free = t;
+  }
+  uint64_t d = lat;
+  if (l->cfg.jitter) {
+    d += rand_r(&l->seed) % (l->cfg.jitter + 1);
+  }
+  t += d * 1000;
+  l->stats.delay += t - now;
+  pthread_mutex_unlock(&l->lock);
+  return t;
+}
+
+/*!
+ * \brief Waits until the completion time of a call and leaves the queue
+ *
+ * @param l[in] the latency injecting back end
+ * @param until[in] the completion time of the call
+ */
+static void lat_leave(sbdi_lat_t *l, uint64_t until)
+{
+  struct timespec ts;
+  ts.tv_sec = until / LAT_NS_PER_SEC;
+  ts.tv_nsec = until % LAT_NS_PER_SEC;
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+  }
+  pthread_mutex_lock(&l->lock);
+  l->inflight -= 1;
+  pthread_cond_signal(&l->slot);
+  pthread_mutex_unlock(&l->lock);
+}
+
+//----------------------------------------------------------------------
+static ssize_t lat_pread_i(void *iod, void *buf, size_t nbyte, off_t offset)
+{
+  sbdi_lat_t *l = iod;
+  const uint64_t t = lat_enter(l, nbyte, l->cfg.read_lat);
+  ssize_t r = l->inner->pread(l->inner->iod, buf, nbyte, offset);
+  lat_leave(l, t);
+  pthread_mutex_lock(&l->lock);
+  l->stats.reads += 1;
+  l->stats.rd_bytes += (r > 0) ? r : 0;
+  pthread_mutex_unlock(&l->lock);
+  return r;
+}
+
+//----------------------------------------------------------------------
+static ssize_t lat_pwrite_i(void *iod, const void *buf, size_t nbyte,
+    off_t offset)
+{
+  sbdi_lat_t *l = iod;
+  const uint64_t t = lat_enter(l, nbyte, l->cfg.write_lat);
+  ssize_t r = l->inner->pwrite(l->inner->iod, buf, nbyte, offset);
+  lat_leave(l, t);
+  pthread_mutex_lock(&l->lock);
+  l->stats.writes += 1;
+  l->stats.wr_bytes += (r > 0) ? r : 0;
+  pthread_mutex_unlock(&l->lock);
+  return r;
+}
+
+//----------------------------------------------------------------------
+static int lat_flush_i(void *iod)
+{
+  sbdi_lat_t *l = iod;
+  const uint64_t t = lat_enter(l, 0, l->cfg.flush_lat);
+  int r = l->inner->flush ? l->inner->flush(l->inner->iod) : 0;
+  lat_leave(l, t);
+  pthread_mutex_lock(&l->lock);
+  l->stats.flushes += 1;
+  pthread_mutex_unlock(&l->lock);
+  return r;
+}
+
+//----------------------------------------------------------------------
+static int lat_commit_i(void *iod)
+{
+  sbdi_lat_t *l = iod;
+  // A commit only marks a point in the write stream, it does not wait for it
+  return l->inner->commit(l->inner->iod);
+}
+
+//----------------------------------------------------------------------
+static int lat_discard_i(void *iod, off_t offset, size_t nbyte)
+{
+  sbdi_lat_t *l = iod;
+  // Discarding transfers no data, only the command pays the write latency
+  const uint64_t t = lat_enter(l, 0, l->cfg.write_lat);
+  int r = l->inner->discard(l->inner->iod, offset, nbyte);
+  lat_leave(l, t);
+  return r;
+}
+
+//----------------------------------------------------------------------
+static int lat_truncate_i(void *iod, off_t length)
+{
+  sbdi_lat_t *l = iod;
+  const uint64_t t = lat_enter(l, 0, l->cfg.write_lat);
+  int r = l->inner->truncate(l->inner->iod, length);
+  lat_leave(l, t);
+  return r;
+}
+
+//----------------------------------------------------------------------
+sbdi_pio_t *sbdi_lat_create(sbdi_pio_t *pio, const sbdi_lat_cfg_t *cfg)
+{
+  if (!pio || !cfg) {
+    return NULL;
+  }
+  sbdi_lat_t *l = calloc(1, sizeof(sbdi_lat_t));
+  if (!l) {
+    return NULL;
+  }
+  if (pthread_mutex_init(&l->lock, NULL)) {
+    free(l);
+    return NULL;
+  }
+  if (pthread_cond_init(&l->slot, NULL)) {
+    pthread_mutex_destroy(&l->lock);
+    free(l);
+    return NULL;
+  }
+  l->inner = pio;
+  l->cfg = *cfg;
+  l->seed = (unsigned int) lat_now();
+  l->pio.iod = l;
+  l->pio.pread = &lat_pread_i;
+  l->pio.pwrite = &lat_pwrite_i;
+  l->pio.flush = &lat_flush_i;
+  l->pio.commit = pio->commit ? &lat_commit_i : NULL;
+  l->pio.discard = pio->discard ? &lat_discard_i : NULL;
+  l->pio.truncate = pio->truncate ? &lat_truncate_i : NULL;
+  l->pio.genseed = pio->genseed;
+  return &l->pio;
+}
+
+//----------------------------------------------------------------------
+void sbdi_lat_get_stats(sbdi_pio_t *pio, sbdi_lat_stats_t *stats)
+{
+  sbdi_lat_t *l = pio->iod;
+  pthread_mutex_lock(&l->lock);
+  *stats = l->stats;
+  pthread_mutex_unlock(&l->lock);
+}
+
+//----------------------------------------------------------------------
+void sbdi_lat_delete(sbdi_pio_t *pio)
+{
+  if (!pio) {
+    return;
+  }
+  sbdi_lat_t *l = pio->iod;
+  pthread_cond_destroy(&l->slot);
+  pthread_mutex_destroy(&l->lock);
+  memset(l, 0, sizeof(sbdi_lat_t));
+  free(l);
+}
@@ -0,0 +1,112 @@
+/* Copyright (c) IAIK, Graz University of Technology, 2015.
+ * All rights reserved.
+ * Contact: http://opensource.iaik.tugraz.at
+ * 
+ * This file is part of the Secure Block Device Library.
+ * 
+ * Commercial License Usage
+ * Licensees holding valid commercial licenses may use this file in
+ * accordance with the commercial license agreement provided with the
+ * Software or, alternatively, in accordance with the terms contained in
+ * a written agreement between you and SIC. For further information
+ * contact us at http://opensource.iaik.tugraz.at.
+ * 
+ * Alternatively, this file may be used under the terms of the GNU General
+ * Public License as published by the Free Software Foundation version 2.
+ * 
+ * The Secure Block Device Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with the Secure Block Device Library. If not, see <http://www.gnu.org/licenses/>.
+ */
+///
+/// \file
+/// \brief Specifies the Secure Block Device Library's latency injecting back
+/// end.
+///
+/// The latency injecting back end wraps any other back end and delays its
+/// calls to model slow or remote storage, e.g. to test caching, readahead and
+/// batching behavior without a real network. Every call costs a fixed latency
+/// plus a random jitter. The transfers of all calls share a link of limited
+/// bandwidth, i.e. they are serialized on the link, and the number of calls
+/// in flight can be limited to model a storage queue depth.
+///
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef SBDI_LAT_H_
+#define SBDI_LAT_H_
+
+#include "sbdi_config.h"
+#include "sbdi_pio.h"
+
+#include <stdint.h>
+
+/*!
+ * \brief the storage model of a latency injecting back end
+ *
+ * All latencies are in microseconds; zero disables the respective limit.
+ */
+typedef struct sbdi_lat_config {
+  uint32_t read_lat;     //!< the latency of a read
+  uint32_t write_lat;    //!< the latency of a write
+  uint32_t flush_lat;    //!< the latency of a flush
+  uint32_t jitter;       //!< the maximum random latency added to every call
+  uint64_t bandwidth;    //!< the bandwidth of the link in bytes per second
+  uint32_t queue_depth;  //!< the maximum number of calls in flight
+} sbdi_lat_cfg_t;
+
+/*!
+ * \brief the call statistics of a latency injecting back end
+ */
+typedef struct sbdi_lat_stats {
+  uint64_t reads;        //!< the number of reads
+  uint64_t writes;       //!< the number of writes
+  uint64_t flushes;      //!< the number of flushes
+  uint64_t rd_bytes;     //!< the number of bytes read
+  uint64_t wr_bytes;     //!< the number of bytes written
+  uint64_t delay;        //!< the total injected delay in nanoseconds
+  uint32_t max_inflight; //!< the maximum number of calls in flight
+} sbdi_lat_stats_t;
+
+/*!
+ * \brief Creates a latency injecting block device abstraction layer around
+ * the given back end
+ *
+ * The flush function of the resulting pio injects the flush latency even if
+ * the wrapped back end has no flush function. Discards and truncations are
+ * passed on with the write latency if the wrapped back end supports them,
+ * commits without a latency. Use sbdi_lat_delete to free the pio; the wrapped back end remains owned by the
+ * caller.
+ *
+ * @param pio[in] the back end to wrap
+ * @param cfg[in] the storage model
+ * @return a pointer to the latency injecting pio if successful; NULL
+ * otherwise
+ */
+sbdi_pio_t *sbdi_lat_create(sbdi_pio_t *pio, const sbdi_lat_cfg_t *cfg);
+
+/*!
+ * \brief Gets the call statistics of the given latency injecting pio
+ *
+ * @param pio[in] the latency injecting pio
+ * @param stats[out] the statistics
+ */
+void sbdi_lat_get_stats(sbdi_pio_t *pio, sbdi_lat_stats_t *stats);
+
+/*!
+ * \brief Frees the given latency injecting pio
+ *
+ * @param pio[in] the latency injecting pio to delete (can be NULL)
+ */
+void sbdi_lat_delete(sbdi_pio_t *pio);
+
+#endif /* SBDI_LAT_H_ */
+
+#ifdef __cplusplus
+}
+#endif
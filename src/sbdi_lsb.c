@@ -0,0 +1,679 @@
+/* Copyright (c) IAIK, Graz University of Technology, 2015.
+ * All rights reserved.
+ * Contact: http://opensource.iaik.tugraz.at
+ * 
+ * This file is part of the Secure Block Device Library.
+ * 
+ * Commercial License Usage
+ * Licensees holding valid commercial licenses may use this file in
+ * accordance with the commercial license agreement provided with the
+ * Software or, alternatively, in accordance with the terms contained in
+ * a written agreement between you and SIC. For further information
+ * contact us at http://opensource.iaik.tugraz.at.
+ * 
+ * Alternatively, this file may be used under the terms of the GNU General
+ * Public License as published by the Free Software Foundation version 2.
+ * 
+ * The Secure Block Device Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with the Secure Block Device Library. If not, see <http://www.gnu.org/licenses/>.
+ */
+///
+/// \file
+/// \brief Implements the Secure Block Device Library's log-structured back
+/// end.
+///
+/// Segments are files named after their hexadecimal segment number. A
+/// segment is a sequence of records of fixed size. A record consists of a
+/// record header (magic, sequence number, device offset, payload length and
+/// a CRC-32 over the record header and the payload) followed by the block.
+/// The first invalid record ends a segment. Segments are never appended to
+/// after they have been closed, and every creation starts a new segment.
+///
+#include "sbdi_lsb.h"
+#include "sbdi_buffer.h"
+#include "sbdi_crc.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#define LSB_REC_SIZE      32u //!< the packed size of a record header
+#define LSB_REC_CRC_OFF   28u //!< the offset of the CRC in a record header
+#define LSB_REC_TOTAL     (LSB_REC_SIZE + SBDI_BLOCK_SIZE) //!< the size of a record
+#define LSB_REC_MAGIC     UINT32_C(0x4C534252)
+#define LSB_SEG_RECS      (SBDI_LSB_SEGMENT_SIZE / LSB_REC_TOTAL) //!< the records per segment
+#define LSB_SEG_NAME_LEN  12u //!< the length of a segment file name
+#define LSB_NONE          UINT32_MAX
+
+#if SBDI_LSB_SEGMENT_SIZE < 2 * (32u + SBDI_BLOCK_SIZE)
+#error "a segment of the log-structured back end must hold at least two records"
+#endif
+
+/*!
+ * \brief the state of a single segment
+ */
+typedef struct sbdi_lsb_segment {
+  int fd;        //!< the file descriptor of the segment; -1 if the slot is free
+  uint32_t id;   //!< the segment number, which determines the file name
+  uint32_t size; //!< the number of bytes taken up by valid records
+  uint32_t recs; //!< the number of valid records
+  uint32_t live; //!< the number of records the block map points to
+} lsb_seg_t;
+
+/*!
+ * \brief the block map entry of a single block
+ */
+typedef struct sbdi_lsb_entry {
+  uint64_t seq; //!< the sequence number of the mapped record; 0 if unmapped
+  uint32_t seg; //!< the slot of the segment holding the record
+  uint32_t off; //!< the offset of the record in its segment
+} lsb_ent_t;
+
+typedef struct sbdi_lsb {
+  sbdi_pio_t pio;            //!< the log-structured pio handed out to the user
+  int dir_fd;                //!< the file descriptor of the segment directory
+  pthread_mutex_t lock;      //!< protects all of the following fields
+  pthread_cond_t work;       //!< signaled if cleaning is due or on shutdown
+  pthread_t cleaner;         //!< the cleaner thread
+  int clean_req;             //!< set if cleaning is due
+  int shutdown;              //!< set to stop the cleaner thread
+  lsb_seg_t *segs;           //!< the segment slots
+  uint32_t n_segs;           //!< the number of segment slots
+  uint32_t active;           //!< the slot of the segment appended to
+  uint32_t next_id;          //!< the number of the next segment to create
+  uint64_t next_seq;         //!< the sequence number of the next block write
+  uint64_t dead;             //!< the number of records superseded by newer ones
+  uint64_t dev_end;          //!< the end of the device
+  lsb_ent_t *ents;           //!< the block map
+  uint32_t n_ents;           //!< the number of entries in ents
+  uint8_t rec[LSB_REC_TOTAL]; //!< record assembly buffer
+} sbdi_lsb_t;
+
+static sbdi_error_t lsb_pread_full(int fd, void *buf, size_t n, uint64_t off)
+{
+  ssize_t r = pread(fd, buf, n, off);
+  if (r == -1) {
+    return SBDI_ERR_IO;
+  }
+  return ((size_t) r == n) ? SBDI_SUCCESS : SBDI_ERR_IO_MISSING_DATA;
+}
+
+static sbdi_error_t lsb_pwrite_full(int fd, const void *buf, size_t n,
+    uint64_t off)
+{
+  ssize_t r = pwrite(fd, buf, n, off);
+  return (r != -1 && (size_t) r == n) ? SBDI_SUCCESS : SBDI_ERR_IO;
+}
+
+static void lsb_seg_name(char *name, uint32_t id)
+{
+  snprintf(name, LSB_SEG_NAME_LEN + 1, "%08" PRIx32 ".seg", id);
+}
+
+//----------------------------------------------------------------------
+static void lsb_build_rec(uint8_t *rec, uint64_t seq, uint64_t off,
+    const void *data)
+{
+  sbdi_buffer_t b;
+  sbdi_buffer_init(&b, rec, LSB_REC_SIZE);
+  sbdi_buffer_write_uint32_t(&b, LSB_REC_MAGIC);
+  sbdi_buffer_write_uint64_t(&b, seq);
+  sbdi_buffer_write_uint64_t(&b, off);
+  sbdi_buffer_write_uint32_t(&b, SBDI_BLOCK_SIZE);
+  sbdi_buffer_write_uint32_t(&b, 0);
+  memcpy(rec + LSB_REC_SIZE, data, SBDI_BLOCK_SIZE);
+  uint32_t crc = sbdi_crc32(0, rec, LSB_REC_CRC_OFF);
+  sbdi_buffer_write_uint32_t(&b, sbdi_crc32(crc, rec + LSB_REC_SIZE,
+      SBDI_BLOCK_SIZE));
+}
+
+/*!
+ * \brief Parses the record header of the given record
+ *
+ * @param rec[in] the record (LSB_REC_TOTAL bytes)
+ * @param check[in] if set the checksum and the header fields are verified
+ * @param seq[out] the sequence number of the record
+ * @param off[out] the device offset of the block in the record
+ * @return 1 if the record is valid (or not checked); 0 otherwise
+ */
+static int lsb_parse_rec(uint8_t *rec, int check, uint64_t *seq,
+    uint64_t *off)
+{
+  sbdi_buffer_t b;
+  sbdi_buffer_init(&b, rec, LSB_REC_SIZE);
+  uint32_t magic = sbdi_buffer_read_uint32_t(&b);
+  *seq = sbdi_buffer_read_uint64_t(&b);
+  *off = sbdi_buffer_read_uint64_t(&b);
+  uint32_t len = sbdi_buffer_read_uint32_t(&b);
+  sbdi_buffer_read_uint32_t(&b);
+  uint32_t crc = sbdi_buffer_read_uint32_t(&b);
+  if (!check) {
+    return 1;
+  }
+  return magic == LSB_REC_MAGIC && len == SBDI_BLOCK_SIZE && *seq
+      && *off % SBDI_BLOCK_SIZE == 0
+      && *off / SBDI_BLOCK_SIZE < UINT32_MAX
+      && crc == sbdi_crc32(sbdi_crc32(0, rec, LSB_REC_CRC_OFF),
+          rec + LSB_REC_SIZE, SBDI_BLOCK_SIZE);
+}
+
+/*!
+ * \brief Gets the block map entry of the given block
+ *
+ * Must be called with the lock held.
+ *
+ * @param l[in] the log-structured back end
+ * @param blk[in] the block number
+ * @param create[in] if set the block map is grown to contain the block
+ * @return a pointer to the entry; NULL if there is none and create is not
+ * set, or if growing the block map fails
+ */
+static lsb_ent_t *lsb_get_ent(sbdi_lsb_t *l, uint32_t blk, int create)
+{
+  if (blk < l->n_ents) {
+    return &l->ents[blk];
+  } else if (!create) {
+    return NULL;
+  }
+  uint32_t n = (l->n_ents < 64) ? 64 : l->n_ents;
+  while (n <= blk) {
+    n *= 2;
+  }
+  lsb_ent_t *e = realloc(l->ents, n * sizeof(lsb_ent_t));
+  if (!e) {
+    return NULL;
+  }
+  memset(e + l->n_ents, 0, (n - l->n_ents) * sizeof(lsb_ent_t));
+  l->ents = e;
+  l->n_ents = n;
+  return &l->ents[blk];
+}
+
+//----------------------------------------------------------------------
+static void lsb_map(sbdi_lsb_t *l, lsb_ent_t *e, uint32_t blk, uint64_t seq,
+    uint32_t seg, uint32_t off)
+{
+  if (e->seq) {
+    l->segs[e->seg].live -= 1;
+    l->dead += 1;
+  }
+  e->seq = seq;
+  e->seg = seg;
+  e->off = off;
+  l->segs[seg].live += 1;
+  if ((uint64_t) (blk + 1) * SBDI_BLOCK_SIZE > l->dev_end) {
+    l->dev_end = (uint64_t) (blk + 1) * SBDI_BLOCK_SIZE;
+  }
+}
+
+//----------------------------------------------------------------------
+static sbdi_error_t lsb_seg_add(sbdi_lsb_t *l, int fd, uint32_t id,
+    uint32_t *slot)
+{
+  uint32_t s = 0;
+  while (s < l->n_segs && l->segs[s].fd != -1) {
+    s += 1;
+  }
+  if (s == l->n_segs) {
+    uint32_t n = l->n_segs ? 2 * l->n_segs : 16;
+    lsb_seg_t *p = realloc(l->segs, n * sizeof(lsb_seg_t));
+    if (!p) {
+      return SBDI_ERR_OUT_Of_MEMORY;
+    }
+    for (uint32_t i = l->n_segs; i < n; ++i) {
+      p[i].fd = -1;
+    }
+    l->segs = p;
+    l->n_segs = n;
+  }
+  memset(&l->segs[s], 0, sizeof(lsb_seg_t));
+  l->segs[s].fd = fd;
+  l->segs[s].id = id;
+  *slot = s;
+  return SBDI_SUCCESS;
+}
+
+/*!
+ * \brief Deletes the segment in the given slot
+ *
+ * Must be called with the lock held. Making the removal durable is not
+ * required: a segment that reappears after a crash only holds records that
+ * have been superseded or copied with the same sequence number.
+ *
+ * @param l[in] the log-structured back end
+ * @param s[in] the slot of the segment to delete
+ */
+static void lsb_seg_drop(sbdi_lsb_t *l, uint32_t s)
+{
+  char name[LSB_SEG_NAME_LEN + 1];
+  lsb_seg_name(name, l->segs[s].id);
+  unlinkat(l->dir_fd, name, 0);
+  close(l->segs[s].fd);
+  l->dead -= l->segs[s].recs - l->segs[s].live;
+  l->segs[s].fd = -1;
+}
+
+/*!
+ * \brief Closes the active segment and starts a new one
+ *
+ * Must be called with the lock held. The closed segment is flushed, so
+ * closed segments never hold torn records.
+ *
+ * @param l[in] the log-structured back end
+ * @return SBDI_SUCCESS if the new segment could be created; an error code
+ * otherwise
+ */
+static sbdi_error_t lsb_rotate(sbdi_lsb_t *l)
+{
+  char name[LSB_SEG_NAME_LEN + 1];
+  if (l->active != LSB_NONE && fdatasync(l->segs[l->active].fd)) {
+    return SBDI_ERR_IO;
+  }
+  lsb_seg_name(name, l->next_id);
+  int fd = openat(l->dir_fd, name, O_RDWR | O_CREAT | O_EXCL,
+      S_IRUSR | S_IWUSR);
+  if (fd == -1) {
+    return SBDI_ERR_IO;
+  }
+  uint32_t s = 0;
+  sbdi_error_t r = lsb_seg_add(l, fd, l->next_id, &s);
+  if (r != SBDI_SUCCESS) {
+    close(fd);
+    unlinkat(l->dir_fd, name, 0);
+    return r;
+  }
+  l->next_id += 1;
+  l->active = s;
+  // The directory entry of the new segment has to be durable as well
+  return (fsync(l->dir_fd) == 0) ? SBDI_SUCCESS : SBDI_ERR_IO;
+}
+
+/*!
+ * \brief Appends a record to the active segment and maps the block to it
+ *
+ * Must be called with the lock held.
+ *
+ * @param l[in] the log-structured back end
+ * @param rec[in] the complete record
+ * @param blk[in] the block number of the record
+ * @param seq[in] the sequence number of the record
+ * @return SBDI_SUCCESS if the record could be appended; an error code
+ * otherwise
+ */
+static sbdi_error_t lsb_append(sbdi_lsb_t *l, const uint8_t *rec, uint32_t blk,
+    uint64_t seq)
+{
+  if (l->segs[l->active].size + LSB_REC_TOTAL > SBDI_LSB_SEGMENT_SIZE) {
+    SBDI_ERR_CHK(lsb_rotate(l));
+  }
+  lsb_ent_t *e = lsb_get_ent(l, blk, 1);
+  if (!e) {
+    return SBDI_ERR_OUT_Of_MEMORY;
+  }
+  lsb_seg_t *s = &l->segs[l->active];
+  SBDI_ERR_CHK(lsb_pwrite_full(s->fd, rec, LSB_REC_TOTAL, s->size));
+  lsb_map(l, e, blk, seq, l->active, s->size);
+  s->size += LSB_REC_TOTAL;
+  s->recs += 1;
+  return SBDI_SUCCESS;
+}
+
+//----------------------------------------------------------------------
+static ssize_t lsb_pread_i(void *iod, void *buf, size_t nbyte, off_t offset)
+{
+  sbdi_lsb_t *l = iod;
+  uint8_t *ptr = buf;
+  if (offset < 0 || offset % SBDI_BLOCK_SIZE) {
+    errno = EINVAL;
+    return -1;
+  }
+  size_t done = 0;
+  pthread_mutex_lock(&l->lock);
+  while (done < nbyte) {
+    uint64_t pos = (uint64_t) offset + done;
+    if (pos >= l->dev_end) {
+      break;
+    }
+    size_t n = (nbyte - done > SBDI_BLOCK_SIZE) ? SBDI_BLOCK_SIZE : nbyte - done;
+    lsb_ent_t *e = lsb_get_ent(l, pos / SBDI_BLOCK_SIZE, 0);
+    if (e && e->seq) {
+      if (lsb_pread_full(l->segs[e->seg].fd, ptr + done, n,
+          (uint64_t) e->off + LSB_REC_SIZE) != SBDI_SUCCESS) {
+        pthread_mutex_unlock(&l->lock);
+        errno = EIO;
+        return -1;
+      }
+    } else {
+      // Blocks below the end of the device that were never written
+      memset(ptr + done, 0, n);
+    }
+    done += n;
+  }
+  pthread_mutex_unlock(&l->lock);
+  return done;
+}
+
+//----------------------------------------------------------------------
+static ssize_t lsb_pwrite_i(void *iod, const void *buf, size_t nbyte,
+    off_t offset)
+{
+  sbdi_lsb_t *l = iod;
+  if (offset < 0 || offset % SBDI_BLOCK_SIZE || nbyte != SBDI_BLOCK_SIZE
+      || offset / SBDI_BLOCK_SIZE >= UINT32_MAX) {
+    errno = EINVAL;
+    return -1;
+  }
+  pthread_mutex_lock(&l->lock);
+  const uint64_t seq = l->next_seq++;
+  lsb_build_rec(l->rec, seq, offset, buf);
+  if (lsb_append(l, l->rec, offset / SBDI_BLOCK_SIZE, seq) != SBDI_SUCCESS) {
+    pthread_mutex_unlock(&l->lock);
+    errno = EIO;
+    return -1;
+  }
+  if (l->dead >= LSB_SEG_RECS && !l->clean_req) {
+    l->clean_req = 1;
+    pthread_cond_signal(&l->work);
+  }
+  pthread_mutex_unlock(&l->lock);
+  return nbyte;
+}
+
+//----------------------------------------------------------------------
+static int lsb_flush_i(void *iod)
+{
+  sbdi_lsb_t *l = iod;
+  pthread_mutex_lock(&l->lock);
+  // Closed segments have been flushed when they were closed
+  int r = fdatasync(l->segs[l->active].fd);
+  pthread_mutex_unlock(&l->lock);
+  return r ? -1 : 0;
+}
+
+/*!
+ * \brief Selects the closed segment with the least live records
+ *
+ * Must be called with the lock held.
+ *
+ * @param l[in] the log-structured back end
+ * @return the slot of the segment to clean; LSB_NONE if no closed segment
+ * holds superseded records
+ */
+static uint32_t lsb_pick_victim(sbdi_lsb_t *l)
+{
+  uint32_t v = LSB_NONE;
+  for (uint32_t s = 0; s < l->n_segs; ++s) {
+    lsb_seg_t *g = &l->segs[s];
+    if (g->fd == -1 || s == l->active || g->live == g->recs) {
+      continue;
+    }
+    if (v == LSB_NONE || g->live < l->segs[v].live) {
+      v = s;
+    }
+  }
+  return v;
+}
+
+/*!
+ * \brief Copies the live records of the given closed segment to the active
+ * segment and deletes it
+ *
+ * Runs concurrently to reads, writes and flushes. Closed segments are
+ * immutable and only the cleaner deletes them, so the segment is read
+ * without holding the lock.
+ *
+ * @param l[in] the log-structured back end
+ * @param v[in] the slot of the segment to clean
+ * @param fd[in] the file descriptor of the segment to clean
+ * @param size[in] the number of bytes taken up by valid records
+ * @param buf[in] a buffer of SBDI_LSB_SEGMENT_SIZE bytes
+ * @return SBDI_SUCCESS if the segment could be cleaned; an error code
+ * otherwise
+ */
+static sbdi_error_t lsb_clean(sbdi_lsb_t *l, uint32_t v, int fd, uint32_t size,
+    uint8_t *buf)
+{
+  SBDI_ERR_CHK(lsb_pread_full(fd, buf, size, 0));
+  sbdi_error_t r = SBDI_SUCCESS;
+  for (uint32_t o = 0; o < size && r == SBDI_SUCCESS; o += LSB_REC_TOTAL) {
+    uint64_t seq, off;
+    lsb_parse_rec(buf + o, 0, &seq, &off);
+    pthread_mutex_lock(&l->lock);
+    lsb_ent_t *e = lsb_get_ent(l, off / SBDI_BLOCK_SIZE, 0);
+    if (e && e->seq == seq && e->seg == v && e->off == o) {
+      // The copy keeps the sequence number, so it does not matter which one
+      // recovery finds if the segment survives a crash
+      r = lsb_append(l, buf + o, off / SBDI_BLOCK_SIZE, seq);
+    }
+    pthread_mutex_unlock(&l->lock);
+  }
+  if (r != SBDI_SUCCESS) {
+    return r;
+  }
+  pthread_mutex_lock(&l->lock);
+  // The copies and any newer versions have to be durable before the segment
+  // goes away
+  if (fdatasync(l->segs[l->active].fd)) {
+    r = SBDI_ERR_IO;
+  } else if (l->segs[v].live == 0) {
+    lsb_seg_drop(l, v);
+  }
+  pthread_mutex_unlock(&l->lock);
+  return r;
+}
+
+static void *lsb_thread(void *arg)
+{
+  sbdi_lsb_t *l = arg;
+  uint8_t *buf = NULL;
+  pthread_mutex_lock(&l->lock);
+  while (!l->shutdown) {
+    if (!l->clean_req) {
+      pthread_cond_wait(&l->work, &l->lock);
+      continue;
+    }
+    const uint32_t v = lsb_pick_victim(l);
+    if (v == LSB_NONE || l->dead < LSB_SEG_RECS
+        || (!buf && !(buf = malloc(SBDI_LSB_SEGMENT_SIZE)))) {
+      l->clean_req = 0;
+      continue;
+    }
+    const int fd = l->segs[v].fd;
+    const uint32_t size = l->segs[v].size;
+    pthread_mutex_unlock(&l->lock);
+    sbdi_error_t r = lsb_clean(l, v, fd, size, buf);
+    pthread_mutex_lock(&l->lock);
+    if (r != SBDI_SUCCESS) {
+      // Retried once the next write finds that cleaning is due
+      l->clean_req = 0;
+    }
+  }
+  pthread_mutex_unlock(&l->lock);
+  free(buf);
+  return NULL;
+}
+
+/*!
+ * \brief Adds the valid records of the given segment to the block map
+ *
+ * @param l[in] the log-structured back end
+ * @param slot[in] the slot of the segment to scan
+ * @param buf[in] a buffer of SBDI_LSB_SEGMENT_SIZE bytes
+ * @return SBDI_SUCCESS if the segment could be scanned; an error code
+ * otherwise
+ */
+static sbdi_error_t lsb_scan(sbdi_lsb_t *l, uint32_t slot, uint8_t *buf)
+{
+  lsb_seg_t *s = &l->segs[slot];
+  ssize_t r = pread(s->fd, buf, SBDI_LSB_SEGMENT_SIZE, 0);
+  if (r == -1) {
+    return SBDI_ERR_IO;
+  }
+  uint64_t seq, off;
+  while (s->size + LSB_REC_TOTAL <= (size_t) r
+      && lsb_parse_rec(buf + s->size, 1, &seq, &off)) {
+    lsb_ent_t *e = lsb_get_ent(l, off / SBDI_BLOCK_SIZE, 1);
+    if (!e) {
+      return SBDI_ERR_OUT_Of_MEMORY;
+    }
+    if (seq > e->seq) {
+      lsb_map(l, e, off / SBDI_BLOCK_SIZE, seq, slot, s->size);
+    } else {
+      l->dead += 1;
+    }
+    if (seq >= l->next_seq) {
+      l->next_seq = seq + 1;
+    }
+    s->size += LSB_REC_TOTAL;
+    s->recs += 1;
+  }
+  return SBDI_SUCCESS;
+}
+
+/*!
+ * \brief Rebuilds the block map from the segments in the segment directory
+ * and starts a new active segment
+ *
+ * @param l[in] the log-structured back end
+ * @return SBDI_SUCCESS if the recovery succeeds; an error code otherwise
+ */
+static sbdi_error_t lsb_recover(sbdi_lsb_t *l)
+{
+  uint8_t *buf = malloc(SBDI_LSB_SEGMENT_SIZE);
+  int dfd = dup(l->dir_fd);
+  DIR *d = (dfd == -1) ? NULL : fdopendir(dfd);
+  if (!buf || !d) {
+    if (dfd != -1) {
+      close(dfd);
+    }
+    free(buf);
+    return buf ? SBDI_ERR_IO : SBDI_ERR_OUT_Of_MEMORY;
+  }
+  sbdi_error_t r = SBDI_SUCCESS;
+  struct dirent *ent;
+  while (r == SBDI_SUCCESS && (ent = readdir(d))) {
+    char *end = NULL;
+    if (strlen(ent->d_name) != LSB_SEG_NAME_LEN
+        || strcmp(ent->d_name + 8, ".seg")) {
+      continue;
+    }
+    unsigned long id = strtoul(ent->d_name, &end, 16);
+    if (end != ent->d_name + 8 || id >= UINT32_MAX) {
+      continue;
+    }
+    int fd = openat(l->dir_fd, ent->d_name, O_RDWR);
+    uint32_t slot = 0;
+    if (fd == -1) {
+      r = SBDI_ERR_IO;
+    } else if ((r = lsb_seg_add(l, fd, id, &slot)) != SBDI_SUCCESS) {
+      close(fd);
+    } else {
+      r = lsb_scan(l, slot, buf);
+    }
+    if (id >= l->next_id) {
+      l->next_id = id + 1;
+    }
+  }
+  closedir(d);
+  free(buf);
+  if (r != SBDI_SUCCESS) {
+    return r;
+  }
+  for (uint32_t s = 0; s < l->n_segs; ++s) {
+    if (l->segs[s].fd != -1 && l->segs[s].recs == 0) {
+      lsb_seg_drop(l, s);
+    }
+  }
+  return lsb_rotate(l);
+}
+
+//----------------------------------------------------------------------
+static void lsb_free(sbdi_lsb_t *l)
+{
+  for (uint32_t s = 0; s < l->n_segs; ++s) {
+    if (l->segs[s].fd != -1) {
+      close(l->segs[s].fd);
+    }
+  }
+  close(l->dir_fd);
+  free(l->segs);
+  free(l->ents);
+  memset(l, 0, sizeof(sbdi_lsb_t));
+  free(l);
+}
+
+//----------------------------------------------------------------------
+sbdi_pio_t *sbdi_lsb_create(const char *dir)
+{
+  if (!dir || (mkdir(dir, S_IRWXU) == -1 && errno != EEXIST)) {
+    return NULL;
+  }
+  sbdi_lsb_t *l = calloc(1, sizeof(sbdi_lsb_t));
+  if (!l) {
+    return NULL;
+  }
+  l->active = LSB_NONE;
+  l->next_seq = 1;
+  l->dir_fd = open(dir, O_RDONLY | O_DIRECTORY);
+  if (l->dir_fd == -1) {
+    free(l);
+    return NULL;
+  }
+  if (lsb_recover(l) != SBDI_SUCCESS) {
+    lsb_free(l);
+    return NULL;
+  }
+  if (pthread_mutex_init(&l->lock, NULL)) {
+    lsb_free(l);
+    return NULL;
+  }
+  if (pthread_cond_init(&l->work, NULL)) {
+    pthread_mutex_destroy(&l->lock);
+    lsb_free(l);
+    return NULL;
+  }
+  // Cleaning might already be due
+  l->clean_req = (l->dead >= LSB_SEG_RECS);
+  if (pthread_create(&l->cleaner, NULL, &lsb_thread, l)) {
+    pthread_cond_destroy(&l->work);
+    pthread_mutex_destroy(&l->lock);
+    lsb_free(l);
+    return NULL;
+  }
+  l->pio.iod = l;
+  l->pio.pread = &lsb_pread_i;
+  l->pio.pwrite = &lsb_pwrite_i;
+  l->pio.flush = &lsb_flush_i;
+  l->pio.genseed = &sbdi_pio_generate_seed;
+  return &l->pio;
+}
+
+//----------------------------------------------------------------------
+void sbdi_lsb_delete(sbdi_pio_t *pio)
+{
+  if (!pio) {
+    return;
+  }
+  sbdi_lsb_t *l = pio->iod;
+  pthread_mutex_lock(&l->lock);
+  l->shutdown = 1;
+  pthread_cond_signal(&l->work);
+  pthread_mutex_unlock(&l->lock);
+  pthread_join(l->cleaner, NULL);
+  pthread_cond_destroy(&l->work);
+  pthread_mutex_destroy(&l->lock);
+  lsb_free(l);
+}
@@ -0,0 +1,86 @@
+/* Copyright (c) IAIK, Graz University of Technology, 2015.
+ * All rights reserved.
+ * Contact: http://opensource.iaik.tugraz.at
+ * 
+ * This file is part of the Secure Block Device Library.
+ * 
+ * Commercial License Usage
+ * Licensees holding valid commercial licenses may use this file in
+ * accordance with the commercial license agreement provided with the
+ * Software or, alternatively, in accordance with the terms contained in
+ * a written agreement between you and SIC. For further information
+ * contact us at http://opensource.iaik.tugraz.at.
+ * 
+ * Alternatively, this file may be used under the terms of the GNU General
+ * Public License as published by the Free Software Foundation version 2.
+ * 
+ * The Secure Block Device Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with the Secure Block Device Library. If not, see <http://www.gnu.org/licenses/>.
+ */
+///
+/// \file
+/// \brief Specifies the Secure Block Device Library's log-structured back end.
+///
+/// The log-structured back end is a block device abstraction layer for
+/// storage where appends are cheap but random overwrites are expensive. It
+/// stores blocks in a directory of segment files that are only ever appended
+/// to. Every block write, data and management blocks alike, appends a
+/// checksummed record that carries the block's offset and a sequence number
+/// to the active segment. An in-memory map translates block offsets into
+/// record locations; it is rebuilt from the segments on creation, the latest
+/// sequence number of a block wins.
+///
+/// The map does not need protection of its own: the secure block device
+/// authenticates every block against its offset and the Merkle tree, so a
+/// record that a tampered segment maps to the wrong offset or an outdated
+/// version fails the integrity check like any other modified block.
+///
+/// A background cleaner compacts segments once the space taken up by
+/// overwritten records exceeds one segment. It copies the live records of the
+/// segment with the least live records to the active segment and deletes it.
+///
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef SBDI_LSB_H_
+#define SBDI_LSB_H_
+
+#include "sbdi_config.h"
+#include "sbdi_pio.h"
+
+/*!
+ * \brief Creates a log-structured block device abstraction layer that keeps
+ * its segments in the given directory
+ *
+ * The directory is created if it does not exist. Existing segments are
+ * scanned to rebuild the block map; records torn by a crash are ignored. The
+ * resulting pio supports block aligned reads and writes of whole blocks
+ * only, which is what the secure block device uses. Use sbdi_lsb_delete to
+ * free it.
+ *
+ * @param dir[in] the path of the segment directory
+ * @return a pointer to the log-structured pio if successful; NULL otherwise
+ */
+sbdi_pio_t *sbdi_lsb_create(const char *dir);
+
+/*!
+ * \brief Stops the cleaner, closes all segments and frees the given
+ * log-structured back end
+ *
+ * Blocks written after the last flush might be lost.
+ *
+ * @param pio[in] the log-structured pio to delete (can be NULL)
+ */
+void sbdi_lsb_delete(sbdi_pio_t *pio);
+
+#endif /* SBDI_LSB_H_ */
+
+#ifdef __cplusplus
+}
+#endif
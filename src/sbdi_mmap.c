@@ -0,0 +1,246 @@
+/* Copyright (c) IAIK, Graz University of Technology, 2015.
+ * All rights reserved.
+ * Contact: http://opensource.iaik.tugraz.at
+ * 
+ * This file is part of the Secure Block Device Library.
+ * 
+ * Commercial License Usage
+ * Licensees holding valid commercial licenses may use this file in
+ * accordance with the commercial license agreement provided with the
+ * Software or, alternatively, in accordance with the terms contained in
+ * a written agreement between you and SIC. For further information
+ * contact us at http://opensource.iaik.tugraz.at.
+ * 
+ * Alternatively, this file may be used under the terms of the GNU General
+ * Public License as published by the Free Software Foundation version 2.
+ * 
+ * The Secure Block Device Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with the Secure Block Device Library. If not, see <http://www.gnu.org/licenses/>.
+ */
+///
+/// \file
+/// \brief Implements the Secure Block Device Library's mmap back end.
+///
+/// The mapping covers the file in multiples of SBDI_MMAP_CHUNK_SIZE and is
+/// replaced by a larger one when reads go beyond it. Reads never touch the
+/// mapping beyond the known end of the file, which is the larger of the
+/// file size at creation and the end of the last extending write.
+///
+#include "sbdi_mmap.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#define MM_SEQ_RUN 4u //!< the number of sequential reads that start prefetching
+
+typedef struct sbdi_mmap {
+  sbdi_pio_t pio;            //!< the mmap pio handed out to the user
+  int fd;                    //!< the file descriptor of the backing file
+  size_t page;               //!< the page size
+  pthread_rwlock_t lock;     //!< protects the mapping; held shared while copying
+  uint8_t *map;              //!< the mapping; NULL if not yet mapped
+  size_t map_len;            //!< the length of the mapping
+  pthread_mutex_t state;     //!< protects all of the following fields
+  uint64_t size;             //!< the known end of the file
+  uint64_t next;             //!< the offset following the last read
+  uint32_t run;              //!< the number of consecutive sequential reads
+  uint64_t ahead;            //!< the end of the range prefetched for the current run
+} sbdi_mmap_t;
+
+/*!
+ * \brief Replaces the mapping with one that covers at least the given range
+ *
+ * @param m[in] the mmap back end
+ * @param end[in] the end of the range the mapping has to cover
+ * @return SBDI_SUCCESS if the mapping covers the range; SBDI_ERR_IO
+ * otherwise
+ */
+static sbdi_error_t mm_grow(sbdi_mmap_t *m, uint64_t end)
+{
+  pthread_rwlock_wrlock(&m->lock);
+  if (end <= m->map_len) {
+    // Grown by another reader in the meantime
+    pthread_rwlock_unlock(&m->lock);
+    return SBDI_SUCCESS;
+  }
+  uint64_t len = end + SBDI_MMAP_CHUNK_SIZE - 1;
+  len -= len % SBDI_MMAP_CHUNK_SIZE;
+  if (len > SIZE_MAX) {
+    pthread_rwlock_unlock(&m->lock);
+    return SBDI_ERR_IO;
+  }
+  void *p = mmap(NULL, len, PROT_READ, MAP_SHARED, m->fd, 0);
+  if (p == MAP_FAILED) {
+    pthread_rwlock_unlock(&m->lock);
+    return SBDI_ERR_IO;
+  }
+  // Prefetching is left to the sequential read detection
+  madvise(p, len, MADV_RANDOM);
+  if (m->map) {
+    munmap(m->map, m->map_len);
+  }
+  m->map = p;
+  m->map_len = len;
+  pthread_rwlock_unlock(&m->lock);
+  return SBDI_SUCCESS;
+}
+
+/*!
+ * \brief Tracks the access pattern and determines the range to prefetch
+ *
+ * Must be called with the state lock held.
+ *
+ * @param m[in] the mmap back end
+ * @param off[in] the offset of the read
+ * @param n[in] the number of bytes read
+ * @param pf_end[out] the end of the range to prefetch; 0 if none
+ * @return the start of the range to prefetch
+ */
+static uint64_t mm_pattern(sbdi_mmap_t *m, uint64_t off, size_t n,
+    uint64_t *pf_end)
+{
+  *pf_end = 0;
+  if (off == m->next) {
+    m->run += (m->run < MM_SEQ_RUN);
+  } else {
+    m->run = 0;
+    m->ahead = 0;
+  }
+  m->next = off + n;
+  // Prefetch the next window once half of the current one has been read
+  if (m->run < MM_SEQ_RUN || m->ahead >= m->next + SBDI_MMAP_READAHEAD / 2) {
+    return 0;
+  }
+  const uint64_t start = (m->ahead > m->next) ? m->ahead : m->next;
+  m->ahead = m->next + SBDI_MMAP_READAHEAD;
+  *pf_end = (m->ahead < m->size) ? m->ahead : m->size;
+  return start;
+}
+
+//----------------------------------------------------------------------
+static ssize_t mm_pread_i(void *iod, void *buf, size_t nbyte, off_t offset)
+{
+  sbdi_mmap_t *m = iod;
+  if (offset < 0) {
+    errno = EINVAL;
+    return -1;
+  }
+  uint64_t pf_end = 0;
+  pthread_mutex_lock(&m->state);
+  const uint64_t size = m->size;
+  if ((uint64_t) offset >= size) {
+    pthread_mutex_unlock(&m->state);
+    return 0;
+  }
+  const size_t n = (nbyte > size - offset) ? size - offset : nbyte;
+  uint64_t pf = mm_pattern(m, offset, n, &pf_end);
+  pthread_mutex_unlock(&m->state);
+  pthread_rwlock_rdlock(&m->lock);
+  if (offset + n > m->map_len) {
+    pthread_rwlock_unlock(&m->lock);
+    if (mm_grow(m, offset + n) != SBDI_SUCCESS) {
+      errno = ENOMEM;
+      return -1;
+    }
+    // The mapping never shrinks
+    pthread_rwlock_rdlock(&m->lock);
+  }
+  memcpy(buf, m->map + offset, n);
+  if (pf_end > pf) {
+    pf -= pf % m->page;
+    pf_end = (pf_end > m->map_len) ? m->map_len : pf_end;
+    if (pf_end > pf) {
+      madvise(m->map + pf, pf_end - pf, MADV_WILLNEED);
+    }
+  }
+  pthread_rwlock_unlock(&m->lock);
+  return n;
+}
+
+//----------------------------------------------------------------------
+static ssize_t mm_pwrite_i(void *iod, const void *buf, size_t nbyte,
+    off_t offset)
+{
+  sbdi_mmap_t *m = iod;
+  ssize_t r = pwrite(m->fd, buf, nbyte, offset);
+  if (r > 0) {
+    pthread_mutex_lock(&m->state);
+    if ((uint64_t) offset + r > m->size) {
+      m->size = offset + r;
+    }
+    pthread_mutex_unlock(&m->state);
+  }
+  return r;
+}
+
+//----------------------------------------------------------------------
+static int mm_flush_i(void *iod)
+{
+  sbdi_mmap_t *m = iod;
+  return fdatasync(m->fd);
+}
+
+//----------------------------------------------------------------------
+sbdi_pio_t *sbdi_mmap_create(int fd)
+{
+  struct stat s;
+  long page = sysconf(_SC_PAGESIZE);
+  if (fd < 0 || fstat(fd, &s) || page <= 0) {
+    return NULL;
+  }
+  sbdi_mmap_t *m = calloc(1, sizeof(sbdi_mmap_t));
+  if (!m) {
+    return NULL;
+  }
+  m->fd = fd;
+  m->page = page;
+  m->size = s.st_size;
+  if (pthread_rwlock_init(&m->lock, NULL)) {
+    free(m);
+    return NULL;
+  }
+  if (pthread_mutex_init(&m->state, NULL)) {
+    pthread_rwlock_destroy(&m->lock);
+    free(m);
+    return NULL;
+  }
+  if (m->size && mm_grow(m, m->size) != SBDI_SUCCESS) {
+    pthread_mutex_destroy(&m->state);
+    pthread_rwlock_destroy(&m->lock);
+    free(m);
+    return NULL;
+  }
+  m->pio.iod = m;
+  m->pio.pread = &mm_pread_i;
+  m->pio.pwrite = &mm_pwrite_i;
+  m->pio.flush = &mm_flush_i;
+  m->pio.genseed = &sbdi_pio_generate_seed;
+  return &m->pio;
+}
+
+//----------------------------------------------------------------------
+void sbdi_mmap_delete(sbdi_pio_t *pio)
+{
+  if (!pio) {
+    return;
+  }
+  sbdi_mmap_t *m = pio->iod;
+  if (m->map) {
+    munmap(m->map, m->map_len);
+  }
+  pthread_mutex_destroy(&m->state);
+  pthread_rwlock_destroy(&m->lock);
+  memset(m, 0, sizeof(sbdi_mmap_t));
+  free(m);
+}
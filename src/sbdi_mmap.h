@@ -0,0 +1,75 @@
+/* Copyright (c) IAIK, Graz University of Technology, 2015.
+ * All rights reserved.
+ * Contact: http://opensource.iaik.tugraz.at
+ * 
+ * This file is part of the Secure Block Device Library.
+ * 
+ * Commercial License Usage
+ * Licensees holding valid commercial licenses may use this file in
+ * accordance with the commercial license agreement provided with the
+ * Software or, alternatively, in accordance with the terms contained in
+ * a written agreement between you and SIC. For further information
+ * contact us at http://opensource.iaik.tugraz.at.
+ * 
+ * Alternatively, this file may be used under the terms of the GNU General
+ * Public License as published by the Free Software Foundation version 2.
+ * 
+ * The Secure Block Device Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with the Secure Block Device Library. If not, see <http://www.gnu.org/licenses/>.
+ */
+///
+/// \file
+/// \brief Specifies the Secure Block Device Library's mmap back end.
+///
+/// The mmap back end is a block device abstraction layer for read-heavy
+/// devices on local file systems. It maps the backing file into memory and
+/// serves reads by copying straight from the mapping, so reads of cached
+/// blocks do not cost a system call. Writes and flushes still use pwrite and
+/// fdatasync; the mapping is shared and thus sees them through the page
+/// cache.
+///
+/// The mapping is advised as randomly accessed, which keeps the kernel from
+/// reading ahead on every page fault. Once a run of sequential reads is
+/// detected, the back end asks the kernel to prefetch SBDI_MMAP_READAHEAD
+/// bytes ahead of the reader.
+///
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef SBDI_MMAP_H_
+#define SBDI_MMAP_H_
+
+#include "sbdi_config.h"
+#include "sbdi_pio.h"
+
+/*!
+ * \brief Creates an mmap block device abstraction layer on top of the given
+ * file
+ *
+ * The file must be opened for reading and writing, and must not be
+ * truncated by anyone else while the pio exists. Use sbdi_mmap_delete to
+ * free the pio; the file descriptor remains owned by the caller.
+ *
+ * @param fd[in] the file descriptor of the backing file
+ * @return a pointer to the mmap pio if successful; NULL otherwise
+ */
+sbdi_pio_t *sbdi_mmap_create(int fd);
+
+/*!
+ * \brief Unmaps the backing file and frees the given mmap pio
+ *
+ * @param pio[in] the mmap pio to delete (can be NULL)
+ */
+void sbdi_mmap_delete(sbdi_pio_t *pio);
+
+#endif /* SBDI_MMAP_H_ */
+
+#ifdef __cplusplus
+}
+#endif
@@ -27,9 +27,10 @@
 /// \brief An implementation of the Secure Block Device Libarary's block
 /// device abstraction layer that uses files as storage back end.
 ///
-
+#define _GNU_SOURCE 1
 #include "sbdi_pio.h"
 
+#include <errno.h>
 #include <unistd.h>
 #include <stdlib.h>
 #include <fcntl.h>
@@ -49,7 +50,33 @@ static ssize_t bl_pwrite_i(void *iod, const void * buf, size_t nbyte, off_t offs
 }
 
 //----------------------------------------------------------------------
-static ssize_t bl_generate_seed_i(uint8_t *buf, size_t nbyte)
+static int bl_flush_i(void *iod)
+{
+  int fd = *((int *)iod);
+  return fdatasync(fd);
+}
+
+//----------------------------------------------------------------------
+static int bl_discard_i(void *iod, off_t offset, size_t nbyte)
+{
+  int fd = *((int *)iod);
+  if (fallocate(fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, offset,
+      nbyte) == -1) {
+    // The file system cannot punch holes ==> keep the storage
+    return (errno == EOPNOTSUPP || errno == ENOSYS) ? 0 : -1;
+  }
+  return 0;
+}
+
+//----------------------------------------------------------------------
+static int bl_truncate_i(void *iod, off_t length)
+{
+  int fd = *((int *)iod);
+  return ftruncate(fd, length);
+}
+
+//----------------------------------------------------------------------
+ssize_t sbdi_pio_generate_seed(uint8_t *buf, size_t nbyte)
 {
   int rfh = open("/dev/random", O_RDONLY);
   if (rfh < 0) {
@@ -78,7 +105,10 @@ sbdi_pio_t *sbdi_pio_create(void *iod, off_t size_at_open)
   io->iod = iod;
   io->pread = &bl_pread_i;
   io->pwrite = &bl_pwrite_i;
-  io->genseed = &bl_generate_seed_i;
+  io->genseed = &sbdi_pio_generate_seed;
+  io->flush = &bl_flush_i;
+  io->discard = &bl_discard_i;
+  io->truncate = &bl_truncate_i;
   return io;
 }
 
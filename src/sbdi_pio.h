@@ -81,6 +81,68 @@ typedef ssize_t (*bl_pwrite)(void *iod, const void * buf, size_t nbyte,
  */
 typedef ssize_t (*bl_generate_seed)(uint8_t *buf, size_t nbyte);
 
+/*!
+ * \brief Defines a fdatasync like function pointer
+ *
+ * The function has to make all data previously written through the pwrite
+ * function durable, i.e. it has to survive a crash or power loss once the
+ * function returns.
+ *
+ * @param iod[in] a pointer to the I/O descriptor, e.g. a pointer to a file
+ *                descriptor
+ * @return 0 if successful; -1 otherwise
+ */
+typedef int (*bl_flush)(void *iod);
+
+/*!
+ * \brief Defines a function pointer for a function that marks a consistent
+ * state of the back end
+ *
+ * The secure block device calls this function during a sync while it still
+ * holds the device lock, after the complete state of the sync has been
+ * written and before the flush that makes it durable. Back ends that make
+ * groups of writes durable atomically, like the write-ahead log, close the
+ * current group here. Writes issued after the call belong to the next group,
+ * even if they reach the back end before the flush.
+ *
+ * @param iod[in] a pointer to the I/O descriptor, e.g. a pointer to a file
+ *                descriptor
+ * @return 0 if successful; -1 otherwise
+ */
+typedef int (*bl_commit)(void *iod);
+
+/*!
+ * \brief Defines a function pointer similar to fallocate with
+ * FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE
+ *
+ * The function releases the storage of the given range without changing the
+ * size of the back end. The secure block device only discards whole data
+ * blocks it no longer needs and never reads them from the back end again, so
+ * discarding is best effort: a back end that cannot release the range, e.g.
+ * because the file system does not support hole punching, keeps the data and
+ * returns 0. Only return -1 on actual I/O errors.
+ *
+ * @param iod[in] a pointer to the I/O descriptor, e.g. a pointer to a file
+ *                descriptor
+ * @param offset[in] the offset of the range to discard
+ * @param nbyte[in] the length of the range to discard
+ * @return 0 if successful; -1 otherwise
+ */
+typedef int (*bl_discard)(void *iod, off_t offset, size_t nbyte);
+
+/*!
+ * \brief Defines a ftruncate like function pointer
+ *
+ * The function sets the size of the back end to the given length. The
+ * secure block device only uses it to shrink the back end.
+ *
+ * @param iod[in] a pointer to the I/O descriptor, e.g. a pointer to a file
+ *                descriptor
+ * @param length[in] the new size of the back end
+ * @return 0 if successful; -1 otherwise
+ */
+typedef int (*bl_truncate)(void *iod, off_t length);
+
 /*!
  * \brief wrapper data type to hide pread and pwrite implementation
  */
@@ -89,6 +151,10 @@ typedef struct sbdi_pio {
   bl_pread pread;    //!< pread like function pointer
   bl_pwrite pwrite;  //!< pwrite like function pointer
   bl_generate_seed genseed; //!< function pointer to seed generator function
+  bl_flush flush;    //!< fdatasync like function pointer (optional, can be NULL)
+  bl_commit commit; //!< marks a consistent state to flush (optional, can be NULL)
+  bl_discard discard; //!< hole punching function pointer (optional, can be NULL)
+  bl_truncate truncate; //!< ftruncate like function pointer (optional, can be NULL)
 } sbdi_pio_t;
 
 /*!
@@ -104,6 +170,19 @@ typedef struct sbdi_pio {
  */
 sbdi_pio_t *sbdi_pio_create(void *iod, off_t size_at_open);
 
+/*!
+ * \brief generates random seed bytes from the operating system's random
+ * number generator
+ *
+ * This is the seed generator used by pio types created with sbdi_pio_create.
+ * Back ends that do not wrap such a pio type can use it as well.
+ *
+ * @param buf[out] a pointer to the buffer to fill with random bytes
+ * @param nbyte[in] the number of random bytes to generate
+ * @return the number of random bytes generated if successful; -1 otherwise
+ */
+ssize_t sbdi_pio_generate_seed(uint8_t *buf, size_t nbyte);
+
 /*!
  * \brief frees the memory allocated for the given pio type
  *
@@ -0,0 +1,180 @@
+/* Copyright (c) IAIK, Graz University of Technology, 2015.
+ * All rights reserved.
+ * Contact: http://opensource.iaik.tugraz.at
+ * 
+ * This file is part of the Secure Block Device Library.
+ * 
+ * Commercial License Usage
+ * Licensees holding valid commercial licenses may use this file in
+ * accordance with the commercial license agreement provided with the
+ * Software or, alternatively, in accordance with the terms contained in
+ * a written agreement between you and SIC. For further information
+ * contact us at http://opensource.iaik.tugraz.at.
+ * 
+ * Alternatively, this file may be used under the terms of the GNU General
+ * Public License as published by the Free Software Foundation version 2.
+ * 
+ * The Secure Block Device Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with the Secure Block Device Library. If not, see <http://www.gnu.org/licenses/>.
+ */
+///
+/// \file
+/// \brief Implements the Secure Block Device Library's in-memory back end.
+///
+#include "sbdi_ram.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#define RAM_MIN_CAPACITY (64u * 1024u) //!< the initial capacity of the buffer
+
+typedef struct sbdi_ram {
+  sbdi_pio_t pio;            //!< the in-memory pio handed out to the user
+  pthread_rwlock_t lock;     //!< protects all of the following fields
+  uint8_t *data;             //!< the buffer; zero beyond size
+  size_t size;               //!< the end of the written data
+  size_t cap;                //!< the capacity of the buffer
+} sbdi_ram_t;
+
+//----------------------------------------------------------------------
+static ssize_t ram_pread_i(void *iod, void *buf, size_t nbyte, off_t offset)
+{
+  sbdi_ram_t *m = iod;
+  if (offset < 0) {
+    errno = EINVAL;
+    return -1;
+  }
+  pthread_rwlock_rdlock(&m->lock);
+  size_t n = 0;
+  if ((uint64_t) offset < m->size) {
+    n = (nbyte > m->size - offset) ? m->size - offset : nbyte;
+    memcpy(buf, m->data + offset, n);
+  }
+  pthread_rwlock_unlock(&m->lock);
+  return n;
+}
+
+//----------------------------------------------------------------------
+static ssize_t ram_pwrite_i(void *iod, const void *buf, size_t nbyte,
+    off_t offset)
+{
+  sbdi_ram_t *m = iod;
+  if (offset < 0 || (uint64_t) offset + nbyte > SIZE_MAX / 2) {
+    errno = EINVAL;
+    return -1;
+  }
+  const size_t end = offset + nbyte;
+  pthread_rwlock_wrlock(&m->lock);
+  if (end > m->cap) {
+    size_t cap = m->cap ? m->cap : RAM_MIN_CAPACITY;
+    while (cap < end) {
+      cap *= 2;
+    }
+    uint8_t *d = realloc(m->data, cap);
+    if (!d) {
+      pthread_rwlock_unlock(&m->lock);
+      errno = ENOMEM;
+      return -1;
+    }
+    memset(d + m->cap, 0, cap - m->cap);
+    m->data = d;
+    m->cap = cap;
+  }
+  memcpy(m->data + offset, buf, nbyte);
+  if (end > m->size) {
+    m->size = end;
+  }
+  pthread_rwlock_unlock(&m->lock);
+  return nbyte;
+}
+
+//----------------------------------------------------------------------
+static int ram_discard_i(void *iod, off_t offset, size_t nbyte)
+{
+  sbdi_ram_t *m = iod;
+  if (offset < 0) {
+    errno = EINVAL;
+    return -1;
+  }
+  pthread_rwlock_wrlock(&m->lock);
+  if ((uint64_t) offset < m->size) {
+    memset(m->data + offset, 0,
+        (nbyte > m->size - offset) ? m->size - offset : nbyte);
+  }
+  pthread_rwlock_unlock(&m->lock);
+  return 0;
+}
+
+//----------------------------------------------------------------------
+static int ram_truncate_i(void *iod, off_t length)
+{
+  sbdi_ram_t *m = iod;
+  if (length < 0) {
+    errno = EINVAL;
+    return -1;
+  }
+  pthread_rwlock_wrlock(&m->lock);
+  if ((uint64_t) length > m->cap) {
+    // Growing beyond the capacity is not needed by the secure block device
+    pthread_rwlock_unlock(&m->lock);
+    errno = EINVAL;
+    return -1;
+  } else if ((size_t) length < m->size) {
+    // Keep the buffer zero beyond size
+    memset(m->data + length, 0, m->size - length);
+  }
+  m->size = length;
+  pthread_rwlock_unlock(&m->lock);
+  return 0;
+}
+
+//----------------------------------------------------------------------
+sbdi_pio_t *sbdi_ram_create(void)
+{
+  sbdi_ram_t *m = calloc(1, sizeof(sbdi_ram_t));
+  if (!m) {
+    return NULL;
+  }
+  if (pthread_rwlock_init(&m->lock, NULL)) {
+    free(m);
+    return NULL;
+  }
+  m->pio.iod = m;
+  m->pio.pread = &ram_pread_i;
+  m->pio.pwrite = &ram_pwrite_i;
+  m->pio.flush = NULL;
+  m->pio.discard = &ram_discard_i;
+  m->pio.truncate = &ram_truncate_i;
+  m->pio.genseed = &sbdi_pio_generate_seed;
+  return &m->pio;
+}
+
+//----------------------------------------------------------------------
+size_t sbdi_ram_size(const sbdi_pio_t *pio)
+{
+  sbdi_ram_t *m = pio->iod;
+  pthread_rwlock_rdlock(&m->lock);
+  size_t s = m->size;
+  pthread_rwlock_unlock(&m->lock);
+  return s;
+}
+
+//----------------------------------------------------------------------
+void sbdi_ram_delete(sbdi_pio_t *pio)
+{
+  if (!pio) {
+    return;
+  }
+  sbdi_ram_t *m = pio->iod;
+  pthread_rwlock_destroy(&m->lock);
+  free(m->data);
+  memset(m, 0, sizeof(sbdi_ram_t));
+  free(m);
+}
@@ -0,0 +1,76 @@
+/* Copyright (c) IAIK, Graz University of Technology, 2015.
+ * All rights reserved.
+ * Contact: http://opensource.iaik.tugraz.at
+ * 
+ * This file is part of the Secure Block Device Library.
+ * 
+ * Commercial License Usage
+ * Licensees holding valid commercial licenses may use this file in
+ * accordance with the commercial license agreement provided with the
+ * Software or, alternatively, in accordance with the terms contained in
+ * a written agreement between you and SIC. For further information
+ * contact us at http://opensource.iaik.tugraz.at.
+ * 
+ * Alternatively, this file may be used under the terms of the GNU General
+ * Public License as published by the Free Software Foundation version 2.
+ * 
+ * The Secure Block Device Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with the Secure Block Device Library. If not, see <http://www.gnu.org/licenses/>.
+ */
+///
+/// \file
+/// \brief Specifies the Secure Block Device Library's in-memory back end.
+///
+/// The in-memory back end keeps the whole device in a growable buffer. It is
+/// meant for tests and for benchmarking the processing of the secure block
+/// device without any storage costs. Combine it with the latency injecting
+/// back end (see sbdi_lat.h) to model slow storage.
+///
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef SBDI_RAM_H_
+#define SBDI_RAM_H_
+
+#include "sbdi_config.h"
+#include "sbdi_pio.h"
+
+/*!
+ * \brief Creates an empty in-memory block device abstraction layer
+ *
+ * The pio behaves like an initially empty file: reads beyond the end of the
+ * written data come up short, and writes beyond the end grow the buffer and
+ * fill any gap with zeros. It has no flush function, as there is nothing to
+ * make durable. Discarding a range or truncating zeroes the affected bytes
+ * but keeps the memory. Use sbdi_ram_delete to free it.
+ *
+ * @return a pointer to the in-memory pio if successful; NULL otherwise
+ */
+sbdi_pio_t *sbdi_ram_create(void);
+
+/*!
+ * \brief Gets the size of the data written to the given in-memory pio
+ *
+ * @param pio[in] the in-memory pio
+ * @return the end of the written data in bytes
+ */
+size_t sbdi_ram_size(const sbdi_pio_t *pio);
+
+/*!
+ * \brief Frees the given in-memory pio and its data
+ *
+ * @param pio[in] the in-memory pio to delete (can be NULL)
+ */
+void sbdi_ram_delete(sbdi_pio_t *pio);
+
+#endif /* SBDI_RAM_H_ */
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,421 @@
+/* Copyright (c) IAIK, Graz University of Technology, 2015.
+ * All rights reserved.
+ * Contact: http://opensource.iaik.tugraz.at
+ * 
+ * This file is part of the Secure Block Device Library.
+ * 
+ * Commercial License Usage
+ * Licensees holding valid commercial licenses may use this file in
+ * accordance with the commercial license agreement provided with the
+ * Software or, alternatively, in accordance with the terms contained in
+ * a written agreement between you and SIC. For further information
+ * contact us at http://opensource.iaik.tugraz.at.
+ * 
+ * Alternatively, this file may be used under the terms of the GNU General
+ * Public License as published by the Free Software Foundation version 2.
+ * 
+ * The Secure Block Device Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with the Secure Block Device Library. If not, see <http://www.gnu.org/licenses/>.
+ */
+///
+/// \file
+/// \brief Implements the Secure Block Device Library's segment file back end.
+///
+/// Segment files are named after their hexadecimal segment number. Segment
+/// k > 0 holds the physical blocks starting at 1 + k * SEG_BLKS, segment 0
+/// holds the header and the blocks up to and including SEG_BLKS. Open
+/// segment files are reference counted while in use and the least recently
+/// used idle one is closed when another segment needs to be opened.
+///
+#include "sbdi_seg.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#define SEG_BLKS     ((uint64_t) SBDI_SEG_GROUPS * (SBDI_MNGT_BLOCK_ENTRIES + 1u)) //!< the blocks of a segment (apart from the header)
+#define SEG_NAME_LEN 12u //!< the length of a segment file name
+#define SEG_NONE     UINT32_MAX
+
+#if SBDI_SEG_GROUPS == 0 || SBDI_SEG_OPEN_FILES == 0
+#error "segment files must hold at least one group and one must be kept open"
+#endif
+
+/*!
+ * \brief an open segment file
+ */
+typedef struct sbdi_seg_file {
+  uint32_t id;   //!< the segment number; SEG_NONE if the slot is free
+  int fd;        //!< the file descriptor of the segment file
+  uint32_t refs; //!< the number of requests currently using the file
+  int dirty;     //!< set if the file was written to since its last sync
+  uint64_t used; //!< the time of the last use, for finding the LRU file
+} seg_file_t;
+
+typedef struct sbdi_seg {
+  sbdi_pio_t pio;          //!< the segment file pio handed out to the user
+  int dir_fd;              //!< the file descriptor of the segment directory
+  pthread_mutex_t lock;    //!< protects everything below
+  pthread_cond_t idle;     //!< signalled when a file is no longer in use
+  seg_file_t files[SBDI_SEG_OPEN_FILES]; //!< the open segment files
+  uint64_t tick;           //!< the use counter
+  int dir_dirty;           //!< set if segment files were created since the last sync
+  uint64_t dev_end;        //!< the end of the device
+} sbdi_seg_t;
+
+//----------------------------------------------------------------------
+static inline uint64_t seg_start(uint32_t id)
+{
+  return (id == 0) ? 0 : (1 + id * SEG_BLKS) * SBDI_BLOCK_SIZE;
+}
+
+//----------------------------------------------------------------------
+static inline uint32_t seg_of(uint64_t off)
+{
+  const uint64_t blk = off / SBDI_BLOCK_SIZE;
+  return (blk <= SEG_BLKS) ? 0 : (blk - 1) / SEG_BLKS;
+}
+
+//----------------------------------------------------------------------
+static void seg_name(char *name, uint32_t id)
+{
+  snprintf(name, SEG_NAME_LEN + 1, "%08x.seg", id);
+}
+
+/*!
+ * \brief Gets an open file for the given segment
+ *
+ * Reuses the file if it is open already. Otherwise the least recently used
+ * idle file is closed, after waiting for one to become idle if necessary.
+ * Must be called with the lock held.
+ *
+ * @param s[in] the segment file back end
+ * @param id[in] the segment number
+ * @param create[in] create the segment file if it does not exist
+ * @param f[out] the open file; NULL if the segment does not exist
+ * @return 0 if successful; -1 otherwise
+ */
+static int seg_get(sbdi_seg_t *s, uint32_t id, int create, seg_file_t **f)
+{
+  for (;;) {
+    seg_file_t *victim = NULL;
+    for (uint32_t i = 0; i < SBDI_SEG_OPEN_FILES; ++i) {
+      seg_file_t *c = &s->files[i];
+      if (c->id == id) {
+        c->refs += 1;
+        c->used = ++s->tick;
+        *f = c;
+        return 0;
+      } else if (c->refs == 0 && (!victim || c->id == SEG_NONE
+          || (victim->id != SEG_NONE && c->used < victim->used))) {
+        victim = c;
+      }
+    }
+    if (!victim) {
+      pthread_cond_wait(&s->idle, &s->lock);
+      continue;
+    }
+    if (victim->id != SEG_NONE) {
+      // Closing a file must not lose what the next flush has to make durable
+      if (victim->dirty && fdatasync(victim->fd) == -1) {
+        return -1;
+      }
+      close(victim->fd);
+      victim->id = SEG_NONE;
+    }
+    char name[SEG_NAME_LEN + 1];
+    seg_name(name, id);
+    int fd = openat(s->dir_fd, name, O_RDWR);
+    if (fd == -1 && errno == ENOENT && create) {
+      fd = openat(s->dir_fd, name, O_RDWR | O_CREAT, S_IRUSR | S_IWUSR);
+      s->dir_dirty = 1;
+    }
+    if (fd == -1) {
+      *f = NULL;
+      return (errno == ENOENT && !create) ? 0 : -1;
+    }
+    victim->id = id;
+    victim->fd = fd;
+    victim->refs = 1;
+    victim->dirty = 0;
+    victim->used = ++s->tick;
+    *f = victim;
+    return 0;
+  }
+}
+
+/*!
+ * \brief Releases a file gotten with seg_get; must be called with the lock
+ * held
+ *
+ * @param s[in] the segment file back end
+ * @param f[in] the file to release
+ * @param wrote[in] set if the file was written to
+ */
+static void seg_put(sbdi_seg_t *s, seg_file_t *f, int wrote)
+{
+  f->dirty |= wrote;
+  if (--f->refs == 0) {
+    pthread_cond_broadcast(&s->idle);
+  }
+}
+
+/*!
+ * \brief Reads or writes a range that lies within a single segment
+ *
+ * @param s[in] the segment file back end
+ * @param write[in] set to write, clear to read
+ * @param buf[in] the buffer
+ * @param nbyte[in] the length of the range
+ * @param off[in] the device offset of the range
+ * @return 0 if successful; -1 otherwise
+ */
+static int seg_rw(sbdi_seg_t *s, int write, uint8_t *buf, size_t nbyte,
+    uint64_t off)
+{
+  const uint32_t id = seg_of(off);
+  seg_file_t *f = NULL;
+  pthread_mutex_lock(&s->lock);
+  int r = seg_get(s, id, write, &f);
+  pthread_mutex_unlock(&s->lock);
+  if (r == -1) {
+    return -1;
+  } else if (!f) {
+    // A missing segment below the end of the device is a hole
+    memset(buf, 0, nbyte);
+    return 0;
+  }
+  const uint64_t loc = off - seg_start(id);
+  size_t done = 0;
+  ssize_t k = 0;
+  while (done < nbyte) {
+    k = write ?
+        pwrite(f->fd, buf + done, nbyte - done, loc + done) :
+        pread(f->fd, buf + done, nbyte - done, loc + done);
+    if (k <= 0) {
+      break;
+    }
+    done += k;
+  }
+  if (!write && k == 0) {
+    memset(buf + done, 0, nbyte - done);
+    done = nbyte;
+  }
+  pthread_mutex_lock(&s->lock);
+  seg_put(s, f, write);
+  pthread_mutex_unlock(&s->lock);
+  return (done == nbyte) ? 0 : -1;
+}
+
+/*!
+ * \brief Splits a request at segment boundaries
+ *
+ * @param s[in] the segment file back end
+ * @param write[in] set to write, clear to read
+ * @param buf[in] the buffer
+ * @param nbyte[in] the length of the request
+ * @param off[in] the device offset of the request
+ * @return 0 if successful; -1 otherwise
+ */
+static int seg_request(sbdi_seg_t *s, int write, uint8_t *buf, size_t nbyte,
+    uint64_t off)
+{
+  size_t done = 0;
+  while (done < nbyte) {
+    const uint64_t end = seg_start(seg_of(off + done) + 1);
+    const size_t len =
+        (nbyte - done > end - off - done) ? end - off - done : nbyte - done;
+    if (seg_rw(s, write, buf + done, len, off + done) == -1) {
+      return -1;
+    }
+    done += len;
+  }
+  return 0;
+}
+
+//----------------------------------------------------------------------
+static ssize_t seg_pread_i(void *iod, void *buf, size_t nbyte, off_t offset)
+{
+  sbdi_seg_t *s = iod;
+  if (offset < 0) {
+    errno = EINVAL;
+    return -1;
+  }
+  pthread_mutex_lock(&s->lock);
+  const uint64_t end = s->dev_end;
+  pthread_mutex_unlock(&s->lock);
+  if ((uint64_t) offset >= end) {
+    return 0;
+  }
+  const size_t n = (nbyte > end - offset) ? end - offset : nbyte;
+  return (seg_request(s, 0, buf, n, offset) == -1) ? -1 : (ssize_t) n;
+}
+
+//----------------------------------------------------------------------
+static ssize_t seg_pwrite_i(void *iod, const void *buf, size_t nbyte,
+    off_t offset)
+{
+  sbdi_seg_t *s = iod;
+  if (offset < 0) {
+    errno = EINVAL;
+    return -1;
+  }
+  if (seg_request(s, 1, (uint8_t *) buf, nbyte, offset) == -1) {
+    return -1;
+  }
+  pthread_mutex_lock(&s->lock);
+  if ((uint64_t) offset + nbyte > s->dev_end) {
+    s->dev_end = offset + nbyte;
+  }
+  pthread_mutex_unlock(&s->lock);
+  return nbyte;
+}
+
+//----------------------------------------------------------------------
+static int seg_flush_i(void *iod)
+{
+  sbdi_seg_t *s = iod;
+  seg_file_t *dirty[SBDI_SEG_OPEN_FILES];
+  uint32_t n = 0;
+  pthread_mutex_lock(&s->lock);
+  for (uint32_t i = 0; i < SBDI_SEG_OPEN_FILES; ++i) {
+    if (s->files[i].id != SEG_NONE && s->files[i].dirty) {
+      s->files[i].dirty = 0;
+      s->files[i].refs += 1;
+      dirty[n++] = &s->files[i];
+    }
+  }
+  const int dir_dirty = s->dir_dirty;
+  s->dir_dirty = 0;
+  pthread_mutex_unlock(&s->lock);
+  int r = 0;
+  for (uint32_t i = 0; i < n; ++i) {
+    const int failed = (fdatasync(dirty[i]->fd) == -1);
+    pthread_mutex_lock(&s->lock);
+    seg_put(s, dirty[i], failed);
+    pthread_mutex_unlock(&s->lock);
+    r = failed ? -1 : r;
+  }
+  // New segment files are only durable once their directory entry is
+  if (dir_dirty && fsync(s->dir_fd) == -1) {
+    pthread_mutex_lock(&s->lock);
+    s->dir_dirty = 1;
+    pthread_mutex_unlock(&s->lock);
+    r = -1;
+  }
+  return r;
+}
+
+/*!
+ * \brief Determines the end of the device from the last segment file
+ *
+ * @param s[in] the segment file back end
+ * @return 0 if successful; -1 otherwise
+ */
+static int seg_scan(sbdi_seg_t *s)
+{
+  int dfd = dup(s->dir_fd);
+  DIR *d = (dfd == -1) ? NULL : fdopendir(dfd);
+  if (!d) {
+    if (dfd != -1) {
+      close(dfd);
+    }
+    return -1;
+  }
+  uint32_t last = SEG_NONE;
+  struct dirent *ent;
+  while ((ent = readdir(d))) {
+    char *end = NULL;
+    if (strlen(ent->d_name) != SEG_NAME_LEN
+        || strcmp(ent->d_name + 8, ".seg")) {
+      continue;
+    }
+    unsigned long id = strtoul(ent->d_name, &end, 16);
+    if (end != ent->d_name + 8 || id >= UINT32_MAX) {
+      continue;
+    }
+    last = (last == SEG_NONE || id > last) ? id : last;
+  }
+  closedir(d);
+  if (last == SEG_NONE) {
+    return 0;
+  }
+  char name[SEG_NAME_LEN + 1];
+  struct stat st;
+  seg_name(name, last);
+  if (fstatat(s->dir_fd, name, &st, 0) == -1) {
+    return -1;
+  }
+  s->dev_end = seg_start(last) + st.st_size;
+  return 0;
+}
+
+//----------------------------------------------------------------------
+sbdi_pio_t *sbdi_seg_create(const char *dir)
+{
+  if (!dir || (mkdir(dir, S_IRWXU) == -1 && errno != EEXIST)) {
+    return NULL;
+  }
+  sbdi_seg_t *s = calloc(1, sizeof(sbdi_seg_t));
+  if (!s) {
+    return NULL;
+  }
+  for (uint32_t i = 0; i < SBDI_SEG_OPEN_FILES; ++i) {
+    s->files[i].id = SEG_NONE;
+    s->files[i].fd = -1;
+  }
+  s->dir_fd = open(dir, O_RDONLY | O_DIRECTORY);
+  if (s->dir_fd == -1) {
+    free(s);
+    return NULL;
+  }
+  if (seg_scan(s) == -1 || pthread_mutex_init(&s->lock, NULL)) {
+    close(s->dir_fd);
+    free(s);
+    return NULL;
+  }
+  if (pthread_cond_init(&s->idle, NULL)) {
+    pthread_mutex_destroy(&s->lock);
+    close(s->dir_fd);
+    free(s);
+    return NULL;
+  }
+  s->pio.iod = s;
+  s->pio.pread = &seg_pread_i;
+  s->pio.pwrite = &seg_pwrite_i;
+  s->pio.flush = &seg_flush_i;
+  s->pio.genseed = &sbdi_pio_generate_seed;
+  return &s->pio;
+}
+
+//----------------------------------------------------------------------
+void sbdi_seg_delete(sbdi_pio_t *pio)
+{
+  if (!pio) {
+    return;
+  }
+  sbdi_seg_t *s = pio->iod;
+  seg_flush_i(s);
+  for (uint32_t i = 0; i < SBDI_SEG_OPEN_FILES; ++i) {
+    if (s->files[i].id != SEG_NONE) {
+      close(s->files[i].fd);
+    }
+  }
+  pthread_cond_destroy(&s->idle);
+  pthread_mutex_destroy(&s->lock);
+  close(s->dir_fd);
+  memset(s, 0, sizeof(sbdi_seg_t));
+  free(s);
+}
@@ -0,0 +1,76 @@
+/* Copyright (c) IAIK, Graz University of Technology, 2015.
+ * All rights reserved.
+ * Contact: http://opensource.iaik.tugraz.at
+ * 
+ * This file is part of the Secure Block Device Library.
+ * 
+ * Commercial License Usage
+ * Licensees holding valid commercial licenses may use this file in
+ * accordance with the commercial license agreement provided with the
+ * Software or, alternatively, in accordance with the terms contained in
+ * a written agreement between you and SIC. For further information
+ * contact us at http://opensource.iaik.tugraz.at.
+ * 
+ * Alternatively, this file may be used under the terms of the GNU General
+ * Public License as published by the Free Software Foundation version 2.
+ * 
+ * The Secure Block Device Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with the Secure Block Device Library. If not, see <http://www.gnu.org/licenses/>.
+ */
+///
+/// \file
+/// \brief Specifies the Secure Block Device Library's segment file back end.
+///
+/// The segment file back end stores the physical blocks of a secure block
+/// device in a directory of fixed size segment files, each holding
+/// SBDI_SEG_GROUPS whole management groups. The first segment additionally
+/// holds the header block in front of its groups. A write only touches the
+/// segment files it falls into, which suits storage that transfers or
+/// versions whole files, e.g. cloud drives and object stores.
+///
+/// Segment files are created on their first write; missing segments below
+/// the end of the device read as zeros. A small number of recently used
+/// segment files is kept open.
+///
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef SBDI_SEG_H_
+#define SBDI_SEG_H_
+
+#include "sbdi_config.h"
+#include "sbdi_pio.h"
+
+/*!
+ * \brief Creates a segment file block device abstraction layer that keeps
+ * its segments in the given directory
+ *
+ * The directory is created if it does not exist. The end of the device is
+ * determined from the last existing segment. Use sbdi_seg_delete to free
+ * the pio.
+ *
+ * @param dir[in] the path of the segment directory
+ * @return a pointer to the segment file pio if successful; NULL otherwise
+ */
+sbdi_pio_t *sbdi_seg_create(const char *dir);
+
+/*!
+ * \brief Closes all segment files and frees the given segment file back end
+ *
+ * Segment files that were written to are synchronized before closing them.
+ *
+ * @param pio[in] the segment file pio to delete (can be NULL)
+ */
+void sbdi_seg_delete(sbdi_pio_t *pio);
+
+#endif /* SBDI_SEG_H_ */
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,367 @@
+/* Copyright (c) IAIK, Graz University of Technology, 2015.
+ * All rights reserved.
+ * Contact: http://opensource.iaik.tugraz.at
+ * 
+ * This file is part of the Secure Block Device Library.
+ * 
+ * Commercial License Usage
+ * Licensees holding valid commercial licenses may use this file in
+ * accordance with the commercial license agreement provided with the
+ * Software or, alternatively, in accordance with the terms contained in
+ * a written agreement between you and SIC. For further information
+ * contact us at http://opensource.iaik.tugraz.at.
+ * 
+ * Alternatively, this file may be used under the terms of the GNU General
+ * Public License as published by the Free Software Foundation version 2.
+ * 
+ * The Secure Block Device Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with the Secure Block Device Library. If not, see <http://www.gnu.org/licenses/>.
+ */
+///
+/// \file
+/// \brief Implements the Secure Block Device Library's striping back end.
+///
+/// Physical block 0 is the header. The following blocks form management
+/// groups of SBDI_MNGT_BLOCK_ENTRIES + 1 blocks, and unit consecutive groups
+/// form a stripe unit. Stripe unit u is stored on member u % n as the
+/// (u / n)-th stripe unit of the member, starting at block 1 of the member's
+/// file.
+///
+/// Like a file, the striped device ends at the end of its last block. Blocks
+/// below the end that a member does not hold, e.g. because a later stripe
+/// unit on another member has been written first, read as zeros.
+///
+#include "sbdi_stripe.h"
+#include "sbdi_wp.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#define STP_GRP_BLKS (SBDI_MNGT_BLOCK_ENTRIES + 1u) //!< the blocks of a management group
+#define STP_RUNS     8u //!< the number of runs a request can be split into without allocating
+
+typedef enum stripe_op {
+  STP_READ, STP_WRITE, STP_FLUSH
+} stp_op_t;
+
+/*!
+ * \brief a part of a request that maps to consecutive bytes of one member
+ */
+typedef struct stripe_run {
+  int fd;        //!< the file descriptor of the member
+  uint64_t loc;  //!< the offset in the member
+  uint8_t *buf;  //!< the part of the request buffer
+  size_t len;    //!< the length of the run
+  ssize_t r;     //!< the number of bytes transferred; -1 on error
+} stp_run_t;
+
+typedef struct stripe_job {
+  stp_op_t op;
+  stp_run_t *runs;
+} stp_job_t;
+
+typedef struct sbdi_stripe {
+  sbdi_pio_t pio;            //!< the striping pio handed out to the user
+  int fds[SBDI_STRIPE_MAX_MEMBERS]; //!< the file descriptors of the members
+  uint32_t n;                //!< the number of members
+  uint64_t ub;               //!< the blocks of a stripe unit
+  sbdi_wp_t *wp;             //!< the worker pool that fans requests out
+  pthread_mutex_t wp_lock;   //!< held while using the worker pool
+  pthread_mutex_t lock;      //!< protects dev_end
+  uint64_t dev_end;          //!< the end of the device
+} sbdi_stripe_t;
+
+/*!
+ * \brief Maps a physical block of the device to a block of a member
+ *
+ * @param s[in] the striping back end
+ * @param phy[in] the physical block
+ * @param loc[out] the block of the member
+ * @param left[out] the number of consecutive device blocks starting at phy
+ * that map to consecutive blocks of the member
+ * @return the member
+ */
+static uint32_t stp_map(const sbdi_stripe_t *s, uint64_t phy, uint64_t *loc,
+    uint64_t *left)
+{
+  if (phy == 0) {
+    // The header directly precedes the first stripe unit
+    *loc = 0;
+    *left = 1 + s->ub;
+    return 0;
+  }
+  const uint64_t u = (phy - 1) / s->ub;
+  const uint64_t in = (phy - 1) % s->ub;
+  *loc = 1 + (u / s->n) * s->ub + in;
+  *left = s->ub - in;
+  return u % s->n;
+}
+
+/*!
+ * \brief Maps a block of a member back to the physical block of the device
+ *
+ * @param s[in] the striping back end
+ * @param m[in] the member
+ * @param loc[in] the block of the member (at least 1)
+ * @return the physical block
+ */
+static uint64_t stp_unmap(const sbdi_stripe_t *s, uint32_t m, uint64_t loc)
+{
+  const uint64_t lu = (loc - 1) / s->ub;
+  return 1 + (lu * s->n + m) * s->ub + (loc - 1) % s->ub;
+}
+
+//----------------------------------------------------------------------
+static void stp_job(void *data, uint32_t j)
+{
+  stp_job_t *job = data;
+  stp_run_t *r = &job->runs[j];
+  size_t done = 0;
+  ssize_t k = 0;
+  switch (job->op) {
+  case STP_READ:
+    while (done < r->len
+        && (k = pread(r->fd, r->buf + done, r->len - done, r->loc + done)) > 0) {
+      done += k;
+    }
+    break;
+  case STP_WRITE:
+    while (done < r->len
+        && (k = pwrite(r->fd, r->buf + done, r->len - done, r->loc + done)) > 0) {
+      done += k;
+    }
+    break;
+  case STP_FLUSH:
+    k = fdatasync(r->fd);
+    break;
+  }
+  r->r = (k == -1) ? -1 : (ssize_t) done;
+}
+
+/*!
+ * \brief Runs the runs of a request, in parallel if the worker pool is free
+ *
+ * @param s[in] the striping back end
+ * @param job[in] the request
+ * @param k[in] the number of runs
+ */
+static void stp_run(sbdi_stripe_t *s, stp_job_t *job, uint32_t k)
+{
+  // If another request uses the pool, this one still runs in parallel to it
+  if (k > 1 && s->wp && pthread_mutex_trylock(&s->wp_lock) == 0) {
+    sbdi_wp_run(s->wp, &stp_job, job, k);
+    pthread_mutex_unlock(&s->wp_lock);
+    return;
+  }
+  for (uint32_t i = 0; i < k; ++i) {
+    stp_job(job, i);
+  }
+}
+
+/*!
+ * \brief Splits a request into runs of consecutive bytes of single members
+ *
+ * @param s[in] the striping back end
+ * @param buf[in] the request buffer
+ * @param nbyte[in] the length of the request
+ * @param offset[in] the block aligned device offset of the request
+ * @param runs[out] the runs; NULL to only count them
+ * @return the number of runs
+ */
+static uint32_t stp_split(const sbdi_stripe_t *s, uint8_t *buf, size_t nbyte,
+    uint64_t offset, stp_run_t *runs)
+{
+  uint32_t k = 0;
+  size_t done = 0;
+  while (done < nbyte) {
+    uint64_t loc, left;
+    const uint32_t m = stp_map(s, (offset + done) / SBDI_BLOCK_SIZE, &loc,
+        &left);
+    const size_t len = (nbyte - done > left * SBDI_BLOCK_SIZE) ?
+        left * SBDI_BLOCK_SIZE : nbyte - done;
+    if (runs) {
+      runs[k].fd = s->fds[m];
+      runs[k].loc = loc * SBDI_BLOCK_SIZE;
+      runs[k].buf = buf + done;
+      runs[k].len = len;
+    }
+    k += 1;
+    done += len;
+  }
+  return k;
+}
+
+/*!
+ * \brief Splits and runs a read or write request
+ *
+ * @param s[in] the striping back end
+ * @param op[in] STP_READ or STP_WRITE
+ * @param buf[in] the request buffer
+ * @param nbyte[in] the length of the request
+ * @param offset[in] the block aligned device offset of the request
+ * @return nbyte if every run transferred all of its bytes, the number of
+ * bytes of the first short read run, or -1 on an error
+ */
+static ssize_t stp_rw(sbdi_stripe_t *s, stp_op_t op, uint8_t *buf,
+    size_t nbyte, uint64_t offset)
+{
+  stp_run_t a_runs[STP_RUNS];
+  stp_run_t *runs = a_runs;
+  const uint32_t k = stp_split(s, buf, nbyte, offset, NULL);
+  if (k > STP_RUNS && !(runs = malloc(k * sizeof(stp_run_t)))) {
+    errno = ENOMEM;
+    return -1;
+  }
+  stp_split(s, buf, nbyte, offset, runs);
+  stp_job_t job = { op, runs };
+  stp_run(s, &job, k);
+  ssize_t r = nbyte;
+  for (uint32_t i = 0; i < k; ++i) {
+    if (runs[i].r == -1 || (op == STP_WRITE && (size_t) runs[i].r != runs[i].len)) {
+      r = -1;
+      break;
+    } else if ((size_t) runs[i].r < runs[i].len) {
+      // Only happens below the end of the device ==> hole
+      memset(runs[i].buf + runs[i].r, 0, runs[i].len - runs[i].r);
+    }
+  }
+  if (runs != a_runs) {
+    free(runs);
+  }
+  if (r == -1) {
+    errno = EIO;
+  }
+  return r;
+}
+
+//----------------------------------------------------------------------
+static ssize_t stp_pread_i(void *iod, void *buf, size_t nbyte, off_t offset)
+{
+  sbdi_stripe_t *s = iod;
+  if (offset < 0 || offset % SBDI_BLOCK_SIZE) {
+    errno = EINVAL;
+    return -1;
+  }
+  pthread_mutex_lock(&s->lock);
+  const uint64_t end = s->dev_end;
+  pthread_mutex_unlock(&s->lock);
+  if ((uint64_t) offset >= end) {
+    return 0;
+  }
+  const size_t n = (nbyte > end - offset) ? end - offset : nbyte;
+  return stp_rw(s, STP_READ, buf, n, offset);
+}
+
+//----------------------------------------------------------------------
+static ssize_t stp_pwrite_i(void *iod, const void *buf, size_t nbyte,
+    off_t offset)
+{
+  sbdi_stripe_t *s = iod;
+  if (offset < 0 || offset % SBDI_BLOCK_SIZE) {
+    errno = EINVAL;
+    return -1;
+  }
+  ssize_t r = stp_rw(s, STP_WRITE, (uint8_t *) buf, nbyte, offset);
+  if (r > 0) {
+    pthread_mutex_lock(&s->lock);
+    if ((uint64_t) offset + r > s->dev_end) {
+      s->dev_end = offset + r;
+    }
+    pthread_mutex_unlock(&s->lock);
+  }
+  return r;
+}
+
+//----------------------------------------------------------------------
+static int stp_flush_i(void *iod)
+{
+  sbdi_stripe_t *s = iod;
+  stp_run_t runs[SBDI_STRIPE_MAX_MEMBERS];
+  for (uint32_t m = 0; m < s->n; ++m) {
+    runs[m].fd = s->fds[m];
+  }
+  stp_job_t job = { STP_FLUSH, runs };
+  stp_run(s, &job, s->n);
+  for (uint32_t m = 0; m < s->n; ++m) {
+    if (runs[m].r == -1) {
+      return -1;
+    }
+  }
+  return 0;
+}
+
+//----------------------------------------------------------------------
+sbdi_pio_t *sbdi_stripe_create(const int *fds, uint32_t n, uint32_t unit)
+{
+  if (!fds || n == 0 || n > SBDI_STRIPE_MAX_MEMBERS || unit == 0
+      || unit > UINT32_MAX / STP_GRP_BLKS) {
+    return NULL;
+  }
+  sbdi_stripe_t *s = calloc(1, sizeof(sbdi_stripe_t));
+  if (!s) {
+    return NULL;
+  }
+  s->n = n;
+  s->ub = (uint64_t) unit * STP_GRP_BLKS;
+  for (uint32_t m = 0; m < n; ++m) {
+    struct stat st;
+    if (fds[m] < 0 || fstat(fds[m], &st)) {
+      free(s);
+      return NULL;
+    }
+    s->fds[m] = fds[m];
+    // Find the device end from the last block of every member
+    const uint64_t size = st.st_size;
+    uint64_t end = 0;
+    if (size > SBDI_BLOCK_SIZE) {
+      const uint64_t last = (size - 1) / SBDI_BLOCK_SIZE;
+      end = stp_unmap(s, m, last) * SBDI_BLOCK_SIZE
+          + (size - last * SBDI_BLOCK_SIZE);
+    } else if (m == 0) {
+      end = size;
+    }
+    s->dev_end = (end > s->dev_end) ? end : s->dev_end;
+  }
+  if (pthread_mutex_init(&s->lock, NULL)) {
+    free(s);
+    return NULL;
+  }
+  if (pthread_mutex_init(&s->wp_lock, NULL)) {
+    pthread_mutex_destroy(&s->lock);
+    free(s);
+    return NULL;
+  }
+  // Without a worker pool all runs are processed on the calling thread
+  s->wp = sbdi_wp_create(
+      (n - 1 < SBDI_WORKER_THREADS) ? n - 1 : SBDI_WORKER_THREADS);
+  s->pio.iod = s;
+  s->pio.pread = &stp_pread_i;
+  s->pio.pwrite = &stp_pwrite_i;
+  s->pio.flush = &stp_flush_i;
+  s->pio.genseed = &sbdi_pio_generate_seed;
+  return &s->pio;
+}
+
+//----------------------------------------------------------------------
+void sbdi_stripe_delete(sbdi_pio_t *pio)
+{
+  if (!pio) {
+    return;
+  }
+  sbdi_stripe_t *s = pio->iod;
+  sbdi_wp_destroy(s->wp);
+  pthread_mutex_destroy(&s->wp_lock);
+  pthread_mutex_destroy(&s->lock);
+  memset(s, 0, sizeof(sbdi_stripe_t));
+  free(s);
+}
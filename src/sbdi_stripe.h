@@ -0,0 +1,82 @@
+/* Copyright (c) IAIK, Graz University of Technology, 2015.
+ * All rights reserved.
+ * Contact: http://opensource.iaik.tugraz.at
+ * 
+ * This file is part of the Secure Block Device Library.
+ * 
+ * Commercial License Usage
+ * Licensees holding valid commercial licenses may use this file in
+ * accordance with the commercial license agreement provided with the
+ * Software or, alternatively, in accordance with the terms contained in
+ * a written agreement between you and SIC. For further information
+ * contact us at http://opensource.iaik.tugraz.at.
+ * 
+ * Alternatively, this file may be used under the terms of the GNU General
+ * Public License as published by the Free Software Foundation version 2.
+ * 
+ * The Secure Block Device Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with the Secure Block Device Library. If not, see <http://www.gnu.org/licenses/>.
+ */
+///
+/// \file
+/// \brief Specifies the Secure Block Device Library's striping back end.
+///
+/// The striping back end spreads the physical blocks of a secure block device
+/// over several backing files or disks to aggregate their throughput. The
+/// management groups of the device, i.e. a management block and the data
+/// blocks it protects, are assigned to the members round robin in stripe
+/// units of a configurable number of whole groups. A group's management and
+/// data blocks thus always stay on the same member. The header block is kept
+/// on the first member in front of its first stripe unit; the other members
+/// leave the first block of their files unused.
+///
+/// Requests that span several stripe units are split up and run on all
+/// members at once.
+///
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef SBDI_STRIPE_H_
+#define SBDI_STRIPE_H_
+
+#include "sbdi_config.h"
+#include "sbdi_pio.h"
+
+#include <stdint.h>
+
+#define SBDI_STRIPE_MAX_MEMBERS 16u //!< The maximum number of members of a striping back end
+
+/*!
+ * \brief Creates a striping block device abstraction layer over the given
+ * files
+ *
+ * The members must always be given in the same order, and the stripe unit
+ * must not change between uses. Use sbdi_stripe_delete to free the pio; the
+ * file descriptors remain owned by the caller.
+ *
+ * @param fds[in] the file descriptors of the members, opened for reading and
+ * writing
+ * @param n[in] the number of members (1 to SBDI_STRIPE_MAX_MEMBERS)
+ * @param unit[in] the stripe unit in management groups (at least 1)
+ * @return a pointer to the striping pio if successful; NULL otherwise
+ */
+sbdi_pio_t *sbdi_stripe_create(const int *fds, uint32_t n, uint32_t unit);
+
+/*!
+ * \brief Frees the given striping pio
+ *
+ * @param pio[in] the striping pio to delete (can be NULL)
+ */
+void sbdi_stripe_delete(sbdi_pio_t *pio);
+
+#endif /* SBDI_STRIPE_H_ */
+
+#ifdef __cplusplus
+}
+#endif
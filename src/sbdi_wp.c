@@ -0,0 +1,204 @@
+/* Copyright (c) IAIK, Graz University of Technology, 2015.
+ * All rights reserved.
+ * Contact: http://opensource.iaik.tugraz.at
+ * 
+ * This file is part of the Secure Block Device Library.
+ * 
+ * Commercial License Usage
+ * Licensees holding valid commercial licenses may use this file in
+ * accordance with the commercial license agreement provided with the
+ * Software or, alternatively, in accordance with the terms contained in
+ * a written agreement between you and SIC. For further information
+ * contact us at http://opensource.iaik.tugraz.at.
+ * 
+ * Alternatively, this file may be used under the terms of the GNU General
+ * Public License as published by the Free Software Foundation version 2.
+ * 
+ * The Secure Block Device Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with the Secure Block Device Library. If not, see <http://www.gnu.org/licenses/>.
+ */
+///
+/// \file
+/// \brief Implements the Secure Block Device Library's worker pool.
+///
+#include "sbdi_wp.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if SBDI_WORKER_THREADS > 0
+#include <pthread.h>
+
+struct sbdi_worker_pool {
+  pthread_mutex_t lock;      //!< protects all of the following fields
+  pthread_cond_t work;       //!< signaled if there are new jobs or on shutdown
+  pthread_cond_t done;       //!< signaled if the last pending job finished
+  pthread_t threads[SBDI_WORKER_THREADS];
+  uint32_t nthreads;         //!< the number of started worker threads
+  sbdi_wp_job_fp_t job;      //!< the job function of the current run
+  void *data;                //!< the job data of the current run
+  uint32_t next;             //!< the number of the next job to take
+  uint32_t njobs;            //!< the number of jobs in the current run
+  uint32_t pending;          //!< the number of unfinished jobs
+  int shutdown;              //!< set to stop all worker threads
+};
+
+/*!
+ * \brief Takes and runs jobs of the current run until there are no more
+ *
+ * Must be called with the pool lock held; returns with the lock held.
+ *
+ * @param wp[in] the worker pool to take the jobs from
+ */
+static void wp_work(sbdi_wp_t *wp)
+{
+  while (wp->next < wp->njobs) {
+    uint32_t j = wp->next++;
+    sbdi_wp_job_fp_t job = wp->job;
+    void *data = wp->data;
+    pthread_mutex_unlock(&wp->lock);
+    job(data, j);
+    pthread_mutex_lock(&wp->lock);
+    if (--wp->pending == 0) {
+      pthread_cond_signal(&wp->done);
+    }
+  }
+}
+
+static void *wp_thread(void *arg)
+{
+  sbdi_wp_t *wp = arg;
+  pthread_mutex_lock(&wp->lock);
+  while (!wp->shutdown) {
+    wp_work(wp);
+    if (!wp->shutdown) {
+      pthread_cond_wait(&wp->work, &wp->lock);
+    }
+  }
+  pthread_mutex_unlock(&wp->lock);
+  return NULL;
+}
+
+//----------------------------------------------------------------------
+sbdi_wp_t *sbdi_wp_create(uint32_t nthreads)
+{
+  if (nthreads == 0 || nthreads > SBDI_WORKER_THREADS) {
+    return NULL;
+  }
+  sbdi_wp_t *wp = calloc(1, sizeof(sbdi_wp_t));
+  if (!wp) {
+    return NULL;
+  }
+  if (pthread_mutex_init(&wp->lock, NULL)) {
+    free(wp);
+    return NULL;
+  }
+  if (pthread_cond_init(&wp->work, NULL)) {
+    pthread_mutex_destroy(&wp->lock);
+    free(wp);
+    return NULL;
+  }
+  if (pthread_cond_init(&wp->done, NULL)) {
+    pthread_cond_destroy(&wp->work);
+    pthread_mutex_destroy(&wp->lock);
+    free(wp);
+    return NULL;
+  }
+  for (wp->nthreads = 0; wp->nthreads < nthreads; ++wp->nthreads) {
+    if (pthread_create(&wp->threads[wp->nthreads], NULL, &wp_thread, wp)) {
+      sbdi_wp_destroy(wp);
+      return NULL;
+    }
+  }
+  return wp;
+}
+
+//----------------------------------------------------------------------
+void sbdi_wp_destroy(sbdi_wp_t *wp)
+{
+  if (!wp) {
+    return;
+  }
+  pthread_mutex_lock(&wp->lock);
+  wp->shutdown = 1;
+  pthread_cond_broadcast(&wp->work);
+  pthread_mutex_unlock(&wp->lock);
+  for (uint32_t i = 0; i < wp->nthreads; ++i) {
+    pthread_join(wp->threads[i], NULL);
+  }
+  pthread_cond_destroy(&wp->done);
+  pthread_cond_destroy(&wp->work);
+  pthread_mutex_destroy(&wp->lock);
+  memset(wp, 0, sizeof(sbdi_wp_t));
+  free(wp);
+}
+
+//----------------------------------------------------------------------
+uint32_t sbdi_wp_get_concurrency(const sbdi_wp_t *wp)
+{
+  return wp ? wp->nthreads + 1 : 1;
+}
+
+//----------------------------------------------------------------------
+void sbdi_wp_run(sbdi_wp_t *wp, sbdi_wp_job_fp_t job, void *data,
+    uint32_t njobs)
+{
+  assert(job);
+  if (!wp || njobs < 2) {
+    for (uint32_t j = 0; j < njobs; ++j) {
+      job(data, j);
+    }
+    return;
+  }
+  pthread_mutex_lock(&wp->lock);
+  wp->job = job;
+  wp->data = data;
+  wp->next = 0;
+  wp->njobs = njobs;
+  wp->pending = njobs;
+  pthread_cond_broadcast(&wp->work);
+  // The calling thread helps out
+  wp_work(wp);
+  while (wp->pending) {
+    pthread_cond_wait(&wp->done, &wp->lock);
+  }
+  wp->job = NULL;
+  wp->data = NULL;
+  wp->njobs = 0;
+  wp->next = 0;
+  pthread_mutex_unlock(&wp->lock);
+}
+
+#else
+//----------------------------------------------------------------------
+sbdi_wp_t *sbdi_wp_create(uint32_t nthreads)
+{
+  return NULL;
+}
+
+//----------------------------------------------------------------------
+void sbdi_wp_destroy(sbdi_wp_t *wp)
+{
+}
+
+//----------------------------------------------------------------------
+uint32_t sbdi_wp_get_concurrency(const sbdi_wp_t *wp)
+{
+  return 1;
+}
+
+//----------------------------------------------------------------------
+void sbdi_wp_run(sbdi_wp_t *wp, sbdi_wp_job_fp_t job, void *data,
+    uint32_t njobs)
+{
+  assert(job);
+  for (uint32_t j = 0; j < njobs; ++j) {
+    job(data, j);
+  }
+}
+#endif
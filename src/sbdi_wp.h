@@ -0,0 +1,102 @@
+/* Copyright (c) IAIK, Graz University of Technology, 2015.
+ * All rights reserved.
+ * Contact: http://opensource.iaik.tugraz.at
+ * 
+ * This file is part of the Secure Block Device Library.
+ * 
+ * Commercial License Usage
+ * Licensees holding valid commercial licenses may use this file in
+ * accordance with the commercial license agreement provided with the
+ * Software or, alternatively, in accordance with the terms contained in
+ * a written agreement between you and SIC. For further information
+ * contact us at http://opensource.iaik.tugraz.at.
+ * 
+ * Alternatively, this file may be used under the terms of the GNU General
+ * Public License as published by the Free Software Foundation version 2.
+ * 
+ * The Secure Block Device Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with the Secure Block Device Library. If not, see <http://www.gnu.org/licenses/>.
+ */
+///
+/// \file
+/// \brief Specifies the Secure Block Device Library's worker pool.
+///
+/// The worker pool runs independent jobs, e.g. the encryption of independent
+/// data blocks, on a fixed set of threads. The calling thread participates in
+/// processing the jobs. Define SBDI_WORKER_THREADS as 0 to build the library
+/// without thread support; all jobs then run on the calling thread.
+///
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef SBDI_WP_H_
+#define SBDI_WP_H_
+
+#include "sbdi_config.h"
+
+#include <stdint.h>
+
+/*!
+ * \brief Defines a function pointer to a worker pool job
+ *
+ * @param data[in] the job data pointer given to sbdi_wp_run
+ * @param job[in] the number of the job to run (0 to njobs - 1)
+ */
+typedef void (*sbdi_wp_job_fp_t)(void *data, uint32_t job);
+
+typedef struct sbdi_worker_pool sbdi_wp_t;
+
+/*!
+ * \brief Creates a new worker pool with the given number of worker threads
+ *
+ * Use sbdi_wp_destroy to stop the threads and free the pool.
+ *
+ * @param nthreads[in] the number of worker threads to start (at most
+ * SBDI_WORKER_THREADS)
+ * @return a pointer to the new worker pool if successful; NULL otherwise
+ */
+sbdi_wp_t *sbdi_wp_create(uint32_t nthreads);
+
+/*!
+ * \brief Stops all threads of the given worker pool and frees it
+ *
+ * @param wp[in] the worker pool to destroy (can be NULL)
+ */
+void sbdi_wp_destroy(sbdi_wp_t *wp);
+
+/*!
+ * \brief Determines the number of threads (including the calling thread)
+ * that sbdi_wp_run uses to process jobs
+ *
+ * @param wp[in] the worker pool (can be NULL)
+ * @return the number of threads that process jobs in parallel
+ */
+uint32_t sbdi_wp_get_concurrency(const sbdi_wp_t *wp);
+
+/*!
+ * \brief Runs the given job function for every job number from 0 to
+ * njobs - 1 and returns when all jobs are done
+ *
+ * Jobs run in an unspecified order and possibly in parallel. If wp is NULL
+ * all jobs run on the calling thread. Only one thread at a time may call
+ * this function for the same worker pool.
+ *
+ * @param wp[in] the worker pool (can be NULL)
+ * @param job[in] the job function
+ * @param data[in] the data pointer to pass to the job function
+ * @param njobs[in] the number of jobs to run
+ */
+void sbdi_wp_run(sbdi_wp_t *wp, sbdi_wp_job_fp_t job, void *data,
+    uint32_t njobs);
+
+#endif /* SBDI_WP_H_ */
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,172 @@
+/* Copyright (c) IAIK, Graz University of Technology, 2015.
+ * All rights reserved.
+ * Contact: http://opensource.iaik.tugraz.at
+ * 
+ * This file is part of the Secure Block Device Library.
+ * 
+ * Commercial License Usage
+ * Licensees holding valid commercial licenses may use this file in
+ * accordance with the commercial license agreement provided with the
+ * Software or, alternatively, in accordance with the terms contained in
+ * a written agreement between you and SIC. For further information
+ * contact us at http://opensource.iaik.tugraz.at.
+ * 
+ * Alternatively, this file may be used under the terms of the GNU General
+ * Public License as published by the Free Software Foundation version 2.
+ * 
+ * The Secure Block Device Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with the Secure Block Device Library. If not, see <http://www.gnu.org/licenses/>.
+ */
+///
+/// \file
+/// \brief Tests the AEGIS-128L implementation used by the Secure Block Device
+/// Library.
+///
+#include "crypto/aegis128l.h"
+
+#include <string.h>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#define LONG_LEN 2100
+
+class Aegis128lTest: public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE( Aegis128lTest );
+  CPPUNIT_TEST(testAegisEncryption);
+  CPPUNIT_TEST(testAegisDecryption);
+  CPPUNIT_TEST(testAegisGenericEqualsAccelerated);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  // Test vectors of the CFRG AEGIS draft, AEGIS-128L test vectors 1 to 4
+  static unsigned char KEY[AEGIS128L_KEY_SIZE];
+  static unsigned char NONCE[AEGIS128L_NONCE_SIZE];
+  static unsigned char AD[8];
+  static unsigned char TV1_RESULT[16 + AEGIS128L_TAG_SIZE];
+  static unsigned char TV2_TAG[AEGIS128L_TAG_SIZE];
+  static unsigned char TV3_RESULT[32 + AEGIS128L_TAG_SIZE];
+  static unsigned char TV4_RESULT[14 + AEGIS128L_TAG_SIZE];
+
+  aegis128l_ctx ctx;
+  unsigned char msg[LONG_LEN];
+  unsigned char ct[LONG_LEN];
+  unsigned char pt[LONG_LEN];
+  unsigned char tag[AEGIS128L_TAG_SIZE];
+
+public:
+  void setUp()
+  {
+    CPPUNIT_ASSERT(aegis128l_init(&ctx, KEY) == 0);
+    for (int i = 0; i < LONG_LEN; ++i) {
+      msg[i] = (unsigned char) i;
+    }
+    memset(ct, 0, LONG_LEN);
+    memset(pt, 0, LONG_LEN);
+  }
+
+  void tearDown()
+  {
+    aegis128l_clear(&ctx);
+  }
+
+  void testAegisEncryption()
+  {
+    aegis128l_encrypt(&ctx, NONCE, NULL, 0, pt, ct, 16, tag);
+    CPPUNIT_ASSERT(!memcmp(ct, TV1_RESULT, 16));
+    CPPUNIT_ASSERT(!memcmp(tag, TV1_RESULT + 16, AEGIS128L_TAG_SIZE));
+    aegis128l_encrypt(&ctx, NONCE, NULL, 0, pt, ct, 0, tag);
+    CPPUNIT_ASSERT(!memcmp(tag, TV2_TAG, AEGIS128L_TAG_SIZE));
+    aegis128l_encrypt(&ctx, NONCE, AD, sizeof(AD), msg, ct, 32, tag);
+    CPPUNIT_ASSERT(!memcmp(ct, TV3_RESULT, 32));
+    CPPUNIT_ASSERT(!memcmp(tag, TV3_RESULT + 32, AEGIS128L_TAG_SIZE));
+    aegis128l_encrypt(&ctx, NONCE, AD, sizeof(AD), msg, ct, 14, tag);
+    CPPUNIT_ASSERT(!memcmp(ct, TV4_RESULT, 14));
+    CPPUNIT_ASSERT(!memcmp(tag, TV4_RESULT + 14, AEGIS128L_TAG_SIZE));
+  }
+
+  void testAegisDecryption()
+  {
+    CPPUNIT_ASSERT(
+        aegis128l_decrypt(&ctx, NONCE, AD, sizeof(AD), TV4_RESULT, pt, 14,
+            TV4_RESULT + 14) == 1);
+    CPPUNIT_ASSERT(!memcmp(pt, msg, 14));
+    // In place decryption
+    memcpy(ct, TV3_RESULT, 32);
+    CPPUNIT_ASSERT(
+        aegis128l_decrypt(&ctx, NONCE, AD, sizeof(AD), ct, ct, 32,
+            TV3_RESULT + 32) == 1);
+    CPPUNIT_ASSERT(!memcmp(ct, msg, 32));
+    // Modified ciphertext
+    memcpy(ct, TV3_RESULT, 32);
+    ct[31] ^= 0x80;
+    CPPUNIT_ASSERT(
+        aegis128l_decrypt(&ctx, NONCE, AD, sizeof(AD), ct, pt, 32,
+            TV3_RESULT + 32) == -1);
+    // Modified additional data
+    CPPUNIT_ASSERT(
+        aegis128l_decrypt(&ctx, NONCE, AD, sizeof(AD) - 1, TV3_RESULT, pt, 32,
+            TV3_RESULT + 32) == -1);
+  }
+
+  void testAegisGenericEqualsAccelerated()
+  {
+    static const int LENS[] = { 1, 31, 32, 33, 64, 100, 2048, LONG_LEN };
+    aegis128l_ctx gen;
+    unsigned char tag_gen[AEGIS128L_TAG_SIZE];
+    CPPUNIT_ASSERT(aegis128l_init(&gen, KEY) == 0);
+    // Force the generic code path
+    gen.use_ni = 0;
+    for (unsigned i = 0; i < sizeof(LENS) / sizeof(LENS[0]); ++i) {
+      aegis128l_encrypt(&ctx, NONCE, AD, sizeof(AD), msg, ct, LENS[i], tag);
+      aegis128l_encrypt(&gen, NONCE, AD, sizeof(AD), msg, pt, LENS[i],
+          tag_gen);
+      CPPUNIT_ASSERT(!memcmp(ct, pt, LENS[i]));
+      CPPUNIT_ASSERT(!memcmp(tag, tag_gen, AEGIS128L_TAG_SIZE));
+      CPPUNIT_ASSERT(
+          aegis128l_decrypt(&gen, NONCE, AD, sizeof(AD), ct, pt, LENS[i],
+              tag) == 1);
+      CPPUNIT_ASSERT(!memcmp(msg, pt, LENS[i]));
+    }
+    aegis128l_clear(&gen);
+  }
+};
+
+unsigned char Aegis128lTest::KEY[AEGIS128L_KEY_SIZE] = { 0x10, 0x01 };
+
+unsigned char Aegis128lTest::NONCE[AEGIS128L_NONCE_SIZE] = { 0x10, 0x00,
+    0x02 };
+
+unsigned char Aegis128lTest::AD[8] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05,
+    0x06, 0x07 };
+
+unsigned char Aegis128lTest::TV1_RESULT[16 + AEGIS128L_TAG_SIZE] = {
+    // c1c0e58b d913006f eba00f4b 3cc3594e abe0ece8 0c24868a 226a35d1 6bdae37a
+    0xc1, 0xc0, 0xe5, 0x8b, 0xd9, 0x13, 0x00, 0x6f, 0xeb, 0xa0, 0x0f, 0x4b,
+    0x3c, 0xc3, 0x59, 0x4e, 0xab, 0xe0, 0xec, 0xe8, 0x0c, 0x24, 0x86, 0x8a,
+    0x22, 0x6a, 0x35, 0xd1, 0x6b, 0xda, 0xe3, 0x7a };
+
+unsigned char Aegis128lTest::TV2_TAG[AEGIS128L_TAG_SIZE] = {
+    // c2b879a6 7def9d74 e6c14f70 8bbcc9b4
+    0xc2, 0xb8, 0x79, 0xa6, 0x7d, 0xef, 0x9d, 0x74, 0xe6, 0xc1, 0x4f, 0x70,
+    0x8b, 0xbc, 0xc9, 0xb4 };
+
+unsigned char Aegis128lTest::TV3_RESULT[32 + AEGIS128L_TAG_SIZE] = {
+    // 79d94593 d8c2119d 7e8fd9b8 fc77845c 5c077a05 b2528b6a c54b563a ed8efe84
+    // cc6f3372 f6aa1bb8 2388d695 c3962d9a
+    0x79, 0xd9, 0x45, 0x93, 0xd8, 0xc2, 0x11, 0x9d, 0x7e, 0x8f, 0xd9, 0xb8,
+    0xfc, 0x77, 0x84, 0x5c, 0x5c, 0x07, 0x7a, 0x05, 0xb2, 0x52, 0x8b, 0x6a,
+    0xc5, 0x4b, 0x56, 0x3a, 0xed, 0x8e, 0xfe, 0x84, 0xcc, 0x6f, 0x33, 0x72,
+    0xf6, 0xaa, 0x1b, 0xb8, 0x23, 0x88, 0xd6, 0x95, 0xc3, 0x96, 0x2d, 0x9a };
+
+unsigned char Aegis128lTest::TV4_RESULT[14 + AEGIS128L_TAG_SIZE] = {
+    // 79d94593 d8c2119d 7e8fd9b8 fc77 5c04b3db a849b270 1effbe32 c7f0fab7
+    0x79, 0xd9, 0x45, 0x93, 0xd8, 0xc2, 0x11, 0x9d, 0x7e, 0x8f, 0xd9, 0xb8,
+    0xfc, 0x77, 0x5c, 0x04, 0xb3, 0xdb, 0xa8, 0x49, 0xb2, 0x70, 0x1e, 0xff,
+    0xbe, 0x32, 0xc7, 0xf0, 0xfa, 0xb7 };
+
+CPPUNIT_TEST_SUITE_REGISTRATION(Aegis128lTest);
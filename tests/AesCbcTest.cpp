@@ -0,0 +1,163 @@
+/* Copyright (c) IAIK, Graz University of Technology, 2015.
+ * All rights reserved.
+ * Contact: http://opensource.iaik.tugraz.at
+ * 
+ * This file is part of the Secure Block Device Library.
+ * 
+ * Commercial License Usage
+ * Licensees holding valid commercial licenses may use this file in
+ * accordance with the commercial license agreement provided with the
+ * Software or, alternatively, in accordance with the terms contained in
+ * a written agreement between you and SIC. For further information
+ * contact us at http://opensource.iaik.tugraz.at.
+ * 
+ * Alternatively, this file may be used under the terms of the GNU General
+ * Public License as published by the Free Software Foundation version 2.
+ * 
+ * The Secure Block Device Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with the Secure Block Device Library. If not, see <http://www.gnu.org/licenses/>.
+ */
+///
+/// \file
+/// \brief Tests the CBC modes of the AES wrapper (aes.h) used by the HMAC
+/// cryptographic abstraction layer.
+///
+#include "crypto/aes.h"
+
+#include <string.h>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#define MAX_BLKS 21
+#define MAX_LEN  (MAX_BLKS * AES_BLOCK_SIZE)
+#define LANES    (AES_MB_LANES + 3)
+
+class AesCbcTest: public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE( AesCbcTest );
+  CPPUNIT_TEST(testCbcKnownAnswer);
+  CPPUNIT_TEST(testCbcDecryption);
+  CPPUNIT_TEST(testCbcEncryptionLanes);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  static unsigned char KEY[16];
+  static unsigned char IV[AES_BLOCK_SIZE];
+  // NIST SP 800-38A, F.2.1 and F.2.2, the first two blocks
+  static unsigned char TV_PT[2 * AES_BLOCK_SIZE];
+  static unsigned char TV_CT[2 * AES_BLOCK_SIZE];
+
+  AES_KEY enc_key;
+  AES_KEY dec_key;
+  unsigned char msg[LANES][MAX_LEN];
+  unsigned char ct[LANES][MAX_LEN];
+  unsigned char pt[MAX_LEN];
+
+public:
+  void setUp()
+  {
+    CPPUNIT_ASSERT(AES_set_encrypt_key(KEY, 128, &enc_key) == 0);
+    CPPUNIT_ASSERT(AES_set_decrypt_key(KEY, 128, &dec_key) == 0);
+    for (int l = 0; l < LANES; ++l) {
+      for (int i = 0; i < MAX_LEN; ++i) {
+        msg[l][i] = (unsigned char) (i * 11 + l * 3);
+      }
+    }
+    memset(ct, 0, sizeof(ct));
+    memset(pt, 0, sizeof(pt));
+  }
+
+  void tearDown()
+  {
+  }
+
+  void testCbcKnownAnswer()
+  {
+    unsigned char iv[AES_BLOCK_SIZE];
+    memcpy(iv, IV, AES_BLOCK_SIZE);
+    AES_cbc_encrypt(TV_PT, ct[0], sizeof(TV_PT), &enc_key, iv, AES_ENCRYPT);
+    CPPUNIT_ASSERT(!memcmp(ct[0], TV_CT, sizeof(TV_CT)));
+    memcpy(iv, IV, AES_BLOCK_SIZE);
+    AES_cbc_encrypt(TV_CT, pt, sizeof(TV_CT), &dec_key, iv, AES_DECRYPT);
+    CPPUNIT_ASSERT(!memcmp(pt, TV_PT, sizeof(TV_PT)));
+  }
+
+  void testCbcDecryption()
+  {
+    unsigned char iv[AES_BLOCK_SIZE], ref_iv[AES_BLOCK_SIZE];
+    unsigned char ref[MAX_LEN], tmp[AES_BLOCK_SIZE];
+    for (int n = 1; n <= MAX_BLKS; ++n) {
+      const int len = n * AES_BLOCK_SIZE;
+      memcpy(iv, IV, AES_BLOCK_SIZE);
+      AES_cbc_encrypt(msg[0], ct[0], len, &enc_key, iv, AES_ENCRYPT);
+      // Block by block reference decryption
+      memcpy(ref_iv, IV, AES_BLOCK_SIZE);
+      for (int j = 0; j < len; j += AES_BLOCK_SIZE) {
+        AES_decrypt(ct[0] + j, tmp, &dec_key);
+        for (int i = 0; i < AES_BLOCK_SIZE; ++i) {
+          ref[j + i] = tmp[i] ^ ref_iv[i];
+        }
+        memcpy(ref_iv, ct[0] + j, AES_BLOCK_SIZE);
+      }
+      CPPUNIT_ASSERT(!memcmp(ref, msg[0], len));
+      memcpy(iv, IV, AES_BLOCK_SIZE);
+      AES_cbc_encrypt(ct[0], pt, len, &dec_key, iv, AES_DECRYPT);
+      CPPUNIT_ASSERT(!memcmp(pt, msg[0], len));
+      CPPUNIT_ASSERT(!memcmp(iv, ref_iv, AES_BLOCK_SIZE));
+      // In-place
+      memcpy(pt, ct[0], len);
+      memcpy(iv, IV, AES_BLOCK_SIZE);
+      AES_cbc_encrypt(pt, pt, len, &dec_key, iv, AES_DECRYPT);
+      CPPUNIT_ASSERT(!memcmp(pt, msg[0], len));
+    }
+  }
+
+  void testCbcEncryptionLanes()
+  {
+    unsigned char iv[LANES][AES_BLOCK_SIZE], ref_iv[AES_BLOCK_SIZE];
+    unsigned char ref[MAX_LEN];
+    const unsigned char *in[LANES];
+    unsigned char *out[LANES];
+    for (int lanes = 1; lanes <= LANES; ++lanes) {
+      for (int l = 0; l < lanes; ++l) {
+        memcpy(iv[l], IV, AES_BLOCK_SIZE);
+        iv[l][0] ^= (unsigned char) l;
+        in[l] = msg[l];
+        out[l] = ct[l];
+      }
+      AES_cbc_encrypt_mb(in, out, MAX_BLKS, &enc_key, iv, lanes);
+      // Every lane must equal a single CBC encryption
+      for (int l = 0; l < lanes; ++l) {
+        memcpy(ref_iv, IV, AES_BLOCK_SIZE);
+        ref_iv[0] ^= (unsigned char) l;
+        AES_cbc_encrypt(msg[l], ref, MAX_LEN, &enc_key, ref_iv, AES_ENCRYPT);
+        CPPUNIT_ASSERT(!memcmp(ref, ct[l], MAX_LEN));
+        CPPUNIT_ASSERT(!memcmp(ref_iv, iv[l], AES_BLOCK_SIZE));
+      }
+    }
+  }
+};
+
+unsigned char AesCbcTest::KEY[16] = { 0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae,
+    0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c };
+
+unsigned char AesCbcTest::IV[AES_BLOCK_SIZE] = { 0x00, 0x01, 0x02, 0x03,
+    0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f };
+
+unsigned char AesCbcTest::TV_PT[2 * AES_BLOCK_SIZE] = {
+    // 6bc1bee2 2e409f96 e93d7e11 7393172a ae2d8a57 1e03ac9c 9eb76fac 45af8e51
+    0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96, 0xe9, 0x3d, 0x7e, 0x11,
+    0x73, 0x93, 0x17, 0x2a, 0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c,
+    0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51 };
+
+unsigned char AesCbcTest::TV_CT[2 * AES_BLOCK_SIZE] = {
+    // 7649abac 8119b246 cee98e9b 12e9197d 5086cb9b 507219ee 95db113a 917678b2
+    0x76, 0x49, 0xab, 0xac, 0x81, 0x19, 0xb2, 0x46, 0xce, 0xe9, 0x8e, 0x9b,
+    0x12, 0xe9, 0x19, 0x7d, 0x50, 0x86, 0xcb, 0x9b, 0x50, 0x72, 0x19, 0xee,
+    0x95, 0xdb, 0x11, 0x3a, 0x91, 0x76, 0x78, 0xb2 };
+
+CPPUNIT_TEST_SUITE_REGISTRATION(AesCbcTest);
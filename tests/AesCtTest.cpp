@@ -0,0 +1,205 @@
+/* Copyright (c) IAIK, Graz University of Technology, 2015.
+ * All rights reserved.
+ * Contact: http://opensource.iaik.tugraz.at
+ * 
+ * This file is part of the Secure Block Device Library.
+ * 
+ * Commercial License Usage
+ * Licensees holding valid commercial licenses may use this file in
+ * accordance with the commercial license agreement provided with the
+ * Software or, alternatively, in accordance with the terms contained in
+ * a written agreement between you and SIC. For further information
+ * contact us at http://opensource.iaik.tugraz.at.
+ * 
+ * Alternatively, this file may be used under the terms of the GNU General
+ * Public License as published by the Free Software Foundation version 2.
+ * 
+ * The Secure Block Device Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with the Secure Block Device Library. If not, see <http://www.gnu.org/licenses/>.
+ */
+///
+/// \file
+/// \brief Tests the bitsliced AES implementation used by the Secure Block
+/// Device Library if the CPU does not support AES-NI.
+///
+#include "crypto/aes.h"
+#include "crypto/aes_ct.h"
+
+#include <string.h>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#define LONG_LEN 2100
+#define MB_LANES 6
+#define MB_BLKS  5
+
+class AesCtTest: public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE( AesCtTest );
+  CPPUNIT_TEST(testFips197);
+  CPPUNIT_TEST(testBatchEqualsReference);
+  CPPUNIT_TEST(testCtr32);
+  CPPUNIT_TEST(testAesKeyFallback);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  // FIPS-197, appendix C
+  static unsigned char KEY[32];
+  static unsigned char PT[16];
+  static unsigned char CT_128[16];
+  static unsigned char CT_192[16];
+  static unsigned char CT_256[16];
+
+  AES_KEY ref;
+  AES_KEY ct;
+  unsigned char msg[LONG_LEN];
+  unsigned char out[LONG_LEN];
+  unsigned char exp[LONG_LEN];
+
+  void setKeys(const int bits)
+  {
+    CPPUNIT_ASSERT(AES_set_encrypt_key(KEY, bits, &ref) == 0);
+    ref.use_ct = 0;
+    memcpy(&ct, &ref, sizeof(AES_KEY));
+    aes_ct_keysched(ct.ct_key, ct.key, ct.rounds);
+    ct.use_ct = 1;
+  }
+
+  // CTR mode with a 32 bit counter, one block at a time
+  void refCtr32(const unsigned char *ctr, const int ctr_le, const int len)
+  {
+    unsigned char cb[16], ks[16];
+    memcpy(cb, ctr, 16);
+    for (int i = 0; i < len; i += 16) {
+      AES_encrypt(cb, ks, &ref);
+      for (int j = 0; j < 16 && i + j < len; ++j) {
+        exp[i + j] = msg[i + j] ^ ks[j];
+      }
+      for (int j = 0; j < 4; ++j) {
+        if (++cb[ctr_le ? j : 15 - j]) {
+          break;
+        }
+      }
+    }
+  }
+
+public:
+  void setUp()
+  {
+    for (int i = 0; i < LONG_LEN; ++i) {
+      msg[i] = (unsigned char) (i * 13 + 7);
+    }
+    memset(out, 0, LONG_LEN);
+    memset(exp, 0, LONG_LEN);
+  }
+
+  void tearDown()
+  {
+  }
+
+  void testFips197()
+  {
+    static const int bits[3] = { 128, 192, 256 };
+    const unsigned char *res[3] = { CT_128, CT_192, CT_256 };
+    for (int i = 0; i < 3; ++i) {
+      setKeys(bits[i]);
+      aes_ct_encrypt_blks(ct.ct_key, ct.rounds, PT, out, 1);
+      CPPUNIT_ASSERT(!memcmp(out, res[i], 16));
+      memset(out, 0, 16);
+      AES_encrypt(PT, out, &ct);
+      CPPUNIT_ASSERT(!memcmp(out, res[i], 16));
+    }
+  }
+
+  void testBatchEqualsReference()
+  {
+    for (int bits = 128; bits <= 256; bits += 64) {
+      setKeys(bits);
+      for (unsigned n = 1; n <= 2 * AES_CT_BATCH + 1; ++n) {
+        for (unsigned i = 0; i < n; ++i) {
+          AES_encrypt(msg + 16 * i + n, exp + 16 * i, &ref);
+        }
+        memset(out, 0, LONG_LEN);
+        aes_ct_encrypt_blks(ct.ct_key, ct.rounds, msg + n, out, n);
+        CPPUNIT_ASSERT(!memcmp(out, exp, 16 * n));
+        // Blocks behind the batch must not be touched
+        CPPUNIT_ASSERT(out[16 * n] == 0);
+        // In place
+        memcpy(out, msg + n, 16 * n);
+        AES_encrypt_blks(out, out, n, &ct);
+        CPPUNIT_ASSERT(!memcmp(out, exp, 16 * n));
+      }
+    }
+  }
+
+  void testCtr32()
+  {
+    unsigned char ctr[16];
+    for (int i = 0; i < 16; ++i) {
+      ctr[i] = (unsigned char) (0xA0 + i);
+    }
+    // The counter wraps within the first batch
+    ctr[12] = ctr[13] = ctr[14] = 0xFF;
+    ctr[0] = ctr[1] = ctr[2] = 0xFF;
+    setKeys(128);
+    for (int ctr_le = 0; ctr_le < 2; ++ctr_le) {
+      static const int lens[5] = { 1, 16, 127, 128, LONG_LEN };
+      for (int l = 0; l < 5; ++l) {
+        refCtr32(ctr, ctr_le, lens[l]);
+        memset(out, 0, LONG_LEN);
+        aes_ct_ctr32(ct.ct_key, ct.rounds, msg, out, lens[l], ctr, ctr_le);
+        CPPUNIT_ASSERT(!memcmp(out, exp, lens[l]));
+        CPPUNIT_ASSERT(lens[l] == LONG_LEN || out[lens[l]] == 0);
+      }
+    }
+  }
+
+  void testAesKeyFallback()
+  {
+    unsigned char iv_ref[MB_LANES][AES_BLOCK_SIZE];
+    unsigned char iv_ct[MB_LANES][AES_BLOCK_SIZE];
+    const unsigned char *in[MB_LANES];
+    unsigned char *out_ref[MB_LANES], *out_ct[MB_LANES];
+    setKeys(256);
+    for (int l = 0; l < MB_LANES; ++l) {
+      memset(iv_ref[l], l, AES_BLOCK_SIZE);
+      memset(iv_ct[l], l, AES_BLOCK_SIZE);
+      in[l] = msg + l * MB_BLKS * AES_BLOCK_SIZE;
+      out_ref[l] = exp + l * MB_BLKS * AES_BLOCK_SIZE;
+      out_ct[l] = (l == 2) ? NULL : out + l * MB_BLKS * AES_BLOCK_SIZE;
+    }
+    // The bitsliced multi-buffer CBC must match the reference lane by lane
+    AES_cbc_encrypt_mb(in, out_ref, MB_BLKS, &ref, iv_ref, MB_LANES);
+    AES_cbc_encrypt_mb(in, out_ct, MB_BLKS, &ct, iv_ct, MB_LANES);
+    CPPUNIT_ASSERT(!memcmp(iv_ref, iv_ct, sizeof(iv_ref)));
+    for (int l = 0; l < MB_LANES; ++l) {
+      if (out_ct[l]) {
+        CPPUNIT_ASSERT(
+            !memcmp(out_ref[l], out_ct[l], MB_BLKS * AES_BLOCK_SIZE));
+      }
+    }
+  }
+};
+
+unsigned char AesCtTest::KEY[32] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06,
+    0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10, 0x11, 0x12,
+    0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e,
+    0x1f };
+
+unsigned char AesCtTest::PT[16] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66,
+    0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff };
+
+unsigned char AesCtTest::CT_128[16] = { 0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b,
+    0x04, 0x30, 0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a };
+
+unsigned char AesCtTest::CT_192[16] = { 0xdd, 0xa9, 0x7c, 0xa4, 0x86, 0x4c,
+    0xdf, 0xe0, 0x6e, 0xaf, 0x70, 0xa0, 0xec, 0x0d, 0x71, 0x91 };
+
+unsigned char AesCtTest::CT_256[16] = { 0x8e, 0xa2, 0xb7, 0xca, 0x51, 0x67,
+    0x45, 0xbf, 0xea, 0xfc, 0x49, 0x90, 0x4b, 0x49, 0x60, 0x89 };
+
+CPPUNIT_TEST_SUITE_REGISTRATION(AesCtTest);
@@ -0,0 +1,176 @@
+/* Copyright (c) IAIK, Graz University of Technology, 2015.
+ * All rights reserved.
+ * Contact: http://opensource.iaik.tugraz.at
+ * 
+ * This file is part of the Secure Block Device Library.
+ * 
+ * Commercial License Usage
+ * Licensees holding valid commercial licenses may use this file in
+ * accordance with the commercial license agreement provided with the
+ * Software or, alternatively, in accordance with the terms contained in
+ * a written agreement between you and SIC. For further information
+ * contact us at http://opensource.iaik.tugraz.at.
+ * 
+ * Alternatively, this file may be used under the terms of the GNU General
+ * Public License as published by the Free Software Foundation version 2.
+ * 
+ * The Secure Block Device Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with the Secure Block Device Library. If not, see <http://www.gnu.org/licenses/>.
+ */
+///
+/// \file
+/// \brief Tests the AES-GCM-SIV implementation used by the Secure Block
+/// Device Library.
+///
+#include "crypto/gcm_siv.h"
+
+#include <string.h>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#define LONG_LEN 2100
+
+class AesGcmSivTest: public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE( AesGcmSivTest );
+  CPPUNIT_TEST(testGcmSivEncryption);
+  CPPUNIT_TEST(testGcmSivEncryption256);
+  CPPUNIT_TEST(testGcmSivDecryption);
+  CPPUNIT_TEST(testGcmSivGenericEqualsAccelerated);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  // Test vectors of RFC 8452, appendix C.1 and C.2
+  static unsigned char KEY[32];
+  static unsigned char NONCE[GCM_SIV_NONCE_SIZE];
+  static unsigned char PLAIN_TEXT[16];
+  static unsigned char AD[1];
+  static unsigned char TV_TAG_EMPTY_128[GCM_SIV_TAG_SIZE];
+  static unsigned char TV_RESULT_16_128[16 + GCM_SIV_TAG_SIZE];
+  static unsigned char TV_RESULT_AD_128[8 + GCM_SIV_TAG_SIZE];
+  static unsigned char TV_RESULT_8_256[8 + GCM_SIV_TAG_SIZE];
+
+  gcm_siv_ctx ctx;
+  unsigned char ct[LONG_LEN];
+  unsigned char pt[LONG_LEN];
+  unsigned char tag[GCM_SIV_TAG_SIZE];
+
+public:
+  void setUp()
+  {
+    CPPUNIT_ASSERT(gcm_siv_init(&ctx, KEY, 128) == 0);
+    memset(ct, 0, LONG_LEN);
+    memset(pt, 0, LONG_LEN);
+  }
+
+  void tearDown()
+  {
+    gcm_siv_clear(&ctx);
+  }
+
+  void testGcmSivEncryption()
+  {
+    gcm_siv_encrypt(&ctx, NONCE, NULL, 0, PLAIN_TEXT, ct, 0, tag);
+    CPPUNIT_ASSERT(!memcmp(tag, TV_TAG_EMPTY_128, GCM_SIV_TAG_SIZE));
+    gcm_siv_encrypt(&ctx, NONCE, NULL, 0, PLAIN_TEXT, ct, 16, tag);
+    CPPUNIT_ASSERT(!memcmp(ct, TV_RESULT_16_128, 16));
+    CPPUNIT_ASSERT(!memcmp(tag, TV_RESULT_16_128 + 16, GCM_SIV_TAG_SIZE));
+    // 0200000000000000 with the additional data 01
+    unsigned char p[8] = { 0x02 };
+    gcm_siv_encrypt(&ctx, NONCE, AD, 1, p, ct, 8, tag);
+    CPPUNIT_ASSERT(!memcmp(ct, TV_RESULT_AD_128, 8));
+    CPPUNIT_ASSERT(!memcmp(tag, TV_RESULT_AD_128 + 8, GCM_SIV_TAG_SIZE));
+  }
+
+  void testGcmSivEncryption256()
+  {
+    gcm_siv_ctx ctx256;
+    CPPUNIT_ASSERT(gcm_siv_init(&ctx256, KEY, 256) == 0);
+    gcm_siv_encrypt(&ctx256, NONCE, NULL, 0, PLAIN_TEXT, ct, 8, tag);
+    CPPUNIT_ASSERT(!memcmp(ct, TV_RESULT_8_256, 8));
+    CPPUNIT_ASSERT(!memcmp(tag, TV_RESULT_8_256 + 8, GCM_SIV_TAG_SIZE));
+    gcm_siv_clear(&ctx256);
+  }
+
+  void testGcmSivDecryption()
+  {
+    CPPUNIT_ASSERT(
+        gcm_siv_decrypt(&ctx, NONCE, NULL, 0, TV_RESULT_16_128, pt, 16,
+            TV_RESULT_16_128 + 16) == 1);
+    CPPUNIT_ASSERT(!memcmp(pt, PLAIN_TEXT, 16));
+    // In place decryption
+    memcpy(ct, TV_RESULT_16_128, 16);
+    CPPUNIT_ASSERT(
+        gcm_siv_decrypt(&ctx, NONCE, NULL, 0, ct, ct, 16,
+            TV_RESULT_16_128 + 16) == 1);
+    CPPUNIT_ASSERT(!memcmp(ct, PLAIN_TEXT, 16));
+    // Modified ciphertext
+    memcpy(ct, TV_RESULT_16_128, 16);
+    ct[7] ^= 0x20;
+    CPPUNIT_ASSERT(
+        gcm_siv_decrypt(&ctx, NONCE, NULL, 0, ct, pt, 16,
+            TV_RESULT_16_128 + 16) == -1);
+    // Modified additional data
+    CPPUNIT_ASSERT(
+        gcm_siv_decrypt(&ctx, NONCE, AD, 1, TV_RESULT_16_128, pt, 16,
+            TV_RESULT_16_128 + 16) == -1);
+  }
+
+  void testGcmSivGenericEqualsAccelerated()
+  {
+    static const int LENS[] = { 1, 16, 17, 127, 128, 129, 2048, LONG_LEN };
+    gcm_siv_ctx gen;
+    CPPUNIT_ASSERT(gcm_siv_init(&gen, KEY, 128) == 0);
+    // Force the generic code path
+    gen.use_ni = 0;
+    unsigned char in[LONG_LEN], tag_gen[GCM_SIV_TAG_SIZE];
+    for (int i = 0; i < LONG_LEN; ++i) {
+      in[i] = (unsigned char) (i * 13 + 7);
+    }
+    for (unsigned i = 0; i < sizeof(LENS) / sizeof(LENS[0]); ++i) {
+      gcm_siv_encrypt(&ctx, NONCE, AD, 1, in, ct, LENS[i], tag);
+      gcm_siv_encrypt(&gen, NONCE, AD, 1, in, pt, LENS[i], tag_gen);
+      CPPUNIT_ASSERT(!memcmp(ct, pt, LENS[i]));
+      CPPUNIT_ASSERT(!memcmp(tag, tag_gen, GCM_SIV_TAG_SIZE));
+      CPPUNIT_ASSERT(
+          gcm_siv_decrypt(&gen, NONCE, AD, 1, ct, pt, LENS[i], tag) == 1);
+      CPPUNIT_ASSERT(!memcmp(in, pt, LENS[i]));
+    }
+    gcm_siv_clear(&gen);
+  }
+};
+
+unsigned char AesGcmSivTest::KEY[32] = { 0x01 };
+
+unsigned char AesGcmSivTest::NONCE[GCM_SIV_NONCE_SIZE] = { 0x03 };
+
+unsigned char AesGcmSivTest::PLAIN_TEXT[16] = { 0x01 };
+
+unsigned char AesGcmSivTest::AD[1] = { 0x01 };
+
+unsigned char AesGcmSivTest::TV_TAG_EMPTY_128[GCM_SIV_TAG_SIZE] = {
+    // dc20e2d8 3f25705b b49e439e ca56de25
+    0xdc, 0x20, 0xe2, 0xd8, 0x3f, 0x25, 0x70, 0x5b, 0xb4, 0x9e, 0x43, 0x9e,
+    0xca, 0x56, 0xde, 0x25 };
+
+unsigned char AesGcmSivTest::TV_RESULT_16_128[16 + GCM_SIV_TAG_SIZE] = {
+    // 743f7c80 77ab25f8 624e2e94 8579cf77 303aaf90 f6fe2119 9c606857 7437a0c4
+    0x74, 0x3f, 0x7c, 0x80, 0x77, 0xab, 0x25, 0xf8, 0x62, 0x4e, 0x2e, 0x94,
+    0x85, 0x79, 0xcf, 0x77, 0x30, 0x3a, 0xaf, 0x90, 0xf6, 0xfe, 0x21, 0x19,
+    0x9c, 0x60, 0x68, 0x57, 0x74, 0x37, 0xa0, 0xc4 };
+
+unsigned char AesGcmSivTest::TV_RESULT_AD_128[8 + GCM_SIV_TAG_SIZE] = {
+    // 1e6daba3 5669f427 3b0a1a25 60969cdf 790d9975 9abd1508
+    0x1e, 0x6d, 0xab, 0xa3, 0x56, 0x69, 0xf4, 0x27, 0x3b, 0x0a, 0x1a, 0x25,
+    0x60, 0x96, 0x9c, 0xdf, 0x79, 0x0d, 0x99, 0x75, 0x9a, 0xbd, 0x15, 0x08 };
+
+unsigned char AesGcmSivTest::TV_RESULT_8_256[8 + GCM_SIV_TAG_SIZE] = {
+    // c2ef328e 5c71c83b 84312213 0f7364b7 61e0b974 27e3df28
+    0xc2, 0xef, 0x32, 0x8e, 0x5c, 0x71, 0xc8, 0x3b, 0x84, 0x31, 0x22, 0x13,
+    0x0f, 0x73, 0x64, 0xb7, 0x61, 0xe0, 0xb9, 0x74, 0x27, 0xe3, 0xdf, 0x28 };
+
+CPPUNIT_TEST_SUITE_REGISTRATION(AesGcmSivTest);
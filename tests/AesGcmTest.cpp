@@ -0,0 +1,215 @@
+/* Copyright (c) IAIK, Graz University of Technology, 2015.
+ * All rights reserved.
+ * Contact: http://opensource.iaik.tugraz.at
+ * 
+ * This file is part of the Secure Block Device Library.
+ * 
+ * Commercial License Usage
+ * Licensees holding valid commercial licenses may use this file in
+ * accordance with the commercial license agreement provided with the
+ * Software or, alternatively, in accordance with the terms contained in
+ * a written agreement between you and SIC. For further information
+ * contact us at http://opensource.iaik.tugraz.at.
+ * 
+ * Alternatively, this file may be used under the terms of the GNU General
+ * Public License as published by the Free Software Foundation version 2.
+ * 
+ * The Secure Block Device Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with the Secure Block Device Library. If not, see <http://www.gnu.org/licenses/>.
+ */
+///
+/// \file
+/// \brief Tests the AES-GCM implementation used by the Secure Block Device
+/// Library.
+///
+#include "crypto/gcm.h"
+
+#include <string.h>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#define TC_PT_LEN 60
+#define TC_AD_LEN 20
+#define LONG_LEN  2100
+
+class AesGcmTest: public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE( AesGcmTest );
+  CPPUNIT_TEST(testGcmEncryption);
+  CPPUNIT_TEST(testGcmEncryption256);
+  CPPUNIT_TEST(testGcmDecryption);
+  CPPUNIT_TEST(testGcmGenericEqualsAccelerated);
+  CPPUNIT_TEST(testGcmMac);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  // Test cases 4 and 16 of the GCM specification (McGrew and Viega)
+  static unsigned char KEY[32];
+  static unsigned char IV[GCM_IV_SIZE];
+  static unsigned char PLAIN_TEXT[TC_PT_LEN];
+  static unsigned char AD[TC_AD_LEN];
+  static unsigned char TV_CIPHER_TEXT_128[TC_PT_LEN];
+  static unsigned char TV_TAG_128[GCM_TAG_SIZE];
+  static unsigned char TV_CIPHER_TEXT_256[TC_PT_LEN];
+  static unsigned char TV_TAG_256[GCM_TAG_SIZE];
+
+  gcm_ctx ctx;
+  unsigned char ct[LONG_LEN];
+  unsigned char pt[LONG_LEN];
+  unsigned char tag[GCM_TAG_SIZE];
+
+public:
+  void setUp()
+  {
+    CPPUNIT_ASSERT(gcm_init(&ctx, KEY, 128) == 0);
+    memset(ct, 0, LONG_LEN);
+    memset(pt, 0, LONG_LEN);
+  }
+
+  void tearDown()
+  {
+    gcm_clear(&ctx);
+  }
+
+  void testGcmEncryption()
+  {
+    gcm_encrypt(&ctx, IV, AD, TC_AD_LEN, PLAIN_TEXT, ct, TC_PT_LEN, tag);
+    CPPUNIT_ASSERT(!memcmp(ct, TV_CIPHER_TEXT_128, TC_PT_LEN));
+    CPPUNIT_ASSERT(!memcmp(tag, TV_TAG_128, GCM_TAG_SIZE));
+  }
+
+  void testGcmEncryption256()
+  {
+    gcm_ctx ctx256;
+    CPPUNIT_ASSERT(gcm_init(&ctx256, KEY, 256) == 0);
+    gcm_encrypt(&ctx256, IV, AD, TC_AD_LEN, PLAIN_TEXT, ct, TC_PT_LEN, tag);
+    CPPUNIT_ASSERT(!memcmp(ct, TV_CIPHER_TEXT_256, TC_PT_LEN));
+    CPPUNIT_ASSERT(!memcmp(tag, TV_TAG_256, GCM_TAG_SIZE));
+    gcm_clear(&ctx256);
+  }
+
+  void testGcmDecryption()
+  {
+    CPPUNIT_ASSERT(
+        gcm_decrypt(&ctx, IV, AD, TC_AD_LEN, TV_CIPHER_TEXT_128, pt, TC_PT_LEN,
+            TV_TAG_128) == 1);
+    CPPUNIT_ASSERT(!memcmp(pt, PLAIN_TEXT, TC_PT_LEN));
+    // In place decryption
+    memcpy(ct, TV_CIPHER_TEXT_128, TC_PT_LEN);
+    CPPUNIT_ASSERT(
+        gcm_decrypt(&ctx, IV, AD, TC_AD_LEN, ct, ct, TC_PT_LEN, TV_TAG_128)
+            == 1);
+    CPPUNIT_ASSERT(!memcmp(ct, PLAIN_TEXT, TC_PT_LEN));
+    // Modified additional data
+    unsigned char ad[TC_AD_LEN];
+    memcpy(ad, AD, TC_AD_LEN);
+    ad[3] ^= 0x80;
+    CPPUNIT_ASSERT(
+        gcm_decrypt(&ctx, IV, ad, TC_AD_LEN, TV_CIPHER_TEXT_128, pt, TC_PT_LEN,
+            TV_TAG_128) == -1);
+    // Modified ciphertext
+    memcpy(ct, TV_CIPHER_TEXT_128, TC_PT_LEN);
+    ct[TC_PT_LEN - 1] ^= 0x01;
+    CPPUNIT_ASSERT(
+        gcm_decrypt(&ctx, IV, AD, TC_AD_LEN, ct, pt, TC_PT_LEN, TV_TAG_128)
+            == -1);
+  }
+
+  void testGcmGenericEqualsAccelerated()
+  {
+    static const int LENS[] = { 0, 1, 16, 17, 127, 128, 129, 2048, LONG_LEN };
+    gcm_ctx gen;
+    CPPUNIT_ASSERT(gcm_init(&gen, KEY, 128) == 0);
+    // Force the generic code path
+    gen.hkey.use_clmul = 0;
+    unsigned char in[LONG_LEN], tag_gen[GCM_TAG_SIZE];
+    for (int i = 0; i < LONG_LEN; ++i) {
+      in[i] = (unsigned char) (i * 13 + 7);
+    }
+    for (unsigned i = 0; i < sizeof(LENS) / sizeof(LENS[0]); ++i) {
+      gcm_encrypt(&ctx, IV, AD, TC_AD_LEN, in, ct, LENS[i], tag);
+      gcm_encrypt(&gen, IV, AD, TC_AD_LEN, in, pt, LENS[i], tag_gen);
+      CPPUNIT_ASSERT(!memcmp(ct, pt, LENS[i]));
+      CPPUNIT_ASSERT(!memcmp(tag, tag_gen, GCM_TAG_SIZE));
+      CPPUNIT_ASSERT(
+          gcm_decrypt(&gen, IV, AD, TC_AD_LEN, ct, pt, LENS[i], tag) == 1);
+      CPPUNIT_ASSERT(!memcmp(in, pt, LENS[i]));
+    }
+    gcm_clear(&gen);
+  }
+
+  void testGcmMac()
+  {
+    gcm_ctx gen;
+    CPPUNIT_ASSERT(gcm_init(&gen, KEY, 128) == 0);
+    gen.hkey.use_clmul = 0;
+    // The MAC of the ciphertext is the GCM tag
+    gcm_mac(&ctx, IV, AD, TC_AD_LEN, TV_CIPHER_TEXT_128, TC_PT_LEN, tag);
+    CPPUNIT_ASSERT(!memcmp(tag, TV_TAG_128, GCM_TAG_SIZE));
+    gcm_mac(&gen, IV, AD, TC_AD_LEN, TV_CIPHER_TEXT_128, TC_PT_LEN, tag);
+    CPPUNIT_ASSERT(!memcmp(tag, TV_TAG_128, GCM_TAG_SIZE));
+    // Long messages take the aggregated GHASH path
+    unsigned char tag_gen[GCM_TAG_SIZE];
+    for (int i = 0; i < LONG_LEN; ++i) {
+      pt[i] = (unsigned char) (i * 13 + 7);
+    }
+    gcm_encrypt(&ctx, IV, AD, TC_AD_LEN, pt, ct, LONG_LEN, tag);
+    gcm_mac(&gen, IV, AD, TC_AD_LEN, ct, LONG_LEN, tag_gen);
+    CPPUNIT_ASSERT(!memcmp(tag, tag_gen, GCM_TAG_SIZE));
+    gcm_mac(&ctx, IV, AD, TC_AD_LEN, ct, LONG_LEN, tag_gen);
+    CPPUNIT_ASSERT(!memcmp(tag, tag_gen, GCM_TAG_SIZE));
+    gcm_clear(&gen);
+  }
+};
+
+unsigned char AesGcmTest::KEY[32] = {
+    // feffe992 8665731c 6d6a8f94 67308308 (twice)
+    0xfe, 0xff, 0xe9, 0x92, 0x86, 0x65, 0x73, 0x1c, 0x6d, 0x6a, 0x8f, 0x94,
+    0x67, 0x30, 0x83, 0x08, 0xfe, 0xff, 0xe9, 0x92, 0x86, 0x65, 0x73, 0x1c,
+    0x6d, 0x6a, 0x8f, 0x94, 0x67, 0x30, 0x83, 0x08 };
+
+unsigned char AesGcmTest::IV[GCM_IV_SIZE] = {
+    // cafebabe facedbad decaf888
+    0xca, 0xfe, 0xba, 0xbe, 0xfa, 0xce, 0xdb, 0xad, 0xde, 0xca, 0xf8, 0x88 };
+
+unsigned char AesGcmTest::PLAIN_TEXT[TC_PT_LEN] = {
+    0xd9, 0x31, 0x32, 0x25, 0xf8, 0x84, 0x06, 0xe5, 0xa5, 0x59, 0x09, 0xc5,
+    0xaf, 0xf5, 0x26, 0x9a, 0x86, 0xa7, 0xa9, 0x53, 0x15, 0x34, 0xf7, 0xda,
+    0x2e, 0x4c, 0x30, 0x3d, 0x8a, 0x31, 0x8a, 0x72, 0x1c, 0x3c, 0x0c, 0x95,
+    0x95, 0x68, 0x09, 0x53, 0x2f, 0xcf, 0x0e, 0x24, 0x49, 0xa6, 0xb5, 0x25,
+    0xb1, 0x6a, 0xed, 0xf5, 0xaa, 0x0d, 0xe6, 0x57, 0xba, 0x63, 0x7b, 0x39 };
+
+unsigned char AesGcmTest::AD[TC_AD_LEN] = {
+    // feedface deadbeef feedface deadbeef abaddad2
+    0xfe, 0xed, 0xfa, 0xce, 0xde, 0xad, 0xbe, 0xef, 0xfe, 0xed, 0xfa, 0xce,
+    0xde, 0xad, 0xbe, 0xef, 0xab, 0xad, 0xda, 0xd2 };
+
+unsigned char AesGcmTest::TV_CIPHER_TEXT_128[TC_PT_LEN] = {
+    0x42, 0x83, 0x1e, 0xc2, 0x21, 0x77, 0x74, 0x24, 0x4b, 0x72, 0x21, 0xb7,
+    0x84, 0xd0, 0xd4, 0x9c, 0xe3, 0xaa, 0x21, 0x2f, 0x2c, 0x02, 0xa4, 0xe0,
+    0x35, 0xc1, 0x7e, 0x23, 0x29, 0xac, 0xa1, 0x2e, 0x21, 0xd5, 0x14, 0xb2,
+    0x54, 0x66, 0x93, 0x1c, 0x7d, 0x8f, 0x6a, 0x5a, 0xac, 0x84, 0xaa, 0x05,
+    0x1b, 0xa3, 0x0b, 0x39, 0x6a, 0x0a, 0xac, 0x97, 0x3d, 0x58, 0xe0, 0x91 };
+
+unsigned char AesGcmTest::TV_TAG_128[GCM_TAG_SIZE] = {
+    // 5bc94fbc 3221a5db 94fae95a e7121a47
+    0x5b, 0xc9, 0x4f, 0xbc, 0x32, 0x21, 0xa5, 0xdb, 0x94, 0xfa, 0xe9, 0x5a,
+    0xe7, 0x12, 0x1a, 0x47 };
+
+unsigned char AesGcmTest::TV_CIPHER_TEXT_256[TC_PT_LEN] = {
+    0x52, 0x2d, 0xc1, 0xf0, 0x99, 0x56, 0x7d, 0x07, 0xf4, 0x7f, 0x37, 0xa3,
+    0x2a, 0x84, 0x42, 0x7d, 0x64, 0x3a, 0x8c, 0xdc, 0xbf, 0xe5, 0xc0, 0xc9,
+    0x75, 0x98, 0xa2, 0xbd, 0x25, 0x55, 0xd1, 0xaa, 0x8c, 0xb0, 0x8e, 0x48,
+    0x59, 0x0d, 0xbb, 0x3d, 0xa7, 0xb0, 0x8b, 0x10, 0x56, 0x82, 0x88, 0x38,
+    0xc5, 0xf6, 0x1e, 0x63, 0x93, 0xba, 0x7a, 0x0a, 0xbc, 0xc9, 0xf6, 0x62 };
+
+unsigned char AesGcmTest::TV_TAG_256[GCM_TAG_SIZE] = {
+    // 76fc6ece 0f4e1768 cddf8853 bb2d551b
+    0x76, 0xfc, 0x6e, 0xce, 0x0f, 0x4e, 0x17, 0x68, 0xcd, 0xdf, 0x88, 0x53,
+    0xbb, 0x2d, 0x55, 0x1b };
+
+CPPUNIT_TEST_SUITE_REGISTRATION(AesGcmTest);
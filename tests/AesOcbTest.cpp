@@ -0,0 +1,219 @@
+/* Copyright (c) IAIK, Graz University of Technology, 2015.
+ * All rights reserved.
+ * Contact: http://opensource.iaik.tugraz.at
+ * 
+ * This file is part of the Secure Block Device Library.
+ * 
+ * Commercial License Usage
+ * Licensees holding valid commercial licenses may use this file in
+ * accordance with the commercial license agreement provided with the
+ * Software or, alternatively, in accordance with the terms contained in
+ * a written agreement between you and SIC. For further information
+ * contact us at http://opensource.iaik.tugraz.at.
+ * 
+ * Alternatively, this file may be used under the terms of the GNU General
+ * Public License as published by the Free Software Foundation version 2.
+ * 
+ * The Secure Block Device Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with the Secure Block Device Library. If not, see <http://www.gnu.org/licenses/>.
+ */
+///
+/// \file
+/// \brief Tests the AES-OCB implementation used by the Secure Block Device
+/// Library.
+///
+#include "crypto/ae.h"
+#include "crypto/ocb_vaes.h"
+
+#include <string.h>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#define OCB_NONCE_SIZE 12
+#define OCB_TAG_SIZE   16
+#define LONG_LEN       2100
+
+class AesOcbTest: public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE( AesOcbTest );
+  CPPUNIT_TEST(testOcbEncryption);
+  CPPUNIT_TEST(testOcbDecryption);
+  CPPUNIT_TEST(testOcbVaesEqualsBpi);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  // Sample results 1 and 2 of RFC 7253
+  static unsigned char KEY[16];
+  static unsigned char NONCE1[OCB_NONCE_SIZE];
+  static unsigned char NONCE2[OCB_NONCE_SIZE];
+  static unsigned char MSG2[8];
+  static unsigned char TV1_TAG[OCB_TAG_SIZE];
+  static unsigned char TV2_RESULT[8 + OCB_TAG_SIZE];
+
+  ae_ctx *ctx;
+  alignas(16) unsigned char msg[LONG_LEN];
+  alignas(16) unsigned char ct[LONG_LEN];
+  alignas(16) unsigned char pt[LONG_LEN];
+  unsigned char tag[OCB_TAG_SIZE];
+
+  /*!
+   * \brief Encrypts msg in pieces of the given numbers of blocks and the rest
+   * in a final call
+   *
+   * The associated data is passed to the final call, because a partial block
+   * of associated data is only processed there.
+   */
+  void encryptPieces(ae_ctx *c, const int *blks, int n, int len,
+      unsigned char *out, unsigned char *t)
+  {
+    int done = 0;
+    for (int i = 0; i < n; ++i) {
+      CPPUNIT_ASSERT(
+          ae_encrypt(c, done ? NULL : NONCE2, msg + done, 16 * blks[i], NULL,
+              0, out + done, NULL, AE_PENDING) >= 0);
+      done += 16 * blks[i];
+    }
+    CPPUNIT_ASSERT(
+        ae_encrypt(c, done ? NULL : NONCE2, msg + done, len - done, MSG2,
+            sizeof(MSG2), out + done, t, AE_FINALIZE) >= 0);
+  }
+
+  /*!
+   * \brief Decrypts ct in pieces of the given numbers of blocks and the rest
+   * in a final call
+   */
+  int decryptPieces(ae_ctx *c, const int *blks, int n, int len,
+      const unsigned char *t)
+  {
+    int done = 0;
+    for (int i = 0; i < n; ++i) {
+      CPPUNIT_ASSERT(
+          ae_decrypt(c, done ? NULL : NONCE2, ct + done, 16 * blks[i], NULL,
+              0, pt + done, NULL, AE_PENDING) >= 0);
+      done += 16 * blks[i];
+    }
+    return ae_decrypt(c, done ? NULL : NONCE2, ct + done, len - done, MSG2,
+        sizeof(MSG2), pt + done, t, AE_FINALIZE);
+  }
+
+public:
+  void setUp()
+  {
+    ctx = ae_allocate(NULL);
+    CPPUNIT_ASSERT(ctx);
+    CPPUNIT_ASSERT(
+        ae_init(ctx, KEY, sizeof(KEY), OCB_NONCE_SIZE, OCB_TAG_SIZE) == AE_SUCCESS);
+    for (int i = 0; i < LONG_LEN; ++i) {
+      msg[i] = (unsigned char) i;
+    }
+    memset(ct, 0, LONG_LEN);
+    memset(pt, 0, LONG_LEN);
+  }
+
+  void tearDown()
+  {
+    ae_clear(ctx);
+    ae_free(ctx);
+  }
+
+  void testOcbEncryption()
+  {
+    CPPUNIT_ASSERT(ae_encrypt(ctx, NONCE1, NULL, 0, NULL, 0, ct, tag, AE_FINALIZE) >= 0);
+    CPPUNIT_ASSERT(!memcmp(tag, TV1_TAG, OCB_TAG_SIZE));
+    CPPUNIT_ASSERT(
+        ae_encrypt(ctx, NONCE2, MSG2, sizeof(MSG2), MSG2, sizeof(MSG2), ct, tag,
+            AE_FINALIZE) >= 0);
+    CPPUNIT_ASSERT(!memcmp(ct, TV2_RESULT, sizeof(MSG2)));
+    CPPUNIT_ASSERT(!memcmp(tag, TV2_RESULT + sizeof(MSG2), OCB_TAG_SIZE));
+  }
+
+  void testOcbDecryption()
+  {
+    CPPUNIT_ASSERT(
+        ae_decrypt(ctx, NONCE2, TV2_RESULT, sizeof(MSG2), MSG2, sizeof(MSG2),
+            pt, TV2_RESULT + sizeof(MSG2), AE_FINALIZE) == sizeof(MSG2));
+    CPPUNIT_ASSERT(!memcmp(pt, MSG2, sizeof(MSG2)));
+    memcpy(tag, TV2_RESULT + sizeof(MSG2), OCB_TAG_SIZE);
+    tag[0] ^= 1;
+    CPPUNIT_ASSERT(
+        ae_decrypt(ctx, NONCE2, TV2_RESULT, sizeof(MSG2), MSG2, sizeof(MSG2),
+            pt, tag, AE_FINALIZE) == AE_INVALID);
+  }
+
+  void testOcbVaesEqualsBpi()
+  {
+    static const unsigned WIDTHS[] = { 512, 256 };
+    // Whole chunks, chunks plus a partial block and odd lengths
+    static const int LENS[] = { 16 * OCB_VAES_CHUNK, 16 * OCB_VAES_CHUNK + 1,
+        3 * 16 * OCB_VAES_CHUNK + 8 * 16 + 5, 5 * 16 * OCB_VAES_CHUNK + 15,
+        LONG_LEN };
+    // Incremental calls; the block counts make the number of processed
+    // blocks at the start of a call 0, 8, 32, 64, 80 and 120, so the chunk
+    // kernels run on some calls only and the block number is not always 0
+    static const int PIECES[] = { 8, 24, 32, 16, 40 };
+    const int n_pieces = sizeof(PIECES) / sizeof(PIECES[0]);
+    unsigned char ref[LONG_LEN];
+    unsigned char tag_ref[OCB_TAG_SIZE];
+    ae_ctx *bpi = ae_allocate(NULL);
+    CPPUNIT_ASSERT(bpi);
+    CPPUNIT_ASSERT(
+        ae_init(bpi, KEY, sizeof(KEY), OCB_NONCE_SIZE, OCB_TAG_SIZE) == AE_SUCCESS);
+    // Force the generic code path
+    CPPUNIT_ASSERT(ocb_vaes_set_width(bpi, 0) == 0);
+    for (unsigned w = 0; w < sizeof(WIDTHS) / sizeof(WIDTHS[0]); ++w) {
+      if (ocb_vaes_set_width(ctx, WIDTHS[w]) != WIDTHS[w]) {
+        // The CPU does not support kernels of this width
+        continue;
+      }
+      for (unsigned i = 0; i < sizeof(LENS) / sizeof(LENS[0]); ++i) {
+        encryptPieces(bpi, NULL, 0, LENS[i], ref, tag_ref);
+        encryptPieces(ctx, NULL, 0, LENS[i], ct, tag);
+        CPPUNIT_ASSERT(!memcmp(ct, ref, LENS[i]));
+        CPPUNIT_ASSERT(!memcmp(tag, tag_ref, OCB_TAG_SIZE));
+        CPPUNIT_ASSERT(decryptPieces(ctx, NULL, 0, LENS[i], tag) >= 0);
+        CPPUNIT_ASSERT(!memcmp(pt, msg, LENS[i]));
+      }
+      const int len = LONG_LEN - 100;
+      encryptPieces(bpi, NULL, 0, len, ref, tag_ref);
+      encryptPieces(ctx, PIECES, n_pieces, len, ct, tag);
+      CPPUNIT_ASSERT(!memcmp(ct, ref, len));
+      CPPUNIT_ASSERT(!memcmp(tag, tag_ref, OCB_TAG_SIZE));
+      memset(pt, 0, LONG_LEN);
+      CPPUNIT_ASSERT(decryptPieces(ctx, PIECES, n_pieces, len, tag) >= 0);
+      CPPUNIT_ASSERT(!memcmp(pt, msg, len));
+      memset(pt, 0, LONG_LEN);
+      CPPUNIT_ASSERT(decryptPieces(bpi, PIECES, n_pieces, len, tag) >= 0);
+      CPPUNIT_ASSERT(!memcmp(pt, msg, len));
+    }
+    ae_clear(bpi);
+    ae_free(bpi);
+  }
+};
+
+unsigned char AesOcbTest::KEY[16] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05,
+    0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f };
+
+unsigned char AesOcbTest::NONCE1[OCB_NONCE_SIZE] = { 0xbb, 0xaa, 0x99, 0x88,
+    0x77, 0x66, 0x55, 0x44, 0x33, 0x22, 0x11, 0x00 };
+
+unsigned char AesOcbTest::NONCE2[OCB_NONCE_SIZE] = { 0xbb, 0xaa, 0x99, 0x88,
+    0x77, 0x66, 0x55, 0x44, 0x33, 0x22, 0x11, 0x01 };
+
+unsigned char AesOcbTest::MSG2[8] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05,
+    0x06, 0x07 };
+
+unsigned char AesOcbTest::TV1_TAG[OCB_TAG_SIZE] = {
+    // 785407bf ffc8ad9e dcc5520a c9111ee6
+    0x78, 0x54, 0x07, 0xbf, 0xff, 0xc8, 0xad, 0x9e, 0xdc, 0xc5, 0x52, 0x0a,
+    0xc9, 0x11, 0x1e, 0xe6 };
+
+unsigned char AesOcbTest::TV2_RESULT[8 + OCB_TAG_SIZE] = {
+    // 6820b365 7b6f615a 5725bda0 d3b4eb3a 257c9af1 f8f03009
+    0x68, 0x20, 0xb3, 0x65, 0x7b, 0x6f, 0x61, 0x5a, 0x57, 0x25, 0xbd, 0xa0,
+    0xd3, 0xb4, 0xeb, 0x3a, 0x25, 0x7c, 0x9a, 0xf1, 0xf8, 0xf0, 0x30, 0x09 };
+
+CPPUNIT_TEST_SUITE_REGISTRATION(AesOcbTest);
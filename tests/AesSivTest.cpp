@@ -44,6 +44,8 @@ class AesSivTest: public CppUnit::TestFixture {
   CPPUNIT_TEST(testSivDecryption);
   CPPUNIT_TEST(testSivInplaceEnDecryption);
   CPPUNIT_TEST(testSivAesCmac);
+  CPPUNIT_TEST(testSivFusedDecryption);
+  CPPUNIT_TEST(testSivCtrBatches);
   CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -152,6 +154,71 @@ public:
     dec2(tstMemIdx(3), tstMemIdx(4), ivMemIdx(0), PT2_LEN);
   }
 
+  void testSivFusedDecryption()
+  {
+    static const int LENS[] = { PT_LEN, PT2_LEN, PT2_LEN + 1, 3 * PT2_LEN,
+        2048 };
+    unsigned char pt[2048], ct[2048], dc[2048], dc2[2048];
+    for (int i = 0; i < 2048; ++i) {
+      pt[i] = (unsigned char) (i * 13 + 5);
+    }
+    for (unsigned l = 0; l < sizeof(LENS) / sizeof(LENS[0]); ++l) {
+      const int len = LENS[l];
+      enc(pt, ct, IV, len);
+      // The fused decryption must match the two-pass decryption
+      dec(ct, dc, IV, len);
+      CPPUNIT_ASSERT(
+          siv_decrypt_fused(&tst, ct, dc2, len, IV, AD_H1, AD_LEN) == 1);
+      CPPUNIT_ASSERT(!memcmp(dc, dc2, len) && !memcmp(pt, dc2, len));
+      // In-place
+      memcpy(dc2, ct, len);
+      CPPUNIT_ASSERT(
+          siv_decrypt_fused(&tst, dc2, dc2, len, IV, AD_H1, AD_LEN) == 1);
+      CPPUNIT_ASSERT(!memcmp(pt, dc2, len));
+      // Modified ciphertext
+      ct[len - 1] ^= 0x01;
+      CPPUNIT_ASSERT(
+          siv_decrypt_fused(&tst, ct, dc2, len, IV, AD_H1, AD_LEN) == -1);
+    }
+  }
+
+  void testSivCtrBatches()
+  {
+    static const int LENS[] = { 1, PT2_LEN, 127, 128, 129, 2053 };
+    unsigned char pt[2053], ct[2053], ref[2053], ctr[IV_LEN], ks[IV_LEN];
+    for (int i = 0; i < 2053; ++i) {
+      pt[i] = (unsigned char) (i * 7 + 3);
+    }
+    // The counter carries into the cleared bit 31 within the first batch
+    memcpy(ctr, TV_IV, IV_LEN);
+    ctr[12] = ctr[13] = ctr[14] = 0xff;
+    ctr[15] = 0xfd;
+    for (unsigned l = 0; l < sizeof(LENS) / sizeof(LENS[0]); ++l) {
+      const int len = LENS[l];
+      // One block per AES call as in the original SIV implementation
+      uint32_t c = 0x7ffffffd;
+      unsigned char cb[IV_LEN];
+      memcpy(cb, ctr, IV_LEN);
+      cb[8] &= 0x7f;
+      for (int i = 0; i < len; i += IV_LEN, ++c) {
+        cb[12] = (unsigned char) (c >> 24);
+        cb[13] = (unsigned char) (c >> 16);
+        cb[14] = (unsigned char) (c >> 8);
+        cb[15] = (unsigned char) c;
+        AES_encrypt(cb, ks, &ctx.ctr_sched);
+        for (int j = 0; j < IV_LEN && i + j < len; ++j) {
+          ref[i + j] = pt[i + j] ^ ks[j];
+        }
+      }
+      siv_aes_ctr(&ctx, pt, len, ct, ctr);
+      CPPUNIT_ASSERT(!memcmp(ct, ref, len));
+      // In-place
+      memcpy(ct, pt, len);
+      siv_aes_ctr(&ctx, ct, len, ct, ctr);
+      CPPUNIT_ASSERT(!memcmp(ct, ref, len));
+    }
+  }
+
   void testSivAesCmac() {
     memcpy(iv_mem, PLAIN_TEXT_2, PT2_LEN);
     memcpy(iv_mem + PT2_LEN, PLAIN_TEXT_3, IV_LEN*2);
@@ -0,0 +1,190 @@
+/* Copyright (c) IAIK, Graz University of Technology, 2015.
+ * All rights reserved.
+ * Contact: http://opensource.iaik.tugraz.at
+ * 
+ * This file is part of the Secure Block Device Library.
+ * 
+ * Commercial License Usage
+ * Licensees holding valid commercial licenses may use this file in
+ * accordance with the commercial license agreement provided with the
+ * Software or, alternatively, in accordance with the terms contained in
+ * a written agreement between you and SIC. For further information
+ * contact us at http://opensource.iaik.tugraz.at.
+ * 
+ * Alternatively, this file may be used under the terms of the GNU General
+ * Public License as published by the Free Software Foundation version 2.
+ * 
+ * The Secure Block Device Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with the Secure Block Device Library. If not, see <http://www.gnu.org/licenses/>.
+ */
+///
+/// \file
+/// \brief Tests the ChaCha20-Poly1305 implementation used by the Secure Block
+/// Device Library.
+///
+#include "crypto/chacha20_poly1305.h"
+
+#include <string.h>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#define LONG_LEN 2100
+
+class ChaChaPolyTest: public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE( ChaChaPolyTest );
+  CPPUNIT_TEST(testPoly1305);
+  CPPUNIT_TEST(testChaChaPolyEncryption);
+  CPPUNIT_TEST(testChaChaPolyDecryption);
+  CPPUNIT_TEST(testChaChaPolyGenericEqualsSimd);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  // Test vectors of RFC 8439, sections 2.5.2 and 2.8.2
+  static unsigned char POLY_KEY[POLY1305_KEY_SIZE];
+  static const char *POLY_MSG;
+  static unsigned char POLY_TAG[POLY1305_TAG_SIZE];
+  static unsigned char NONCE[CHACHA20_NONCE_SIZE];
+  static unsigned char AD[12];
+  static const char *PLAIN_TEXT;
+  static unsigned char CT_START[16];
+  static unsigned char TAG[POLY1305_TAG_SIZE];
+
+  unsigned char key[CHACHA20_KEY_SIZE];
+  chacha20_poly1305_ctx ctx;
+  unsigned char ct[LONG_LEN];
+  unsigned char pt[LONG_LEN];
+  unsigned char tag[POLY1305_TAG_SIZE];
+  int len;
+
+public:
+  void setUp()
+  {
+    for (int i = 0; i < CHACHA20_KEY_SIZE; ++i) {
+      key[i] = (unsigned char) (0x80 + i);
+    }
+    CPPUNIT_ASSERT(chacha20_poly1305_init(&ctx, key) == 0);
+    memset(ct, 0, LONG_LEN);
+    memset(pt, 0, LONG_LEN);
+    len = strlen(PLAIN_TEXT);
+  }
+
+  void tearDown()
+  {
+    chacha20_poly1305_clear(&ctx);
+  }
+
+  void testPoly1305()
+  {
+    poly1305_state st;
+    const int mlen = strlen(POLY_MSG);
+    poly1305_init(&st, POLY_KEY, CHACHA20_SIMD_NONE);
+    poly1305_update(&st, (const unsigned char *) POLY_MSG, mlen);
+    poly1305_finish(&st, tag);
+    CPPUNIT_ASSERT(!memcmp(tag, POLY_TAG, POLY1305_TAG_SIZE));
+    // Incremental updates
+    poly1305_init(&st, POLY_KEY, chacha20_simd_level());
+    for (int i = 0; i < mlen; i += 5) {
+      poly1305_update(&st, (const unsigned char *) POLY_MSG + i,
+          (mlen - i < 5) ? mlen - i : 5);
+    }
+    poly1305_finish(&st, tag);
+    CPPUNIT_ASSERT(!memcmp(tag, POLY_TAG, POLY1305_TAG_SIZE));
+  }
+
+  void testChaChaPolyEncryption()
+  {
+    chacha20_poly1305_encrypt(&ctx, NONCE, AD, sizeof(AD),
+        (const unsigned char *) PLAIN_TEXT, ct, len, tag);
+    CPPUNIT_ASSERT(!memcmp(ct, CT_START, sizeof(CT_START)));
+    CPPUNIT_ASSERT(!memcmp(tag, TAG, POLY1305_TAG_SIZE));
+  }
+
+  void testChaChaPolyDecryption()
+  {
+    chacha20_poly1305_encrypt(&ctx, NONCE, AD, sizeof(AD),
+        (const unsigned char *) PLAIN_TEXT, ct, len, tag);
+    CPPUNIT_ASSERT(
+        chacha20_poly1305_decrypt(&ctx, NONCE, AD, sizeof(AD), ct, pt, len,
+            tag) == 1);
+    CPPUNIT_ASSERT(!memcmp(pt, PLAIN_TEXT, len));
+    // In place decryption
+    CPPUNIT_ASSERT(
+        chacha20_poly1305_decrypt(&ctx, NONCE, AD, sizeof(AD), ct, ct, len,
+            tag) == 1);
+    CPPUNIT_ASSERT(!memcmp(ct, PLAIN_TEXT, len));
+    // Modified ciphertext
+    chacha20_poly1305_encrypt(&ctx, NONCE, AD, sizeof(AD),
+        (const unsigned char *) PLAIN_TEXT, ct, len, tag);
+    ct[len - 1] ^= 0x01;
+    CPPUNIT_ASSERT(
+        chacha20_poly1305_decrypt(&ctx, NONCE, AD, sizeof(AD), ct, pt, len,
+            tag) == -1);
+    ct[len - 1] ^= 0x01;
+    // Modified additional data
+    CPPUNIT_ASSERT(
+        chacha20_poly1305_decrypt(&ctx, NONCE, AD, sizeof(AD) - 1, ct, pt,
+            len, tag) == -1);
+  }
+
+  void testChaChaPolyGenericEqualsSimd()
+  {
+    static const int LENS[] = { 1, 64, 65, 255, 256, 511, 512, 4096 - 1,
+        LONG_LEN };
+    chacha20_poly1305_ctx gen;
+    unsigned char in[LONG_LEN], tag_gen[POLY1305_TAG_SIZE];
+    for (int i = 0; i < LONG_LEN; ++i) {
+      in[i] = (unsigned char) (i * 13 + 7);
+    }
+    for (int simd = CHACHA20_SIMD_SSE2; simd <= chacha20_simd_level();
+        ++simd) {
+      CPPUNIT_ASSERT(chacha20_poly1305_init(&gen, key) == 0);
+      // Force the portable code path
+      gen.simd = CHACHA20_SIMD_NONE;
+      ctx.simd = simd;
+      for (unsigned i = 0; i < sizeof(LENS) / sizeof(LENS[0]); ++i) {
+        const int l = (LENS[i] < LONG_LEN) ? LENS[i] : LONG_LEN;
+        chacha20_poly1305_encrypt(&ctx, NONCE, AD, sizeof(AD), in, ct, l, tag);
+        chacha20_poly1305_encrypt(&gen, NONCE, AD, sizeof(AD), in, pt, l,
+            tag_gen);
+        CPPUNIT_ASSERT(!memcmp(ct, pt, l));
+        CPPUNIT_ASSERT(!memcmp(tag, tag_gen, POLY1305_TAG_SIZE));
+      }
+      chacha20_poly1305_clear(&gen);
+    }
+  }
+};
+
+unsigned char ChaChaPolyTest::POLY_KEY[POLY1305_KEY_SIZE] = { 0x85, 0xd6,
+    0xbe, 0x78, 0x57, 0x55, 0x6d, 0x33, 0x7f, 0x44, 0x52, 0xfe, 0x42, 0xd5,
+    0x06, 0xa8, 0x01, 0x03, 0x80, 0x8a, 0xfb, 0x0d, 0xb2, 0xfd, 0x4a, 0xbf,
+    0xf6, 0xaf, 0x41, 0x49, 0xf5, 0x1b };
+
+const char *ChaChaPolyTest::POLY_MSG = "Cryptographic Forum Research Group";
+
+unsigned char ChaChaPolyTest::POLY_TAG[POLY1305_TAG_SIZE] = { 0xa8, 0x06,
+    0x1d, 0xc1, 0x30, 0x51, 0x36, 0xc6, 0xc2, 0x2b, 0x8b, 0xaf, 0x0c, 0x01,
+    0x27, 0xa9 };
+
+unsigned char ChaChaPolyTest::NONCE[CHACHA20_NONCE_SIZE] = { 0x07, 0x00,
+    0x00, 0x00, 0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47 };
+
+unsigned char ChaChaPolyTest::AD[12] = { 0x50, 0x51, 0x52, 0x53, 0xc0, 0xc1,
+    0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7 };
+
+const char *ChaChaPolyTest::PLAIN_TEXT =
+    "Ladies and Gentlemen of the class of '99: If I could offer you only "
+        "one tip for the future, sunscreen would be it.";
+
+unsigned char ChaChaPolyTest::CT_START[16] = { 0xd3, 0x1a, 0x8d, 0x34, 0x64,
+    0x8e, 0x60, 0xdb, 0x7b, 0x86, 0xaf, 0xbc, 0x53, 0xef, 0x7e, 0xc2 };
+
+unsigned char ChaChaPolyTest::TAG[POLY1305_TAG_SIZE] = { 0x1a, 0xe1, 0x0b,
+    0x59, 0x4f, 0x09, 0xe2, 0x6a, 0x7e, 0x90, 0x2e, 0xcb, 0xd0, 0x60, 0x06,
+    0x91 };
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ChaChaPolyTest);
@@ -0,0 +1,221 @@
+/* Copyright (c) IAIK, Graz University of Technology, 2015.
+ * All rights reserved.
+ * Contact: http://opensource.iaik.tugraz.at
+ * 
+ * This file is part of the Secure Block Device Library.
+ * 
+ * Commercial License Usage
+ * Licensees holding valid commercial licenses may use this file in
+ * accordance with the commercial license agreement provided with the
+ * Software or, alternatively, in accordance with the terms contained in
+ * a written agreement between you and SIC. For further information
+ * contact us at http://opensource.iaik.tugraz.at.
+ * 
+ * Alternatively, this file may be used under the terms of the GNU General
+ * Public License as published by the Free Software Foundation version 2.
+ * 
+ * The Secure Block Device Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with the Secure Block Device Library. If not, see <http://www.gnu.org/licenses/>.
+ */
+///
+/// \file
+/// \brief Tests the HMAC-SHA256 implementation used by the Secure Block
+/// Device Library.
+///
+#include "crypto/sbdi_hmac.h"
+
+#include <string.h>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#define KEY_LEN  131
+#define LONG_LEN (SBDI_BLOCK_SIZE + 80)
+
+class HmacSha256Test: public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE( HmacSha256Test );
+  CPPUNIT_TEST(testRfc4231);
+  CPPUNIT_TEST(testSplitMessages);
+  CPPUNIT_TEST(testGenericEqualsShaNi);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  // Test cases 1 to 7 of RFC 4231
+  static const char *TC_DATA[7];
+  static unsigned char TC_MAC[7][SBDI_HMAC_SHA256_SIZE];
+
+  unsigned char key[KEY_LEN];
+  unsigned char msg[LONG_LEN];
+  unsigned char mac[SBDI_HMAC_SHA256_SIZE];
+
+  /*!
+   * \brief Sets up the key and the data of the given RFC 4231 test case
+   *
+   * @return the length of the key
+   */
+  size_t setupCase(int tc, const unsigned char **data, size_t *len)
+  {
+    static const size_t KEY_LENS[7] = { 20, 4, 20, 25, 20, 131, 131 };
+    switch (tc) {
+    case 0:
+      memset(key, 0x0b, KEY_LENS[tc]);
+      break;
+    case 1:
+      memcpy(key, "Jefe", KEY_LENS[tc]);
+      break;
+    case 3:
+      for (size_t i = 0; i < KEY_LENS[tc]; ++i) {
+        key[i] = (unsigned char) (i + 1);
+      }
+      break;
+    case 4:
+      memset(key, 0x0c, KEY_LENS[tc]);
+      break;
+    default:
+      memset(key, 0xaa, KEY_LENS[tc]);
+      break;
+    }
+    if (tc == 2 || tc == 3) {
+      memset(msg, (tc == 2) ? 0xdd : 0xcd, 50);
+      *data = msg;
+      *len = 50;
+    } else {
+      *data = (const unsigned char *) TC_DATA[tc];
+      *len = strlen(TC_DATA[tc]);
+    }
+    return KEY_LENS[tc];
+  }
+
+  void checkCases(sbdi_hmac_sha256_impl_t impl)
+  {
+    for (int tc = 0; tc < 7; ++tc) {
+      const unsigned char *data = NULL;
+      size_t len = 0;
+      size_t k_len = setupCase(tc, &data, &len);
+      memset(mac, 0, SBDI_HMAC_SHA256_SIZE);
+      CPPUNIT_ASSERT(
+          sbdi_hmac_sha256_compute(impl, key, k_len, data, len, NULL, 0, mac) == SBDI_SUCCESS);
+      // Test case 5 only specifies the output truncated to 128 bits
+      CPPUNIT_ASSERT(!memcmp(mac, TC_MAC[tc], (tc == 4) ? 16 : SBDI_HMAC_SHA256_SIZE));
+    }
+  }
+
+public:
+  void setUp()
+  {
+    for (unsigned i = 0; i < LONG_LEN; ++i) {
+      msg[i] = (unsigned char) (31 * i + 7);
+    }
+  }
+
+  void tearDown()
+  {
+  }
+
+  void testRfc4231()
+  {
+    checkCases(SBDI_HMAC_SHA256_AUTO);
+    checkCases(SBDI_HMAC_SHA256_GENERIC);
+    if (sbdi_hmac_sha256_compute(SBDI_HMAC_SHA256_SHA_NI, key, 1, msg, 1, NULL,
+        0, mac) == SBDI_SUCCESS) {
+      checkCases(SBDI_HMAC_SHA256_SHA_NI);
+    }
+    CPPUNIT_ASSERT(
+        sbdi_hmac_sha256_compute(SBDI_HMAC_SHA256_AUTO, NULL, 0, msg, 1, NULL, 0, mac) == SBDI_ERR_ILLEGAL_PARAM);
+    CPPUNIT_ASSERT(
+        sbdi_hmac_sha256_compute(SBDI_HMAC_SHA256_AUTO, key, 1, NULL, 1, NULL, 0, mac) == SBDI_ERR_ILLEGAL_PARAM);
+  }
+
+  void testSplitMessages()
+  {
+    // Resuming from the midstates with buffered partial blocks gives the same
+    // MAC as a single message
+    const unsigned char *data = NULL;
+    size_t len = 0;
+    size_t k_len = setupCase(6, &data, &len);
+    for (size_t split = 0; split <= len; ++split) {
+      memset(mac, 0, SBDI_HMAC_SHA256_SIZE);
+      CPPUNIT_ASSERT(
+          sbdi_hmac_sha256_compute(SBDI_HMAC_SHA256_AUTO, key, k_len, data, split, data + split, len - split, mac) == SBDI_SUCCESS);
+      CPPUNIT_ASSERT(!memcmp(mac, TC_MAC[6], SBDI_HMAC_SHA256_SIZE));
+    }
+  }
+
+  void testGenericEqualsShaNi()
+  {
+    static const size_t KEY_LENS[] = { 1, 32, 63, 64, 65, KEY_LEN };
+    // Empty, partial, exactly padded and multi-block messages
+    static const size_t LENS[] = { 0, 1, 55, 56, 63, 64, 65, 119, 128, 200,
+        SBDI_BLOCK_SIZE, LONG_LEN };
+    static const size_t SPLITS[] = { 0, 1, 16, 63, 64, 100 };
+    unsigned char ref[SBDI_HMAC_SHA256_SIZE];
+    for (size_t i = 0; i < KEY_LEN; ++i) {
+      key[i] = (unsigned char) (i ^ 0x5a);
+    }
+    if (sbdi_hmac_sha256_compute(SBDI_HMAC_SHA256_SHA_NI, key, 1, msg, 1, NULL,
+        0, mac) == SBDI_ERR_UNSUPPORTED) {
+      // Nothing to compare against on this CPU
+      return;
+    }
+    for (size_t k = 0; k < sizeof(KEY_LENS) / sizeof(KEY_LENS[0]); ++k) {
+      for (size_t l = 0; l < sizeof(LENS) / sizeof(LENS[0]); ++l) {
+        for (size_t s = 0; s < sizeof(SPLITS) / sizeof(SPLITS[0]); ++s) {
+          const size_t len = LENS[l];
+          const size_t split = (SPLITS[s] > len) ? len : SPLITS[s];
+          CPPUNIT_ASSERT(
+              sbdi_hmac_sha256_compute(SBDI_HMAC_SHA256_GENERIC, key, KEY_LENS[k], msg, split, msg + split, len - split, ref) == SBDI_SUCCESS);
+          CPPUNIT_ASSERT(
+              sbdi_hmac_sha256_compute(SBDI_HMAC_SHA256_SHA_NI, key, KEY_LENS[k], msg, split, msg + split, len - split, mac) == SBDI_SUCCESS);
+          CPPUNIT_ASSERT(!memcmp(mac, ref, SBDI_HMAC_SHA256_SIZE));
+        }
+      }
+    }
+  }
+};
+
+const char *HmacSha256Test::TC_DATA[7] = {
+    "Hi There",
+    "what do ya want for nothing?",
+    NULL,
+    NULL,
+    "Test With Truncation",
+    "Test Using Larger Than Block-Size Key - Hash Key First",
+    "This is a test using a larger than block-size key and a larger than "
+    "block-size data. The key needs to be hashed before being used by the "
+    "HMAC algorithm." };
+
+unsigned char HmacSha256Test::TC_MAC[7][SBDI_HMAC_SHA256_SIZE] = {
+    // b0344c61 d8db3853 5ca8afce af0bf12b 881dc200 c9833da7 26e9376c 2e32cff7
+    { 0xb0, 0x34, 0x4c, 0x61, 0xd8, 0xdb, 0x38, 0x53, 0x5c, 0xa8, 0xaf, 0xce,
+      0xaf, 0x0b, 0xf1, 0x2b, 0x88, 0x1d, 0xc2, 0x00, 0xc9, 0x83, 0x3d, 0xa7,
+      0x26, 0xe9, 0x37, 0x6c, 0x2e, 0x32, 0xcf, 0xf7 },
+    // 5bdcc146 bf60754e 6a042426 089575c7 5a003f08 9d273983 9dec58b9 64ec3843
+    { 0x5b, 0xdc, 0xc1, 0x46, 0xbf, 0x60, 0x75, 0x4e, 0x6a, 0x04, 0x24, 0x26,
+      0x08, 0x95, 0x75, 0xc7, 0x5a, 0x00, 0x3f, 0x08, 0x9d, 0x27, 0x39, 0x83,
+      0x9d, 0xec, 0x58, 0xb9, 0x64, 0xec, 0x38, 0x43 },
+    // 773ea91e 36800e46 854db8eb d09181a7 2959098b 3ef8c122 d9635514 ced565fe
+    { 0x77, 0x3e, 0xa9, 0x1e, 0x36, 0x80, 0x0e, 0x46, 0x85, 0x4d, 0xb8, 0xeb,
+      0xd0, 0x91, 0x81, 0xa7, 0x29, 0x59, 0x09, 0x8b, 0x3e, 0xf8, 0xc1, 0x22,
+      0xd9, 0x63, 0x55, 0x14, 0xce, 0xd5, 0x65, 0xfe },
+    // 82558a38 9a443c0e a4cc8198 99f2083a 85f0faa3 e578f807 7a2e3ff4 6729665b
+    { 0x82, 0x55, 0x8a, 0x38, 0x9a, 0x44, 0x3c, 0x0e, 0xa4, 0xcc, 0x81, 0x98,
+      0x99, 0xf2, 0x08, 0x3a, 0x85, 0xf0, 0xfa, 0xa3, 0xe5, 0x78, 0xf8, 0x07,
+      0x7a, 0x2e, 0x3f, 0xf4, 0x67, 0x29, 0x66, 0x5b },
+    // a3b61674 73100ee0 6e0c796c 2955552b
+    { 0xa3, 0xb6, 0x16, 0x74, 0x73, 0x10, 0x0e, 0xe0, 0x6e, 0x0c, 0x79, 0x6c,
+      0x29, 0x55, 0x55, 0x2b, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },
+    // 60e43159 1ee0b67f 0d8a26aa cbf5b77f 8e0bc621 3728c514 0546040f 0ee37f54
+    { 0x60, 0xe4, 0x31, 0x59, 0x1e, 0xe0, 0xb6, 0x7f, 0x0d, 0x8a, 0x26, 0xaa,
+      0xcb, 0xf5, 0xb7, 0x7f, 0x8e, 0x0b, 0xc6, 0x21, 0x37, 0x28, 0xc5, 0x14,
+      0x05, 0x46, 0x04, 0x0f, 0x0e, 0xe3, 0x7f, 0x54 },
+    // 9b09ffa7 1b942fcb 27635fbc d5b0e944 bfdc6364 4f071393 8a7f5153 5c3a35e2
+    { 0x9b, 0x09, 0xff, 0xa7, 0x1b, 0x94, 0x2f, 0xcb, 0x27, 0x63, 0x5f, 0xbc,
+      0xd5, 0xb0, 0xe9, 0x44, 0xbf, 0xdc, 0x63, 0x64, 0x4f, 0x07, 0x13, 0x93,
+      0x8a, 0x7f, 0x51, 0x53, 0x5c, 0x3a, 0x35, 0xe2 } };
+
+CPPUNIT_TEST_SUITE_REGISTRATION(HmacSha256Test);
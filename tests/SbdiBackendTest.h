@@ -0,0 +1,157 @@
+/* Copyright (c) IAIK, Graz University of Technology, 2015.
+ * All rights reserved.
+ * Contact: http://opensource.iaik.tugraz.at
+ * 
+ * This file is part of the Secure Block Device Library.
+ * 
+ * Commercial License Usage
+ * Licensees holding valid commercial licenses may use this file in
+ * accordance with the commercial license agreement provided with the
+ * Software or, alternatively, in accordance with the terms contained in
+ * a written agreement between you and SIC. For further information
+ * contact us at http://opensource.iaik.tugraz.at.
+ * 
+ * Alternatively, this file may be used under the terms of the GNU General
+ * Public License as published by the Free Software Foundation version 2.
+ * 
+ * The Secure Block Device Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with the Secure Block Device Library. If not, see <http://www.gnu.org/licenses/>.
+ */
+///
+/// \file
+/// \brief Shared fixture for the tests of the block layer back ends.
+///
+#ifndef SBDIBACKENDTEST_H_
+#define SBDIBACKENDTEST_H_
+
+#include "SbdiTest.h"
+#include "SecureBlockDeviceInterface.h"
+
+#include <sys/types.h>
+#include <string.h>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <vector>
+
+static unsigned char SIV_KEYS[32] = {
+    0xff, 0xfe, 0xfd, 0xfc, 0xfb, 0xfa, 0xf9, 0xf8, 0xf7, 0xf6, 0xf5, 0xf4,
+    0xf3, 0xf2, 0xf1, 0xf0, 0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7,
+    0xf8, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe, 0xff };
+
+/*!
+ * \brief Base fixture for back end tests
+ *
+ * A suite derives from this fixture and implements openBackend and
+ * closeBackend to create and delete its back end in pio. The fixture
+ * provides block granular access to the back end and a round trip through
+ * the secure block device that reopens the back end in between.
+ */
+class SbdiBackendTest: public CppUnit::TestFixture {
+protected:
+  sbdi_pio_t *pio;
+
+  /*!
+   * \brief Creates the back end under test and stores it in pio
+   */
+  virtual void openBackend() = 0;
+
+  /*!
+   * \brief Deletes the back end created by openBackend
+   */
+  virtual void closeBackend() = 0;
+
+  void pwriteBlk(sbdi_pio_t *p, int c, uint32_t blk)
+  {
+    unsigned char b[SBDI_BLOCK_SIZE];
+    memset(b, c, SBDI_BLOCK_SIZE);
+    CPPUNIT_ASSERT(
+        p->pwrite(p->iod, b, SBDI_BLOCK_SIZE, (off_t) blk * SBDI_BLOCK_SIZE) == SBDI_BLOCK_SIZE);
+  }
+
+  void preadBlk(sbdi_pio_t *p, int c, uint32_t blk)
+  {
+    unsigned char b[SBDI_BLOCK_SIZE];
+    memset(b, ~c, SBDI_BLOCK_SIZE);
+    CPPUNIT_ASSERT(
+        p->pread(p->iod, b, SBDI_BLOCK_SIZE, (off_t) blk * SBDI_BLOCK_SIZE) == SBDI_BLOCK_SIZE);
+    CPPUNIT_ASSERT(memchrcmp(b, c, SBDI_BLOCK_SIZE));
+  }
+
+  void pwriteBlk(int c, uint32_t blk)
+  {
+    pwriteBlk(pio, c, blk);
+  }
+
+  void preadBlk(int c, uint32_t blk)
+  {
+    preadBlk(pio, c, blk);
+  }
+
+  /*!
+   * \brief Writes blocks 0 to blks - 1 of a secure block device, block i is
+   * filled with (i + k) & 0xFF
+   * @param sbdi[in] the secure block device to write to
+   * @param blks[in] the number of blocks to write
+   * @param k[in] the offset added to the block contents
+   */
+  void sbdiWrite(sbdi_t *sbdi, uint32_t blks, uint32_t k)
+  {
+    std::vector<unsigned char> b(SBDI_BLOCK_SIZE);
+    ssize_t rw = 0;
+    for (uint32_t i = 0; i < blks; ++i) {
+      memset(&b[0], (i + k) & 0xFF, SBDI_BLOCK_SIZE);
+      ASS_SUC(sbdi_pwrite(&rw, sbdi, &b[0], SBDI_BLOCK_SIZE, (off_t) i * SBDI_BLOCK_SIZE));
+    }
+  }
+
+  /*!
+   * \brief Checks the blocks written by sbdiWrite with the same arguments
+   * @param sbdi[in] the secure block device to read from
+   * @param blks[in] the number of blocks to check
+   * @param k[in] the offset added to the block contents
+   */
+  void sbdiRead(sbdi_t *sbdi, uint32_t blks, uint32_t k)
+  {
+    std::vector<unsigned char> b(SBDI_BLOCK_SIZE);
+    ssize_t rw = 0;
+    for (uint32_t i = 0; i < blks; ++i) {
+      ASS_SUC(sbdi_pread(&rw, sbdi, &b[0], SBDI_BLOCK_SIZE, (off_t) i * SBDI_BLOCK_SIZE));
+      CPPUNIT_ASSERT(memchrcmp(&b[0], (i + k) & 0xFF, SBDI_BLOCK_SIZE));
+    }
+  }
+
+  /*!
+   * \brief Writes blks blocks through a secure block device in the given
+   * number of synced rounds, then reopens the back end and checks the blocks
+   * of the last round
+   * @param blks[in] the number of blocks to write in each round
+   * @param rounds[in] the number of rounds, at least one
+   */
+  void roundTrip(uint32_t blks, uint32_t rounds)
+  {
+    mt_hash_t root;
+    memset(root, 0, sizeof(mt_hash_t));
+    sbdi_t *sbdi = NULL;
+    openBackend();
+    ASS_SUC(sbdi_open(&sbdi, pio, SBDI_CRYPTO_SIV, SIV_KEYS, root));
+    for (uint32_t k = 0; k < rounds; ++k) {
+      sbdiWrite(sbdi, blks, k);
+      ASS_SUC(sbdi_sync(sbdi, SIV_KEYS, root));
+    }
+    ASS_SUC(sbdi_close(sbdi, SIV_KEYS, root));
+    closeBackend();
+    openBackend();
+    ASS_SUC(sbdi_open(&sbdi, pio, SBDI_CRYPTO_SIV, SIV_KEYS, root));
+    sbdiRead(sbdi, blks, rounds - 1);
+    ASS_SUC(sbdi_close(sbdi, SIV_KEYS, root));
+    closeBackend();
+  }
+};
+
+#endif /* SBDIBACKENDTEST_H_ */
@@ -0,0 +1,241 @@
+/* Copyright (c) IAIK, Graz University of Technology, 2015.
+ * All rights reserved.
+ * Contact: http://opensource.iaik.tugraz.at
+ * 
+ * This file is part of the Secure Block Device Library.
+ * 
+ * Commercial License Usage
+ * Licensees holding valid commercial licenses may use this file in
+ * accordance with the commercial license agreement provided with the
+ * Software or, alternatively, in accordance with the terms contained in
+ * a written agreement between you and SIC. For further information
+ * contact us at http://opensource.iaik.tugraz.at.
+ * 
+ * Alternatively, this file may be used under the terms of the GNU General
+ * Public License as published by the Free Software Foundation version 2.
+ * 
+ * The Secure Block Device Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with the Secure Block Device Library. If not, see <http://www.gnu.org/licenses/>.
+ */
+///
+/// \file
+/// \brief Tests the Secure Block Device Library's cryptographic abstraction
+/// layers.
+///
+/// In particular this checks that the optional batch operations of each
+/// layer produce exactly the same results as its single block operations.
+///
+
+#include "SbdiTest.h"
+
+#include "sbdi_crypto.h"
+#include "sbdi_buffer.h"
+#include "sbdi_nocrypto.h"
+#include "sbdi_siv.h"
+#include "sbdi_ocb.h"
+#include "sbdi_hmac.h"
+#include "sbdi_gcm.h"
+#include "sbdi_gcm_siv.h"
+#include "sbdi_chacha.h"
+#include "sbdi_aegis.h"
+#include "sbdi_gmac.h"
+
+#include <string.h>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#define SBDI_CT_NBLK 7
+
+typedef sbdi_error_t (*sbdi_crypto_create_fn)(sbdi_crypto_t **crypto,
+    const sbdi_key_t key);
+typedef void (*sbdi_crypto_destroy_fn)(sbdi_crypto_t *crypto);
+
+class SbdiCryptoTest: public CppUnit::TestFixture {
+CPPUNIT_TEST_SUITE( SbdiCryptoTest );
+  CPPUNIT_TEST(testNoCryptoBatch);
+  CPPUNIT_TEST(testSivBatch);
+  CPPUNIT_TEST(testOcbBatch);
+  CPPUNIT_TEST(testHmacBatch);
+  CPPUNIT_TEST(testGcmBatch);
+  CPPUNIT_TEST(testGcmSivBatch);
+  CPPUNIT_TEST(testChaChaBatch);
+  CPPUNIT_TEST(testAegisBatch);
+  CPPUNIT_TEST(testGmacBatch);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  static unsigned char KEY[32];
+  sbdi_bl_data_t pt[SBDI_CT_NBLK];
+  sbdi_bl_data_t ct[SBDI_CT_NBLK];
+  sbdi_bl_data_t ct_n[SBDI_CT_NBLK];
+  sbdi_bl_data_t dec_n[SBDI_CT_NBLK];
+  sbdi_tag_t tag[SBDI_CT_NBLK];
+  sbdi_tag_t tag_n[SBDI_CT_NBLK];
+  sbdi_ctr_128b_t ctr[SBDI_CT_NBLK];
+  sbdi_ctr_pkd_t ctr_pkd[SBDI_CT_NBLK];
+  uint32_t blk_nbr[SBDI_CT_NBLK];
+
+  void checkBatch(sbdi_crypto_create_fn create, sbdi_crypto_destroy_fn destroy,
+      int with_key)
+  {
+    sbdi_crypto_t *c = NULL;
+    const uint8_t *ppt[SBDI_CT_NBLK], *pct[SBDI_CT_NBLK];
+    const uint8_t *pctr[SBDI_CT_NBLK], *ptag[SBDI_CT_NBLK];
+    uint8_t *pct_n[SBDI_CT_NBLK], *pdec_n[SBDI_CT_NBLK], *ptag_n[SBDI_CT_NBLK];
+    ASS_SUC(create(&c, with_key ? KEY : NULL));
+
+    for (int i = 0; i < SBDI_CT_NBLK; ++i) {
+      ASS_SUC(
+          c->enc(c->ctx, pt[i], SBDI_BLOCK_SIZE, &ctr[i], blk_nbr[i], ct[i],
+              tag[i]));
+      ppt[i] = pt[i];
+      pct[i] = ct_n[i];
+      pctr[i] = ctr_pkd[i];
+      ptag[i] = tag_n[i];
+      pct_n[i] = ct_n[i];
+      pdec_n[i] = dec_n[i];
+      ptag_n[i] = tag_n[i];
+    }
+
+    // Batch encryption must equal single block encryption
+    ASS_SUC(
+        sbdi_crypto_enc_n(c, SBDI_CT_NBLK, ppt, SBDI_BLOCK_SIZE, ctr, blk_nbr,
+            pct_n, ptag_n));
+    CPPUNIT_ASSERT(memcmp(ct, ct_n, sizeof(ct)) == 0);
+    CPPUNIT_ASSERT(memcmp(tag, tag_n, sizeof(tag)) == 0);
+
+    // Batch decryption must restore the plaintext
+    ASS_SUC(
+        sbdi_crypto_dec_n(c, SBDI_CT_NBLK, pct, SBDI_BLOCK_SIZE, pctr, blk_nbr,
+            pdec_n, ptag));
+    CPPUNIT_ASSERT(memcmp(pt, dec_n, sizeof(pt)) == 0);
+
+    // Batch MACs must equal single MACs
+    for (int i = 0; i < SBDI_CT_NBLK; ++i) {
+      ASS_SUC(
+          c->mac(c->ctx, pt[i], SBDI_BLOCK_SIZE, tag[i], ctr_pkd[i],
+              SBDI_BLOCK_CTR_SIZE));
+    }
+    ASS_SUC(
+        sbdi_crypto_mac_n(c, SBDI_CT_NBLK, ppt, SBDI_BLOCK_SIZE, ptag_n, pctr,
+            SBDI_BLOCK_CTR_SIZE));
+    CPPUNIT_ASSERT(memcmp(tag, tag_n, sizeof(tag)) == 0);
+
+    destroy(c);
+  }
+
+  void checkBatchIntegrity(sbdi_crypto_create_fn create,
+      sbdi_crypto_destroy_fn destroy)
+  {
+    sbdi_crypto_t *c = NULL;
+    const uint8_t *pct[SBDI_CT_NBLK], *pctr[SBDI_CT_NBLK], *ptag[SBDI_CT_NBLK];
+    uint8_t *pdec_n[SBDI_CT_NBLK];
+    ASS_SUC(create(&c, KEY));
+
+    for (int i = 0; i < SBDI_CT_NBLK; ++i) {
+      ASS_SUC(
+          c->enc(c->ctx, pt[i], SBDI_BLOCK_SIZE, &ctr[i], blk_nbr[i], ct[i],
+              tag[i]));
+      pct[i] = ct[i];
+      pctr[i] = ctr_pkd[i];
+      ptag[i] = tag[i];
+      pdec_n[i] = dec_n[i];
+    }
+    // A single modified block must make the whole batch fail
+    ct[SBDI_CT_NBLK - 2][42] ^= 0x01;
+    CPPUNIT_ASSERT(
+        sbdi_crypto_dec_n(c, SBDI_CT_NBLK, pct, SBDI_BLOCK_SIZE, pctr, blk_nbr,
+            pdec_n, ptag) != SBDI_SUCCESS);
+    destroy(c);
+  }
+
+public:
+  void setUp()
+  {
+    for (int i = 0; i < SBDI_CT_NBLK; ++i) {
+      for (unsigned j = 0; j < SBDI_BLOCK_SIZE; ++j) {
+        pt[i][j] = (uint8_t) (i * 31 + j * 7);
+      }
+      sbdi_ctr_128b_init(&ctr[i], 0x0102030405060708ull, 1000 + i * 3);
+      sbdi_buffer_t b;
+      sbdi_buffer_init(&b, ctr_pkd[i], SBDI_BLOCK_CTR_SIZE);
+      sbdi_buffer_write_ctr_128b(&b, &ctr[i]);
+      blk_nbr[i] = 2 + i * 5;
+    }
+    memset(ct, 0, sizeof(ct));
+    memset(ct_n, 0, sizeof(ct_n));
+    memset(dec_n, 0, sizeof(dec_n));
+  }
+
+  void tearDown()
+  {
+  }
+
+  void testNoCryptoBatch()
+  {
+    checkBatch(&sbdi_nocrypto_create, &sbdi_nocrypto_destroy, 0);
+  }
+
+  void testSivBatch()
+  {
+    checkBatch(&sbdi_siv_create, &sbdi_siv_destroy, 1);
+    checkBatchIntegrity(&sbdi_siv_create, &sbdi_siv_destroy);
+  }
+
+  void testOcbBatch()
+  {
+    checkBatch(&sbdi_ocb_create, &sbdi_ocb_destroy, 1);
+    checkBatchIntegrity(&sbdi_ocb_create, &sbdi_ocb_destroy);
+  }
+
+  void testHmacBatch()
+  {
+    checkBatch(&sbdi_hmac_create, &sbdi_hmac_destroy, 1);
+    checkBatchIntegrity(&sbdi_hmac_create, &sbdi_hmac_destroy);
+  }
+
+  void testGcmBatch()
+  {
+    checkBatch(&sbdi_gcm_create, &sbdi_gcm_destroy, 1);
+    checkBatchIntegrity(&sbdi_gcm_create, &sbdi_gcm_destroy);
+  }
+
+  void testGcmSivBatch()
+  {
+    checkBatch(&sbdi_gcm_siv_create, &sbdi_gcm_siv_destroy, 1);
+    checkBatchIntegrity(&sbdi_gcm_siv_create, &sbdi_gcm_siv_destroy);
+  }
+
+  void testChaChaBatch()
+  {
+    checkBatch(&sbdi_chacha_create, &sbdi_chacha_destroy, 1);
+    checkBatchIntegrity(&sbdi_chacha_create, &sbdi_chacha_destroy);
+  }
+
+  void testAegisBatch()
+  {
+    checkBatch(&sbdi_aegis_create, &sbdi_aegis_destroy, 1);
+    checkBatchIntegrity(&sbdi_aegis_create, &sbdi_aegis_destroy);
+  }
+
+  void testGmacBatch()
+  {
+    checkBatch(&sbdi_gmac_create, &sbdi_gmac_destroy, 1);
+    // GMAC only authenticates, the plaintext is stored unmodified
+    CPPUNIT_ASSERT(memcmp(pt, ct, sizeof(pt)) == 0);
+    checkBatchIntegrity(&sbdi_gmac_create, &sbdi_gmac_destroy);
+  }
+
+};
+
+unsigned char SbdiCryptoTest::KEY[32] = { 0xff, 0xfe, 0xfd, 0xfc, 0xfb, 0xfa,
+    0xf9, 0xf8, 0xf7, 0xf6, 0xf5, 0xf4, 0xf3, 0xf2, 0xf1, 0xf0, 0xf0, 0xf1,
+    0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd,
+    0xfe, 0xff };
+
+CPPUNIT_TEST_SUITE_REGISTRATION(SbdiCryptoTest);
@@ -49,6 +49,7 @@ CPPUNIT_TEST_SUITE( SbdiCtrTest );
   CPPUNIT_TEST(testReset);
   CPPUNIT_TEST(testBasicIncrement);
   CPPUNIT_TEST(testBorderIncrement);
+  CPPUNIT_TEST(testAdd);
   CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -128,6 +129,27 @@ public:
     CPPUNIT_ASSERT(!res);
   }
 
+  void testAdd() {
+    int res = 0;
+    sbdi_ctr_128b_t tst, cmp;
+    CPPUNIT_ASSERT(sbdi_ctr_128b_init(&tst, 0, 1) == SBDI_SUCCESS);
+    CPPUNIT_ASSERT(sbdi_ctr_128b_add(&tst, 1) == SBDI_SUCCESS);
+    CPPUNIT_ASSERT(sbdi_ctr_128b_cmp(&tst, &TWO, &res) == SBDI_SUCCESS);
+    CPPUNIT_ASSERT(!res);
+    CPPUNIT_ASSERT(sbdi_ctr_128b_init(&tst, 7, UINT64_MAX - 2) == SBDI_SUCCESS);
+    CPPUNIT_ASSERT(sbdi_ctr_128b_add(&tst, 5) == SBDI_SUCCESS);
+    CPPUNIT_ASSERT(sbdi_ctr_128b_init(&cmp, 8, 2) == SBDI_SUCCESS);
+    CPPUNIT_ASSERT(sbdi_ctr_128b_cmp(&tst, &cmp, &res) == SBDI_SUCCESS);
+    CPPUNIT_ASSERT(!res);
+    CPPUNIT_ASSERT(sbdi_ctr_128b_init(&tst, UINT64_MAX, UINT64_MAX - 2) == SBDI_SUCCESS);
+    CPPUNIT_ASSERT(sbdi_ctr_128b_add(&tst, 1) == SBDI_SUCCESS);
+    CPPUNIT_ASSERT(sbdi_ctr_128b_cmp(&tst, &MAX_M1, &res) == SBDI_SUCCESS);
+    CPPUNIT_ASSERT(!res);
+    CPPUNIT_ASSERT(sbdi_ctr_128b_add(&tst, 2) == SBDI_ERR_ILLEGAL_STATE);
+    CPPUNIT_ASSERT(sbdi_ctr_128b_cmp(&tst, &MAX_M1, &res) == SBDI_SUCCESS);
+    CPPUNIT_ASSERT(!res);
+  }
+
 };
 
 const sbdi_ctr_128b_t SbdiCtrTest::ZERO = { 0, 0 };
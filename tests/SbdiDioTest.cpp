@@ -0,0 +1,168 @@
+/* Copyright (c) IAIK, Graz University of Technology, 2015.
+ * All rights reserved.
+ * Contact: http://opensource.iaik.tugraz.at
+ * 
+ * This file is part of the Secure Block Device Library.
+ * 
+ * Commercial License Usage
+ * Licensees holding valid commercial licenses may use this file in
+ * accordance with the commercial license agreement provided with the
+ * Software or, alternatively, in accordance with the terms contained in
+ * a written agreement between you and SIC. For further information
+ * contact us at http://opensource.iaik.tugraz.at.
+ * 
+ * Alternatively, this file may be used under the terms of the GNU General
+ * Public License as published by the Free Software Foundation version 2.
+ * 
+ * The Secure Block Device Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with the Secure Block Device Library. If not, see <http://www.gnu.org/licenses/>.
+ */
+///
+/// \file
+/// \brief Tests the Secure Block Device Library's direct I/O back end.
+///
+#include "SbdiBackendTest.h"
+#include "sbdi_dio.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+class SbdiDioTest: public SbdiBackendTest {
+  CPPUNIT_TEST_SUITE( SbdiDioTest );
+  CPPUNIT_TEST(testAlignment);
+  CPPUNIT_TEST(testReadWrite);
+  CPPUNIT_TEST(testAlignedRuns);
+  CPPUNIT_TEST(testSbdi);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  int fd;
+
+  void openBackend()
+  {
+    fd = open(FILE_NAME, O_RDWR | O_CREAT, S_IRUSR | S_IWUSR);
+    CPPUNIT_ASSERT(fd != -1);
+    pio = sbdi_dio_create(fd);
+    CPPUNIT_ASSERT(pio);
+  }
+
+  void closeBackend()
+  {
+    sbdi_dio_delete(pio);
+    CPPUNIT_ASSERT(close(fd) != -1);
+  }
+
+  off_t fileSize()
+  {
+    struct stat s;
+    CPPUNIT_ASSERT(stat(FILE_NAME, &s) == 0);
+    return s.st_size;
+  }
+
+  static int isAligned(const void *p)
+  {
+    return ((uintptr_t) p) % SBDI_BL_ALIGN == 0;
+  }
+
+public:
+  void setUp()
+  {
+    unlink(FILE_NAME);
+  }
+
+  void tearDown()
+  {
+    unlink(FILE_NAME);
+  }
+
+  void testAlignment()
+  {
+    mt_hash_t root;
+    memset(root, 0, sizeof(mt_hash_t));
+    openBackend();
+    sbdi_t *sbdi = NULL;
+    ASS_SUC(sbdi_open(&sbdi, pio, SBDI_CRYPTO_SIV, SIV_KEYS, root));
+    CPPUNIT_ASSERT(isAligned(sbdi->cache->store));
+    CPPUNIT_ASSERT(isAligned(sbdi->write_store_dat));
+    CPPUNIT_ASSERT(isAligned(sbdi->batch_store_dat));
+    ASS_SUC(sbdi_close(sbdi, SIV_KEYS, root));
+    closeBackend();
+  }
+
+  void testReadWrite()
+  {
+    openBackend();
+    unsigned char b[3 * SBDI_BLOCK_SIZE];
+    CPPUNIT_ASSERT(pio->pread(pio->iod, b, SBDI_BLOCK_SIZE, 0) == 0);
+    pwriteBlk(1, 0);
+    // Writing part of a sector must not make the rest of it readable
+    CPPUNIT_ASSERT(fileSize() == SBDI_BLOCK_SIZE);
+    CPPUNIT_ASSERT(pio->pread(pio->iod, b, SBDI_BLOCK_SIZE, SBDI_BLOCK_SIZE) == 0);
+    preadBlk(1, 0);
+    pwriteBlk(2, 1);
+    pwriteBlk(4, 4);
+    CPPUNIT_ASSERT(fileSize() == 5 * SBDI_BLOCK_SIZE);
+    preadBlk(1, 0);
+    preadBlk(2, 1);
+    preadBlk(0, 3);
+    preadBlk(4, 4);
+    // Overwriting half a sector keeps the other half
+    pwriteBlk(5, 0);
+    preadBlk(5, 0);
+    preadBlk(2, 1);
+    // Unaligned reads end at the end of the file
+    CPPUNIT_ASSERT(pio->pread(pio->iod, b, sizeof(b), 3 * SBDI_BLOCK_SIZE) == 2 * SBDI_BLOCK_SIZE);
+    CPPUNIT_ASSERT(memchrcmp(b, 0, SBDI_BLOCK_SIZE));
+    CPPUNIT_ASSERT(memchrcmp(b + SBDI_BLOCK_SIZE, 4, SBDI_BLOCK_SIZE));
+    CPPUNIT_ASSERT(pio->flush(pio->iod) == 0);
+    closeBackend();
+    openBackend();
+    preadBlk(5, 0);
+    preadBlk(2, 1);
+    preadBlk(4, 4);
+    pwriteBlk(6, 5);
+    preadBlk(4, 4);
+    preadBlk(6, 5);
+    closeBackend();
+  }
+
+  void testAlignedRuns()
+  {
+    const size_t LEN = 4 * SBDI_BL_ALIGN;
+    void *p = NULL;
+    CPPUNIT_ASSERT(posix_memalign(&p, SBDI_BL_ALIGN, LEN) == 0);
+    unsigned char *b = (unsigned char *) p;
+    openBackend();
+    memset(b, 7, LEN);
+    CPPUNIT_ASSERT(pio->pwrite(pio->iod, b, LEN, SBDI_BL_ALIGN) == (ssize_t) LEN);
+    CPPUNIT_ASSERT(fileSize() == (off_t) (SBDI_BL_ALIGN + LEN));
+    preadBlk(0, 0);
+    preadBlk(7, SBDI_BL_ALIGN / SBDI_BLOCK_SIZE);
+    memset(b, 0, LEN);
+    CPPUNIT_ASSERT(pio->pread(pio->iod, b, LEN, SBDI_BL_ALIGN) == (ssize_t) LEN);
+    CPPUNIT_ASSERT(memchrcmp(b, 7, LEN));
+    // Aligned reads come up short at the end of the file as well
+    CPPUNIT_ASSERT(pio->pread(pio->iod, b, LEN, LEN) == (ssize_t) SBDI_BL_ALIGN);
+    CPPUNIT_ASSERT(pio->pread(pio->iod, b, LEN, 2 * LEN) == 0);
+    closeBackend();
+    free(p);
+  }
+
+  void testSbdi()
+  {
+    roundTrip(SBDI_MNGT_BLOCK_ENTRIES + 8, 1);
+  }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(SbdiDioTest);
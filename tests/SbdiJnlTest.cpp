@@ -0,0 +1,381 @@
+/* Copyright (c) IAIK, Graz University of Technology, 2015.
+ * All rights reserved.
+ * Contact: http://opensource.iaik.tugraz.at
+ * 
+ * This file is part of the Secure Block Device Library.
+ * 
+ * Commercial License Usage
+ * Licensees holding valid commercial licenses may use this file in
+ * accordance with the commercial license agreement provided with the
+ * Software or, alternatively, in accordance with the terms contained in
+ * a written agreement between you and SIC. For further information
+ * contact us at http://opensource.iaik.tugraz.at.
+ * 
+ * Alternatively, this file may be used under the terms of the GNU General
+ * Public License as published by the Free Software Foundation version 2.
+ * 
+ * The Secure Block Device Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with the Secure Block Device Library. If not, see <http://www.gnu.org/licenses/>.
+ */
+///
+/// \file
+/// \brief Tests the Secure Block Device Library's write-ahead log.
+///
+#include "SbdiBackendTest.h"
+#include "sbdi_jnl.h"
+#include "sbdi_ram.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <thread>
+#include <vector>
+
+#define LOG_NAME "sbdi_tst_jnl"
+#define CRASH_FILE_NAME "sbdi_tst_enc_crash"
+#define CRASH_LOG_NAME "sbdi_tst_jnl_crash"
+
+class SbdiJnlTest: public SbdiBackendTest {
+  CPPUNIT_TEST_SUITE( SbdiJnlTest );
+  CPPUNIT_TEST(testReadWrite);
+  CPPUNIT_TEST(testRecovery);
+  CPPUNIT_TEST(testCheckpoint);
+  CPPUNIT_TEST(testRoundTrip);
+  CPPUNIT_TEST(testSbdi);
+  CPPUNIT_TEST(testConcurrentSync);
+  CPPUNIT_TEST(testCheckpointOpenTransaction);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  int d_fd;
+  int l_fd;
+  sbdi_pio_t *d_pio;
+  sbdi_pio_t *l_pio;
+
+  void openJnl(const char *d_name, const char *l_name)
+  {
+    d_fd = open(d_name, O_RDWR | O_CREAT, S_IRUSR | S_IWUSR);
+    l_fd = open(l_name, O_RDWR | O_CREAT, S_IRUSR | S_IWUSR);
+    CPPUNIT_ASSERT(d_fd != -1 && l_fd != -1);
+    d_pio = sbdi_pio_create(&d_fd, 0);
+    l_pio = sbdi_pio_create(&l_fd, 0);
+    CPPUNIT_ASSERT(d_pio && l_pio);
+    pio = sbdi_jnl_create(d_pio, l_pio);
+    CPPUNIT_ASSERT(pio);
+  }
+
+  void closeJnl()
+  {
+    sbdi_jnl_delete(pio);
+    sbdi_pio_delete(l_pio);
+    sbdi_pio_delete(d_pio);
+    CPPUNIT_ASSERT(close(l_fd) != -1);
+    CPPUNIT_ASSERT(close(d_fd) != -1);
+  }
+
+  void openBackend()
+  {
+    openJnl(FILE_NAME, LOG_NAME);
+  }
+
+  void closeBackend()
+  {
+    closeJnl();
+  }
+
+  void copyFile(const char *from, const char *to)
+  {
+    std::vector<unsigned char> b(SBDI_BLOCK_SIZE);
+    int f = open(from, O_RDONLY);
+    int t = open(to, O_RDWR | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+    CPPUNIT_ASSERT(f != -1 && t != -1);
+    ssize_t r;
+    while ((r = read(f, &b[0], b.size())) > 0) {
+      CPPUNIT_ASSERT(write(t, &b[0], r) == r);
+    }
+    CPPUNIT_ASSERT(r == 0);
+    CPPUNIT_ASSERT(close(t) != -1);
+    CPPUNIT_ASSERT(close(f) != -1);
+  }
+
+  off_t fileSize(const char *name)
+  {
+    struct stat s;
+    CPPUNIT_ASSERT(stat(name, &s) == 0);
+    return s.st_size;
+  }
+
+  void commit()
+  {
+    CPPUNIT_ASSERT(pio->commit(pio->iod) == 0);
+    CPPUNIT_ASSERT(pio->flush(pio->iod) == 0);
+  }
+
+  static SbdiJnlTest *interposer;
+  static bl_flush jnlFlush;
+
+  static int interposedFlush(void *iod)
+  {
+    // Let another thread write between the write-out and the flush of a sync
+    if (interposer) {
+      SbdiJnlTest *t = interposer;
+      interposer = NULL;
+      std::thread w(&SbdiJnlTest::overwrite, t);
+      w.join();
+    }
+    return jnlFlush(iod);
+  }
+
+  sbdi_t *c_sbdi;
+
+  void overwrite()
+  {
+    // Overwrite more blocks than the cache holds to evict dirty data blocks
+    // whose management block is still cached
+    std::vector<unsigned char> b(SBDI_BLOCK_SIZE, 0xAA);
+    ssize_t rw = 0;
+    for (uint32_t i = 0; i < 2 * SBDI_CACHE_MAX_SIZE; ++i) {
+      ASS_SUC(sbdi_pwrite(&rw, c_sbdi, &b[0], SBDI_BLOCK_SIZE, i * SBDI_BLOCK_SIZE));
+    }
+  }
+
+public:
+  void setUp()
+  {
+    unlink(FILE_NAME);
+    unlink(LOG_NAME);
+    unlink(CRASH_FILE_NAME);
+    unlink(CRASH_LOG_NAME);
+  }
+
+  void tearDown()
+  {
+    unlink(FILE_NAME);
+    unlink(LOG_NAME);
+    unlink(CRASH_FILE_NAME);
+    unlink(CRASH_LOG_NAME);
+  }
+
+  void testReadWrite()
+  {
+    openJnl(FILE_NAME, LOG_NAME);
+    unsigned char b[3 * SBDI_BLOCK_SIZE];
+    CPPUNIT_ASSERT(pio->pread(pio->iod, b, SBDI_BLOCK_SIZE, 0) == 0);
+    CPPUNIT_ASSERT(pio->pwrite(pio->iod, b, 10, 0) == -1);
+    pwriteBlk(1, 0);
+    pwriteBlk(3, 2);
+    pwriteBlk(4, 0);
+    // Nothing reaches the data back end before a checkpoint
+    CPPUNIT_ASSERT(fileSize(FILE_NAME) == 0);
+    preadBlk(4, 0);
+    preadBlk(3, 2);
+    // The gap reads as zeros, reads end at the last written block
+    CPPUNIT_ASSERT(pio->pread(pio->iod, b, sizeof(b), SBDI_BLOCK_SIZE) == 2 * SBDI_BLOCK_SIZE);
+    CPPUNIT_ASSERT(memchrcmp(b, 0, SBDI_BLOCK_SIZE));
+    CPPUNIT_ASSERT(memchrcmp(b + SBDI_BLOCK_SIZE, 3, SBDI_BLOCK_SIZE));
+    commit();
+    closeJnl();
+    // Deleting the write-ahead log checkpoints all committed blocks
+    CPPUNIT_ASSERT(fileSize(FILE_NAME) == 3 * SBDI_BLOCK_SIZE);
+    openJnl(FILE_NAME, LOG_NAME);
+    preadBlk(4, 0);
+    preadBlk(0, 1);
+    preadBlk(3, 2);
+    closeJnl();
+  }
+
+  void testRecovery()
+  {
+    openJnl(FILE_NAME, LOG_NAME);
+    pwriteBlk(1, 0);
+    pwriteBlk(2, 1);
+    commit();
+    pwriteBlk(5, 1);
+    pwriteBlk(6, 2);
+    // Flushing without a commit does not complete the transaction
+    CPPUNIT_ASSERT(pio->flush(pio->iod) == 0);
+    // Crash with a committed and an incomplete transaction in the log
+    copyFile(FILE_NAME, CRASH_FILE_NAME);
+    copyFile(LOG_NAME, CRASH_LOG_NAME);
+    closeJnl();
+    CPPUNIT_ASSERT(fileSize(CRASH_FILE_NAME) == 0);
+    openJnl(CRASH_FILE_NAME, CRASH_LOG_NAME);
+    CPPUNIT_ASSERT(fileSize(CRASH_FILE_NAME) == 2 * SBDI_BLOCK_SIZE);
+    preadBlk(1, 0);
+    preadBlk(2, 1);
+    unsigned char b[SBDI_BLOCK_SIZE];
+    CPPUNIT_ASSERT(pio->pread(pio->iod, b, SBDI_BLOCK_SIZE, 2 * SBDI_BLOCK_SIZE) == 0);
+    closeJnl();
+    // A torn record at the end of the log is ignored as well
+    CPPUNIT_ASSERT(unlink(LOG_NAME) != -1);
+    openJnl(FILE_NAME, LOG_NAME);
+    pwriteBlk(7, 0);
+    commit();
+    pwriteBlk(8, 0);
+    commit();
+    copyFile(FILE_NAME, CRASH_FILE_NAME);
+    copyFile(LOG_NAME, CRASH_LOG_NAME);
+    closeJnl();
+    // Cut off the commit record and part of the last block write
+    CPPUNIT_ASSERT(truncate(CRASH_LOG_NAME, fileSize(CRASH_LOG_NAME) - 40) == 0);
+    openJnl(CRASH_FILE_NAME, CRASH_LOG_NAME);
+    preadBlk(7, 0);
+    preadBlk(2, 1);
+    closeJnl();
+  }
+
+  void testCheckpoint()
+  {
+    const uint32_t BLKS = SBDI_JNL_CHECKPOINT_SIZE / SBDI_BLOCK_SIZE + 1;
+    openJnl(FILE_NAME, LOG_NAME);
+    for (uint32_t i = 0; i < BLKS; ++i) {
+      pwriteBlk(i % 256, i);
+    }
+    commit();
+    // Keep writing and reading while the background checkpoint runs
+    for (int k = 0; k < 1000 && fileSize(FILE_NAME) < BLKS * SBDI_BLOCK_SIZE; ++k) {
+      pwriteBlk(k % 256, k % 16);
+      preadBlk(k % 256, k % 16);
+      preadBlk(100, 100);
+      usleep(1000);
+    }
+    CPPUNIT_ASSERT(fileSize(FILE_NAME) == BLKS * SBDI_BLOCK_SIZE);
+    for (uint32_t i = 16; i < BLKS; ++i) {
+      preadBlk(i % 256, i);
+    }
+    pwriteBlk(42, 0);
+    commit();
+    closeJnl();
+    openJnl(FILE_NAME, LOG_NAME);
+    preadBlk(42, 0);
+    preadBlk(BLKS % 256 - 1, BLKS - 1);
+    closeJnl();
+  }
+
+  void testRoundTrip()
+  {
+    roundTrip(SBDI_MNGT_BLOCK_ENTRIES + 8, 2);
+  }
+
+  void testSbdi()
+  {
+    mt_hash_t root;
+    memset(root, 0, sizeof(mt_hash_t));
+    const uint32_t BLKS = SBDI_MNGT_BLOCK_ENTRIES + 8;
+    std::vector<unsigned char> b(SBDI_BLOCK_SIZE);
+    openJnl(FILE_NAME, LOG_NAME);
+    sbdi_t *sbdi = NULL;
+    ASS_SUC(sbdi_open(&sbdi, pio, SBDI_CRYPTO_SIV, SIV_KEYS, root));
+    sbdiWrite(sbdi, BLKS, 0);
+    ASS_SUC(sbdi_sync(sbdi, SIV_KEYS, root));
+    ssize_t rw = 0;
+    // Crash right after the sync: the store has to match the root
+    mt_hash_t sync_root;
+    memcpy(sync_root, root, sizeof(mt_hash_t));
+    copyFile(FILE_NAME, CRASH_FILE_NAME);
+    copyFile(LOG_NAME, CRASH_LOG_NAME);
+    memset(&b[0], 0xAA, SBDI_BLOCK_SIZE);
+    ASS_SUC(sbdi_pwrite(&rw, sbdi, &b[0], SBDI_BLOCK_SIZE, 0));
+    ASS_SUC(sbdi_close(sbdi, SIV_KEYS, root));
+    closeJnl();
+    // After deleting the write-ahead log the store is usable without it
+    int fd = open(FILE_NAME, O_RDWR);
+    CPPUNIT_ASSERT(fd != -1);
+    sbdi_pio_t *p = sbdi_pio_create(&fd, 0);
+    ASS_SUC(sbdi_open(&sbdi, p, SBDI_CRYPTO_SIV, SIV_KEYS, root));
+    ASS_SUC(sbdi_pread(&rw, sbdi, &b[0], SBDI_BLOCK_SIZE, 0));
+    CPPUNIT_ASSERT(memchrcmp(&b[0], 0xAA, SBDI_BLOCK_SIZE));
+    ASS_SUC(sbdi_close(sbdi, SIV_KEYS, root));
+    sbdi_pio_delete(p);
+    CPPUNIT_ASSERT(close(fd) != -1);
+    openJnl(CRASH_FILE_NAME, CRASH_LOG_NAME);
+    ASS_SUC(sbdi_open(&sbdi, pio, SBDI_CRYPTO_SIV, SIV_KEYS, sync_root));
+    sbdiRead(sbdi, BLKS, 0);
+    ASS_SUC(sbdi_close(sbdi, SIV_KEYS, sync_root));
+    closeJnl();
+  }
+
+  void testConcurrentSync()
+  {
+    mt_hash_t root;
+    memset(root, 0, sizeof(mt_hash_t));
+    const uint32_t BLKS = 2 * SBDI_CACHE_MAX_SIZE;
+    openJnl(FILE_NAME, LOG_NAME);
+    ASS_SUC(sbdi_open(&c_sbdi, pio, SBDI_CRYPTO_SIV, SIV_KEYS, root));
+    sbdiWrite(c_sbdi, BLKS, 0);
+    jnlFlush = pio->flush;
+    pio->flush = &interposedFlush;
+    interposer = this;
+    ASS_SUC(sbdi_sync(c_sbdi, SIV_KEYS, root));
+    CPPUNIT_ASSERT(!interposer);
+    // Crash right after the sync: the writes of the other thread are not
+    // part of it, even though they reached the log before its flush
+    copyFile(FILE_NAME, CRASH_FILE_NAME);
+    copyFile(LOG_NAME, CRASH_LOG_NAME);
+    mt_hash_t sync_root;
+    memcpy(sync_root, root, sizeof(mt_hash_t));
+    ASS_SUC(sbdi_close(c_sbdi, SIV_KEYS, root));
+    closeJnl();
+    openJnl(CRASH_FILE_NAME, CRASH_LOG_NAME);
+    ASS_SUC(sbdi_open(&c_sbdi, pio, SBDI_CRYPTO_SIV, SIV_KEYS, sync_root));
+    sbdiRead(c_sbdi, BLKS, 0);
+    ASS_SUC(sbdi_close(c_sbdi, SIV_KEYS, sync_root));
+    closeJnl();
+  }
+
+  void testCheckpointOpenTransaction()
+  {
+    const uint32_t BLKS = SBDI_JNL_CHECKPOINT_SIZE / SBDI_BLOCK_SIZE + 8;
+    const uint32_t B = BLKS + 1;
+    sbdi_pio_t *d = sbdi_ram_create();
+    sbdi_pio_t *l = sbdi_ram_create();
+    CPPUNIT_ASSERT(d && l);
+    pio = sbdi_jnl_create(d, l);
+    CPPUNIT_ASSERT(pio);
+    for (uint32_t i = 0; i < BLKS; ++i) {
+      pwriteBlk(i % 256, i);
+    }
+    CPPUNIT_ASSERT(pio->commit(pio->iod) == 0);
+    // The log header is rewritten at the end of every checkpoint
+    unsigned char hdr[64];
+    CPPUNIT_ASSERT(l->pread(l->iod, hdr, sizeof(hdr), 0) == sizeof(hdr));
+    // Make the open transaction durable, which starts a checkpoint
+    pwriteBlk(0xBB, B);
+    CPPUNIT_ASSERT(pio->flush(pio->iod) == 0);
+    unsigned char cur[sizeof(hdr)];
+    for (int k = 0; k < 1000; ++k) {
+      CPPUNIT_ASSERT(l->pread(l->iod, cur, sizeof(cur), 0) == sizeof(cur));
+      if (memcmp(hdr, cur, sizeof(hdr))) {
+        break;
+      }
+      usleep(1000);
+    }
+    CPPUNIT_ASSERT(memcmp(hdr, cur, sizeof(hdr)));
+    CPPUNIT_ASSERT(pio->commit(pio->iod) == 0);
+    CPPUNIT_ASSERT(pio->flush(pio->iod) == 0);
+    // Crash: recover from the same data and log
+    sbdi_pio_t *r = sbdi_jnl_create(d, l);
+    CPPUNIT_ASSERT(r);
+    preadBlk(r, 0xBB, B);
+    preadBlk(r, 3, 3);
+    sbdi_jnl_delete(r);
+    sbdi_jnl_delete(pio);
+    sbdi_ram_delete(l);
+    sbdi_ram_delete(d);
+  }
+};
+
+SbdiJnlTest *SbdiJnlTest::interposer = NULL;
+bl_flush SbdiJnlTest::jnlFlush = NULL;
+
+CPPUNIT_TEST_SUITE_REGISTRATION(SbdiJnlTest);
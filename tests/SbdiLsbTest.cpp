@@ -0,0 +1,226 @@
+/* Copyright (c) IAIK, Graz University of Technology, 2015.
+ * All rights reserved.
+ * Contact: http://opensource.iaik.tugraz.at
+ * 
+ * This file is part of the Secure Block Device Library.
+ * 
+ * Commercial License Usage
+ * Licensees holding valid commercial licenses may use this file in
+ * accordance with the commercial license agreement provided with the
+ * Software or, alternatively, in accordance with the terms contained in
+ * a written agreement between you and SIC. For further information
+ * contact us at http://opensource.iaik.tugraz.at.
+ * 
+ * Alternatively, this file may be used under the terms of the GNU General
+ * Public License as published by the Free Software Foundation version 2.
+ * 
+ * The Secure Block Device Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with the Secure Block Device Library. If not, see <http://www.gnu.org/licenses/>.
+ */
+///
+/// \file
+/// \brief Tests the Secure Block Device Library's log-structured back end.
+///
+#include "SbdiBackendTest.h"
+#include "sbdi_lsb.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <string>
+#include <vector>
+
+#define LSB_DIR_NAME "sbdi_tst_lsb"
+#define LSB_SEG_RECS (SBDI_LSB_SEGMENT_SIZE / (32u + SBDI_BLOCK_SIZE))
+
+class SbdiLsbTest: public SbdiBackendTest {
+  CPPUNIT_TEST_SUITE( SbdiLsbTest );
+  CPPUNIT_TEST(testReadWrite);
+  CPPUNIT_TEST(testRecovery);
+  CPPUNIT_TEST(testClean);
+  CPPUNIT_TEST(testSbdi);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  void openBackend()
+  {
+    pio = sbdi_lsb_create(LSB_DIR_NAME);
+    CPPUNIT_ASSERT(pio);
+  }
+
+  void closeBackend()
+  {
+    sbdi_lsb_delete(pio);
+  }
+
+  std::vector<std::string> segments()
+  {
+    std::vector<std::string> s;
+    DIR *d = opendir(LSB_DIR_NAME);
+    if (!d) {
+      return s;
+    }
+    struct dirent *e;
+    while ((e = readdir(d))) {
+      if (strcmp(e->d_name, ".") && strcmp(e->d_name, "..")) {
+        s.push_back(std::string(LSB_DIR_NAME "/") + e->d_name);
+      }
+    }
+    closedir(d);
+    return s;
+  }
+
+  std::string lastSegment()
+  {
+    std::vector<std::string> s = segments();
+    CPPUNIT_ASSERT(!s.empty());
+    std::string l = s[0];
+    for (size_t i = 1; i < s.size(); ++i) {
+      l = (s[i] > l) ? s[i] : l;
+    }
+    return l;
+  }
+
+  off_t fileSize(const char *name)
+  {
+    struct stat s;
+    CPPUNIT_ASSERT(stat(name, &s) == 0);
+    return s.st_size;
+  }
+
+  void removeDir()
+  {
+    std::vector<std::string> s = segments();
+    for (size_t i = 0; i < s.size(); ++i) {
+      unlink(s[i].c_str());
+    }
+    rmdir(LSB_DIR_NAME);
+  }
+
+public:
+  void setUp()
+  {
+    removeDir();
+  }
+
+  void tearDown()
+  {
+    removeDir();
+  }
+
+  void testReadWrite()
+  {
+    openBackend();
+    unsigned char b[3 * SBDI_BLOCK_SIZE];
+    CPPUNIT_ASSERT(pio->pread(pio->iod, b, SBDI_BLOCK_SIZE, 0) == 0);
+    CPPUNIT_ASSERT(pio->pwrite(pio->iod, b, 10, 0) == -1);
+    pwriteBlk(1, 0);
+    pwriteBlk(3, 2);
+    pwriteBlk(4, 0);
+    preadBlk(4, 0);
+    preadBlk(3, 2);
+    // The gap reads as zeros, reads end at the last written block
+    CPPUNIT_ASSERT(pio->pread(pio->iod, b, sizeof(b), SBDI_BLOCK_SIZE) == 2 * SBDI_BLOCK_SIZE);
+    CPPUNIT_ASSERT(memchrcmp(b, 0, SBDI_BLOCK_SIZE));
+    CPPUNIT_ASSERT(memchrcmp(b + SBDI_BLOCK_SIZE, 3, SBDI_BLOCK_SIZE));
+    CPPUNIT_ASSERT(pio->flush(pio->iod) == 0);
+    // Overwrites are appended
+    CPPUNIT_ASSERT(segments().size() == 1);
+    CPPUNIT_ASSERT(fileSize(lastSegment().c_str()) == 3 * (32 + SBDI_BLOCK_SIZE));
+    closeBackend();
+    openBackend();
+    // Reopening starts a new segment
+    CPPUNIT_ASSERT(segments().size() == 2);
+    preadBlk(4, 0);
+    preadBlk(0, 1);
+    preadBlk(3, 2);
+    CPPUNIT_ASSERT(pio->pread(pio->iod, b, SBDI_BLOCK_SIZE, 3 * SBDI_BLOCK_SIZE) == 0);
+    pwriteBlk(5, 2);
+    CPPUNIT_ASSERT(pio->flush(pio->iod) == 0);
+    closeBackend();
+    openBackend();
+    preadBlk(4, 0);
+    preadBlk(5, 2);
+    closeBackend();
+  }
+
+  void testRecovery()
+  {
+    openBackend();
+    pwriteBlk(1, 0);
+    pwriteBlk(2, 1);
+    CPPUNIT_ASSERT(pio->flush(pio->iod) == 0);
+    pwriteBlk(5, 1);
+    closeBackend();
+    // Tear the last record
+    std::string seg = lastSegment();
+    CPPUNIT_ASSERT(truncate(seg.c_str(), fileSize(seg.c_str()) - 40) == 0);
+    openBackend();
+    preadBlk(1, 0);
+    preadBlk(2, 1);
+    pwriteBlk(6, 1);
+    CPPUNIT_ASSERT(pio->flush(pio->iod) == 0);
+    closeBackend();
+    // Corrupting a record ends its segment
+    int fd = open(seg.c_str(), O_RDWR);
+    CPPUNIT_ASSERT(fd != -1);
+    CPPUNIT_ASSERT(pwrite(fd, "x", 1, 32 + SBDI_BLOCK_SIZE + 100) == 1);
+    CPPUNIT_ASSERT(close(fd) != -1);
+    openBackend();
+    preadBlk(1, 0);
+    preadBlk(6, 1);
+    closeBackend();
+  }
+
+  void testClean()
+  {
+    const uint32_t BLKS = 16;
+    const uint32_t ROUNDS = 6 * LSB_SEG_RECS / BLKS;
+    openBackend();
+    pwriteBlk(0xEE, 100);
+    for (uint32_t r = 0; r < ROUNDS; ++r) {
+      for (uint32_t i = 0; i < BLKS; ++i) {
+        pwriteBlk((r + i) % 256, i);
+      }
+    }
+    CPPUNIT_ASSERT(pio->flush(pio->iod) == 0);
+    // Wait for the cleaner while reading concurrently
+    for (int k = 0; k < 1000 && segments().size() > 3; ++k) {
+      preadBlk(0xEE, 100);
+      preadBlk((ROUNDS - 1 + 3) % 256, 3);
+      usleep(1000);
+    }
+    CPPUNIT_ASSERT(segments().size() <= 3);
+    for (uint32_t i = 0; i < BLKS; ++i) {
+      preadBlk((ROUNDS - 1 + i) % 256, i);
+    }
+    preadBlk(0xEE, 100);
+    preadBlk(0, 50);
+    closeBackend();
+    openBackend();
+    for (uint32_t i = 0; i < BLKS; ++i) {
+      preadBlk((ROUNDS - 1 + i) % 256, i);
+    }
+    preadBlk(0xEE, 100);
+    closeBackend();
+  }
+
+  void testSbdi()
+  {
+    // Every round overwrites all blocks and syncs
+    roundTrip(SBDI_MNGT_BLOCK_ENTRIES + 8, 4);
+  }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(SbdiLsbTest);
@@ -0,0 +1,151 @@
+/* Copyright (c) IAIK, Graz University of Technology, 2015.
+ * All rights reserved.
+ * Contact: http://opensource.iaik.tugraz.at
+ * 
+ * This file is part of the Secure Block Device Library.
+ * 
+ * Commercial License Usage
+ * Licensees holding valid commercial licenses may use this file in
+ * accordance with the commercial license agreement provided with the
+ * Software or, alternatively, in accordance with the terms contained in
+ * a written agreement between you and SIC. For further information
+ * contact us at http://opensource.iaik.tugraz.at.
+ * 
+ * Alternatively, this file may be used under the terms of the GNU General
+ * Public License as published by the Free Software Foundation version 2.
+ * 
+ * The Secure Block Device Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with the Secure Block Device Library. If not, see <http://www.gnu.org/licenses/>.
+ */
+///
+/// \file
+/// \brief Tests the Secure Block Device Library's mmap back end.
+///
+#include "SbdiBackendTest.h"
+#include "sbdi_mmap.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <vector>
+
+class SbdiMmapTest: public SbdiBackendTest {
+  CPPUNIT_TEST_SUITE( SbdiMmapTest );
+  CPPUNIT_TEST(testReadWrite);
+  CPPUNIT_TEST(testGrow);
+  CPPUNIT_TEST(testSequential);
+  CPPUNIT_TEST(testSbdi);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  int fd;
+
+  void openBackend()
+  {
+    fd = open(FILE_NAME, O_RDWR | O_CREAT, S_IRUSR | S_IWUSR);
+    CPPUNIT_ASSERT(fd != -1);
+    pio = sbdi_mmap_create(fd);
+    CPPUNIT_ASSERT(pio);
+  }
+
+  void closeBackend()
+  {
+    sbdi_mmap_delete(pio);
+    CPPUNIT_ASSERT(close(fd) != -1);
+  }
+
+public:
+  void setUp()
+  {
+    unlink(FILE_NAME);
+  }
+
+  void tearDown()
+  {
+    unlink(FILE_NAME);
+  }
+
+  void testReadWrite()
+  {
+    openBackend();
+    unsigned char b[3 * SBDI_BLOCK_SIZE];
+    CPPUNIT_ASSERT(pio->pread(pio->iod, b, SBDI_BLOCK_SIZE, 0) == 0);
+    pwriteBlk(1, 0);
+    pwriteBlk(3, 2);
+    preadBlk(1, 0);
+    preadBlk(0, 1);
+    preadBlk(3, 2);
+    // Reads end at the end of the file
+    CPPUNIT_ASSERT(pio->pread(pio->iod, b, sizeof(b), SBDI_BLOCK_SIZE) == 2 * SBDI_BLOCK_SIZE);
+    CPPUNIT_ASSERT(memchrcmp(b, 0, SBDI_BLOCK_SIZE));
+    CPPUNIT_ASSERT(memchrcmp(b + SBDI_BLOCK_SIZE, 3, SBDI_BLOCK_SIZE));
+    CPPUNIT_ASSERT(pio->pread(pio->iod, b, SBDI_BLOCK_SIZE, 3 * SBDI_BLOCK_SIZE) == 0);
+    // Overwrites are visible through the mapping
+    pwriteBlk(4, 0);
+    preadBlk(4, 0);
+    CPPUNIT_ASSERT(pio->flush(pio->iod) == 0);
+    closeBackend();
+    openBackend();
+    preadBlk(4, 0);
+    preadBlk(3, 2);
+    closeBackend();
+  }
+
+  void testGrow()
+  {
+    const uint32_t FAR = SBDI_MMAP_CHUNK_SIZE / SBDI_BLOCK_SIZE + 7;
+    openBackend();
+    pwriteBlk(1, 0);
+    preadBlk(1, 0);
+    // Beyond the current mapping
+    pwriteBlk(2, FAR);
+    preadBlk(2, FAR);
+    preadBlk(0, FAR - 1);
+    preadBlk(1, 0);
+    closeBackend();
+    openBackend();
+    preadBlk(2, FAR);
+    closeBackend();
+  }
+
+  void testSequential()
+  {
+    const uint32_t BLKS = 4 * SBDI_MMAP_READAHEAD / SBDI_BLOCK_SIZE;
+    openBackend();
+    for (uint32_t i = 0; i < BLKS; ++i) {
+      pwriteBlk(i % 256, i);
+    }
+    closeBackend();
+    openBackend();
+    // Sequential runs interrupted by random reads
+    for (uint32_t i = 0; i < BLKS; ++i) {
+      preadBlk(i % 256, i);
+      if (i % 97 == 0) {
+        preadBlk((BLKS - i - 1) % 256, BLKS - i - 1);
+      }
+    }
+    std::vector<unsigned char> b(BLKS * SBDI_BLOCK_SIZE);
+    CPPUNIT_ASSERT(pio->pread(pio->iod, &b[0], b.size(), 0) == (ssize_t) b.size());
+    for (uint32_t i = 0; i < BLKS; ++i) {
+      CPPUNIT_ASSERT(memchrcmp(&b[i * SBDI_BLOCK_SIZE], i % 256, SBDI_BLOCK_SIZE));
+    }
+    closeBackend();
+  }
+
+  void testSbdi()
+  {
+    roundTrip(SBDI_MNGT_BLOCK_ENTRIES + 8, 1);
+  }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(SbdiMmapTest);
@@ -0,0 +1,200 @@
+/* Copyright (c) IAIK, Graz University of Technology, 2015.
+ * All rights reserved.
+ * Contact: http://opensource.iaik.tugraz.at
+ * 
+ * This file is part of the Secure Block Device Library.
+ * 
+ * Commercial License Usage
+ * Licensees holding valid commercial licenses may use this file in
+ * accordance with the commercial license agreement provided with the
+ * Software or, alternatively, in accordance with the terms contained in
+ * a written agreement between you and SIC. For further information
+ * contact us at http://opensource.iaik.tugraz.at.
+ * 
+ * Alternatively, this file may be used under the terms of the GNU General
+ * Public License as published by the Free Software Foundation version 2.
+ * 
+ * The Secure Block Device Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with the Secure Block Device Library. If not, see <http://www.gnu.org/licenses/>.
+ */
+///
+/// \file
+/// \brief Tests the Secure Block Device Library's in-memory and latency
+/// injecting back ends.
+///
+#include "SbdiBackendTest.h"
+#include "sbdi_ram.h"
+#include "sbdi_lat.h"
+
+#include <string.h>
+#include <time.h>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <thread>
+#include <vector>
+
+class SbdiRamTest: public SbdiBackendTest {
+  CPPUNIT_TEST_SUITE( SbdiRamTest );
+  CPPUNIT_TEST(testRam);
+  CPPUNIT_TEST(testLatency);
+  CPPUNIT_TEST(testBandwidth);
+  CPPUNIT_TEST(testQueueDepth);
+  CPPUNIT_TEST(testSbdi);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  sbdi_pio_t *ram;
+  std::vector<sbdi_lat_stats_t> sessions;
+
+  void openBackend()
+  {
+    sbdi_lat_cfg_t cfg = { 50, 50, 500, 20, 0, 4 };
+    pio = sbdi_lat_create(ram, &cfg);
+    CPPUNIT_ASSERT(pio);
+  }
+
+  void closeBackend()
+  {
+    sbdi_lat_stats_t s;
+    sbdi_lat_get_stats(pio, &s);
+    sessions.push_back(s);
+    sbdi_lat_delete(pio);
+    pio = NULL;
+  }
+
+  static uint64_t now()
+  {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000u + ts.tv_nsec;
+  }
+
+public:
+  void setUp()
+  {
+    ram = sbdi_ram_create();
+    CPPUNIT_ASSERT(ram);
+    pio = NULL;
+    sessions.clear();
+  }
+
+  void tearDown()
+  {
+    sbdi_lat_delete(pio);
+    sbdi_ram_delete(ram);
+  }
+
+  void testRam()
+  {
+    unsigned char b[3 * SBDI_BLOCK_SIZE];
+    CPPUNIT_ASSERT(ram->flush == NULL);
+    CPPUNIT_ASSERT(ram->pread(ram->iod, b, SBDI_BLOCK_SIZE, 0) == 0);
+    pwriteBlk(ram, 1, 0);
+    pwriteBlk(ram, 3, 2);
+    CPPUNIT_ASSERT(sbdi_ram_size(ram) == 3 * SBDI_BLOCK_SIZE);
+    preadBlk(ram, 1, 0);
+    preadBlk(ram, 0, 1);
+    preadBlk(ram, 3, 2);
+    CPPUNIT_ASSERT(ram->pread(ram->iod, b, sizeof(b), SBDI_BLOCK_SIZE) == 2 * SBDI_BLOCK_SIZE);
+    CPPUNIT_ASSERT(memchrcmp(b, 0, SBDI_BLOCK_SIZE));
+    CPPUNIT_ASSERT(memchrcmp(b + SBDI_BLOCK_SIZE, 3, SBDI_BLOCK_SIZE));
+    // Discarding zeroes the range but keeps the size
+    CPPUNIT_ASSERT(ram->discard(ram->iod, 2 * SBDI_BLOCK_SIZE, 4 * SBDI_BLOCK_SIZE) == 0);
+    CPPUNIT_ASSERT(sbdi_ram_size(ram) == 3 * SBDI_BLOCK_SIZE);
+    preadBlk(ram, 0, 2);
+    pwriteBlk(ram, 3, 2);
+    // Growing far beyond the initial capacity keeps the data
+    pwriteBlk(ram, 9, 1000);
+    CPPUNIT_ASSERT(sbdi_ram_size(ram) == 1001 * SBDI_BLOCK_SIZE);
+    preadBlk(ram, 1, 0);
+    preadBlk(ram, 0, 999);
+    preadBlk(ram, 9, 1000);
+    CPPUNIT_ASSERT(ram->pread(ram->iod, b, 1, -1) == -1);
+  }
+
+  void testLatency()
+  {
+    sbdi_lat_cfg_t cfg = { 2000, 1000, 5000, 0, 0, 0 };
+    pio = sbdi_lat_create(ram, &cfg);
+    CPPUNIT_ASSERT(pio);
+    uint64_t t = now();
+    pwriteBlk(pio, 1, 0);
+    for (int i = 0; i < 5; ++i) {
+      preadBlk(pio, 1, 0);
+    }
+    CPPUNIT_ASSERT(pio->flush(pio->iod) == 0);
+    t = now() - t;
+    CPPUNIT_ASSERT(t >= (1000 + 5 * 2000 + 5000) * 1000u);
+    sbdi_lat_stats_t s;
+    sbdi_lat_get_stats(pio, &s);
+    CPPUNIT_ASSERT(s.reads == 5 && s.writes == 1 && s.flushes == 1);
+    CPPUNIT_ASSERT(s.rd_bytes == 5 * SBDI_BLOCK_SIZE && s.wr_bytes == SBDI_BLOCK_SIZE);
+    CPPUNIT_ASSERT(s.delay >= (1000 + 5 * 2000 + 5000) * 1000u);
+    CPPUNIT_ASSERT(s.max_inflight == 1);
+  }
+
+  void testBandwidth()
+  {
+    // 20 blocks at 100 blocks per second take at least 200 ms
+    sbdi_lat_cfg_t cfg = { 0, 0, 0, 100, 100 * SBDI_BLOCK_SIZE, 0 };
+    pio = sbdi_lat_create(ram, &cfg);
+    CPPUNIT_ASSERT(pio);
+    uint64_t t = now();
+    for (int i = 0; i < 20; ++i) {
+      pwriteBlk(pio, i, i);
+    }
+    t = now() - t;
+    CPPUNIT_ASSERT(t >= 200 * 1000000u);
+    for (int i = 0; i < 20; ++i) {
+      preadBlk(ram, i, i);
+    }
+  }
+
+  void testQueueDepth()
+  {
+    const int THREADS = 8;
+    sbdi_lat_cfg_t cfg = { 5000, 5000, 0, 0, 0, 2 };
+    pio = sbdi_lat_create(ram, &cfg);
+    CPPUNIT_ASSERT(pio);
+    for (int i = 0; i < THREADS; ++i) {
+      pwriteBlk(ram, i, i);
+    }
+    uint64_t t = now();
+    std::vector<std::thread> ts;
+    for (int i = 0; i < THREADS; ++i) {
+      ts.push_back(std::thread([this, i]() {
+        for (int k = 0; k < 2; ++k) {
+          preadBlk(pio, i, i);
+        }
+      }));
+    }
+    for (size_t i = 0; i < ts.size(); ++i) {
+      ts[i].join();
+    }
+    t = now() - t;
+    sbdi_lat_stats_t s;
+    sbdi_lat_get_stats(pio, &s);
+    CPPUNIT_ASSERT(s.max_inflight <= 2);
+    CPPUNIT_ASSERT(s.reads == 2 * THREADS);
+    // 16 reads of 5 ms, two at a time
+    CPPUNIT_ASSERT(t >= 8 * 5000 * 1000u);
+  }
+
+  void testSbdi()
+  {
+    const uint32_t BLKS = SBDI_MNGT_BLOCK_ENTRIES + 8;
+    // The in-memory back end outlives the latency injecting one
+    roundTrip(BLKS, 1);
+    CPPUNIT_ASSERT(sessions.size() == 2);
+    CPPUNIT_ASSERT(sessions[0].flushes >= 1);
+    CPPUNIT_ASSERT(sessions[0].wr_bytes >= BLKS * SBDI_BLOCK_SIZE);
+  }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(SbdiRamTest);
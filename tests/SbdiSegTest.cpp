@@ -0,0 +1,198 @@
+/* Copyright (c) IAIK, Graz University of Technology, 2015.
+ * All rights reserved.
+ * Contact: http://opensource.iaik.tugraz.at
+ * 
+ * This file is part of the Secure Block Device Library.
+ * 
+ * Commercial License Usage
+ * Licensees holding valid commercial licenses may use this file in
+ * accordance with the commercial license agreement provided with the
+ * Software or, alternatively, in accordance with the terms contained in
+ * a written agreement between you and SIC. For further information
+ * contact us at http://opensource.iaik.tugraz.at.
+ * 
+ * Alternatively, this file may be used under the terms of the GNU General
+ * Public License as published by the Free Software Foundation version 2.
+ * 
+ * The Secure Block Device Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with the Secure Block Device Library. If not, see <http://www.gnu.org/licenses/>.
+ */
+///
+/// \file
+/// \brief Tests the Secure Block Device Library's segment file back end.
+///
+#include "SbdiBackendTest.h"
+#include "sbdi_seg.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <string>
+#include <vector>
+
+#define SEG_DIR_NAME "sbdi_tst_seg"
+#define SEG_BLKS (SBDI_SEG_GROUPS * (SBDI_MNGT_BLOCK_ENTRIES + 1u))
+
+class SbdiSegTest: public SbdiBackendTest {
+  CPPUNIT_TEST_SUITE( SbdiSegTest );
+  CPPUNIT_TEST(testReadWrite);
+  CPPUNIT_TEST(testSpanning);
+  CPPUNIT_TEST(testFileCache);
+  CPPUNIT_TEST(testSbdi);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  void openBackend()
+  {
+    pio = sbdi_seg_create(SEG_DIR_NAME);
+    CPPUNIT_ASSERT(pio);
+  }
+
+  void closeBackend()
+  {
+    sbdi_seg_delete(pio);
+  }
+
+  std::vector<std::string> segments()
+  {
+    std::vector<std::string> s;
+    DIR *d = opendir(SEG_DIR_NAME);
+    if (!d) {
+      return s;
+    }
+    struct dirent *e;
+    while ((e = readdir(d))) {
+      if (strcmp(e->d_name, ".") && strcmp(e->d_name, "..")) {
+        s.push_back(std::string(SEG_DIR_NAME "/") + e->d_name);
+      }
+    }
+    closedir(d);
+    return s;
+  }
+
+  off_t segmentSize(uint32_t id)
+  {
+    char name[64];
+    struct stat s;
+    snprintf(name, sizeof(name), SEG_DIR_NAME "/%08x.seg", id);
+    CPPUNIT_ASSERT(stat(name, &s) == 0);
+    return s.st_size;
+  }
+
+  void removeDir()
+  {
+    std::vector<std::string> s = segments();
+    for (size_t i = 0; i < s.size(); ++i) {
+      unlink(s[i].c_str());
+    }
+    rmdir(SEG_DIR_NAME);
+  }
+
+public:
+  void setUp()
+  {
+    removeDir();
+  }
+
+  void tearDown()
+  {
+    removeDir();
+  }
+
+  void testReadWrite()
+  {
+    unsigned char b[SBDI_BLOCK_SIZE];
+    openBackend();
+    CPPUNIT_ASSERT(pio->pread(pio->iod, b, SBDI_BLOCK_SIZE, 0) == 0);
+    CPPUNIT_ASSERT(segments().empty());
+    // Only the segment written to is created, everything below reads as zeros
+    const uint32_t blk = 1 + 3 * SEG_BLKS + 5;
+    pwriteBlk(3, blk);
+    CPPUNIT_ASSERT(segments().size() == 1);
+    CPPUNIT_ASSERT(segmentSize(3) == 6 * SBDI_BLOCK_SIZE);
+    preadBlk(0, 0);
+    preadBlk(0, SEG_BLKS);
+    preadBlk(0, blk - 1);
+    preadBlk(3, blk);
+    CPPUNIT_ASSERT(pio->pread(pio->iod, b, SBDI_BLOCK_SIZE, (off_t) (blk + 1) * SBDI_BLOCK_SIZE) == 0);
+    // The header and the last block of the first segment share a file
+    pwriteBlk(1, 0);
+    pwriteBlk(2, SEG_BLKS);
+    CPPUNIT_ASSERT(segments().size() == 2);
+    CPPUNIT_ASSERT(segmentSize(0) == (SEG_BLKS + 1) * SBDI_BLOCK_SIZE);
+    CPPUNIT_ASSERT(pio->flush(pio->iod) == 0);
+    closeBackend();
+    // The end of the device is found from the last segment
+    openBackend();
+    preadBlk(1, 0);
+    preadBlk(2, SEG_BLKS);
+    preadBlk(0, SEG_BLKS + 1);
+    preadBlk(3, blk);
+    CPPUNIT_ASSERT(pio->pread(pio->iod, b, SBDI_BLOCK_SIZE, (off_t) (blk + 1) * SBDI_BLOCK_SIZE) == 0);
+    closeBackend();
+  }
+
+  void testSpanning()
+  {
+    openBackend();
+    // A request crossing the end of a segment is split between both files
+    const uint32_t n = 4;
+    const uint32_t first = 2 * SEG_BLKS - 1;
+    std::vector<unsigned char> b(n * SBDI_BLOCK_SIZE);
+    for (uint32_t i = 0; i < n; ++i) {
+      memset(&b[i * SBDI_BLOCK_SIZE], i + 1, SBDI_BLOCK_SIZE);
+    }
+    CPPUNIT_ASSERT(
+        pio->pwrite(pio->iod, &b[0], b.size(), (off_t) first * SBDI_BLOCK_SIZE) == (ssize_t) b.size());
+    CPPUNIT_ASSERT(segmentSize(1) == SEG_BLKS * SBDI_BLOCK_SIZE);
+    CPPUNIT_ASSERT(segmentSize(2) == 2 * SBDI_BLOCK_SIZE);
+    memset(&b[0], 0, b.size());
+    CPPUNIT_ASSERT(
+        pio->pread(pio->iod, &b[0], b.size(), (off_t) first * SBDI_BLOCK_SIZE) == (ssize_t) b.size());
+    for (uint32_t i = 0; i < n; ++i) {
+      CPPUNIT_ASSERT(memchrcmp(&b[i * SBDI_BLOCK_SIZE], i + 1, SBDI_BLOCK_SIZE));
+    }
+    closeBackend();
+  }
+
+  void testFileCache()
+  {
+    // Touch more segments than are kept open, several times over
+    const uint32_t segs = 2 * SBDI_SEG_OPEN_FILES + 3;
+    openBackend();
+    for (uint32_t r = 0; r < 3; ++r) {
+      for (uint32_t i = 0; i < segs; ++i) {
+        pwriteBlk((i + r) & 0xFF, 1 + i * SEG_BLKS + r);
+      }
+    }
+    for (uint32_t r = 0; r < 3; ++r) {
+      for (uint32_t i = 0; i < segs; ++i) {
+        preadBlk((i + r) & 0xFF, 1 + i * SEG_BLKS + r);
+      }
+    }
+    CPPUNIT_ASSERT(pio->flush(pio->iod) == 0);
+    CPPUNIT_ASSERT(segments().size() == segs);
+    closeBackend();
+  }
+
+  void testSbdi()
+  {
+    // Spans two segments
+    roundTrip(SBDI_MNGT_BLOCK_ENTRIES * (SBDI_SEG_GROUPS + 1) + 8, 1);
+    CPPUNIT_ASSERT(segments().size() == 2);
+  }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(SbdiSegTest);
@@ -0,0 +1,184 @@
+/* Copyright (c) IAIK, Graz University of Technology, 2015.
+ * All rights reserved.
+ * Contact: http://opensource.iaik.tugraz.at
+ * 
+ * This file is part of the Secure Block Device Library.
+ * 
+ * Commercial License Usage
+ * Licensees holding valid commercial licenses may use this file in
+ * accordance with the commercial license agreement provided with the
+ * Software or, alternatively, in accordance with the terms contained in
+ * a written agreement between you and SIC. For further information
+ * contact us at http://opensource.iaik.tugraz.at.
+ * 
+ * Alternatively, this file may be used under the terms of the GNU General
+ * Public License as published by the Free Software Foundation version 2.
+ * 
+ * The Secure Block Device Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with the Secure Block Device Library. If not, see <http://www.gnu.org/licenses/>.
+ */
+///
+/// \file
+/// \brief Tests the Secure Block Device Library's striping back end.
+///
+#include "SbdiBackendTest.h"
+#include "sbdi_stripe.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <vector>
+
+#define MEMBERS 3u
+#define GRP_BLKS (SBDI_MNGT_BLOCK_ENTRIES + 1u)
+
+class SbdiStripeTest: public SbdiBackendTest {
+  CPPUNIT_TEST_SUITE( SbdiStripeTest );
+  CPPUNIT_TEST(testLayout);
+  CPPUNIT_TEST(testHoles);
+  CPPUNIT_TEST(testSbdi);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  int fds[MEMBERS];
+
+  static void memberName(char *name, uint32_t m)
+  {
+    snprintf(name, 32, "sbdi_tst_stripe.%u", m);
+  }
+
+  void openStripe(uint32_t unit)
+  {
+    char name[32];
+    for (uint32_t m = 0; m < MEMBERS; ++m) {
+      memberName(name, m);
+      fds[m] = open(name, O_RDWR | O_CREAT, S_IRUSR | S_IWUSR);
+      CPPUNIT_ASSERT(fds[m] != -1);
+    }
+    pio = sbdi_stripe_create(fds, MEMBERS, unit);
+    CPPUNIT_ASSERT(pio);
+  }
+
+  void openBackend()
+  {
+    openStripe(1);
+  }
+
+  void closeBackend()
+  {
+    sbdi_stripe_delete(pio);
+    for (uint32_t m = 0; m < MEMBERS; ++m) {
+      CPPUNIT_ASSERT(close(fds[m]) != -1);
+    }
+  }
+
+  void preadMember(int c, uint32_t m, uint32_t blk)
+  {
+    unsigned char b[SBDI_BLOCK_SIZE];
+    CPPUNIT_ASSERT(
+        pread(fds[m], b, SBDI_BLOCK_SIZE, blk * SBDI_BLOCK_SIZE) == SBDI_BLOCK_SIZE);
+    CPPUNIT_ASSERT(memchrcmp(b, c, SBDI_BLOCK_SIZE));
+  }
+
+public:
+  void setUp()
+  {
+    char name[32];
+    for (uint32_t m = 0; m < MEMBERS; ++m) {
+      memberName(name, m);
+      unlink(name);
+    }
+  }
+
+  void tearDown()
+  {
+    setUp();
+  }
+
+  void testLayout()
+  {
+    int fd = -1;
+    CPPUNIT_ASSERT(!sbdi_stripe_create(&fd, 1, 1));
+    CPPUNIT_ASSERT(!sbdi_stripe_create(fds, 0, 1));
+    CPPUNIT_ASSERT(!sbdi_stripe_create(fds, MEMBERS, 0));
+    openStripe(1);
+    // One request spanning the header and four groups fans out to all members
+    const uint32_t n = 1 + 4 * GRP_BLKS;
+    std::vector<unsigned char> b(n * SBDI_BLOCK_SIZE);
+    for (uint32_t i = 0; i < n; ++i) {
+      memset(&b[i * SBDI_BLOCK_SIZE], i & 0xFF, SBDI_BLOCK_SIZE);
+    }
+    CPPUNIT_ASSERT(pio->pwrite(pio->iod, &b[0], b.size(), 0) == (ssize_t) b.size());
+    CPPUNIT_ASSERT(pio->flush(pio->iod) == 0);
+    preadMember(0, 0, 0);
+    preadMember(1, 0, 1);
+    preadMember(GRP_BLKS & 0xFF, 0, GRP_BLKS);
+    preadMember((GRP_BLKS + 1) & 0xFF, 1, 1);
+    preadMember((2 * GRP_BLKS + 1) & 0xFF, 2, 1);
+    preadMember((3 * GRP_BLKS + 1) & 0xFF, 0, GRP_BLKS + 1);
+    preadMember((n - 1) & 0xFF, 0, 2 * GRP_BLKS);
+    memset(&b[0], 0, b.size());
+    CPPUNIT_ASSERT(pio->pread(pio->iod, &b[0], b.size(), 0) == (ssize_t) b.size());
+    for (uint32_t i = 0; i < n; ++i) {
+      CPPUNIT_ASSERT(memchrcmp(&b[i * SBDI_BLOCK_SIZE], i & 0xFF, SBDI_BLOCK_SIZE));
+    }
+    closeBackend();
+    // Stripe units of two groups
+    setUp();
+    openStripe(2);
+    pwriteBlk(7, 1 + 2 * GRP_BLKS);
+    pwriteBlk(9, 1 + 6 * GRP_BLKS);
+    preadMember(7, 1, 1);
+    preadMember(9, 0, 1 + 2 * GRP_BLKS);
+    closeBackend();
+  }
+
+  void testHoles()
+  {
+    openStripe(1);
+    unsigned char b[2 * SBDI_BLOCK_SIZE];
+    CPPUNIT_ASSERT(pio->pread(pio->iod, b, SBDI_BLOCK_SIZE, 0) == 0);
+    CPPUNIT_ASSERT(pio->pread(pio->iod, b, SBDI_BLOCK_SIZE, 1) == -1);
+    // Only the last member holds data; everything below reads as zeros
+    const uint32_t last = 1 + 2 * GRP_BLKS + 3;
+    pwriteBlk(5, last);
+    preadBlk(0, 0);
+    preadBlk(0, 1);
+    preadBlk(0, 1 + GRP_BLKS);
+    preadBlk(0, last - 1);
+    preadBlk(5, last);
+    CPPUNIT_ASSERT(pio->pread(pio->iod, b, sizeof(b), last * SBDI_BLOCK_SIZE) == SBDI_BLOCK_SIZE);
+    CPPUNIT_ASSERT(pio->pread(pio->iod, b, SBDI_BLOCK_SIZE, (last + 1) * SBDI_BLOCK_SIZE) == 0);
+    closeBackend();
+    // The end of the device is found again from the member sizes
+    openStripe(1);
+    preadBlk(5, last);
+    preadBlk(0, 2);
+    CPPUNIT_ASSERT(pio->pread(pio->iod, b, SBDI_BLOCK_SIZE, (last + 1) * SBDI_BLOCK_SIZE) == 0);
+    pwriteBlk(6, 3);
+    closeBackend();
+    openStripe(1);
+    preadBlk(6, 3);
+    preadBlk(5, last);
+    CPPUNIT_ASSERT(pio->pread(pio->iod, b, SBDI_BLOCK_SIZE, (last + 1) * SBDI_BLOCK_SIZE) == 0);
+    closeBackend();
+  }
+
+  void testSbdi()
+  {
+    roundTrip(5 * SBDI_MNGT_BLOCK_ENTRIES + 8, 1);
+  }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(SbdiStripeTest);
@@ -56,6 +56,7 @@
 
 #include <algorithm>
 #include <vector>
+#include <thread>
 #include <cstdlib>
 
 class SbdiTest: public CppUnit::TestFixture {
@@ -63,6 +64,13 @@ class SbdiTest: public CppUnit::TestFixture {
   CPPUNIT_TEST(testParameterChecks);
   CPPUNIT_TEST(testSimpleReadWrite);
   CPPUNIT_TEST(testRandomAccess);
+  CPPUNIT_TEST(testBatchedSync);
+  CPPUNIT_TEST(testBatchedRead);
+  CPPUNIT_TEST(testHeaderWriteElision);
+  CPPUNIT_TEST(testGroupCommit);
+  CPPUNIT_TEST(testFailedFlush);
+  CPPUNIT_TEST(testPunchHole);
+  CPPUNIT_TEST(testTruncate);
   CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -72,14 +80,14 @@ private:
   int fd;
   sbdi_pio_t *pio;
 
-  void loadStore()
+  void loadStore(sbdi_crypto_type_t ct = SBDI_CRYPTO_NONE)
   {
     fd = open(FILE_NAME, O_RDWR | O_CREAT, S_IRUSR | S_IWUSR);
     CPPUNIT_ASSERT(fd != -1);
     struct stat s;
     CPPUNIT_ASSERT(fstat(fd, &s) == 0);
     pio = sbdi_pio_create(&fd, s.st_size);
-    CPPUNIT_ASSERT(sbdi_open(&sbdi, pio, SBDI_CRYPTO_NONE, SIV_KEYS, root) == SBDI_SUCCESS);
+    CPPUNIT_ASSERT(sbdi_open(&sbdi, pio, ct, SIV_KEYS, root) == SBDI_SUCCESS);
   }
 
   void closeStore()
@@ -257,8 +265,392 @@ public:
     deleteStore();
     free(b);
   }
+
+  void testBatchedSync()
+  {
+    // Dirty more data blocks than fit into one sync batch, spread over two
+    // management blocks, and make sure the batched sync produces a store
+    // that survives re-opening (i.e. the Merkle tree root matches).
+    const int BLKS = SBDI_MNGT_BLOCK_ENTRIES + 3 * SBDI_BL_BATCH_SIZE;
+    unsigned char *b = (unsigned char *) malloc(
+        sizeof(unsigned char) * SBDI_BLOCK_SIZE);
+    CPPUNIT_ASSERT(b);
+    loadStore(SBDI_CRYPTO_SIV);
+    for (int i = 0; i < BLKS; ++i) {
+      f_write(i % 256, b, SBDI_BLOCK_SIZE, i * SBDI_BLOCK_SIZE);
+    }
+    CPPUNIT_ASSERT(sbdi_fsync(sbdi, SIV_KEYS) == SBDI_SUCCESS);
+    closeStore();
+    loadStore(SBDI_CRYPTO_SIV);
+    for (int i = 0; i < BLKS; ++i) {
+      c_read(i % 256, b, SBDI_BLOCK_SIZE, i * SBDI_BLOCK_SIZE);
+    }
+    // Update every other block and sync again
+    for (int i = 0; i < BLKS; i += 2) {
+      f_write((i + 7) % 256, b, SBDI_BLOCK_SIZE, i * SBDI_BLOCK_SIZE);
+    }
+    closeStore();
+    loadStore(SBDI_CRYPTO_SIV);
+    for (int i = 0; i < BLKS; ++i) {
+      c_read(((i % 2) ? i : i + 7) % 256, b, SBDI_BLOCK_SIZE,
+          i * SBDI_BLOCK_SIZE);
+    }
+    closeStore();
+    deleteStore();
+    free(b);
+  }
+
+  void testBatchedRead()
+  {
+    const int BLKS = SBDI_MNGT_BLOCK_ENTRIES + 3 * SBDI_BL_BATCH_SIZE + 5;
+    const size_t LEN = BLKS * SBDI_BLOCK_SIZE;
+    unsigned char *b = (unsigned char *) malloc(sizeof(unsigned char) * LEN);
+    unsigned char *u = (unsigned char *) malloc(
+        sizeof(unsigned char) * SBDI_BLOCK_SIZE);
+    CPPUNIT_ASSERT(b && u);
+    loadStore(SBDI_CRYPTO_SIV);
+    f_write(3, b, LEN, 0);
+    closeStore();
+    // Cold cache: multi-block reads go through the batched read path
+    loadStore(SBDI_CRYPTO_SIV);
+    c_read(3, b, LEN, 0);
+    c_read((3 + 100) % UINT8_MAX, b, LEN - 100, 100);
+    // Dirty blocks in the cache must take precedence over the backend
+    f_write(9, u, SBDI_BLOCK_SIZE, 5 * SBDI_BLOCK_SIZE);
+    f_write(11, u, SBDI_BLOCK_SIZE, (BLKS - 2) * SBDI_BLOCK_SIZE);
+    memset(b, 0xFF, LEN);
+    read(b, LEN, 0);
+    cmp(3, b, 5 * SBDI_BLOCK_SIZE);
+    cmp(9, b + 5 * SBDI_BLOCK_SIZE, SBDI_BLOCK_SIZE);
+    cmp((3 + 6 * SBDI_BLOCK_SIZE) % UINT8_MAX, b + 6 * SBDI_BLOCK_SIZE,
+        (BLKS - 8) * SBDI_BLOCK_SIZE);
+    cmp(11, b + (BLKS - 2) * SBDI_BLOCK_SIZE, SBDI_BLOCK_SIZE);
+    closeStore();
+    // Tamper with a data block; a batched read must detect it
+    int t_fd = open(FILE_NAME, O_RDWR);
+    CPPUNIT_ASSERT(t_fd != -1);
+    off_t t_off = sbdi_blic_log_to_phy_dat_blk(10) * SBDI_BLOCK_SIZE + 42;
+    unsigned char c = 0;
+    CPPUNIT_ASSERT(pread(t_fd, &c, 1, t_off) == 1);
+    c ^= 0x01;
+    CPPUNIT_ASSERT(pwrite(t_fd, &c, 1, t_off) == 1);
+    CPPUNIT_ASSERT(close(t_fd) != -1);
+    loadStore(SBDI_CRYPTO_SIV);
+    ssize_t rd = 0;
+    CPPUNIT_ASSERT(
+        sbdi_pread(&rd, sbdi, b, LEN, 0) == SBDI_ERR_TAG_MISMATCH);
+    closeStore();
+    deleteStore();
+    free(u);
+    free(b);
+  }
+
+  void readHeader(unsigned char *hdr)
+  {
+    int t_fd = open(FILE_NAME, O_RDONLY);
+    CPPUNIT_ASSERT(t_fd != -1);
+    CPPUNIT_ASSERT(pread(t_fd, hdr, SBDI_BLOCK_SIZE, 0) == SBDI_BLOCK_SIZE);
+    CPPUNIT_ASSERT(close(t_fd) != -1);
+  }
+
+  void testHeaderWriteElision()
+  {
+    unsigned char *b = (unsigned char *) malloc(
+        sizeof(unsigned char) * SBDI_BLOCK_SIZE);
+    unsigned char *h1 = (unsigned char *) malloc(
+        sizeof(unsigned char) * SBDI_BLOCK_SIZE);
+    unsigned char *h2 = (unsigned char *) malloc(
+        sizeof(unsigned char) * SBDI_BLOCK_SIZE);
+    CPPUNIT_ASSERT(b && h1 && h2);
+    loadStore(SBDI_CRYPTO_SIV);
+    f_write(1, b, SBDI_BLOCK_SIZE, 0);
+    CPPUNIT_ASSERT(sbdi_fsync(sbdi, SIV_KEYS) == SBDI_SUCCESS);
+    readHeader(h1);
+    // Neither the size changes nor are the reserved counter values used up
+    uint32_t syncs = 0;
+    do {
+      f_write(syncs % 256, b, SBDI_BLOCK_SIZE, 0);
+      CPPUNIT_ASSERT(sbdi_fsync(sbdi, SIV_KEYS) == SBDI_SUCCESS);
+      readHeader(h2);
+      syncs += 1;
+    } while (!memcmp(h1, h2, SBDI_BLOCK_SIZE) && syncs <= SBDI_HDR_CTR_RESERVE + 1);
+    // Every sync uses up one counter value for the data block
+    CPPUNIT_ASSERT(memcmp(h1, h2, SBDI_BLOCK_SIZE));
+    CPPUNIT_ASSERT(syncs > SBDI_HDR_CTR_RESERVE - 2);
+    sbdi_ctr_128b_t ctr = sbdi->hdr->ctr;
+    closeStore();
+    // Re-opening continues after the reserved counter values
+    loadStore(SBDI_CRYPTO_SIV);
+    int res = 0;
+    CPPUNIT_ASSERT(sbdi_ctr_128b_cmp(&sbdi->hdr->ctr, &ctr, &res) == SBDI_SUCCESS);
+    CPPUNIT_ASSERT(res > 0);
+    c_read((syncs - 1) % 256, b, SBDI_BLOCK_SIZE, 0);
+    // Growing the device requires a header write
+    readHeader(h1);
+    f_write(2, b, SBDI_BLOCK_SIZE, SBDI_BLOCK_SIZE);
+    CPPUNIT_ASSERT(sbdi_fsync(sbdi, SIV_KEYS) == SBDI_SUCCESS);
+    readHeader(h2);
+    CPPUNIT_ASSERT(memcmp(h1, h2, SBDI_BLOCK_SIZE));
+    closeStore();
+    loadStore(SBDI_CRYPTO_SIV);
+    c_read(2, b, SBDI_BLOCK_SIZE, SBDI_BLOCK_SIZE);
+    closeStore();
+    deleteStore();
+    free(h2);
+    free(h1);
+    free(b);
+  }
+
+  static int slowFlush(void *iod)
+  {
+    // Give the other committers time to queue up behind this flush
+    usleep(20000);
+    return fdatasync(*(int *) iod);
+  }
+
+  void testGroupCommit()
+  {
+    const int THREADS = 8;
+    loadStore(SBDI_CRYPTO_SIV);
+    pio->flush = &slowFlush;
+    std::vector<std::thread> committers;
+    std::vector<sbdi_error_t> res(THREADS, SBDI_ERR_UNSPECIFIED);
+    for (int i = 0; i < THREADS; ++i) {
+      committers.push_back(std::thread([this, i, &res]() {
+        unsigned char d[SBDI_BLOCK_SIZE];
+        memset(d, i, SBDI_BLOCK_SIZE);
+        ssize_t wr = 0;
+        res[i] = sbdi_pwrite(&wr, sbdi, d, SBDI_BLOCK_SIZE, i * SBDI_BLOCK_SIZE);
+        if (res[i] == SBDI_SUCCESS) {
+          res[i] = sbdi_fsync(sbdi, SIV_KEYS);
+        }
+      }));
+    }
+    for (int i = 0; i < THREADS; ++i) {
+      committers[i].join();
+      CPPUNIT_ASSERT(res[i] == SBDI_SUCCESS);
+    }
+    sbdi_cm_stats_t st;
+    CPPUNIT_ASSERT(sbdi_get_sync_stats(sbdi, &st) == SBDI_SUCCESS);
+    CPPUNIT_ASSERT(st.syncs == THREADS);
+    CPPUNIT_ASSERT(st.flushes >= 1 && st.flushes < THREADS);
+    CPPUNIT_ASSERT(st.max_batch > 1);
+    CPPUNIT_ASSERT(st.max_flush_time >= 20000000);
+    CPPUNIT_ASSERT(st.wait_time >= st.max_wait_time);
+    closeStore();
+    loadStore(SBDI_CRYPTO_SIV);
+    unsigned char *b = (unsigned char *) malloc(
+        sizeof(unsigned char) * SBDI_BLOCK_SIZE);
+    CPPUNIT_ASSERT(b);
+    for (int i = 0; i < THREADS; ++i) {
+      read(b, SBDI_BLOCK_SIZE, i * SBDI_BLOCK_SIZE);
+      for (uint32_t j = 0; j < SBDI_BLOCK_SIZE; ++j) {
+        CPPUNIT_ASSERT(b[j] == i);
+      }
+    }
+    closeStore();
+    deleteStore();
+    free(b);
+  }
+
+  static int flushes;
+
+  static int failOnceFlush(void *iod)
+  {
+    (void) iod;
+    return (flushes++ == 0) ? -1 : 0;
+  }
+
+  void testFailedFlush()
+  {
+    sbdi_pio_t p;
+    memset(&p, 0, sizeof(sbdi_pio_t));
+    p.flush = &failOnceFlush;
+    flushes = 0;
+    sbdi_cm_t *cm = sbdi_cm_create(&p);
+    CPPUNIT_ASSERT(cm);
+    uint64_t t1 = sbdi_cm_enqueue(cm);
+    uint64_t t2 = sbdi_cm_enqueue(cm);
+    CPPUNIT_ASSERT(sbdi_cm_flush(cm, t1) == SBDI_ERR_IO);
+    uint64_t t3 = sbdi_cm_enqueue(cm);
+    CPPUNIT_ASSERT(sbdi_cm_flush(cm, t3) == SBDI_SUCCESS);
+    // A waiter covered by the failed flush that only gets to run after the
+    // successful one must still see the failure
+    CPPUNIT_ASSERT(sbdi_cm_flush(cm, t2) == SBDI_ERR_IO);
+    CPPUNIT_ASSERT(sbdi_cm_flush(cm, t1) == SBDI_ERR_IO);
+    CPPUNIT_ASSERT(flushes == 2);
+    uint64_t t4 = sbdi_cm_enqueue(cm);
+    CPPUNIT_ASSERT(sbdi_cm_flush(cm, t4) == SBDI_SUCCESS);
+    CPPUNIT_ASSERT(sbdi_cm_flush(cm, t3) == SBDI_SUCCESS);
+    sbdi_cm_destroy(cm);
+  }
+
+  void checkHole(unsigned char *b, size_t len, size_t h_off, size_t h_len)
+  {
+    memset(b, 0xFF, len);
+    read(b, len, 0);
+    cmp(3, b, h_off);
+    for (size_t i = h_off; i < h_off + h_len; ++i) {
+      CPPUNIT_ASSERT(b[i] == 0);
+    }
+    cmp((3 + h_off + h_len) % UINT8_MAX, b + h_off + h_len,
+        len - h_off - h_len);
+  }
+
+  void testPunchHole()
+  {
+    const int BLKS = 2 * SBDI_MNGT_BLOCK_ENTRIES + 10;
+    const size_t LEN = BLKS * SBDI_BLOCK_SIZE;
+    // Partial blocks at both edges and whole blocks across a group boundary
+    const size_t H_OFF = SBDI_MNGT_BLOCK_ENTRIES / 2 * SBDI_BLOCK_SIZE + 100;
+    const size_t H_LEN = (SBDI_MNGT_BLOCK_ENTRIES + 3) * SBDI_BLOCK_SIZE;
+    unsigned char *b = (unsigned char *) malloc(sizeof(unsigned char) * LEN);
+    CPPUNIT_ASSERT(b);
+    loadStore(SBDI_CRYPTO_SIV);
+    f_write(3, b, LEN, 0);
+    closeStore();
+    loadStore(SBDI_CRYPTO_SIV);
+    CPPUNIT_ASSERT(sbdi_punch_hole(NULL, 0, 1) == SBDI_ERR_ILLEGAL_PARAM);
+    CPPUNIT_ASSERT(sbdi_punch_hole(sbdi, -1, 1) == SBDI_ERR_ILLEGAL_PARAM);
+    CPPUNIT_ASSERT(sbdi_punch_hole(sbdi, LEN, 1) == SBDI_SUCCESS);
+    CPPUNIT_ASSERT(sbdi_punch_hole(sbdi, H_OFF, H_LEN) == SBDI_SUCCESS);
+    checkHole(b, LEN, H_OFF, H_LEN);
+    off_t size = 0;
+    CPPUNIT_ASSERT(sbdi_lseek(&size, sbdi, 0, SBDI_SEEK_END) == SBDI_SUCCESS);
+    CPPUNIT_ASSERT(size == (off_t ) LEN);
+    // The whole blocks have been released in the back end
+    uint32_t log = (H_OFF + SBDI_BLOCK_SIZE - 1) / SBDI_BLOCK_SIZE;
+    unsigned char *p = (unsigned char *) malloc(
+        sizeof(unsigned char) * SBDI_BLOCK_SIZE);
+    CPPUNIT_ASSERT(p);
+    for (; log < (H_OFF + H_LEN) / SBDI_BLOCK_SIZE; ++log) {
+      CPPUNIT_ASSERT(
+          pread(fd, p, SBDI_BLOCK_SIZE, sbdi_blic_log_to_phy_dat_blk(log) * SBDI_BLOCK_SIZE) == SBDI_BLOCK_SIZE);
+      CPPUNIT_ASSERT(memchrcmp(p, 0, SBDI_BLOCK_SIZE));
+    }
+    closeStore();
+    // The hole survives re-opening and can be written again
+    loadStore(SBDI_CRYPTO_SIV);
+    checkHole(b, LEN, H_OFF, H_LEN);
+    f_write(7, p, SBDI_BLOCK_SIZE, H_OFF + 2 * SBDI_BLOCK_SIZE);
+    c_read(7, p, SBDI_BLOCK_SIZE, H_OFF + 2 * SBDI_BLOCK_SIZE);
+    // A hole reaching the end of the device covers the last block
+    CPPUNIT_ASSERT(sbdi_punch_hole(sbdi, LEN - 10, 100) == SBDI_SUCCESS);
+    c_read((3 + H_OFF + H_LEN) % UINT8_MAX, b, LEN - 10 - H_OFF - H_LEN,
+        H_OFF + H_LEN);
+    memset(p, 0xFF, 10);
+    read(p, 10, LEN - 10);
+    CPPUNIT_ASSERT(memchrcmp(p, 0, 10));
+    closeStore();
+    deleteStore();
+    free(p);
+    free(b);
+  }
+
+  off_t fileSize()
+  {
+    struct stat s;
+    CPPUNIT_ASSERT(stat(FILE_NAME, &s) == 0);
+    return s.st_size;
+  }
+
+  void checkSize(unsigned char *b, size_t size)
+  {
+    off_t end = 0;
+    CPPUNIT_ASSERT(sbdi_lseek(&end, sbdi, 0, SBDI_SEEK_END) == SBDI_SUCCESS);
+    CPPUNIT_ASSERT(end == (off_t ) size);
+    ssize_t rd = -1;
+    CPPUNIT_ASSERT(sbdi_pread(&rd, sbdi, b, 1, size) == SBDI_SUCCESS);
+    CPPUNIT_ASSERT(rd == 0);
+  }
+
+  void testTruncate()
+  {
+    const int BLKS = 3 * SBDI_MNGT_BLOCK_ENTRIES + 10;
+    const size_t LEN = BLKS * SBDI_BLOCK_SIZE;
+    // Keeps one block of the second group, the last one partially
+    const size_t L1 = SBDI_MNGT_BLOCK_ENTRIES * SBDI_BLOCK_SIZE + 100;
+    const size_t L2 = 3 * SBDI_MNGT_BLOCK_ENTRIES * SBDI_BLOCK_SIZE;
+    unsigned char *b = (unsigned char *) malloc(sizeof(unsigned char) * LEN);
+    CPPUNIT_ASSERT(b);
+    loadStore(SBDI_CRYPTO_SIV);
+    f_write(3, b, LEN, 0);
+    closeStore();
+    loadStore(SBDI_CRYPTO_SIV);
+    CPPUNIT_ASSERT(sbdi_ftruncate(NULL, 0) == SBDI_ERR_ILLEGAL_PARAM);
+    CPPUNIT_ASSERT(sbdi_ftruncate(sbdi, -1) == SBDI_ERR_ILLEGAL_PARAM);
+    CPPUNIT_ASSERT(sbdi_ftruncate(sbdi, L1) == SBDI_SUCCESS);
+    checkSize(b, L1);
+    c_read(3, b, L1, 0);
+    // The back end ends behind the last data block
+    CPPUNIT_ASSERT(
+        fileSize() == (sbdi_blic_log_to_phy_dat_blk(SBDI_MNGT_BLOCK_ENTRIES) + 1) * SBDI_BLOCK_SIZE);
+    closeStore();
+    loadStore(SBDI_CRYPTO_SIV);
+    checkSize(b, L1);
+    c_read(3, b, L1, 0);
+    // Extending reads as zeros, also the rest of the former last block
+    CPPUNIT_ASSERT(sbdi_ftruncate(sbdi, L2) == SBDI_SUCCESS);
+    checkSize(b, L2);
+    memset(b, 0xFF, L2);
+    read(b, L2, 0);
+    cmp(3, b, L1);
+    CPPUNIT_ASSERT(memchrcmp(b + L1, 0, L2 - L1));
+    f_write(5, b, SBDI_BLOCK_SIZE, L2 - SBDI_BLOCK_SIZE);
+    closeStore();
+    loadStore(SBDI_CRYPTO_SIV);
+    checkSize(b, L2);
+    c_read(3, b, L1, 0);
+    c_read(5, b, SBDI_BLOCK_SIZE, L2 - SBDI_BLOCK_SIZE);
+    // Without back end truncation the groups stay, but the range is punched
+    pio->truncate = NULL;
+    const off_t f_size = fileSize();
+    CPPUNIT_ASSERT(sbdi_ftruncate(sbdi, 100) == SBDI_SUCCESS);
+    checkSize(b, 100);
+    CPPUNIT_ASSERT(fileSize() == f_size);
+    CPPUNIT_ASSERT(sbdi_ftruncate(sbdi, L1) == SBDI_SUCCESS);
+    memset(b, 0xFF, L1);
+    read(b, L1, 0);
+    cmp(3, b, 100);
+    CPPUNIT_ASSERT(memchrcmp(b + 100, 0, L1 - 100));
+    closeStore();
+    loadStore(SBDI_CRYPTO_SIV);
+    checkSize(b, L1);
+    c_read(3, b, 100, 0);
+    // Shrinking to nothing only leaves the header
+    CPPUNIT_ASSERT(sbdi_ftruncate(sbdi, 0) == SBDI_SUCCESS);
+    checkSize(b, 0);
+    CPPUNIT_ASSERT(fileSize() == SBDI_BLOCK_SIZE);
+    closeStore();
+    loadStore(SBDI_CRYPTO_SIV);
+    checkSize(b, 0);
+    f_write(7, b, SBDI_BLOCK_SIZE, SBDI_BLOCK_SIZE);
+    c_read(7, b, SBDI_BLOCK_SIZE, SBDI_BLOCK_SIZE);
+    // Extending creates new groups whose blocks all read as zeros
+    CPPUNIT_ASSERT(sbdi_ftruncate(sbdi, L2) == SBDI_SUCCESS);
+    checkSize(b, L2);
+    for (uint32_t g = 1; g < 3; ++g) {
+      memset(b, 0xFF, SBDI_BLOCK_SIZE);
+      read(b, SBDI_BLOCK_SIZE, g * SBDI_MNGT_BLOCK_ENTRIES * SBDI_BLOCK_SIZE);
+      CPPUNIT_ASSERT(memchrcmp(b, 0, SBDI_BLOCK_SIZE));
+    }
+    closeStore();
+    loadStore(SBDI_CRYPTO_SIV);
+    checkSize(b, L2);
+    for (uint32_t g = 1; g < 3; ++g) {
+      memset(b, 0xFF, SBDI_BLOCK_SIZE);
+      read(b, SBDI_BLOCK_SIZE, g * SBDI_MNGT_BLOCK_ENTRIES * SBDI_BLOCK_SIZE);
+      CPPUNIT_ASSERT(memchrcmp(b, 0, SBDI_BLOCK_SIZE));
+    }
+    c_read(7, b, SBDI_BLOCK_SIZE, SBDI_BLOCK_SIZE);
+    closeStore();
+    deleteStore();
+    free(b);
+  }
 };
 
+int SbdiTest::flushes = 0;
+
 unsigned char SbdiTest::SIV_KEYS[32] = {
     // Part 1: fffefdfc fbfaf9f8 f7f6f5f4 f3f2f1f0
     0xff, 0xfe, 0xfd, 0xfc, 0xfb, 0xfa, 0xf9, 0xf8, 0xf7, 0xf6, 0xf5, 0xf4,